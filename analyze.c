@@ -1,7 +1,7 @@
 /****************************************************/
 /* File: analyze.c                                  */
 /* Semantic analyzer implementation                 */
-/* for the TINY compiler                            */
+/* for the C- compiler                              */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -9,55 +9,204 @@
 #include "globals.h"
 #include "symtab.h"
 #include "analyze.h"
+#include "traverse.h"
 
-/* counter for variable memory locations */
+/* Storage layout. Globals take consecutive addresses
+ * from gp, starting at 0. Each call has a frame that
+ * grows down from mp:
+ *
+ *   0(mp)          control link (the caller's mp)
+ *   -1(mp)         return address
+ *   -2-i(mp)       parameter i (an address for int a[])
+ *   below          locals of the body, then of the
+ *                  nested blocks, which share space
+ *
+ * The frame of a function ends at -frame(mp); code
+ * generation keeps its temporaries below that.
+ */
+
+/* counter for global memory locations */
 static int location = 0;
 
-/* Procedure traverse is a generic recursive 
- * syntax tree traversal routine:
- * it applies preProc in preorder and postProc 
+/* state of the function being analyzed */
+static TreeNode * funcBody; /* its outermost compound */
+static Symbol * funcSym;
+static int paramNo; /* parameters declared so far */
+static int frameOffset; /* next free frame slot */
+static int minOffset; /* lowest frameOffset so far */
+
+/* blockOffsets saves frameOffset at the entry of each
+ * nested block, to be restored at its exit
+ */
+static int * blockOffsets = NULL;
+static int blockTop = 0;
+static int blockSize = 0;
+
+static void pushOffset( int offset )
+{ if (blockTop == blockSize)
+  { int size = blockSize ? 2*blockSize : 64;
+    int * bigger = (int *) realloc(blockOffsets,size * sizeof(int));
+    if (bigger == NULL)
+    { obPuts(listing,"Out of memory error in analyzer\n");
+      Error = TRUE;
+      return;
+    }
+    blockOffsets = bigger;
+    blockSize = size;
+  }
+  blockOffsets[blockTop++] = offset;
+}
+
+static int popOffset( void )
+{ return blockTop > 0 ? blockOffsets[--blockTop] : frameOffset;
+}
+
+/* the pre- and postorder procedures of one
+ * traversal, adapted to walkTree visitors
+ */
+typedef struct
+   { void (* preProc) (TreeNode *);
+     void (* postProc) (TreeNode *);
+   } TraverseProcs;
+
+static int traversePre( TreeNode * t, int depth, void * arg )
+{ ((TraverseProcs *) arg)->preProc(t);
+  return TRUE;
+}
+
+static void traversePost( TreeNode * t, int depth, void * arg )
+{ ((TraverseProcs *) arg)->postProc(t);
+}
+
+/* Procedure traverse is a generic syntax tree
+ * traversal routine:
+ * it applies preProc in preorder and postProc
  * in postorder to tree pointed to by t
  */
 static void traverse( TreeNode * t,
                void (* preProc) (TreeNode *),
                void (* postProc) (TreeNode *) )
-{ if (t != NULL)
-  { preProc(t);
-    { int i;
-      for (i=0; i < MAXCHILDREN; i++)
-        traverse(t->child[i],preProc,postProc);
-    }
-    postProc(t);
-    traverse(t->sibling,preProc,postProc);
+{ TraverseProcs procs;
+  TreeVisitor v;
+  procs.preProc = preProc;
+  procs.postProc = postProc;
+  v.preProc = traversePre;
+  v.childProc = NULL;
+  v.postProc = traversePost;
+  v.arg = &procs;
+  walkTree(t,&v);
+}
+
+/* traverseOne traverses t alone, without the
+ * siblings that follow it
+ */
+static void traverseOne( TreeNode * t,
+               void (* preProc) (TreeNode *),
+               void (* postProc) (TreeNode *) )
+{ TreeNode * sibling = t->sibling;
+  t->sibling = NULL;
+  traverse(t,preProc,postProc);
+  t->sibling = sibling;
+}
+
+
+static void typeError(TreeNode * t, char * message)
+{ obPrintf(listing,"Type error at line %d: %s\n",t->lineno,message);
+  Error = TRUE;
+}
+
+static void nameError(TreeNode * t, char * message)
+{ obPrintf(listing,"Semantic error at line %d: '%s' %s\n",
+           t->lineno,t->attr.name,message);
+  Error = TRUE;
+}
+
+/* declare inserts the name declared by t into the
+ * innermost scope
+ */
+static Symbol * declare( TreeNode * t, SymKind kind, int loc )
+{ Symbol * s = st_insert(t->attr.name,t->lineno,kind,loc);
+  if (s == NULL)
+  { nameError(t,"is already declared");
+    return NULL;
   }
+  s->decl = t;
+  t->sym = s;
+  return s;
 }
 
-/* nullProc is a do-nothing procedure to 
- * generate preorder-only or postorder-only
- * traversals from traverse
+/* countParams returns the number of parameters of
+ * function f; (void) declares none
  */
-static void nullProc(TreeNode * t)
-{ if (t==NULL) return;
-  else return;
+static int countParams( TreeNode * f )
+{ TreeNode * p;
+  int n = 0;
+  for (p = f->child[0]; p != NULL; p = p->sibling)
+    if (p->type != Void) n++;
+  return n;
 }
 
-/* Procedure insertNode inserts 
- * identifiers stored in t into 
- * the symbol table 
+/* Procedure declareGlobals starts a new symbol
+ * table holding the built-in functions and the
+ * top-level declarations of the program
  */
-static void insertNode( TreeNode * t)
-{ switch (t->nodekind)
+void declareGlobals(TreeNode * syntaxTree)
+{ TreeNode * t;
+  Symbol * s;
+  st_reset();
+  location = 0;
+  s = st_insert("input",0,FuncSym,0);
+  s->type = Integer;
+  s = st_insert("output",0,FuncSym,0);
+  s->type = Void;
+  s->size = 1;
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+  { if (t->nodekind != ExpK) continue;
+    switch (t->kind.exp)
+    { case VarK:
+        if (t->type == Void) nameError(t,"is declared void");
+        if (declare(t,VarSym,location) != NULL) location++;
+        break;
+      case ArrK:
+        if (t->type == Void) nameError(t,"is declared void");
+        if (declare(t,ArraySym,location) != NULL)
+          location += t->arr_size;
+        break;
+      case FuncK:
+        s = declare(t,FuncSym,0);
+        if (s != NULL)
+        { s->type = t->type;
+          s->size = countParams(t);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+/* Procedure resolveNode declares the locals and
+ * parameters of a function as they come into
+ * scope and binds every name used to its symbol
+ */
+static void resolveNode( TreeNode * t)
+{ Symbol * s;
+  switch (t->nodekind)
   { case StmtK:
       switch (t->kind.stmt)
-      { case AssignK:
-        case ReadK:
-          if (st_lookup(t->attr.name) == -1)
-          /* not yet in table, so treat as new definition */
-            st_insert(t->attr.name,t->lineno,location++);
-          else
-          /* already in table, so ignore location, 
-             add line number of use only */ 
-            st_insert(t->attr.name,t->lineno,0);
+      { case CompK:
+          if (t != funcBody)
+          { st_enterScope();
+            pushOffset(frameOffset);
+          }
+          break;
+        case AssignK:
+        case AssignKarr:
+        case CallK:
+          s = st_lookup(t->attr.name);
+          if (s == NULL) nameError(t,"is not declared");
+          else st_addLine(s,t->lineno);
+          t->sym = s;
           break;
         default:
           break;
@@ -65,59 +214,150 @@ static void insertNode( TreeNode * t)
       break;
     case ExpK:
       switch (t->kind.exp)
-      { case IdK:
-          if (st_lookup(t->attr.name) == -1)
-          /* not yet in table, so treat as new definition */
-            st_insert(t->attr.name,t->lineno,location++);
-          else
-          /* already in table, so ignore location, 
-             add line number of use only */ 
-            st_insert(t->attr.name,t->lineno,0);
+      { case FuncK:
+          funcSym = t->sym;
+          funcBody = t->child[1];
+          paramNo = 0;
+          frameOffset = -2 - countParams(t);
+          minOffset = frameOffset;
+          st_enterScope();
+          break;
+        case ParamK:
+          if (t->type != Void)
+          { declare(t,t->type == IntArray ? ArrayParamSym : VarSym,-2 - paramNo);
+            paramNo++;
+          }
+          break;
+        case VarK:
+          if (t->type == Void) nameError(t,"is declared void");
+          declare(t,VarSym,frameOffset--);
+          break;
+        case ArrK:
+          if (t->type == Void) nameError(t,"is declared void");
+          frameOffset -= t->arr_size;
+          declare(t,ArraySym,frameOffset + 1);
+          break;
+        case IdK:
+        case ArrexpK:
+          s = st_lookup(t->attr.name);
+          if (s == NULL) nameError(t,"is not declared");
+          else st_addLine(s,t->lineno);
+          t->sym = s;
           break;
         default:
           break;
       }
+      if (frameOffset < minOffset) minOffset = frameOffset;
       break;
     default:
       break;
   }
 }
 
-/* Function buildSymtab constructs the symbol 
+/* Procedure closeNode closes the scopes opened
+ * by resolveNode
+ */
+static void closeNode( TreeNode * t)
+{ if ((t->nodekind == StmtK) && (t->kind.stmt == CompK) &&
+      (t != funcBody))
+  { if (TraceAnalyze) printSymTab(listing);
+    st_exitScope();
+    frameOffset = popOffset();
+  }
+  else if ((t->nodekind == ExpK) && (t->kind.exp == FuncK))
+  { if (funcSym != NULL) funcSym->frame = -minOffset;
+    if (TraceAnalyze)
+    { obPrintf(listing,"\nSymbol table of %s:\n\n",t->attr.name);
+      printSymTab(listing);
+    }
+    st_exitScope();
+  }
+}
+
+/* Function buildSymtab constructs the symbol
  * table by preorder traversal of the syntax tree
  */
 void buildSymtab(TreeNode * syntaxTree)
-{ traverse(syntaxTree,insertNode,nullProc);
+{ TreeNode * t;
+  declareGlobals(syntaxTree);
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+    if ((t->nodekind == ExpK) && (t->kind.exp == FuncK))
+      resolveFunction(t);
   if (TraceAnalyze)
-  { fprintf(listing,"\nSymbol table:\n\n");
+  { obPuts(listing,"\nSymbol table:\n\n");
     printSymTab(listing);
   }
 }
 
-static void typeError(TreeNode * t, char * message)
-{ fprintf(listing,"Type error at line %d: %s\n",t->lineno,message);
-  Error = TRUE;
+/* checkValue reports message unless t has
+ * type Integer
+ */
+static void checkValue(TreeNode * t, char * message)
+{ if ((t != NULL) && (t->type != Integer))
+    typeError(t,message);
+}
+
+/* Procedure checkCall checks the arguments of
+ * call t against the parameters of its function
+ */
+static void checkCall(TreeNode * t)
+{ Symbol * s = t->sym;
+  TreeNode * arg = t->child[0];
+  TreeNode * param;
+  int n = 0;
+  if (s == NULL) return;
+  if (s->kind != FuncSym)
+  { nameError(t,"is not a function");
+    return;
+  }
+  t->type = s->type;
+  param = s->decl != NULL ? s->decl->child[0] : NULL;
+  if ((param != NULL) && (param->type == Void)) param = NULL;
+  for (; arg != NULL; arg = arg->sibling, n++)
+  { ExpType want = Integer;
+    if (param != NULL)
+    { want = param->type;
+      param = param->sibling;
+    }
+    if (arg->type != want)
+      typeError(arg,want == IntArray ? "argument is not an array"
+                                     : "argument is not an integer value");
+  }
+  if (n != s->size)
+    nameError(t,"is called with the wrong number of arguments");
 }
 
 /* Procedure checkNode performs
  * type checking at a single tree node
  */
 static void checkNode(TreeNode * t)
-{ switch (t->nodekind)
+{ Symbol * s = t->sym;
+  switch (t->nodekind)
   { case ExpK:
       switch (t->kind.exp)
       { case OpK:
           if ((t->child[0]->type != Integer) ||
               (t->child[1]->type != Integer))
             typeError(t,"Op applied to non-integer");
-          if ((t->attr.op == EQ) || (t->attr.op == LT))
-            t->type = Boolean;
-          else
-            t->type = Integer;
+          t->type = Integer;
           break;
         case ConstK:
+          t->type = Integer;
+          break;
         case IdK:
           t->type = Integer;
+          if (s == NULL) break;
+          if (s->kind == FuncSym)
+            nameError(t,"is a function");
+          else if (s->kind != VarSym)
+            t->type = IntArray;
+          break;
+        case ArrexpK:
+          t->type = Integer;
+          if ((s != NULL) && (s->kind != ArraySym) &&
+              (s->kind != ArrayParamSym))
+            nameError(t,"is not an array");
+          checkValue(t->child[0],"array index is not an integer value");
           break;
         default:
           break;
@@ -126,20 +366,38 @@ static void checkNode(TreeNode * t)
     case StmtK:
       switch (t->kind.stmt)
       { case IfK:
-          if (t->child[0]->type == Integer)
-            typeError(t->child[0],"if test is not Boolean");
+          checkValue(t->child[0],"if test is not an integer value");
+          break;
+        case RepeatK:
+          checkValue(t->child[0],"while test is not an integer value");
           break;
         case AssignK:
-          if (t->child[0]->type != Integer)
-            typeError(t->child[0],"assignment of non-integer value");
+          t->type = Integer;
+          if ((s != NULL) && (s->kind != VarSym))
+            nameError(t,"cannot be assigned");
+          checkValue(t->child[0],"assignment of non-integer value");
           break;
-        case WriteK:
-          if (t->child[0]->type != Integer)
-            typeError(t->child[0],"write of non-integer value");
+        case AssignKarr:
+          t->type = Integer;
+          if ((s != NULL) && (s->kind != ArraySym) &&
+              (s->kind != ArrayParamSym))
+            nameError(t,"is not an array");
+          checkValue(t->child[0],"assignment of non-integer value");
+          checkValue(t->child[1],"array index is not an integer value");
           break;
-        case RepeatK:
-          if (t->child[1]->type == Integer)
-            typeError(t->child[1],"repeat test is not Boolean");
+        case CallK:
+          checkCall(t);
+          break;
+        case ReturnK:
+          if (funcSym == NULL) break;
+          if (funcSym->type == Void)
+          { if (t->child[0] != NULL)
+              typeError(t,"return with a value in a void function");
+          }
+          else if (t->child[0] == NULL)
+            typeError(t,"return without a value");
+          else
+            checkValue(t->child[0],"return of non-integer value");
           break;
         default:
           break;
@@ -151,9 +409,52 @@ static void checkNode(TreeNode * t)
   }
 }
 
-/* Procedure typeCheck performs type checking 
+/* enterFunction sets the function whose return
+ * statements are checked
+ */
+static void enterFunction(TreeNode * t)
+{ if ((t->nodekind == ExpK) && (t->kind.exp == FuncK))
+    funcSym = t->sym;
+}
+
+/* Procedure typeCheck performs type checking
  * by a postorder syntax tree traversal
  */
 void typeCheck(TreeNode * syntaxTree)
-{ traverse(syntaxTree,nullProc,checkNode);
+{ TreeNode * t;
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+    if ((t->nodekind == ExpK) && (t->kind.exp == FuncK))
+      checkFunction(t);
+  checkMain();
+}
+
+/* Procedure resolveFunction declares the locals
+ * of function declaration f and binds the names
+ * it uses; the globals must have been declared
+ */
+void resolveFunction(TreeNode * f)
+{ traverseOne(f,resolveNode,closeNode);
+}
+
+/* Procedure checkFunction type checks function
+ * declaration f, after resolveFunction
+ */
+void checkFunction(TreeNode * f)
+{ traverseOne(f,enterFunction,checkNode);
+}
+
+/* Procedure checkMain checks that the program
+ * defines a function main without parameters
+ */
+void checkMain(void)
+{ Symbol * s = st_lookup("main");
+  if ((s == NULL) || (s->kind != FuncSym))
+  { obPuts(listing,"Semantic error: function main is not declared\n");
+    Error = TRUE;
+  }
+  else if (s->size != 0)
+  { obPrintf(listing,"Semantic error at line %d: main must not take parameters\n",
+             s->decl->lineno);
+    Error = TRUE;
+  }
 }
@@ -1,6 +1,6 @@
 /****************************************************/
 /* File: analyze.h                                  */
-/* Semantic analyzer interface for TINY compiler    */
+/* Semantic analyzer interface for the C- compiler  */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -8,6 +8,28 @@
 #ifndef _ANALYZE_H_
 #define _ANALYZE_H_
 
+/* Procedure declareGlobals starts a new symbol
+ * table holding the built-in functions and the
+ * top-level declarations of the program
+ */
+void declareGlobals(TreeNode *);
+
+/* Procedure resolveFunction declares the locals
+ * of function declaration f and binds the names
+ * it uses; the globals must have been declared
+ */
+void resolveFunction(TreeNode * f);
+
+/* Procedure checkFunction type checks function
+ * declaration f, after resolveFunction
+ */
+void checkFunction(TreeNode * f);
+
+/* Procedure checkMain checks that the program
+ * defines a function main without parameters
+ */
+void checkMain(void);
+
 /* Function buildSymtab constructs the symbol 
  * table by preorder traversal of the syntax tree
  */
@@ -0,0 +1,126 @@
+/****************************************************/
+/* File: astbench.c                                 */
+/* Compares walks over the TreeNode syntax tree     */
+/* with walks over the same tree in a NodePool      */
+/****************************************************/
+
+#include <time.h>
+#include "globals.h"
+#include "util.h"
+#include "parse.h"
+#include "traverse.h"
+#include "astpool.h"
+
+/* allocate global variables */
+int lineno = 0;
+FILE * source;
+OutBuf * listing;
+OutBuf * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MaxErrors = 20;
+
+int Error = FALSE;
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* the walks fold every node's kind and depth into
+ * a checksum, so both layouts must agree on shape
+ */
+typedef struct
+   { unsigned long sum;
+     unsigned long nodes;
+   } WalkSum;
+
+static int treeVisit(TreeNode * t, int depth, void * arg)
+{ WalkSum * w = (WalkSum *) arg;
+  int kind = t->nodekind == StmtK ? (int) t->kind.stmt : (int) t->kind.exp;
+  w->sum = w->sum * 31 + (t->nodekind << 5 | kind) + depth;
+  w->nodes++;
+  return TRUE;
+}
+
+static int poolVisit(NodePool * p, NodeId n, int depth, void * arg)
+{ WalkSum * w = (WalkSum *) arg;
+  w->sum = w->sum * 31 + p->kind[n] + depth;
+  w->nodes++;
+  return TRUE;
+}
+
+/* treeBytes estimates the heap used by n TreeNodes,
+ * each a malloc chunk of its own (glibc: 8 bytes of
+ * header, 16-byte alignment)
+ */
+static size_t treeBytes(unsigned long n)
+{ return n * ((sizeof(TreeNode) + 8 + 15) & ~(size_t) 15);
+}
+
+int main(int argc, char * argv[])
+{ TreeNode * tree;
+  NodePool * pool;
+  NodeId root;
+  WalkSum tw, pw;
+  TreeVisitor tv = { treeVisit, NULL, NULL, &tw };
+  PoolVisitor pv = { poolVisit, NULL, NULL, &pw };
+  double tTree, tPool, start;
+  int reps, i, err;
+  FILE * f;
+  if (argc != 3)
+  { fprintf(stderr,"usage: %s <source> <walks>\n",argv[0]);
+    return 1;
+  }
+  reps = atoi(argv[2]);
+  listing = newOutBuf(stdout);
+  f = fopen(argv[1],"r");
+  if (f == NULL)
+  { fprintf(stderr,"File %s not found\n",argv[1]);
+    return 1;
+  }
+  tree = parseSource(f,listing,&err);
+  fclose(f);
+  if (err) { freeOutBuf(listing); return 1; }
+  pool = newNodePool();
+  root = pool != NULL ? poolFromTree(pool,tree) : NO_NODE;
+  if (root == NO_NODE)
+  { fprintf(stderr,"Out of memory building the node pool\n");
+    return 1;
+  }
+
+  start = now();
+  for (i=0;i<reps;i++)
+  { tw.sum = tw.nodes = 0;
+    walkTree(tree,&tv);
+  }
+  tTree = now() - start;
+  start = now();
+  for (i=0;i<reps;i++)
+  { pw.sum = pw.nodes = 0;
+    walkPool(pool,root,&pv);
+  }
+  tPool = now() - start;
+  if ((tw.sum != pw.sum) || (tw.nodes != pw.nodes))
+  { fprintf(stderr,"pool walk disagrees with tree walk\n");
+    return 1;
+  }
+
+  printf("%lu nodes, %d walks\n",tw.nodes,reps);
+  printf("%-10s %12s %10s %14s\n","layout","bytes","seconds","Mnodes/s");
+  printf("%-10s %12lu %10.3f %14.1f\n","TreeNode",
+         (unsigned long) treeBytes(tw.nodes),tTree,tw.nodes * (double) reps / tTree / 1e6);
+  printf("%-10s %12lu %10.3f %14.1f\n","NodePool",
+         (unsigned long) poolBytes(pool),tPool,pw.nodes * (double) reps / tPool / 1e6);
+  printf("memory %.2fx smaller, walks %.2fx faster\n",
+         (double) treeBytes(tw.nodes) / poolBytes(pool),tTree / tPool);
+  freeNodePool(pool);
+  freeOutBuf(listing);
+  return 0;
+}
@@ -0,0 +1,383 @@
+/****************************************************/
+/* File: astio.c                                    */
+/* Binary serialization of syntax trees for the     */
+/* C- compiler (the format is given in astio.h)     */
+/****************************************************/
+
+#include "globals.h"
+#include "traverse.h"
+#include "astio.h"
+
+#define AST_MAGIC "CAST"
+#define AST_MAGICLEN 4
+
+/* MAXNODEBYTES bounds the coded size of one node:
+ * kind, shape and three varints
+ */
+#define MAXNODEBYTES 20
+
+/* hasName tells whether attr.name is used by t */
+static int hasName(NodeKind nodekind, int kind)
+{ if (nodekind == StmtK)
+    return (kind == AssignK) || (kind == AssignKarr) ||
+           (kind == ReadK) || (kind == CallK);
+  return (kind != OpK) && (kind != ConstK);
+}
+
+/* needsName tells whether a node of this kind
+ * always has a name; needsChild is the mask of the
+ * children it always has. The parser builds no
+ * other shapes, and the analyzer relies on them
+ */
+static int needsName(NodeKind nodekind, int kind)
+{ return hasName(nodekind,kind) && ! ((nodekind == ExpK) && (kind == ParamK));
+}
+
+static int needsChild(NodeKind nodekind, int kind)
+{ if (nodekind == StmtK)
+    switch (kind)
+    { case IfK: case RepeatK: case AssignK: return 1;
+      case AssignKarr: return 3;
+      default: return 0;
+    }
+  switch (kind)
+  { case OpK: return 3;
+    case ArrexpK: return 1;
+    case FuncK: return 2;
+    default: return 0;
+  }
+}
+
+/* putVarint codes v at p and returns the bytes used */
+static int putVarint(unsigned char * p, unsigned int v)
+{ int n = 0;
+  while (v >= 0x80)
+  { p[n++] = (unsigned char) (v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (unsigned char) v;
+  return n;
+}
+
+static int putSigned(unsigned char * p, int v)
+{ return putVarint(p,((unsigned int) v << 1) ^ (unsigned int) (v >> 31));
+}
+
+/**************************************************/
+/*****************   Output   *********************/
+/**************************************************/
+
+/* NameTable interns the names of a tree while it is
+ * written: an open addressing hash table of indexes
+ * into the list of distinct names
+ */
+typedef struct
+   { char ** names; /* by index */
+     int count;
+     int * slots; /* index + 1, 0 if free */
+     int size; /* slots, a power of two */
+   } NameTable;
+
+static unsigned int nameHash(const char * s)
+{ unsigned int h = 2166136261u;
+  while (*s) h = (h ^ (unsigned char) *s++) * 16777619u;
+  return h;
+}
+
+/* internName returns the index of name, adding it
+ * to the table if it is new, or -1 if memory runs out
+ */
+static int internName(NameTable * nt, char * name)
+{ unsigned int i;
+  if (2 * (nt->count + 1) > nt->size)
+  { int size = nt->size ? 2 * nt->size : 256, k;
+    int * slots = (int *) calloc(size,sizeof(int));
+    char ** names = (char **) realloc(nt->names,size * sizeof(char *));
+    if ((slots == NULL) || (names == NULL))
+    { free(slots);
+      if (names != NULL) nt->names = names;
+      return -1;
+    }
+    nt->names = names;
+    for (k = 0; k < nt->count; k++)
+    { i = nameHash(names[k]) & (size - 1);
+      while (slots[i] != 0) i = (i + 1) & (size - 1);
+      slots[i] = k + 1;
+    }
+    free(nt->slots);
+    nt->slots = slots;
+    nt->size = size;
+  }
+  i = nameHash(name) & (nt->size - 1);
+  while (nt->slots[i] != 0)
+  { int k = nt->slots[i] - 1;
+    if (strcmp(nt->names[k],name) == 0) return k;
+    i = (i + 1) & (nt->size - 1);
+  }
+  nt->names[nt->count] = name;
+  nt->slots[i] = ++nt->count;
+  return nt->count - 1;
+}
+
+/* AstWriter is the state of one serializeTree walk;
+ * nodes are coded into body while the names are
+ * collected, since the names come first
+ */
+typedef struct
+   { OutBuf * body;
+     NameTable names;
+     int line; /* line of the previous node */
+     unsigned int count;
+   } AstWriter;
+
+static int writeNode(TreeNode * t, int depth, void * arg)
+{ AstWriter * w = (AstWriter *) arg;
+  unsigned char b[MAXNODEBYTES];
+  int kind = t->nodekind == StmtK ? (int) t->kind.stmt : (int) t->kind.exp;
+  int n = 0, i, shape = 0;
+  for (i = 0; i < MAXCHILDREN; i++)
+    if (t->child[i] != NULL) shape |= 1 << i;
+  if (t->sibling != NULL) shape |= 1 << 3;
+  shape |= (t->type & 3) << 4;
+  b[n++] = (unsigned char) (t->nodekind << 5 | kind);
+  b[n++] = (unsigned char) shape;
+  n += putSigned(b+n,t->lineno - w->line);
+  w->line = t->lineno;
+  if (hasName(t->nodekind,kind))
+  { int k = t->attr.name != NULL ? internName(&w->names,t->attr.name) : -1;
+    n += putVarint(b+n,(unsigned int) (k + 1));
+  }
+  else if (kind == OpK)
+    n += putVarint(b+n,(unsigned int) t->attr.op);
+  else if (kind == ConstK)
+    n += putSigned(b+n,t->attr.val);
+  if ((t->nodekind == ExpK) && (kind == ArrK))
+    n += putSigned(b+n,t->arr_size);
+  obWrite(w->body,(const char *) b,n);
+  w->count++;
+  return TRUE;
+}
+
+/* Procedure serializeTree appends the binary form of
+ * the list t to ob; line numbers are coded relative
+ * to lineBase
+ */
+void serializeTree(OutBuf * ob, TreeNode * t, int lineBase)
+{ AstWriter w;
+  TreeVisitor v = { writeNode, NULL, NULL, &w };
+  unsigned char b[MAXNODEBYTES];
+  int i;
+  memset(&w,0,sizeof(w));
+  w.body = newOutBuf(NULL);
+  w.line = lineBase;
+  if (w.body == NULL)
+  { obPuts(listing,"Out of memory error in serializeTree\n");
+    Error = TRUE;
+    return;
+  }
+  walkTree(t,&v);
+  obWrite(ob,AST_MAGIC,AST_MAGICLEN);
+  obPutc(ob,AST_VERSION);
+  obWrite(ob,(const char *) b,putVarint(b,(unsigned int) w.names.count));
+  for (i = 0; i < w.names.count; i++)
+  { size_t len = strlen(w.names.names[i]);
+    obWrite(ob,(const char *) b,putVarint(b,(unsigned int) len));
+    obWrite(ob,w.names.names[i],len);
+  }
+  obWrite(ob,(const char *) b,putVarint(b,w.count));
+  obWrite(ob,w.body->buf,w.body->len);
+  freeOutBuf(w.body);
+  free(w.names.names);
+  free(w.names.slots);
+}
+
+/**************************************************/
+/*****************   Input   **********************/
+/**************************************************/
+
+/* AstReader reads from the bytes p..end */
+typedef struct
+   { const unsigned char * p;
+     const unsigned char * end;
+     int error;
+   } AstReader;
+
+static unsigned int getVarint(AstReader * r)
+{ unsigned int v = 0;
+  int shift = 0;
+  while (r->p < r->end)
+  { unsigned int c = *r->p++;
+    v |= (c & 0x7f) << shift;
+    if (c < 0x80) return v;
+    shift += 7;
+    if (shift > 28) break;
+  }
+  r->error = TRUE;
+  return 0;
+}
+
+static int getSigned(AstReader * r)
+{ unsigned int v = getVarint(r);
+  return (int) (v >> 1) ^ -(int) (v & 1);
+}
+
+/* Function deserializeTree rebuilds a list from the
+ * len bytes at buf, adding lineBase to its line
+ * numbers. *used gets the bytes read. On malformed
+ * input it returns NULL with *error set
+ */
+TreeNode * deserializeTree(const char * buf, size_t len, int lineBase,
+                           size_t * used, int * error)
+{ AstReader r;
+  char ** names = NULL;
+  char * text = NULL;
+  TreeNode * nodes = NULL, * root = NULL;
+  TreeNode *** slots = NULL;
+  unsigned int nnames, nnodes, i;
+  size_t textLen = 0;
+  const unsigned char * start;
+  int top = 0, line = lineBase;
+  r.p = (const unsigned char *) buf;
+  r.end = r.p + len;
+  r.error = FALSE;
+  if ((len < AST_MAGICLEN + 1) || (memcmp(buf,AST_MAGIC,AST_MAGICLEN) != 0) ||
+      (buf[AST_MAGICLEN] != AST_VERSION))
+    goto fail;
+  r.p += AST_MAGICLEN + 1;
+  /* the names: one block for all of their text */
+  nnames = getVarint(&r);
+  if (r.error || (nnames > len)) goto fail;
+  start = r.p;
+  for (i = 0; i < nnames; i++)
+  { unsigned int n = getVarint(&r), k;
+    if (r.error || (n == 0) || (n > (size_t) (r.end - r.p))) goto fail;
+    /* names are tokens: printable, without blanks */
+    for (k = 0; k < n; k++)
+      if ((r.p[k] <= ' ') || (r.p[k] > '~')) goto fail;
+    r.p += n;
+    textLen += n + 1;
+  }
+  names = (char **) malloc((nnames + 1) * sizeof(char *));
+  text = (char *) malloc(textLen + 1);
+  if ((names == NULL) || (text == NULL)) goto fail;
+  r.p = start;
+  for (i = 0, textLen = 0; i < nnames; i++)
+  { unsigned int n = getVarint(&r);
+    names[i] = text + textLen;
+    memcpy(names[i],r.p,n);
+    names[i][n] = '\0';
+    r.p += n;
+    textLen += n + 1;
+  }
+  /* the nodes: one block, filled in preorder; slots
+     holds the links still to be filled, the next
+     one on top */
+  nnodes = getVarint(&r);
+  if (r.error || (nnodes > (size_t) (r.end - r.p) / 3)) goto fail;
+  if (nnodes > 0)
+  { nodes = (TreeNode *) calloc(nnodes,sizeof(TreeNode));
+    slots = (TreeNode ***) malloc((MAXCHILDREN + 1) * (nnodes + 1) * sizeof(TreeNode **));
+    if ((nodes == NULL) || (slots == NULL)) goto fail;
+    slots[top++] = &root;
+  }
+  for (i = 0; i < nnodes; i++)
+  { TreeNode * t = &nodes[i];
+    int kb, shape, kind, k;
+    if ((top == 0) || (r.end - r.p < 3)) goto fail;
+    kb = *r.p++;
+    shape = *r.p++;
+    kind = kb & 31;
+    t->nodekind = (NodeKind) (kb >> 5);
+    if (t->nodekind == StmtK)
+    { if (kind > CompK) goto fail;
+      t->kind.stmt = (StmtKind) kind;
+    }
+    else if (t->nodekind == ExpK)
+    { if (kind > ArrexpK) goto fail;
+      t->kind.exp = (ExpKind) kind;
+    }
+    else goto fail;
+    if ((shape & needsChild(t->nodekind,kind)) != needsChild(t->nodekind,kind))
+      goto fail;
+    line += getSigned(&r);
+    t->lineno = line;
+    t->type = (ExpType) ((shape >> 4) & 3);
+    if (hasName(t->nodekind,kind))
+    { unsigned int n = getVarint(&r);
+      if ((n > nnames) || ((n == 0) && needsName(t->nodekind,kind)))
+        goto fail;
+      t->attr.name = n > 0 ? names[n-1] : NULL;
+    }
+    else if (kind == OpK)
+      t->attr.op = (TokenType) getVarint(&r);
+    else if (kind == ConstK)
+      t->attr.val = getSigned(&r);
+    if ((t->nodekind == ExpK) && (kind == ArrK))
+      t->arr_size = getSigned(&r);
+    if (r.error) goto fail;
+    *slots[--top] = t;
+    /* children first, then the sibling */
+    if (shape & (1 << 3)) slots[top++] = &t->sibling;
+    for (k = MAXCHILDREN - 1; k >= 0; k--)
+      if (shape & (1 << k)) slots[top++] = &t->child[k];
+  }
+  if (top != 0) goto fail;
+  free(slots);
+  free(names); /* the text block stays with the tree */
+  if (nnodes == 0) free(text);
+  *used = (size_t) (r.p - (const unsigned char *) buf);
+  *error = FALSE;
+  return root;
+fail:
+  free(slots);
+  free(nodes);
+  free(names);
+  free(text);
+  *used = 0;
+  *error = TRUE;
+  return NULL;
+}
+
+/* Function writeTreeFile writes the list t to the
+ * file path; it returns FALSE if that fails
+ */
+int writeTreeFile(const char * path, TreeNode * t)
+{ FILE * f = fopen(path,"wb");
+  OutBuf * ob;
+  int ok;
+  if (f == NULL) return FALSE;
+  ob = newOutBuf(f);
+  if (ob == NULL)
+  { fclose(f);
+    return FALSE;
+  }
+  serializeTree(ob,t,0);
+  freeOutBuf(ob);
+  ok = ! ferror(f);
+  return (fclose(f) == 0) && ok;
+}
+
+/* Function readTreeFile reads a list written by
+ * writeTreeFile; it returns NULL with *error set if
+ * the file is missing or malformed
+ */
+TreeNode * readTreeFile(const char * path, int * error)
+{ FILE * f = fopen(path,"rb");
+  TreeNode * t = NULL;
+  char * buf = NULL;
+  size_t used;
+  long len;
+  *error = TRUE;
+  if (f == NULL) return NULL;
+  if ((fseek(f,0,SEEK_END) == 0) && ((len = ftell(f)) >= 0) &&
+      (fseek(f,0,SEEK_SET) == 0) &&
+      ((buf = (char *) malloc(len + 1)) != NULL) &&
+      (fread(buf,1,len,f) == (size_t) len))
+  { t = deserializeTree(buf,len,0,&used,error);
+    if (! *error && (used != (size_t) len))
+      *error = TRUE;
+  }
+  free(buf);
+  fclose(f);
+  return *error ? NULL : t;
+}
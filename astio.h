@@ -0,0 +1,60 @@
+/****************************************************/
+/* File: astio.h                                    */
+/* Binary serialization of syntax trees for the     */
+/* C- compiler                                      */
+/****************************************************/
+
+#ifndef _ASTIO_H_
+#define _ASTIO_H_
+
+/* The binary form of a sibling list and its subtrees:
+ *
+ *   "CAST" <version byte>
+ *   <names> { <len> <bytes> }     interned, first use first
+ *   <nodes> { node }              in walkTree preorder
+ *
+ * where a node is
+ *
+ *   <nodekind<<5 | kind> <shape> <line delta> [attr] [arr_size]
+ *
+ * shape has bit i set if child[i] is not NULL, bit 3
+ * if sibling is not NULL and the ExpType in bits 4-5;
+ * the line delta is from the previous node (the first
+ * from the lineBase given). attr is a name index + 1
+ * (0: NULL) for nodes with a name, the operator for
+ * OpK and the value for ConstK; arr_size is present
+ * for ArrK only. Numbers are LEB128 varints, signed
+ * ones zigzag coded. The symbols bound by the
+ * analyzer (sym) are not kept.
+ */
+
+#define AST_VERSION 1
+
+/* Procedure serializeTree appends the binary form of
+ * the list t to ob; line numbers are coded relative
+ * to lineBase
+ */
+void serializeTree(OutBuf * ob, TreeNode * t, int lineBase);
+
+/* Function deserializeTree rebuilds a list from the
+ * len bytes at buf, adding lineBase to its line
+ * numbers. *used gets the bytes read. On malformed
+ * input it returns NULL with *error set. The nodes
+ * share one allocation and the names another, so
+ * the tree cannot be freed node by node
+ */
+TreeNode * deserializeTree(const char * buf, size_t len, int lineBase,
+                           size_t * used, int * error);
+
+/* Function writeTreeFile writes the list t to the
+ * file path; it returns FALSE if that fails
+ */
+int writeTreeFile(const char * path, TreeNode * t);
+
+/* Function readTreeFile reads a list written by
+ * writeTreeFile; it returns NULL with *error set if
+ * the file is missing or malformed
+ */
+TreeNode * readTreeFile(const char * path, int * error);
+
+#endif
@@ -0,0 +1,281 @@
+/****************************************************/
+/* File: astpool.c                                  */
+/* Compact syntax tree storage for the TINY         */
+/* compiler                                         */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "astpool.h"
+
+/* POOLINIT is the initial capacity of a pool and
+ * of the stacks used to walk or copy a tree
+ */
+#define POOLINIT 1024
+
+/* growArray resizes *a to hold cap elements of
+ * size bytes; it returns FALSE on failure
+ */
+static int growArray(void ** a, size_t cap, size_t size)
+{ void * bigger = realloc(*a,cap * size);
+  if (bigger == NULL) return FALSE;
+  *a = bigger;
+  return TRUE;
+}
+
+static int poolGrow(NodePool * p)
+{ NodeId cap = p->cap ? 2 * p->cap : POOLINIT;
+  if (!growArray((void **) &p->links,cap,sizeof(NodeLinks)) ||
+      !growArray((void **) &p->kind,cap,sizeof(unsigned char)) ||
+      !growArray((void **) &p->lineno,cap,sizeof(int)) ||
+      !growArray((void **) &p->type,cap,sizeof(unsigned char)) ||
+      !growArray((void **) &p->attr,cap,sizeof(NodeAttr)) ||
+      !growArray((void **) &p->arr_size,cap,sizeof(int)))
+    return FALSE;
+  p->cap = cap;
+  return TRUE;
+}
+
+/* Function newNodePool creates an empty pool */
+NodePool * newNodePool(void)
+{ NodePool * p = (NodePool *) calloc(1,sizeof(NodePool));
+  if (p == NULL) return NULL;
+  if (!poolGrow(p))
+  { freeNodePool(p);
+    return NULL;
+  }
+  /* slot 0 is NO_NODE */
+  memset(&p->links[0],0,sizeof(NodeLinks));
+  p->count = 1;
+  return p;
+}
+
+/* Procedure freeNodePool releases a pool and its
+ * arrays (the names are not freed)
+ */
+void freeNodePool(NodePool * p)
+{ if (p == NULL) return;
+  free(p->links);
+  free(p->kind);
+  free(p->lineno);
+  free(p->type);
+  free(p->attr);
+  free(p->arr_size);
+  free(p);
+}
+
+/* Function poolBytes returns the memory held by
+ * the nodes in use
+ */
+size_t poolBytes(NodePool * p)
+{ return (size_t) p->count *
+    (sizeof(NodeLinks) + 2 * sizeof(unsigned char) + 2 * sizeof(int) +
+     sizeof(NodeAttr));
+}
+
+/* Function poolNewNode appends a node with no
+ * children and returns its index, or NO_NODE if
+ * memory runs out
+ */
+NodeId poolNewNode(NodePool * p, NodeKind nodekind, int kind, int lineno)
+{ NodeId n;
+  if (p->count == p->cap && !poolGrow(p)) return NO_NODE;
+  n = p->count++;
+  memset(&p->links[n],0,sizeof(NodeLinks));
+  p->kind[n] = (unsigned char) (nodekind << 5 | kind);
+  p->lineno[n] = lineno;
+  p->type[n] = Void;
+  p->attr[n].val = 0;
+  p->arr_size[n] = 0;
+  return n;
+}
+
+/* a node still to be copied and the parent whose
+ * link must point at the copy: child[slot], or
+ * sibling when slot is MAXCHILDREN (-1 for the root).
+ * Copying into the pool, tree is the node and id the
+ * parent; copying out of it, the other way round
+ */
+typedef struct
+   { TreeNode * tree;
+     NodeId id;
+     int slot;
+   } CopyWork;
+
+/* pushRoom makes room for MAXCHILDREN+1 more entries
+ * on the copy stack; it returns FALSE on failure
+ */
+static int pushRoom(CopyWork ** stack, int * size, int top)
+{ if (top + 1 + MAXCHILDREN + 1 <= *size) return TRUE;
+  if (!growArray((void **) stack,2 * *size,sizeof(CopyWork)))
+    return FALSE;
+  *size *= 2;
+  return TRUE;
+}
+
+/* Function poolFromTree copies the sibling list t
+ * and its subtrees into p in preorder
+ */
+NodeId poolFromTree(NodePool * p, TreeNode * t)
+{ CopyWork * stack;
+  int size = POOLINIT;
+  int top = 0;
+  NodeId root = NO_NODE;
+  if (t == NULL) return NO_NODE;
+  stack = (CopyWork *) malloc(size * sizeof(CopyWork));
+  if (stack == NULL) return NO_NODE;
+  stack[0].tree = t;
+  stack[0].id = NO_NODE;
+  stack[0].slot = -1;
+  while (top >= 0)
+  { CopyWork w = stack[top--];
+    TreeNode * s = w.tree;
+    NodeId n;
+    int i;
+    n = poolNewNode(p,s->nodekind,
+          s->nodekind == StmtK ? (int) s->kind.stmt : (int) s->kind.exp,
+          s->lineno);
+    if (n == NO_NODE || !pushRoom(&stack,&size,top))
+    { root = NO_NODE;
+      break;
+    }
+    p->type[n] = (unsigned char) s->type;
+    p->attr[n].name = s->attr.name; /* widest member */
+    p->arr_size[n] = s->arr_size;
+    if (w.slot < 0) root = n;
+    else if (w.slot == MAXCHILDREN) p->links[w.id].sibling = n;
+    else p->links[w.id].child[w.slot] = n;
+    /* push the sibling first so that child[0] comes next */
+    if (s->sibling != NULL)
+    { ++top;
+      stack[top].tree = s->sibling;
+      stack[top].id = n;
+      stack[top].slot = MAXCHILDREN;
+    }
+    for (i = MAXCHILDREN-1; i >= 0; i--)
+      if (s->child[i] != NULL)
+      { ++top;
+        stack[top].tree = s->child[i];
+        stack[top].id = n;
+        stack[top].slot = i;
+      }
+  }
+  free(stack);
+  return root;
+}
+
+/* Function poolToTree rebuilds the TreeNode form
+ * of the list starting at n
+ */
+TreeNode * poolToTree(NodePool * p, NodeId n)
+{ CopyWork * stack;
+  int size = POOLINIT;
+  int top = 0;
+  TreeNode * root = NULL;
+  if (n == NO_NODE) return NULL;
+  stack = (CopyWork *) malloc(size * sizeof(CopyWork));
+  if (stack == NULL) return NULL;
+  stack[0].tree = NULL;
+  stack[0].id = n;
+  stack[0].slot = -1;
+  while (top >= 0)
+  { CopyWork w = stack[top--];
+    NodeId s = w.id;
+    TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
+    int i;
+    if (t == NULL || !pushRoom(&stack,&size,top))
+    { obPuts(listing,"Out of memory error in poolToTree\n");
+      free(t);
+      root = NULL;
+      break;
+    }
+    for (i = 0; i < MAXCHILDREN; i++) t->child[i] = NULL;
+    t->sibling = NULL;
+    t->lineno = p->lineno[s];
+    t->nodekind = POOL_NODEKIND(p,s);
+    if (t->nodekind == StmtK) t->kind.stmt = (StmtKind) POOL_KIND(p,s);
+    else t->kind.exp = (ExpKind) POOL_KIND(p,s);
+    t->attr.name = p->attr[s].name;
+    t->type = (ExpType) p->type[s];
+    t->arr_size = p->arr_size[s];
+    t->sym = NULL; /* the pool keeps parse results only */
+    t->need = t->effects = 0;
+    if (w.slot < 0) root = t;
+    else if (w.slot == MAXCHILDREN) w.tree->sibling = t;
+    else w.tree->child[w.slot] = t;
+    if (p->links[s].sibling != NO_NODE)
+    { ++top;
+      stack[top].id = p->links[s].sibling;
+      stack[top].tree = t;
+      stack[top].slot = MAXCHILDREN;
+    }
+    for (i = MAXCHILDREN-1; i >= 0; i--)
+      if (p->links[s].child[i] != NO_NODE)
+      { ++top;
+        stack[top].id = p->links[s].child[i];
+        stack[top].tree = t;
+        stack[top].slot = i;
+      }
+  }
+  free(stack);
+  return root;
+}
+
+/* a node on the path from the root whose children
+ * are being visited, as in walkTree
+ */
+typedef struct
+   { NodeId node;
+     int next;
+     int done;
+   } PoolFrame;
+
+/* Procedure walkPool visits the list starting at n
+ * in the order walkTree visits its TreeNode form
+ */
+void walkPool(NodePool * p, NodeId n, PoolVisitor * v)
+{ PoolFrame * stack;
+  int size = POOLINIT;
+  int top = -1;
+  stack = (PoolFrame *) malloc(size * sizeof(PoolFrame));
+  if (stack == NULL)
+  { obPuts(listing,"Out of memory error in walkPool\n");
+    Error = TRUE;
+    return;
+  }
+  for (;;)
+  { if (n != NO_NODE)
+    { int descend = TRUE;
+      if (v->preProc != NULL) descend = v->preProc(p,n,top+1,v->arg);
+      if (top+1 == size)
+      { if (!growArray((void **) &stack,2 * size,sizeof(PoolFrame)))
+        { obPuts(listing,"Out of memory error in walkPool\n");
+          Error = TRUE;
+          break;
+        }
+        size *= 2;
+      }
+      ++top;
+      stack[top].node = n;
+      stack[top].next = stack[top].done = descend ? 0 : MAXCHILDREN;
+      n = NO_NODE;
+    }
+    else if (top < 0) break;
+    else
+    { PoolFrame * f = &stack[top];
+      if (f->done < f->next)
+      { if (v->childProc != NULL) v->childProc(p,f->node,f->done,v->arg);
+        f->done++;
+      }
+      else if (f->next < MAXCHILDREN)
+        n = p->links[f->node].child[f->next++];
+      else
+      { NodeId node = f->node;
+        --top;
+        if (v->postProc != NULL) v->postProc(p,node,top+1,v->arg);
+        n = p->links[node].sibling;
+      }
+    }
+  }
+  free(stack);
+}
@@ -0,0 +1,99 @@
+/****************************************************/
+/* File: astpool.h                                  */
+/* Compact syntax tree storage for the TINY         */
+/* compiler: nodes live in one pool and refer to    */
+/* each other by 32-bit index                       */
+/****************************************************/
+
+#ifndef _ASTPOOL_H_
+#define _ASTPOOL_H_
+
+/* NodeId names a node of a NodePool; index 0 is
+ * never handed out, so NO_NODE plays the part of
+ * a NULL TreeNode pointer
+ */
+typedef unsigned int NodeId;
+#define NO_NODE 0
+
+/* NodeLinks holds the tree structure of one node,
+ * the only fields a traversal has to read
+ */
+typedef struct
+   { NodeId child[MAXCHILDREN];
+     NodeId sibling;
+   } NodeLinks;
+
+typedef union
+   { TokenType op;
+     int val;
+     char * name;
+   } NodeAttr;
+
+/* NodePool keeps each field of the nodes in an
+ * array of its own. The hot arrays (links, kind)
+ * are packed tightly so walks touch few cache
+ * lines; the cold ones are read only by the passes
+ * that need them. Names are shared, not copied
+ */
+typedef struct
+   { NodeId count; /* nodes in use, including slot 0 */
+     NodeId cap; /* nodes allocated */
+     /* hot */
+     NodeLinks * links;
+     unsigned char * kind; /* nodekind<<5 | stmt or exp kind */
+     /* cold */
+     int * lineno;
+     unsigned char * type; /* ExpType */
+     NodeAttr * attr;
+     int * arr_size;
+   } NodePool;
+
+#define POOL_NODEKIND(p,n) ((NodeKind) ((p)->kind[n] >> 5))
+#define POOL_KIND(p,n) ((p)->kind[n] & 31)
+
+/* Function newNodePool creates an empty pool */
+NodePool * newNodePool(void);
+
+/* Procedure freeNodePool releases a pool and its
+ * arrays (the names are not freed)
+ */
+void freeNodePool(NodePool * p);
+
+/* Function poolBytes returns the memory held by
+ * the nodes in use
+ */
+size_t poolBytes(NodePool * p);
+
+/* Function poolNewNode appends a node with no
+ * children and returns its index, or NO_NODE if
+ * memory runs out
+ */
+NodeId poolNewNode(NodePool * p, NodeKind nodekind, int kind, int lineno);
+
+/* Function poolFromTree copies the sibling list t
+ * and its subtrees into p in preorder, so that a
+ * walk reads the arrays front to back; it returns
+ * the index of the first node
+ */
+NodeId poolFromTree(NodePool * p, TreeNode * t);
+
+/* Function poolToTree rebuilds the TreeNode form
+ * of the list starting at n, for the passes that
+ * still work on pointers
+ */
+TreeNode * poolToTree(NodePool * p, NodeId n);
+
+/* PoolVisitor is the TreeVisitor of a pool walk */
+typedef struct
+   { int (* preProc) (NodePool * p, NodeId n, int depth, void * arg);
+     void (* childProc) (NodePool * p, NodeId n, int i, void * arg);
+     void (* postProc) (NodePool * p, NodeId n, int depth, void * arg);
+     void * arg;
+   } PoolVisitor;
+
+/* Procedure walkPool visits the list starting at n
+ * in the order walkTree visits its TreeNode form
+ */
+void walkPool(NodePool * p, NodeId n, PoolVisitor * v);
+
+#endif
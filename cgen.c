@@ -1,7 +1,7 @@
 /****************************************************/
 /* File: cgen.c                                     */
 /* The code generator implementation                */
-/* for the TINY compiler                            */
+/* for the C- compiler                              */
 /* (generates code for the TM machine)              */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
@@ -11,6 +11,19 @@
 #include "symtab.h"
 #include "code.h"
 #include "cgen.h"
+#include "traverse.h"
+#include "ir.h"
+#include "lvn.h"
+#include "stats.h"
+
+/* Each function is generated into its own code
+ * fragment, at locations relative to 0, and
+ * linkProgram places the fragments after the
+ * prelude. Calls and global variables are
+ * relocated by name, so a fragment does not
+ * depend on the layout of the rest of the program.
+ * The frame layout is described in analyze.c.
+ */
 
 /* tmpOffset is the memory offset for temps
    It is decremented each time a temp is
@@ -18,86 +31,411 @@
 */
 static int tmpOffset = 0;
 
-/* prototype for internal recursive code generator */
-static void cGen (TreeNode * tree);
+/* savedLocs holds the code locations still to be
+ * backpatched by the enclosing if and while
+ * statements, innermost last
+ */
+static int * savedLocs = NULL;
+static int savedTop = 0;
+static int savedSize = 0;
 
-/* Procedure genStmt generates code at a statement node */
-static void genStmt( TreeNode * tree)
-{ TreeNode * p1, * p2, * p3;
-  int savedLoc1,savedLoc2,currentLoc;
-  int loc;
-  switch (tree->kind.stmt) {
+static void pushLoc( int loc )
+{ if (savedTop == savedSize)
+  { int * bigger;
+    int size = savedSize ? 2*savedSize : 64;
+    bigger = (int *) realloc(savedLocs,size * sizeof(int));
+    if (bigger == NULL)
+    { obPuts(listing,"Out of memory error in code generator\n");
+      Error = TRUE;
+      return;
+    }
+    savedLocs = bigger;
+    savedSize = size;
+  }
+  savedLocs[savedTop++] = loc;
+}
+
+static int popLoc( void )
+{ return savedTop > 0 ? savedLocs[--savedTop] : 0;
+}
+
+/* CallSite is a call whose arguments are being
+ * evaluated: base is the tmpOffset where the new
+ * frame starts, depth the depth of the call node
+ * and arg the number of the next argument
+ */
+typedef struct
+   { int base;
+     int depth;
+     int arg;
+   } CallSite;
+
+static CallSite * calls = NULL;
+static int callTop = 0;
+static int callSize = 0;
+
+static void pushCall( int base, int depth )
+{ if (callTop == callSize)
+  { CallSite * bigger;
+    int size = callSize ? 2*callSize : 16;
+    bigger = (CallSite *) realloc(calls,size * sizeof(CallSite));
+    if (bigger == NULL)
+    { obPuts(listing,"Out of memory error in code generator\n");
+      Error = TRUE;
+      return;
+    }
+    calls = bigger;
+    callSize = size;
+  }
+  calls[callTop].base = base;
+  calls[callTop].depth = depth;
+  calls[callTop].arg = 0;
+  callTop++;
+}
+
+/* The operands of an operation are evaluated in
+ * the order of Sethi and Ullman: labelNode gives
+ * every expression the number of registers it
+ * needs (need) and what it touches (effects), and
+ * the operand that needs more goes first. A
+ * constant or scalar operand is not evaluated
+ * until the other one is done, and is then loaded
+ * straight into ac1; else the first result waits
+ * in one of the registers FIRSTTEMP to LASTTEMP,
+ * or on the stack at tmpOffset if none is free or
+ * the second operand calls a function, whose code
+ * uses the same registers. Operands trade places
+ * only when neither can change what the other
+ * reads.
+ */
+#define FIRSTTEMP 2
+#define LASTTEMP 4
+
+/* a function uses all registers */
+#define CALLNEED 100
+
+/* the bits of effects */
+#define READS 1 /* reads variables or arrays */
+#define WRITES 2 /* assigns, reads input or calls */
+#define CALLS 4 /* calls a function */
+
+/* nextTemp is the next free register of FIRSTTEMP
+ * to LASTTEMP
+ */
+static int nextTemp = FIRSTTEMP;
+
+/* labelNode is the postorder visitor that sets
+ * need and effects of the expressions
+ */
+static void labelNode( TreeNode * t, int depth, void * arg)
+{ TreeNode * c;
+  int i, need = 0, effects = 0;
+  if ((t->nodekind == StmtK) && (t->kind.stmt != AssignK) &&
+      (t->kind.stmt != AssignKarr) && (t->kind.stmt != CallK))
+    return;
+  for (i = 0; i < MAXCHILDREN; i++)
+    for (c = t->child[i]; c != NULL; c = c->sibling)
+    { effects |= c->effects;
+      if (c->need > need) need = c->need;
+    }
+  if (t->nodekind == StmtK)
+  { effects |= WRITES;
+    if ((t->kind.stmt == CallK) && (t->sym->decl != NULL))
+    { effects |= CALLS;
+      need = CALLNEED;
+    }
+    else if (need < 2) need = 2;
+  }
+  else switch (t->kind.exp)
+  { case ConstK :
+      need = 1;
+      break;
+    case IdK :
+      need = 1;
+      effects |= READS;
+      break;
+    case OpK :
+      if (t->child[0]->need == t->child[1]->need) need++;
+      break;
+    case ArrexpK :
+      if (need < 2) need = 2;
+      effects |= READS;
+      break;
+    default :
+      break;
+  }
+  t->need = need;
+  t->effects = effects;
+}
+
+/* isLeaf tells whether expression t is loaded by
+ * one instruction
+ */
+static int isLeaf( TreeNode * t )
+{ return (t->kind.exp == ConstK) ||
+         ((t->kind.exp == IdK) && (t->sym->kind == VarSym));
+}
+
+/* mayReorder tells whether expressions a and b
+ * can be evaluated in either order
+ */
+static int mayReorder( TreeNode * a, TreeNode * b)
+{ return ! ((a->effects & WRITES) && b->effects) &&
+         ! ((b->effects & WRITES) && a->effects);
+}
+
+/* OpSite is an operation whose operands are being
+ * evaluated: leaf is the operand left for ac1, if
+ * any, swapped tells whether the right operand
+ * goes first, and reg holds the first result (-1:
+ * the stack)
+ */
+typedef struct
+   { TreeNode * leaf;
+     int swapped;
+     int reg;
+   } OpSite;
+
+static OpSite * ops = NULL;
+static int opTop = 0;
+static int opSize = 0;
+
+/* Procedure orderOperands chooses the order of the
+ * operands of operation t, rearranging its
+ * children until popOperands
+ */
+static void orderOperands( TreeNode * t )
+{ TreeNode * l = t->child[0], * r = t->child[1];
+  OpSite s = { NULL, FALSE, -1 };
+  if (opTop == opSize)
+  { OpSite * bigger;
+    int size = opSize ? 2*opSize : 16;
+    bigger = (OpSite *) realloc(ops,size * sizeof(OpSite));
+    if (bigger == NULL)
+    { obPuts(listing,"Out of memory error in code generator\n");
+      Error = TRUE;
+      return;
+    }
+    ops = bigger;
+    opSize = size;
+  }
+  if (isLeaf(r))
+    s.leaf = r;
+  else if (isLeaf(l) && mayReorder(l,r))
+  { s.leaf = l;
+    s.swapped = TRUE;
+  }
+  else if ((r->need > l->need) && mayReorder(l,r))
+    s.swapped = TRUE;
+  if (s.swapped)
+  { t->child[0] = r;
+    t->child[1] = l;
+  }
+  if (s.leaf != NULL)
+  { t->child[1] = NULL;
+    if (Stats != NULL) Stats->spillsAvoided++;
+  }
+  ops[opTop++] = s;
+}
+
+/* Function popOperands puts back the children of
+ * operation t and returns its site
+ */
+static OpSite popOperands( TreeNode * t )
+{ OpSite s = ops[--opTop];
+  if (s.leaf != NULL) t->child[1] = s.leaf;
+  if (s.swapped)
+  { TreeNode * c = t->child[0];
+    t->child[0] = t->child[1];
+    t->child[1] = c;
+  }
+  return s;
+}
+
+/* emitVar emits op on register r and variable s:
+ * globals are relocated, locals are mp-relative
+ */
+static void emitVar( char * op, int r, Symbol * s, char * c)
+{ if (s->level == 0)
+    emitRM_Sym(op,r,0,gp,s->name,c);
+  else
+    emitRM(op,r,s->loc,mp,c);
+}
+
+/* loadBase loads the address of element 0 of
+ * array s into register r
+ */
+static void loadBase( int r, Symbol * s)
+{ if (s->kind == ArrayParamSym)
+    emitRM("LD",r,s->loc,mp,"load array address");
+  else
+    emitVar("LDA",r,s,"load array address");
+}
+
+/* emitReturn emits the return sequence: the value,
+ * if any, stays in ac
+ */
+static void emitReturn(void)
+{ emitRM("LD",ac1,-1,mp,"return: load return address");
+  emitRM("LD",mp,0,mp,"return: pop frame");
+  emitRM("LDA",pc,0,ac1,"return");
+}
+
+/* Procedure genStmtPre generates code on entering
+ * a statement node; it returns FALSE if the
+ * children of the node generate no code
+ */
+static int genStmtPre( TreeNode * tree, int depth)
+{ switch (tree->kind.stmt) {
 
       case IfK :
          if (TraceCode) emitComment("-> if") ;
-         p1 = tree->child[0] ;
-         p2 = tree->child[1] ;
-         p3 = tree->child[2] ;
-         /* generate code for test expression */
-         cGen(p1);
-         savedLoc1 = emitSkip(1) ;
-         emitComment("if: jump to else belongs here");
-         /* recurse on then part */
-         cGen(p2);
-         savedLoc2 = emitSkip(1) ;
-         emitComment("if: jump to end belongs here");
-         currentLoc = emitSkip(0) ;
-         emitBackup(savedLoc1) ;
-         emitRM_Abs("JEQ",ac,currentLoc,"if: jmp to else");
-         emitRestore() ;
-         /* recurse on else part */
-         cGen(p3);
+         return TRUE;
+
+      case RepeatK:
+         if (TraceCode) emitComment("-> while") ;
+         pushLoc(emitSkip(0));
+         emitComment("while: jump after body comes back here");
+         return TRUE;
+
+      case AssignK:
+      case AssignKarr:
+         if (TraceCode) emitComment("-> assign") ;
+         return TRUE;
+
+      case CallK:
+         if (TraceCode) emitComment("-> call") ;
+         pushCall(tmpOffset,depth);
+         tmpOffset -= 2 + tree->sym->size;
+         return TRUE;
+
+      case ReturnK:
+      case CompK:
+         return TRUE;
+
+      default:
+         return FALSE;
+    }
+} /* genStmtPre */
+
+/* Procedure genStmtChild generates the code that
+ * follows child i of a statement node
+ */
+static void genStmtChild( TreeNode * tree, int i)
+{ int savedLoc2,currentLoc;
+  switch (tree->kind.stmt) {
+
+      case IfK :
+         if (i == 0)
+         { /* after the test expression */
+           pushLoc(emitSkip(1));
+           emitComment("if: jump to else belongs here");
+         }
+         else if (i == 1)
+         { /* after the then part */
+           savedLoc2 = emitSkip(1) ;
+           emitComment("if: jump to end belongs here");
+           currentLoc = emitSkip(0) ;
+           emitBackup(popLoc()) ;
+           emitRM_Abs("JEQ",ac,currentLoc,"if: jmp to else");
+           emitRestore() ;
+           pushLoc(savedLoc2);
+         }
+         break;
+
+      case RepeatK:
+         if (i == 0)
+         { /* after the test expression */
+           pushLoc(emitSkip(1));
+           emitComment("while: jump to end belongs here");
+         }
+         break;
+
+      case AssignKarr:
+         if (i == 0)
+           /* keep the value while the index is computed */
+           emitRM("ST",ac,tmpOffset--,mp,"assign: push value");
+         break;
+
+      default:
+         break;
+    }
+} /* genStmtChild */
+
+/* Procedure genStmtPost generates code on leaving
+ * a statement node, after all of its children
+ */
+static void genStmtPost( TreeNode * tree)
+{ int currentLoc;
+  int base;
+  switch (tree->kind.stmt) {
+
+      case IfK :
          currentLoc = emitSkip(0) ;
-         emitBackup(savedLoc2) ;
+         emitBackup(popLoc()) ;
          emitRM_Abs("LDA",pc,currentLoc,"jmp to end") ;
          emitRestore() ;
          if (TraceCode)  emitComment("<- if") ;
          break; /* if_k */
 
       case RepeatK:
-         if (TraceCode) emitComment("-> repeat") ;
-         p1 = tree->child[0] ;
-         p2 = tree->child[1] ;
-         savedLoc1 = emitSkip(0);
-         emitComment("repeat: jump after body comes back here");
-         /* generate code for body */
-         cGen(p1);
-         /* generate code for test */
-         cGen(p2);
-         emitRM_Abs("JEQ",ac,savedLoc1,"repeat: jmp back to body");
-         if (TraceCode)  emitComment("<- repeat") ;
+         currentLoc = popLoc();
+         emitRM_Abs("LDA",pc,popLoc(),"while: jmp back to test");
+         base = emitSkip(0);
+         emitBackup(currentLoc);
+         emitRM_Abs("JEQ",ac,base,"while: jmp to end");
+         emitRestore();
+         if (TraceCode)  emitComment("<- while") ;
          break; /* repeat */
 
       case AssignK:
-         if (TraceCode) emitComment("-> assign") ;
-         /* generate code for rhs */
-         cGen(tree->child[0]);
          /* now store value */
-         loc = st_lookup(tree->attr.name);
-         emitRM("ST",ac,loc,gp,"assign: store value");
+         emitVar("ST",ac,tree->sym,"assign: store value");
          if (TraceCode)  emitComment("<- assign") ;
          break; /* assign_k */
 
-      case ReadK:
-         emitRO("IN",ac,0,0,"read integer value");
-         loc = st_lookup(tree->attr.name);
-         emitRM("ST",ac,loc,gp,"read: store value");
+      case AssignKarr:
+         loadBase(ac1,tree->sym);
+         emitRO("ADD",ac1,ac1,ac,"assign: element address");
+         emitRM("LD",ac,++tmpOffset,mp,"assign: load value");
+         emitRM("ST",ac,0,ac1,"assign: store value");
+         if (TraceCode)  emitComment("<- assign") ;
          break;
-      case WriteK:
-         /* generate code for expression to write */
-         cGen(tree->child[0]);
-         /* now output it */
-         emitRO("OUT",ac,0,0,"write ac");
+
+      case CallK:
+         base = calls[--callTop].base;
+         if (tree->sym->decl == NULL)
+         { /* built in: input() or output(x) */
+           if (tree->sym->size == 0)
+             emitRO("IN",ac,0,0,"read integer value");
+           else
+             emitRO("OUT",ac,0,0,"write ac");
+         }
+         else
+         { emitRM("ST",mp,base,mp,"call: store control link");
+           emitRM("LDA",mp,base,mp,"call: push frame");
+           emitRM("LDA",ac,1,pc,"call: return address");
+           emitRM_Sym("LDC",pc,0,0,tree->attr.name,"call");
+         }
+         tmpOffset = base;
+         if (TraceCode)  emitComment("<- call") ;
+         break;
+
+      case ReturnK:
+         emitReturn();
          break;
+
       default:
          break;
     }
-} /* genStmt */
+} /* genStmtPost */
 
-/* Procedure genExp generates code at an expression node */
-static void genExp( TreeNode * tree)
-{ int loc;
-  TreeNode * p1, * p2;
+/* Procedure genExpPre generates code on entering
+ * an expression node; it returns FALSE if the
+ * children of the node generate no code
+ */
+static int genExpPre( TreeNode * tree)
+{ char buffer[80];
   switch (tree->kind.exp) {
 
     case ConstK :
@@ -105,83 +443,276 @@ static void genExp( TreeNode * tree)
       /* gen code to load integer constant using LDC */
       emitRM("LDC",ac,tree->attr.val,0,"load const");
       if (TraceCode)  emitComment("<- Const") ;
-      break; /* ConstK */
+      return FALSE; /* ConstK */
     
     case IdK :
       if (TraceCode) emitComment("-> Id") ;
-      loc = st_lookup(tree->attr.name);
-      emitRM("LD",ac,loc,gp,"load id value");
+      if (tree->sym->kind == VarSym)
+        emitVar("LD",ac,tree->sym,"load id value");
+      else /* an array passed as an argument */
+        loadBase(ac,tree->sym);
       if (TraceCode)  emitComment("<- Id") ;
-      break; /* IdK */
+      return FALSE; /* IdK */
 
     case OpK :
-         if (TraceCode) emitComment("-> Op") ;
-         p1 = tree->child[0];
-         p2 = tree->child[1];
-         /* gen code for ac = left arg */
-         cGen(p1);
-         /* gen code to push left operand */
-         emitRM("ST",ac,tmpOffset--,mp,"op: push left");
-         /* gen code for ac = right operand */
-         cGen(p2);
-         /* now load left operand */
-         emitRM("LD",ac1,++tmpOffset,mp,"op: load left");
-         switch (tree->attr.op) {
-            case PLUS :
-               emitRO("ADD",ac,ac1,ac,"op +");
-               break;
-            case MINUS :
-               emitRO("SUB",ac,ac1,ac,"op -");
-               break;
-            case TIMES :
-               emitRO("MUL",ac,ac1,ac,"op *");
-               break;
-            case OVER :
-               emitRO("DIV",ac,ac1,ac,"op /");
-               break;
-            case LT :
-               emitRO("SUB",ac,ac1,ac,"op <") ;
-               emitRM("JLT",ac,2,pc,"br if true") ;
-               emitRM("LDC",ac,0,ac,"false case") ;
-               emitRM("LDA",pc,1,pc,"unconditional jmp") ;
-               emitRM("LDC",ac,1,ac,"true case") ;
-               break;
-            case EQ :
-               emitRO("SUB",ac,ac1,ac,"op ==") ;
-               emitRM("JEQ",ac,2,pc,"br if true");
-               emitRM("LDC",ac,0,ac,"false case") ;
-               emitRM("LDA",pc,1,pc,"unconditional jmp") ;
-               emitRM("LDC",ac,1,ac,"true case") ;
-               break;
-            default:
-               emitComment("BUG: Unknown operator");
-               break;
-         } /* case op */
-         if (TraceCode)  emitComment("<- Op") ;
-         break; /* OpK */
+      if (TraceCode) emitComment("-> Op") ;
+      orderOperands(tree);
+      return TRUE;
+
+    case ArrexpK :
+      if (TraceCode) emitComment("-> Array element") ;
+      return TRUE;
+
+    case FuncK :
+      if (TraceCode)
+      { snprintf(buffer,sizeof(buffer),"-> function %s",tree->attr.name);
+        emitComment(buffer);
+      }
+      tmpOffset = -tree->sym->frame;
+      emitRM("ST",ac,-1,mp,"store return address");
+      return TRUE;
 
     default:
-      break;
+      return FALSE;
   }
-} /* genExp */
+} /* genExpPre */
 
-/* Procedure cGen recursively generates code by
- * tree traversal
+/* Procedure genExpChild generates the code that
+ * follows child i of an expression node
  */
-static void cGen( TreeNode * tree)
-{ if (tree != NULL)
-  { switch (tree->nodekind) {
-      case StmtK:
-        genStmt(tree);
+static void genExpChild( TreeNode * tree, int i)
+{ OpSite * s;
+  if ((tree->kind.exp != OpK) || (i != 0)) return;
+  s = &ops[opTop-1];
+  if (s->leaf != NULL) return;
+  if ((nextTemp <= LASTTEMP) && ! (tree->child[1]->effects & CALLS))
+  { /* keep the first operand in a register */
+    s->reg = nextTemp++;
+    emitRM("LDA",s->reg,0,ac,"op: keep operand");
+    if (Stats != NULL) Stats->spillsAvoided++;
+  }
+  else
+  { /* gen code to push it */
+    emitRM("ST",ac,tmpOffset--,mp,s->swapped ? "op: push right" : "op: push left");
+    if (Stats != NULL) Stats->spills++;
+  }
+} /* genExpChild */
+
+/* Procedure genExpPost generates code on leaving
+ * an expression node, after all of its children
+ */
+static void genExpPost( TreeNode * tree)
+{ char * jump;
+  OpSite s;
+  int other, l, r;
+  switch (tree->kind.exp) {
+    case ArrexpK :
+      loadBase(ac1,tree->sym);
+      emitRO("ADD",ac,ac1,ac,"element address");
+      emitRM("LD",ac,0,ac,"load element");
+      if (TraceCode)  emitComment("<- Array element") ;
+      return;
+    case FuncK :
+      /* falling off the end returns */
+      emitReturn();
+      if (TraceCode)  emitComment("<- function") ;
+      return;
+    case OpK :
+      break;
+    default :
+      return;
+  }
+  /* now get the other operand; ac holds the one
+     evaluated last */
+  s = popOperands(tree);
+  if (s.leaf != NULL)
+  { if (s.leaf->kind.exp == ConstK)
+      emitRM("LDC",ac1,s.leaf->attr.val,0,"op: load const");
+    else
+      emitVar("LD",ac1,s.leaf->sym,"op: load id value");
+    other = ac1;
+  }
+  else if (s.reg >= 0)
+  { other = s.reg;
+    nextTemp--;
+  }
+  else
+  { emitRM("LD",ac1,++tmpOffset,mp,s.swapped ? "op: load right" : "op: load left");
+    other = ac1;
+  }
+  if ((s.leaf != NULL) == s.swapped)
+  { l = other;
+    r = ac;
+  }
+  else
+  { l = ac;
+    r = other;
+  }
+  switch (tree->attr.op) {
+     case PLUS :
+        emitRO("ADD",ac,l,r,"op +");
         break;
-      case ExpK:
-        genExp(tree);
+     case MINUS :
+        emitRO("SUB",ac,l,r,"op -");
         break;
-      default:
+     case TIMES :
+        emitRO("MUL",ac,l,r,"op *");
         break;
-    }
-    cGen(tree->sibling);
+     case OVER :
+        emitRO("DIV",ac,l,r,"op /");
+        break;
+     case LT : jump = "JLT"; goto relop;
+     case RT : jump = "JGT"; goto relop;
+     case LEQ : jump = "JLE"; goto relop;
+     case REQ : jump = "JGE"; goto relop;
+     case ASSIGN : jump = "JEQ"; goto relop;
+     case NEQ : jump = "JNE";
+     relop:
+        emitRO("SUB",ac,l,r,"op relational") ;
+        emitRM(jump,ac,2,pc,"br if true") ;
+        emitRM("LDC",ac,0,ac,"false case") ;
+        emitRM("LDA",pc,1,pc,"unconditional jmp") ;
+        emitRM("LDC",ac,1,ac,"true case") ;
+        break;
+     default:
+        emitComment("BUG: Unknown operator");
+        break;
+  } /* case op */
+  if (TraceCode)  emitComment("<- Op") ;
+} /* genExpPost */
+
+/* cGenPre, cGenChild and cGenPost are the visitors
+ * of the code generating tree traversal
+ */
+static int cGenPre( TreeNode * tree, int depth, void * arg)
+{ switch (tree->nodekind) {
+    case StmtK:
+      return genStmtPre(tree,depth);
+    case ExpK:
+      return genExpPre(tree);
+    default:
+      return FALSE;
+  }
+}
+
+static void cGenChild( TreeNode * tree, int i, void * arg)
+{ switch (tree->nodekind) {
+    case StmtK:
+      genStmtChild(tree,i);
+      break;
+    case ExpK:
+      genExpChild(tree,i);
+      break;
+    default:
+      break;
+  }
+}
+
+static void cGenPost( TreeNode * tree, int depth, void * arg)
+{ switch (tree->nodekind) {
+    case StmtK:
+      genStmtPost(tree);
+      break;
+    case ExpK:
+      genExpPost(tree);
+      break;
+    default:
+      break;
+  }
+  /* the arguments of a call are the nodes one
+     level below it; each goes to its frame slot */
+  if ((callTop > 0) && (depth == calls[callTop-1].depth + 1))
+  { CallSite * c = &calls[callTop-1];
+    emitRM("ST",ac,c->base - 2 - c->arg,mp,"call: store argument");
+    c->arg++;
+  }
+}
+
+/* Function genFunction generates the code of
+ * function declaration f into a new fragment:
+ * through the IR of ir.c when optimizing, else
+ * straight from the tree
+ */
+CodeFrag * genFunction(TreeNode * f)
+{ TreeVisitor v = { cGenPre, cGenChild, cGenPost, NULL };
+  TreeVisitor label = { NULL, NULL, labelNode, NULL };
+  CodeFrag * frag;
+  TreeNode * sibling = f->sibling;
+  if (Optimize)
+  { frag = genIrFunction(f);
+    if (frag != NULL) numberValues(frag);
+    return frag;
   }
+  frag = newCodeFrag();
+  if (frag == NULL) return NULL;
+  emitBegin(frag);
+  savedTop = 0;
+  callTop = 0;
+  opTop = 0;
+  nextTemp = FIRSTTEMP;
+  f->sibling = NULL;
+  walkTree(f,&label);
+  walkTree(f,&v);
+  f->sibling = sibling;
+  return frag;
+}
+
+/* symAddress resolves a relocated name: after
+ * linkProgram has placed the functions, the
+ * loc of every global symbol is its address
+ */
+static int symAddress( char * name )
+{ Symbol * s = st_lookup(name);
+  return s != NULL ? s->loc : 0;
+}
+
+/* Procedure linkProgram writes the prelude and the
+ * fragments of the functions of syntaxTree, in
+ * order, to the code file; a NULL fragment is a
+ * function left out
+ */
+void linkProgram(TreeNode * syntaxTree, CodeFrag ** frags, char * codefile)
+{ CodeFrag * prelude = newCodeFrag();
+  char * s = malloc(strlen(codefile)+7);
+  TreeNode * t;
+  int i, loc;
+  if ((prelude == NULL) || (s == NULL))
+  { free(s);
+    freeCodeFrag(prelude);
+    return;
+  }
+  strcpy(s,"File: ");
+  strcat(s,codefile);
+  emitBegin(prelude);
+  emitComment("C- Compilation to TM Code");
+  emitComment(s);
+  /* generate standard prelude */
+  emitComment("Standard prelude:");
+  emitRM("LD",mp,0,ac,"load maxaddress from location 0");
+  emitRM("ST",ac,0,ac,"clear location 0");
+  emitComment("End of standard prelude.");
+  emitRM("LDA",ac,1,pc,"call: return address");
+  emitRM_Sym("LDC",pc,0,0,"main","call main");
+  emitComment("End of execution.");
+  emitRO("HALT",0,0,0,"");
+  /* place the functions */
+  loc = prelude->size;
+  for (t = syntaxTree, i = 0; t != NULL; t = t->sibling)
+    if ((t->nodekind == ExpK) && (t->kind.exp == FuncK))
+    { if (frags[i] != NULL)
+      { t->sym->loc = loc;
+        loc += frags[i]->size;
+      }
+      i++;
+    }
+  emitFrag(prelude,0,symAddress);
+  for (t = syntaxTree, i = 0; t != NULL; t = t->sibling)
+    if ((t->nodekind == ExpK) && (t->kind.exp == FuncK))
+    { if (frags[i] != NULL) emitFrag(frags[i],t->sym->loc,symAddress);
+      i++;
+    }
+  freeCodeFrag(prelude);
+  free(s);
 }
 
 /**********************************************/
@@ -191,22 +722,25 @@ static void cGen( TreeNode * tree)
  * file by traversal of the syntax tree. The
  * second parameter (codefile) is the file name
  * of the code file, and is used to print the
- * file name as a comment in the code file
+ * file name as a comment in the code file.
+ * Functions marked dead by opt.c are left out
  */
 void codeGen(TreeNode * syntaxTree, char * codefile)
-{  char * s = malloc(strlen(codefile)+7);
-   strcpy(s,"File: ");
-   strcat(s,codefile);
-   emitComment("TINY Compilation to TM Code");
-   emitComment(s);
-   /* generate standard prelude */
-   emitComment("Standard prelude:");
-   emitRM("LD",mp,0,ac,"load maxaddress from location 0");
-   emitRM("ST",ac,0,ac,"clear location 0");
-   emitComment("End of standard prelude.");
-   /* generate code for TINY program */
-   cGen(syntaxTree);
-   /* finish */
-   emitComment("End of execution.");
-   emitRO("HALT",0,0,0,"");
+{ CodeFrag ** frags;
+  TreeNode * t;
+  int n = 0, i;
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+    if ((t->nodekind == ExpK) && (t->kind.exp == FuncK)) n++;
+  frags = (CodeFrag **) calloc(n+1,sizeof(CodeFrag *));
+  if (frags == NULL)
+  { obPuts(listing,"Out of memory error in code generator\n");
+    Error = TRUE;
+    return;
+  }
+  for (t = syntaxTree, i = 0; t != NULL; t = t->sibling)
+    if ((t->nodekind == ExpK) && (t->kind.exp == FuncK))
+      frags[i++] = t->sym->dead ? NULL : genFunction(t);
+  if (! Error) linkProgram(syntaxTree,frags,codefile);
+  for (i=0;i<n;i++) freeCodeFrag(frags[i]);
+  free(frags);
 }
@@ -1,6 +1,6 @@
 /****************************************************/
 /* File: cgen.h                                     */
-/* The code generator interface to the TINY compiler*/
+/* The code generator interface to the C- compiler  */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -8,11 +8,26 @@
 #ifndef _CGEN_H_
 #define _CGEN_H_
 
+#include "code.h"
+
+/* Function genFunction generates the code of
+ * function declaration f into a new fragment
+ */
+CodeFrag * genFunction(TreeNode * f);
+
+/* Procedure linkProgram writes the prelude and the
+ * fragments of the functions of syntaxTree, in
+ * order, to the code file; frags[i] is the code
+ * of the i-th function, NULL if it is left out
+ */
+void linkProgram(TreeNode * syntaxTree, CodeFrag ** frags, char * codefile);
+
 /* Procedure codeGen generates code to a code
  * file by traversal of the syntax tree. The
  * second parameter (codefile) is the file name
  * of the code file, and is used to print the
- * file name as a comment in the code file
+ * file name as a comment in the code file.
+ * Functions marked dead by opt.c are left out
  */
 void codeGen(TreeNode * syntaxTree, char * codefile);
 
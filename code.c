@@ -1,13 +1,18 @@
 /****************************************************/
 /* File: code.c                                     */
 /* TM Code emitting utilities                       */
-/* implementation for the TINY compiler             */
+/* implementation for the C- compiler               */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
 
 #include "globals.h"
+#include "util.h"
 #include "code.h"
+#include "stats.h"
+
+/* the fragment code is being emitted into */
+static CodeFrag * frag = NULL;
 
 /* TM location number for current instruction emission */
 static int emitLoc = 0 ;
@@ -17,11 +22,100 @@ static int emitLoc = 0 ;
    emitBackup, and emitRestore */
 static int highEmitLoc = 0;
 
-/* Procedure emitComment prints a comment line 
- * with comment c in the code file
+/* Function newCodeFrag returns an empty fragment */
+CodeFrag * newCodeFrag(void)
+{ CodeFrag * f = (CodeFrag *) calloc(1,sizeof(CodeFrag));
+  if (f == NULL)
+  { obPuts(listing,"Out of memory error in code generator\n");
+    Error = TRUE;
+  }
+  return f;
+}
+
+/* Procedure freeCodeFrag releases a fragment */
+void freeCodeFrag(CodeFrag * f)
+{ int i;
+  if (f == NULL) return;
+  for (i=0;i<f->ncomments;i++)
+    free(f->comments[i].text);
+  free(f->comments);
+  free(f->code);
+  free(f);
+}
+
+/* Procedure emitBegin starts emission of code
+ * into fragment f at its location 0
+ */
+void emitBegin(CodeFrag * f)
+{ frag = f;
+  emitLoc = 0;
+  highEmitLoc = 0;
+}
+
+/* slot returns the instruction at the current
+ * location, growing the fragment as needed
+ */
+static TMInstr * slot(void)
+{ TMInstr * i;
+  if (emitLoc >= frag->cap)
+  { int cap = frag->cap ? 2*frag->cap : 256;
+    TMInstr * bigger;
+    while (cap <= emitLoc) cap *= 2;
+    bigger = (TMInstr *) realloc(frag->code,cap * sizeof(TMInstr));
+    if (bigger == NULL)
+    { obPuts(listing,"Out of memory error in code generator\n");
+      Error = TRUE;
+      return NULL;
+    }
+    memset(bigger + frag->cap,0,(cap - frag->cap) * sizeof(TMInstr));
+    frag->code = bigger;
+    frag->cap = cap;
+  }
+  i = &frag->code[emitLoc++];
+  if (frag->size < emitLoc) frag->size = emitLoc;
+  if (highEmitLoc < emitLoc) highEmitLoc = emitLoc;
+  return i;
+}
+
+/* Procedure emitComment records a comment line
+ * with comment c if TraceCode is TRUE
  */
 void emitComment( char * c )
-{ if (TraceCode) fprintf(code,"* %s\n",c);}
+{ if (TraceCode)
+  { if (frag->ncomments == frag->ccap)
+    { int cap = frag->ccap ? 2*frag->ccap : 64;
+      TMComment * bigger =
+        (TMComment *) realloc(frag->comments,cap * sizeof(TMComment));
+      if (bigger == NULL)
+      { obPuts(listing,"Out of memory error in code generator\n");
+        Error = TRUE;
+        return;
+      }
+      frag->comments = bigger;
+      frag->ccap = cap;
+    }
+    frag->comments[frag->ncomments].loc = emitLoc;
+    frag->comments[frag->ncomments].text = copyString(c);
+    frag->ncomments++;
+  }
+}
+
+/* emitInstr fills in the instruction at the
+ * current location
+ */
+static void emitInstr( char * op, int r, int a, int b, int rm,
+                       char * sym, char * c)
+{ TMInstr * i = slot();
+  if (i == NULL) return;
+  strncpy(i->op,op,sizeof(i->op)-1);
+  i->op[sizeof(i->op)-1] = '\0';
+  i->r = r;
+  i->a = a;
+  i->b = b;
+  i->rm = rm;
+  i->sym = sym;
+  i->comment = c;
+}
 
 /* Procedure emitRO emits a register-only
  * TM instruction
@@ -32,10 +126,7 @@ void emitComment( char * c )
  * c = a comment to be printed if TraceCode is TRUE
  */
 void emitRO( char *op, int r, int s, int t, char *c)
-{ fprintf(code,"%3d:  %5s  %d,%d,%d ",emitLoc++,op,r,s,t);
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
-  if (highEmitLoc < emitLoc) highEmitLoc = emitLoc ;
+{ emitInstr(op,r,s,t,FALSE,NULL,c);
 } /* emitRO */
 
 /* Procedure emitRM emits a register-to-memory
@@ -47,12 +138,17 @@ void emitRO( char *op, int r, int s, int t, char *c)
  * c = a comment to be printed if TraceCode is TRUE
  */
 void emitRM( char * op, int r, int d, int s, char *c)
-{ fprintf(code,"%3d:  %5s  %d,%d(%d) ",emitLoc++,op,r,d,s);
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
-  if (highEmitLoc < emitLoc)  highEmitLoc = emitLoc ;
+{ emitInstr(op,r,d,s,TRUE,NULL,c);
 } /* emitRM */
 
+/* Procedure emitRM_Sym emits a register-to-memory
+ * TM instruction whose offset d is relative to
+ * the address of symbol sym, filled in by emitFrag
+ */
+void emitRM_Sym( char * op, int r, int d, int s, char * sym, char *c)
+{ emitInstr(op,r,d,s,TRUE,sym,c);
+} /* emitRM_Sym */
+
 /* Function emitSkip skips "howMany" code
  * locations for later backpatch. It also
  * returns the current code position
@@ -84,14 +180,57 @@ void emitRestore(void)
  * register-to-memory TM instruction
  * op = the opcode
  * r = target register
- * a = the absolute location in memory
+ * a = the absolute location in the fragment
  * c = a comment to be printed if TraceCode is TRUE
  */
 void emitRM_Abs( char *op, int r, int a, char * c)
-{ fprintf(code,"%3d:  %5s  %d,%d(%d) ",
-               emitLoc,op,r,a-(emitLoc+1),pc);
-  ++emitLoc ;
-  if (TraceCode) fprintf(code,"\t%s",c) ;
-  fprintf(code,"\n") ;
-  if (highEmitLoc < emitLoc) highEmitLoc = emitLoc ;
+{ emitInstr(op,r,a-(emitLoc+1),pc,TRUE,NULL,c);
 } /* emitRM_Abs */
+
+/* writeComment prints one comment line */
+static void writeComment( char * c )
+{ obPuts(code,"* ");
+  obPuts(code,c);
+  obPutc(code,'\n');
+}
+
+/* writeInstr prints the instruction i placed at loc */
+static void writeInstr( TMInstr * i, int loc, int a )
+{ obPutIntW(code,loc,3);
+  obPuts(code,":  ");
+  obPutsW(code,i->op,5);
+  obPuts(code,"  ");
+  obPutInt(code,i->r);
+  obPutc(code,',');
+  obPutInt(code,a);
+  obPutc(code,i->rm ? '(' : ',');
+  obPutInt(code,i->b);
+  if (i->rm) obPutc(code,')');
+  obPutc(code,' ');
+  if (TraceCode && (i->comment != NULL))
+  { obPutc(code,'\t');
+    obPuts(code,i->comment);
+  }
+  obPutc(code,'\n');
+}
+
+/* Procedure emitFrag writes fragment f to the code
+ * file, placed at location base; resolve returns
+ * the address of the symbol of a relocated
+ * instruction
+ */
+void emitFrag(CodeFrag * f, int base, int (* resolve) (char * sym))
+{ int loc, c = 0;
+  for (loc = 0; loc <= f->size; loc++)
+  { while ((c < f->ncomments) && (f->comments[c].loc <= loc))
+      writeComment(f->comments[c++].text);
+    if (loc == f->size) break;
+    if (f->code[loc].op[0] != '\0')
+    { TMInstr * i = &f->code[loc];
+      int a = i->a;
+      if (i->sym != NULL) a += resolve(i->sym);
+      writeInstr(i,base + loc,a);
+      if (Stats != NULL) Stats->instructions++;
+    }
+  }
+}
@@ -1,6 +1,6 @@
 /****************************************************/
 /* File: code.h                                     */
-/* Code emitting utilities for the TINY compiler    */
+/* Code emitting utilities for the C- compiler      */
 /* and interface to the TM machine                  */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
@@ -12,8 +12,9 @@
 /* pc = program counter  */
 #define  pc 7
 
-/* mp = "memory pointer" points
- * to top of memory (for temp storage)
+/* mp = "memory pointer" points to the frame
+ * of the running function (for locals and
+ * temp storage)
  */
 #define  mp 6
 
@@ -29,10 +30,54 @@
 /* 2nd accumulator */
 #define  ac1 1
 
+/* TMInstr is one emitted instruction. If sym is
+ * not NULL, the address of that symbol is added
+ * to the offset a when the code is written
+ */
+typedef struct
+   { char op[5]; /* empty for a skipped location */
+     int r, a, b; /* RO: r,a,b  RM: r,a(b) */
+     int rm; /* TRUE for a register-to-memory op */
+     char * sym;
+     char * comment;
+   } TMInstr;
+
+/* TMComment is a comment line, printed before
+ * the instruction at loc
+ */
+typedef struct
+   { int loc;
+     char * text;
+   } TMComment;
+
+/* CodeFrag holds code emitted at locations
+ * relative to 0, so that it can be placed
+ * anywhere in the program by emitFrag
+ */
+typedef struct
+   { TMInstr * code;
+     int size; /* locations emitted */
+     int cap;
+     TMComment * comments;
+     int ncomments;
+     int ccap;
+   } CodeFrag;
+
+/* Function newCodeFrag returns an empty fragment */
+CodeFrag * newCodeFrag(void);
+
+/* Procedure freeCodeFrag releases a fragment */
+void freeCodeFrag(CodeFrag * f);
+
 /* code emitting utilities */
 
-/* Procedure emitComment prints a comment line 
- * with comment c in the code file
+/* Procedure emitBegin starts emission of code
+ * into fragment f at its location 0
+ */
+void emitBegin(CodeFrag * f);
+
+/* Procedure emitComment records a comment line
+ * with comment c if TraceCode is TRUE
  */
 void emitComment( char * c );
 
@@ -56,6 +101,12 @@ void emitRO( char *op, int r, int s, int t, char *c);
  */
 void emitRM( char * op, int r, int d, int s, char *c);
 
+/* Procedure emitRM_Sym emits a register-to-memory
+ * TM instruction whose offset d is relative to
+ * the address of symbol sym, filled in by emitFrag
+ */
+void emitRM_Sym( char * op, int r, int d, int s, char * sym, char *c);
+
 /* Function emitSkip skips "howMany" code
  * locations for later backpatch. It also
  * returns the current code position
@@ -78,9 +129,16 @@ void emitRestore(void);
  * register-to-memory TM instruction
  * op = the opcode
  * r = target register
- * a = the absolute location in memory
+ * a = the absolute location in the fragment
  * c = a comment to be printed if TraceCode is TRUE
  */
 void emitRM_Abs( char *op, int r, int a, char * c);
 
+/* Procedure emitFrag writes fragment f to the code
+ * file, placed at location base; resolve returns
+ * the address of the symbol of a relocated
+ * instruction
+ */
+void emitFrag(CodeFrag * f, int base, int (* resolve) (char * sym));
+
 #endif
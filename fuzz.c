@@ -0,0 +1,735 @@
+/****************************************************/
+/* File: fuzz.c                                     */
+/* Differential fuzzer of the front end it is       */
+/* linked with: parse.o or tiny.tab.o. It checks    */
+/* the scanner against a reference lexer, prints a  */
+/* verdict per case for diffing the two parsers,    */
+/* and times inputs that could make either of them  */
+/* worse than linear                                */
+/****************************************************/
+
+#include <time.h>
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "parse.h"
+#include "traverse.h"
+
+/* allocate global variables */
+int lineno = 0;
+FILE * source;
+OutBuf * listing;
+OutBuf * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MaxErrors = 20;
+
+int Error = FALSE;
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**************************************************/
+/**********   Random C- programs   ****************/
+/**************************************************/
+
+/* xorshift64*: the same seed gives the same case
+ * on every machine, so a failing seed can be shown
+ * again with "show <seed>"
+ */
+static unsigned long long rngState;
+
+static void seedRng(unsigned long seed)
+{ rngState = 0x9E3779B97F4A7C15ULL ^ ((unsigned long long) seed << 1);
+  if (rngState == 0) rngState = 1;
+}
+
+static unsigned rnd(unsigned n)
+{ rngState ^= rngState >> 12;
+  rngState ^= rngState << 25;
+  rngState ^= rngState >> 27;
+  return (unsigned) ((rngState * 0x2545F4914F6CDD1DULL) >> 33) % n;
+}
+
+/* a case is built as a list of lexemes, which may
+ * then be mutated, and finally joined into text
+ */
+#define MAXLEX 4096
+
+typedef struct
+   { const char * lex[MAXLEX];
+     int n;
+   } LexList;
+
+static void put(LexList * l, const char * s)
+{ if (l->n < MAXLEX) l->lex[l->n++] = s;
+}
+
+static const char * names[] =
+   { "x", "y", "i", "n", "a", "b", "gcd", "input", "output",
+     "value", "Sum", "ZZ", "main" };
+#define NNAMES (sizeof(names) / sizeof(names[0]))
+
+static const char * nums[] =
+   { "0", "1", "2", "7", "10", "42", "255", "1000", "65535", "007" };
+#define NNUMS (sizeof(nums) / sizeof(nums[0]))
+
+static const char * relops[] = { "<", "<=", ">", ">=", "==", "!=" };
+
+static const char * name(void) { return names[rnd(NNAMES)]; }
+static const char * num(void) { return nums[rnd(NNUMS)]; }
+
+static void genExp(LexList * l, int depth);
+
+static void genVar(LexList * l, int depth)
+{ put(l,name());
+  if (depth > 0 && rnd(4) == 0)
+  { put(l,"[");
+    genExp(l,depth-1);
+    put(l,"]");
+  }
+}
+
+static void genFactor(LexList * l, int depth)
+{ int k = depth > 0 ? rnd(6) : rnd(2);
+  switch (k)
+  { case 0: put(l,num()); break;
+    case 1: case 2: genVar(l,depth); break;
+    case 3:
+      put(l,"(");
+      genExp(l,depth-1);
+      put(l,")");
+      break;
+    default:
+      put(l,name());
+      put(l,"(");
+      if (rnd(3) != 0)
+      { int i, args = 1 + rnd(3);
+        for (i=0;i<args;i++)
+        { if (i > 0) put(l,",");
+          genExp(l,depth-1);
+        }
+      }
+      put(l,")");
+      break;
+  }
+}
+
+static void genTerm(LexList * l, int depth)
+{ int i, ops = rnd(2);
+  genFactor(l,depth);
+  for (i=0;i<ops;i++)
+  { put(l,rnd(2) ? "*" : "/");
+    genFactor(l,depth);
+  }
+}
+
+static void genAdditive(LexList * l, int depth)
+{ int i, ops = rnd(3);
+  genTerm(l,depth);
+  for (i=0;i<ops;i++)
+  { put(l,rnd(2) ? "+" : "-");
+    genTerm(l,depth);
+  }
+}
+
+/* relational operators do not chain in C-; a few
+ * chains are made on purpose, both parsers must
+ * reject them
+ */
+static void genExp(LexList * l, int depth)
+{ int k = rnd(10);
+  if (depth > 0 && k < 3)
+  { genVar(l,depth);
+    put(l,"=");
+    genExp(l,depth-1);
+    return;
+  }
+  genAdditive(l,depth);
+  if (k < 6)
+  { put(l,relops[rnd(6)]);
+    genAdditive(l,depth);
+    if ((depth == 2) && (rnd(20) == 0))
+    { put(l,relops[rnd(6)]);
+      genAdditive(l,depth);
+    }
+  }
+}
+
+static void genVarDecl(LexList * l)
+{ put(l,rnd(8) ? "int" : "void");
+  put(l,name());
+  if (rnd(3) == 0)
+  { put(l,"[");
+    put(l,num());
+    put(l,"]");
+  }
+  put(l,";");
+}
+
+static void genStmt(LexList * l, int depth);
+
+static void genCompound(LexList * l, int depth)
+{ int i, n;
+  put(l,"{");
+  n = rnd(3);
+  for (i=0;i<n;i++) genVarDecl(l);
+  n = depth > 0 ? rnd(5) : 0;
+  for (i=0;i<n;i++) genStmt(l,depth-1);
+  put(l,"}");
+}
+
+static void genStmt(LexList * l, int depth)
+{ switch (rnd(depth > 0 ? 8 : 3))
+  { case 0: case 1:
+      genExp(l,2);
+      put(l,";");
+      break;
+    case 2:
+      put(l,"return");
+      if (rnd(3)) genExp(l,2);
+      put(l,";");
+      break;
+    case 3:
+      put(l,";");
+      break;
+    case 4:
+      genCompound(l,depth);
+      break;
+    case 5: case 6:
+      put(l,"if");
+      put(l,"(");
+      genExp(l,2);
+      put(l,")");
+      genStmt(l,depth-1);
+      if (rnd(2))
+      { put(l,"else");
+        genStmt(l,depth-1);
+      }
+      break;
+    default:
+      put(l,"while");
+      put(l,"(");
+      genExp(l,2);
+      put(l,")");
+      genStmt(l,depth-1);
+      break;
+  }
+}
+
+static void genFunction(LexList * l)
+{ put(l,rnd(2) ? "int" : "void");
+  put(l,name());
+  put(l,"(");
+  if (rnd(3) == 0) put(l,"void");
+  else
+  { int i, n = 1 + rnd(3);
+    for (i=0;i<n;i++)
+    { if (i > 0) put(l,",");
+      put(l,"int");
+      put(l,name());
+      if (rnd(3) == 0)
+      { put(l,"[");
+        put(l,"]");
+      }
+    }
+  }
+  put(l,")");
+  genCompound(l,3);
+}
+
+static void genProgram(LexList * l)
+{ int i, n = 1 + rnd(5);
+  l->n = 0;
+  for (i=0;i<n;i++)
+    if (rnd(3) == 0) genVarDecl(l);
+    else genFunction(l);
+}
+
+/* lexemes a mutation may insert: tokens out of
+ * place, reserved words of TINY, and text the
+ * scanner must turn into LEXERR, ERROR or CMTERR
+ */
+static const char * noise[] =
+   { "int", "void", "if", "else", "while", "return", "then", "end",
+     "repeat", "until", "read", "write", "(", ")", "[", "]", "{", "}",
+     ";", ",", "=", "==", "!=", "<", "<=", ">", ">=", "+", "-", "*",
+     "/", "!", "@", "#", ".", "x1", "1x", "a1b2c3", "12ab", "/**/",
+     "/* a\n comment */", "/***/", "/* * / */",
+     "averyveryveryverylongidentifierofmorethanfortyletters",
+     "12345678901234567890123456789012345678901234567890" };
+#define NNOISE (sizeof(noise) / sizeof(noise[0]))
+
+static void mutate(LexList * l)
+{ int i, k, m = 1 + rnd(3);
+  for (k=0;k<m && l->n > 0;k++)
+  { int at = rnd(l->n);
+    switch (rnd(4))
+    { case 0: /* delete */
+        for (i=at;i<l->n-1;i++) l->lex[i] = l->lex[i+1];
+        l->n--;
+        break;
+      case 1: /* duplicate */
+        if (l->n < MAXLEX)
+        { for (i=l->n;i>at;i--) l->lex[i] = l->lex[i-1];
+          l->n++;
+        }
+        break;
+      case 2: /* swap with the next */
+        if (at+1 < l->n)
+        { const char * t = l->lex[at];
+          l->lex[at] = l->lex[at+1];
+          l->lex[at+1] = t;
+        }
+        break;
+      default: /* insert noise */
+        if (l->n < MAXLEX)
+        { for (i=l->n;i>at;i--) l->lex[i] = l->lex[i-1];
+          l->lex[at] = noise[rnd(NNOISE)];
+          l->n++;
+        }
+        break;
+    }
+  }
+}
+
+/* join writes the lexemes separated by blanks,
+ * tabs, newlines, comments or nothing at all. If
+ * merge is set, neighbours may run together ("="
+ * "=" scans as "==", "x" "1" as a LEXERR)
+ */
+static int alnumAt(const char * s)
+{ return isalnum((unsigned char) *s);
+}
+
+static void join(LexList * l, OutBuf * text, int merge)
+{ int i;
+  text->len = 0;
+  for (i=0;i<l->n;i++)
+  { if (i > 0)
+      switch (rnd(12))
+      { case 0:
+          if (merge || !alnumAt(l->lex[i-1]+strlen(l->lex[i-1])-1) ||
+              !alnumAt(l->lex[i]))
+            break;
+          obPutc(text,' ');
+          break;
+        case 1: obPutc(text,'\n'); break;
+        case 2: obPutc(text,'\t'); break;
+        case 3: obPuts(text," /* c */ "); break;
+        default: obPutc(text,' '); break;
+      }
+    obPuts(text,l->lex[i]);
+  }
+  if (merge && (rnd(20) == 0)) obPuts(text,"/* unterminated");
+  else obPutc(text,'\n');
+}
+
+static void genCase(unsigned long seed, OutBuf * text)
+{ static LexList l;
+  int mutated;
+  seedRng(seed);
+  genProgram(&l);
+  mutated = rnd(3) == 0;
+  if (mutated) mutate(&l);
+  join(&l,text,mutated);
+}
+
+/**************************************************/
+/**********   Reference scanner   *****************/
+/**************************************************/
+
+/* refToken scans one token of text at *pos the way
+ * lex/tiny.l does, skipping white space and
+ * comments; the lexeme is copied to lexeme like
+ * Scanner.tokenString
+ */
+static const struct { const char * word; TokenType tok; } reserved[] =
+   { { "if", IF }, { "then", THEN }, { "else", ELSE }, { "end", END },
+     { "repeat", REPEAT }, { "until", UNTIL }, { "read", READ },
+     { "write", WRITE }, { "void", VOID }, { "while", WHILE },
+     { "int", INT }, { "return", RETURN } };
+
+static const struct { const char * op; TokenType tok; } symbols[] =
+   { { "==", ASSIGN }, { "!=", NEQ }, { "<=", LEQ }, { ">=", REQ },
+     { "=", EQ }, { "<", LT }, { ">", RT }, { "+", PLUS },
+     { "-", MINUS }, { "*", TIMES }, { "/", OVER }, { "(", LPAREN },
+     { ")", RPAREN }, { ";", SEMI }, { "[", LSQBRAC },
+     { "]", RSQBRAC }, { "{", LBRAC }, { "}", RBRAC }, { ",", COMMA } };
+
+static TokenType refToken(const char * text, size_t len, size_t * pos,
+                          int * line, char * lexeme)
+{ size_t p = *pos, start;
+  int i;
+  lexeme[0] = '\0';
+  for (;;)
+  { if (p >= len) { *pos = p; return ENDFILE; }
+    if (text[p] == '\n') { (*line)++; p++; }
+    else if (text[p] == ' ' || text[p] == '\t') p++;
+    else if (text[p] == '/' && p+1 < len && text[p+1] == '*')
+    { p += 2;
+      for (;;)
+      { if (p >= len) { *pos = p; return CMTERR; }
+        if (text[p] == '*' && p+1 < len && text[p+1] == '/')
+        { p += 2;
+          break;
+        }
+        if (text[p] == '\n') (*line)++;
+        p++;
+      }
+    }
+    else break;
+  }
+  start = p;
+  if (isalnum((unsigned char) text[p]))
+  { int letters = FALSE, digits = FALSE;
+    TokenType tok;
+    while (p < len && isalnum((unsigned char) text[p]))
+    { if (isdigit((unsigned char) text[p])) digits = TRUE;
+      else letters = TRUE;
+      p++;
+    }
+    i = p - start < MAXTOKENLEN ? (int) (p - start) : MAXTOKENLEN;
+    memcpy(lexeme,text+start,i);
+    lexeme[i] = '\0';
+    *pos = p;
+    if (letters && digits) return LEXERR;
+    if (digits) return NUM;
+    tok = ID;
+    for (i=0;i<(int)(sizeof(reserved)/sizeof(reserved[0]));i++)
+      if (strcmp(lexeme,reserved[i].word) == 0) tok = reserved[i].tok;
+    return tok;
+  }
+  for (i=0;i<(int)(sizeof(symbols)/sizeof(symbols[0]));i++)
+  { size_t n = strlen(symbols[i].op);
+    if (p + n <= len && strncmp(text+p,symbols[i].op,n) == 0)
+    { strcpy(lexeme,symbols[i].op);
+      *pos = p + n;
+      return symbols[i].tok;
+    }
+  }
+  lexeme[0] = text[p];
+  lexeme[1] = '\0';
+  *pos = p + 1;
+  return ERROR;
+}
+
+/* checkScanner runs the linked scanner and the
+ * reference scanner over text side by side and
+ * reports the first token they disagree on.
+ * After CMTERR and at ENDFILE the lexeme is left
+ * to the scanner, so only the token is compared
+ */
+static int checkScanner(unsigned long seed, OutBuf * text)
+{ FILE * f = fmemopen(text->buf,text->len,"r");
+  Scanner * s;
+  char lexeme[MAXTOKENLEN+1];
+  size_t pos = 0;
+  int line = 1, ok = TRUE;
+  if (f == NULL) return FALSE;
+  s = newScanner(f,NULL);
+  for (;;)
+  { TokenType want = refToken(text->buf,text->len,&pos,&line,lexeme);
+    TokenType got;
+    while ((got = getToken(s)) == NLSP)
+      ;
+    if ((got != want) || (s->lineno != line) ||
+        ((want != CMTERR) && (want != ENDFILE) &&
+         (strcmp(s->tokenString,lexeme) != 0)))
+    { fprintf(stderr,"case %lu: scanner gives %d \"%s\" at line %d, "
+              "expected %d \"%s\" at line %d\n",seed,got,
+              s->tokenString,s->lineno,want,lexeme,line);
+      ok = FALSE;
+      break;
+    }
+    if ((want == ENDFILE) || (want == CMTERR)) break;
+  }
+  freeScanner(s);
+  fclose(f);
+  return ok;
+}
+
+/* parseText parses text; errors go to sink */
+static TreeNode * parseText(OutBuf * text, OutBuf * sink, int * error)
+{ FILE * f = fmemopen(text->buf,text->len,"r");
+  TreeNode * tree;
+  if (f == NULL) { *error = TRUE; return NULL; }
+  tree = parseSource(f,sink,error);
+  fclose(f);
+  return tree;
+}
+
+#define FNV_BASIS 0xcbf29ce484222325ULL
+
+/* FNV-1a of n more bytes, starting from hash h */
+static unsigned long long hashBuf(unsigned long long h,
+                                  const char * p, size_t n)
+{ while (n-- > 0)
+  { h ^= (unsigned char) *p++;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+/* hashLine adds the line of each node, in preorder,
+ * to the hash of the listing, which does not show it
+ */
+static int hashLine(TreeNode * t, int depth, void * arg)
+{ unsigned long long * h = arg;
+  *h = hashBuf(*h,(const char *) &t->lineno,sizeof t->lineno);
+  return TRUE;
+}
+
+/* firstError returns the line of the first syntax
+ * error in sink and hashes the token it was found
+ * at. Both parsers must stop at the same token; the
+ * wording and the errors after it depend on each
+ * parser's own messages and error recovery
+ */
+static int firstError(OutBuf * sink, unsigned long long * h)
+{ const char * s, * end, * eol;
+  int line;
+  *h = FNV_BASIS;
+  obWrite(sink,"",1); /* end the text for strstr */
+  sink->len--;
+  s = strstr(sink->buf,"Syntax error at line ");
+  if (s == NULL) return 0;
+  line = atoi(s+21);
+  /* parse.c may end the message on the same line */
+  s = strstr(s,"Current token: \t");
+  if (s == NULL) return line;
+  s += 16;
+  end = sink->buf + sink->len;
+  eol = memchr(s,'\n',end-s);
+  *h = hashBuf(*h,s,(eol ? eol : end)-s);
+  return line;
+}
+
+/* runCases prints one line per case: whether it
+ * parsed, with a hash of the printTree listing and
+ * the line of every node if it did, or the line
+ * and token of its first syntax error if not. The
+ * lines of parse.o and tiny.tab.o must be the same
+ */
+static int runCases(unsigned long first, unsigned long last)
+{ OutBuf * text = newOutBuf(NULL);
+  OutBuf * sink = newOutBuf(NULL);
+  OutBuf * trees = newOutBuf(NULL);
+  TreeVisitor lines = { hashLine, NULL, NULL, NULL };
+  unsigned long long h;
+  unsigned long seed;
+  int bad = 0;
+  listing = trees;
+  for (seed=first;seed<=last;seed++)
+  { TreeNode * tree;
+    int error;
+    genCase(seed,text);
+    if (!checkScanner(seed,text)) bad++;
+    sink->len = 0;
+    tree = parseText(text,sink,&error);
+    if (error)
+    { int line = firstError(sink,&h);
+      printf("case %lu reject %d %016llx\n",seed,line,h);
+    }
+    else
+    { trees->len = 0;
+      printTree(tree);
+      h = hashBuf(FNV_BASIS,trees->buf,trees->len);
+      lines.arg = &h;
+      walkTree(tree,&lines);
+      printf("case %lu accept %016llx\n",seed,h);
+    }
+  }
+  freeOutBuf(text);
+  freeOutBuf(sink);
+  freeOutBuf(trees);
+  return bad ? 1 : 0;
+}
+
+/**************************************************/
+/**********   Scaling probes   ********************/
+/**************************************************/
+
+/* a probe builds an input of about n units; it is
+ * timed at n and at 8n, and a time growing much
+ * more than 8 times marks a super-linear path.
+ * Scanner probes time getToken alone, since the
+ * parsers give up after MaxErrors errors
+ */
+typedef struct
+   { const char * name;
+     int scanOnly;
+     int n; /* units of the small input */
+     void (*build)(OutBuf *, int);
+   } Probe;
+
+static void repeat(OutBuf * b, const char * s, int n)
+{ while (n-- > 0) obPuts(b,s);
+}
+
+static void lexerrRun(OutBuf * b, int n) { repeat(b,"a1",n); }
+static void lexerrRun2(OutBuf * b, int n) { repeat(b,"1a",n); }
+static void lexerrMany(OutBuf * b, int n) { repeat(b,"a1 1a ",n); }
+static void longNum(OutBuf * b, int n) { repeat(b,"9",n); }
+static void longId(OutBuf * b, int n) { repeat(b,"z",n); }
+static void keywordish(OutBuf * b, int n) { repeat(b,"whil retur in els ",n); }
+static void stars(OutBuf * b, int n)
+{ obPuts(b,"/*");
+  repeat(b,"*",n);
+  obPuts(b,"*/");
+}
+static void starSlash(OutBuf * b, int n)
+{ obPuts(b,"/*");
+  repeat(b,"* /",n);
+  obPuts(b,"*/");
+}
+static void openComment(OutBuf * b, int n)
+{ obPuts(b,"/*");
+  repeat(b,"x*\n",n);
+}
+static void equals(OutBuf * b, int n) { repeat(b,"===",n); }
+static void bangs(OutBuf * b, int n) { repeat(b,"!!=",n); }
+static void blanks(OutBuf * b, int n) { repeat(b," \t\n",n); }
+
+static void longExp(OutBuf * b, int n)
+{ obPuts(b,"void main(void)\n{ int x;\n  x = 1");
+  repeat(b," + x * 2 - (x / 3)",n);
+  obPuts(b,";\n}\n");
+}
+static void manyStmts(OutBuf * b, int n)
+{ obPuts(b,"int g[10];\nvoid main(void)\n{ int x;\n");
+  repeat(b,"  if (x < 3) g[x] = x; else while (x > 0) x = x - 1;\n",n);
+  obPuts(b,"}\n");
+}
+static void nestedParens(OutBuf * b, int n)
+{ obPuts(b,"void main(void)\n{ int x;\n  x = ");
+  repeat(b,"(",n);
+  obPuts(b,"x");
+  repeat(b,")",n);
+  obPuts(b,";\n}\n");
+}
+static void nestedIfs(OutBuf * b, int n)
+{ obPuts(b,"void main(void)\n{ int x;\n");
+  repeat(b,"if (x) ",n);
+  obPuts(b,"x = 1;\n}\n");
+}
+static void nestedBlocks(OutBuf * b, int n)
+{ obPuts(b,"void main(void)\n");
+  repeat(b,"{ int x; ",n);
+  repeat(b,"}",n);
+  obPuts(b,"\n");
+}
+static void manyErrors(OutBuf * b, int n)
+{ obPuts(b,"void main(void)\n{\n");
+  repeat(b,"  x = ;\n",n);
+  obPuts(b,"}\n");
+}
+
+/* the nesting probes stay small: both parsers
+ * recurse (or stack states) once per level
+ */
+static Probe probes[] =
+   { { "lexerr-a1", TRUE, 50000, lexerrRun },
+     { "lexerr-1a", TRUE, 50000, lexerrRun2 },
+     { "lexerr-many", TRUE, 20000, lexerrMany },
+     { "long-num", TRUE, 100000, longNum },
+     { "long-id", TRUE, 100000, longId },
+     { "near-keywords", TRUE, 10000, keywordish },
+     { "comment-stars", TRUE, 100000, stars },
+     { "comment-star-slash", TRUE, 50000, starSlash },
+     { "comment-open", TRUE, 50000, openComment },
+     { "equals", TRUE, 50000, equals },
+     { "bangs", TRUE, 50000, bangs },
+     { "blanks", TRUE, 50000, blanks },
+     { "long-expression", FALSE, 5000, longExp },
+     { "statements", FALSE, 5000, manyStmts },
+     { "nested-parens", FALSE, 200, nestedParens },
+     { "nested-ifs", FALSE, 200, nestedIfs },
+     { "nested-blocks", FALSE, 200, nestedBlocks },
+     { "syntax-errors", FALSE, 5000, manyErrors } };
+#define NPROBES (sizeof(probes) / sizeof(probes[0]))
+
+/* RATIO is the growth from n to 8n taken as
+ * super-linear: 8 for linear time, with room for
+ * noise and cache effects
+ */
+#define RATIO 24.0
+
+static double timeOnce(Probe * p, OutBuf * text, OutBuf * sink)
+{ double start = now();
+  if (p->scanOnly)
+  { FILE * f = fmemopen(text->buf,text->len,"r");
+    Scanner * s = newScanner(f,NULL);
+    TokenType t;
+    do t = getToken(s);
+    while ((t != ENDFILE) && (t != CMTERR));
+    freeScanner(s);
+    fclose(f);
+  }
+  else
+  { int error;
+    sink->len = 0;
+    parseText(text,sink,&error);
+  }
+  return now() - start;
+}
+
+/* timeProbe is the best of three runs at size n */
+static double timeProbe(Probe * p, int n, OutBuf * text, OutBuf * sink)
+{ double best = 0;
+  int i;
+  text->len = 0;
+  p->build(text,n);
+  for (i=0;i<3;i++)
+  { double t = timeOnce(p,text,sink);
+    if ((i == 0) || (t < best)) best = t;
+  }
+  return best;
+}
+
+static int runProbes(void)
+{ OutBuf * text = newOutBuf(NULL);
+  OutBuf * sink = newOutBuf(NULL);
+  int i, bad = 0;
+  listing = sink;
+  MaxErrors = 1 << 30; /* so that recovery is timed too */
+  for (i=0;i<(int)NPROBES;i++)
+  { Probe * p = &probes[i];
+    double small = timeProbe(p,p->n,text,sink);
+    double large = timeProbe(p,8*p->n,text,sink);
+    double ratio = large / (small > 1e-6 ? small : 1e-6);
+    int slow = ratio > RATIO;
+    printf("probe %-20s %8d %9.3f ms %8d %9.3f ms  x%-6.1f%s\n",
+           p->name,p->n,small*1e3,8*p->n,large*1e3,ratio,
+           slow ? "  SUPERLINEAR" : "");
+    if (slow) bad++;
+  }
+  freeOutBuf(text);
+  freeOutBuf(sink);
+  return bad ? 1 : 0;
+}
+
+int main(int argc, char * argv[])
+{ if ((argc == 4) && (strcmp(argv[1],"cases") == 0))
+    return runCases(strtoul(argv[2],NULL,10),strtoul(argv[3],NULL,10));
+  if ((argc == 3) && (strcmp(argv[1],"show") == 0))
+  { OutBuf * text = newOutBuf(stdout);
+    genCase(strtoul(argv[2],NULL,10),text);
+    freeOutBuf(text);
+    return 0;
+  }
+  if ((argc == 2) && (strcmp(argv[1],"probes") == 0))
+    return runProbes();
+  fprintf(stderr,"usage: %s cases <first> <last>\n"
+                 "       %s show <seed>\n"
+                 "       %s probes\n",argv[0],argv[0],argv[0]);
+  return 1;
+}
@@ -0,0 +1,389 @@
+/****************************************************/
+/* File: genprog.c                                  */
+/* Generator of large valid C- programs for the     */
+/* benchmarks: the same seed and sizes always give  */
+/* the same program                                 */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The program has NGLOBALS int globals, NARRAYS
+ * global arrays of the -arrays size, gcd, sort and
+ * the generated functions, each of which may call
+ * one earlier function (outside loops), so the
+ * calls of main stay near n log n. Values are kept
+ * below MODULUS, and products have one constant
+ * factor below 100, so no int overflows
+ */
+#define NGLOBALS 8
+#define NARRAYS 4
+#define NLOCALS 4
+#define MODULUS 9973
+#define MAXPARAMS 3
+#define MAXLOOPS 2 /* nested loops in a function */
+
+static int nfuncs = 100; /* generated functions */
+static int maxDepth = 6; /* nesting of if and while */
+static int exprLen = 12; /* terms of the longest expressions */
+static int arrayLen = 1000; /* elements of the global arrays */
+
+/* xorshift64*: the generator must not depend on
+ * the C library's rand
+ */
+static unsigned long long rngState;
+
+static unsigned int rnd(unsigned int n)
+{ rngState ^= rngState >> 12;
+  rngState ^= rngState << 25;
+  rngState ^= rngState >> 27;
+  return (unsigned int) ((rngState * 2685821657736338717ULL) >> 33) % n;
+}
+
+/* C- identifiers are letters only, so numbers are
+ * written as letter strings after a prefix
+ */
+static char * ident(char * buf, const char * prefix, int k)
+{ char tmp[16], * p;
+  int n = 0;
+  do
+  { tmp[n++] = (char) ('a' + k % 26);
+    k /= 26;
+  } while (k > 0);
+  strcpy(buf,prefix);
+  p = buf + strlen(buf);
+  while (n > 0) *p++ = tmp[--n];
+  *p = '\0';
+  return buf;
+}
+
+/* Function describes a generated function */
+typedef struct
+   { int nparams; /* int parameters */
+     int arrayParam; /* TRUE if it takes int px[] first */
+   } Function;
+
+static Function * funcs;
+
+/* Scope is what a statement of function k can use */
+typedef struct
+   { int k; /* the function */
+     int loops; /* enclosing loops */
+     int called; /* TRUE once it has called another */
+     int depth; /* nesting */
+   } Scope;
+
+static void indent(int n)
+{ while (n-- > 0) fputs("  ",stdout);
+}
+
+/* atom writes an operand bounded by MODULUS */
+static void atom(Scope * s)
+{ char name[16];
+  Function * f = &funcs[s->k];
+  switch (rnd(6))
+  { case 0:
+      printf("%u",rnd(MODULUS));
+      break;
+    case 1:
+      printf("%s",ident(name,"gv",rnd(NGLOBALS)));
+      break;
+    case 2:
+      if (s->loops > 0)
+      { printf("%s",rnd(s->loops) == 0 ? "ia" : "ib");
+        break;
+      }
+      /* fall through */
+    case 3:
+      if (f->nparams > 0)
+      { printf("%s",ident(name,"p",rnd(f->nparams)));
+        break;
+      }
+      /* fall through */
+    case 4:
+      if (f->arrayParam)
+      { printf("px[%u]",rnd(arrayLen));
+        break;
+      }
+      printf("%s[%u]",ident(name,"gt",rnd(NARRAYS)),rnd(arrayLen));
+      break;
+    default:
+      printf("%s",ident(name,"v",rnd(NLOCALS)));
+      break;
+  }
+}
+
+/* term writes an atom, maybe scaled by a constant */
+static void term(Scope * s)
+{ switch (rnd(4))
+  { case 0:
+      atom(s);
+      printf(" * %u",1 + rnd(99));
+      break;
+    case 1:
+      atom(s);
+      printf(" / %u",1 + rnd(99));
+      break;
+    default:
+      atom(s);
+      break;
+  }
+}
+
+/* expr writes n terms joined by + and -, with
+ * some of them grouped in parentheses
+ */
+static void expr(Scope * s, int n)
+{ int i;
+  for (i = 0; i < n; i++)
+  { if (i > 0) fputs(rnd(2) ? " + " : " - ",stdout);
+    if ((n - i > 2) && (rnd(5) == 0))
+    { int m = 2 + rnd(n - i - 1);
+      putchar('(');
+      expr(s,m);
+      putchar(')');
+      i += m - 1;
+    }
+    else term(s);
+  }
+}
+
+static void condition(Scope * s)
+{ static const char * rel[] = { "<", "<=", ">", ">=", "==", "!=" };
+  expr(s,1 + rnd(3));
+  printf(" %s ",rel[rnd(6)]);
+  expr(s,1 + rnd(3));
+}
+
+/* reduce keeps local v below MODULUS */
+static void reduce(Scope * s, char * v)
+{ indent(s->depth);
+  printf("%s = %s - %s / %d * %d;\n",v,v,v,MODULUS,MODULUS);
+}
+
+/* call writes a call of an earlier function */
+static void call(Scope * s, int j)
+{ char name[16];
+  int i;
+  printf("%s(",ident(name,"fn",j));
+  if (funcs[j].arrayParam)
+    printf("%s%s",ident(name,"gt",rnd(NARRAYS)),funcs[j].nparams > 0 ? ", " : "");
+  for (i = 0; i < funcs[j].nparams; i++)
+  { if (i > 0) fputs(", ",stdout);
+    atom(s);
+  }
+  putchar(')');
+}
+
+static void statements(Scope * s, int n);
+
+static void statement(Scope * s)
+{ char v[16], name[16];
+  unsigned int c = rnd(10);
+  ident(v,"v",rnd(NLOCALS));
+  if ((c == 0) && (s->k > 0) && ! s->called && (s->loops == 0))
+  { s->called = 1;
+    indent(s->depth);
+    printf("%s = %s + ",v,v);
+    call(s,rnd(s->k));
+    fputs(";\n",stdout);
+    reduce(s,v);
+  }
+  else if ((c <= 2) && (s->depth < maxDepth))
+  { indent(s->depth);
+    fputs("if (",stdout);
+    condition(s);
+    fputs(")\n",stdout);
+    indent(s->depth);
+    fputs("{\n",stdout);
+    s->depth++;
+    statements(s,1 + rnd(3));
+    s->depth--;
+    indent(s->depth);
+    fputs("}\n",stdout);
+    if (rnd(2))
+    { indent(s->depth);
+      fputs("else\n",stdout);
+      indent(s->depth);
+      fputs("{\n",stdout);
+      s->depth++;
+      statements(s,1 + rnd(3));
+      s->depth--;
+      indent(s->depth);
+      fputs("}\n",stdout);
+    }
+  }
+  else if ((c <= 4) && (s->depth < maxDepth) && (s->loops < MAXLOOPS))
+  { char * i = s->loops == 0 ? "ia" : "ib";
+    indent(s->depth);
+    printf("%s = 0;\n",i);
+    indent(s->depth);
+    printf("while (%s < %u)\n",i,2 + rnd(9));
+    indent(s->depth);
+    fputs("{\n",stdout);
+    s->depth++;
+    s->loops++;
+    statements(s,1 + rnd(3));
+    if (rnd(2))
+    { indent(s->depth);
+      printf("%s[%s] = %s + %s;\n",ident(name,"gt",rnd(NARRAYS)),i,v,i);
+    }
+    indent(s->depth);
+    printf("%s = %s + 1;\n",i,i);
+    s->loops--;
+    s->depth--;
+    indent(s->depth);
+    fputs("}\n",stdout);
+  }
+  else if (c == 5)
+  { indent(s->depth);
+    printf("%s = gcd(",v);
+    atom(s);
+    fputs(", ",stdout);
+    atom(s);
+    fputs(");\n",stdout);
+  }
+  else
+  { indent(s->depth);
+    printf("%s = ",v);
+    expr(s,c == 9 ? exprLen : 1 + rnd(4));
+    fputs(";\n",stdout);
+    reduce(s,v);
+  }
+}
+
+static void statements(Scope * s, int n)
+{ while (n-- > 0) statement(s);
+}
+
+static void function(int k)
+{ Function * f = &funcs[k];
+  Scope s;
+  char name[16];
+  int i;
+  f->arrayParam = rnd(4) == 0;
+  f->nparams = rnd(MAXPARAMS + 1);
+  printf("int %s(",ident(name,"fn",k));
+  if (f->arrayParam) printf("int px[]%s",f->nparams > 0 ? ", " : "");
+  for (i = 0; i < f->nparams; i++)
+    printf("%sint %s",i > 0 ? ", " : "",ident(name,"p",i));
+  if ((f->nparams == 0) && ! f->arrayParam) fputs("void",stdout);
+  fputs(")\n{\n",stdout);
+  for (i = 0; i < NLOCALS; i++)
+    printf("  int %s;\n",ident(name,"v",i));
+  fputs("  int ia;\n  int ib;\n",stdout);
+  for (i = 0; i < NLOCALS; i++)
+    printf("  %s = %u;\n",ident(name,"v",i),rnd(MODULUS));
+  s.k = k;
+  s.loops = 0;
+  s.called = 0;
+  s.depth = 1;
+  statements(&s,3 + rnd(6));
+  printf("  return %s;\n}\n\n",ident(name,"v",rnd(NLOCALS)));
+}
+
+static void prelude(void)
+{ char name[16];
+  int i;
+  for (i = 0; i < NGLOBALS; i++)
+    printf("int %s;\n",ident(name,"gv",i));
+  for (i = 0; i < NARRAYS; i++)
+    printf("int %s[%d];\n",ident(name,"gt",i),arrayLen);
+  fputs("\n"
+        "int gcd(int u, int v)\n"
+        "{\n"
+        "  if (v == 0) return u;\n"
+        "  else return gcd(v, u - u / v * v);\n"
+        "}\n\n"
+        "void sort(int a[], int n)\n"
+        "{\n"
+        "  int i;\n"
+        "  int j;\n"
+        "  int k;\n"
+        "  int t;\n"
+        "  i = 0;\n"
+        "  while (i < n - 1)\n"
+        "  {\n"
+        "    k = i;\n"
+        "    j = i + 1;\n"
+        "    while (j < n)\n"
+        "    {\n"
+        "      if (a[j] < a[k]) k = j;\n"
+        "      j = j + 1;\n"
+        "    }\n"
+        "    t = a[i];\n"
+        "    a[i] = a[k];\n"
+        "    a[k] = t;\n"
+        "    i = i + 1;\n"
+        "  }\n"
+        "}\n\n",stdout);
+}
+
+static void mainFunction(void)
+{ char name[16];
+  int i;
+  fputs("void main(void)\n{\n  int s;\n  int i;\n  i = 0;\n",stdout);
+  printf("  while (i < %d)\n  {\n",arrayLen);
+  for (i = 0; i < NARRAYS; i++)
+    printf("    %s[i] = (i * %d + %d) - (i * %d + %d) / %d * %d;\n",
+           ident(name,"gt",i),37 + 2*i,11 + i,37 + 2*i,11 + i,MODULUS,MODULUS);
+  fputs("    i = i + 1;\n  }\n",stdout);
+  for (i = 0; i < NGLOBALS; i++)
+    printf("  %s = %u;\n",ident(name,"gv",i),rnd(MODULUS));
+  fputs("  s = 0;\n",stdout);
+  for (i = 0; i < nfuncs; i++)
+  { int j;
+    /* the arguments of main are constants */
+    printf("  s = s + %s(",ident(name,"fn",i));
+    if (funcs[i].arrayParam)
+      printf("%s%s",ident(name,"gt",rnd(NARRAYS)),funcs[i].nparams > 0 ? ", " : "");
+    for (j = 0; j < funcs[i].nparams; j++)
+      printf("%s%u",j > 0 ? ", " : "",rnd(MODULUS));
+    fputs(");\n",stdout);
+    printf("  s = s - s / %d * %d;\n",MODULUS,MODULUS);
+    if ((i + 1) % 100 == 0) fputs("  output(s);\n",stdout);
+  }
+  printf("  sort(gta, %d);\n",arrayLen);
+  printf("  output(gta[0] + gta[%d]);\n",arrayLen - 1);
+  for (i = 1; i < NARRAYS; i++)
+    printf("  output(%s[%d]);\n",ident(name,"gt",i),rnd(arrayLen));
+  printf("  output(gcd(s, %u));\n",1 + rnd(MODULUS - 1));
+  fputs("  output(s);\n}\n",stdout);
+}
+
+int main(int argc, char * argv[])
+{ char * prog = argv[0];
+  unsigned long seed;
+  int i;
+  while ((argc > 3) && (argv[1][0] == '-'))
+  { int v = atoi(argv[2]);
+    if (strcmp(argv[1],"-depth") == 0) maxDepth = v;
+    else if (strcmp(argv[1],"-expr") == 0) exprLen = v;
+    else if (strcmp(argv[1],"-arrays") == 0) arrayLen = v;
+    else break;
+    argv += 2;
+    argc -= 2;
+  }
+  if ((argc != 3) || (atoi(argv[2]) < 1) || (maxDepth < 0) ||
+      (exprLen < 1) || (arrayLen < 1))
+  { fprintf(stderr,"usage: %s [-depth n] [-expr n] [-arrays n] <seed> <functions>\n",prog);
+    return 1;
+  }
+  seed = strtoul(argv[1],NULL,10);
+  nfuncs = atoi(argv[2]);
+  rngState = 0x9E3779B97F4A7C15ULL ^ seed;
+  if (rngState == 0) rngState = 1;
+  funcs = (Function *) calloc(nfuncs,sizeof(Function));
+  if (funcs == NULL)
+  { fprintf(stderr,"Out of memory\n");
+    return 1;
+  }
+  printf("/* genprog %lu: %d functions, depth %d, expressions of %d terms */\n\n",
+         seed,nfuncs,maxDepth,exprLen);
+  prelude();
+  for (i = 0; i < nfuncs; i++) function(i);
+  mainFunction();
+  free(funcs);
+  return 0;
+}
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include "outbuf.h"
 
 #ifndef FALSE
 #define FALSE 0
@@ -23,7 +24,7 @@
 #endif
 
 /* MAXRESERVED = the number of reserved words */
-#define MAXRESERVED 8
+#define MAXRESERVED 12
 
 typedef enum 
     /* book-keeping tokens */
@@ -37,8 +38,8 @@ typedef enum
    } TokenType;
 
 extern FILE* source; /* source code text file */
-extern FILE* listing; /* listing output text file */
-extern FILE* code; /* code text file for TM simulator */
+extern OutBuf* listing; /* buffered listing output */
+extern OutBuf* code; /* buffered code output for TM simulator */
 
 extern int lineno; /* source line number for listing */
 
@@ -48,13 +49,23 @@ extern int lineno; /* source line number for listing */
 
 typedef enum {StmtK,ExpK} NodeKind;
 typedef enum {IfK,RepeatK,AssignK,AssignKarr,ReadK,WriteK,CallK, ReturnK,CompK} StmtKind;
-typedef enum {OpK,ConstK,IdK, VarK, FuncK, ArrK, ParamK, AddIK, AddCK, MulIK, MulCK, AddK, SimpIK, SimpNK, AddSI, MulSI,ArrexpK} ExpKind;
+typedef enum {OpK,ConstK,IdK, VarK, FuncK, ArrK, ParamK, ArrexpK} ExpKind;
 
-/* ExpType is used for type checking */
-typedef enum {Void,Integer,Boolean, MtA,AtM} ExpType;
+/* ExpType is used for type checking; IntArray is
+ * the type of an array name and of an int a[] param
+ */
+typedef enum {Void,Integer,Boolean,IntArray} ExpType;
 
 #define MAXCHILDREN 3
 
+/* Expressions are trees of OpK nodes (operands in
+ * child[0] and child[1]) over ConstK, IdK, ArrexpK
+ * (subscript in child[0]) and CallK (name in
+ * attr.name, arguments in child[0]). AssignK and
+ * AssignKarr hold the value in child[0] and, for
+ * AssignKarr, the subscript in child[1]
+ */
+
 typedef struct treeNode
    { struct treeNode * child[MAXCHILDREN];
      struct treeNode * sibling;
@@ -65,9 +76,11 @@ typedef struct treeNode
              int val;
              char * name; } attr;
      ExpType type; /* for type checking of exps */
-     int arr_size;
-     char * simp_name;
-     int simp_val;
+     int arr_size; /* size of an ArrK declaration */
+     struct symbol * sym; /* declaration of the name used
+                             or declared here (analyze) */
+     int need; /* registers to evaluate an expression */
+     int effects; /* what evaluating it touches (cgen) */
    } TreeNode;
 
 /**************************************************/
@@ -102,6 +115,17 @@ extern int TraceAnalyze;
  */
 extern int TraceCode;
 
+/* Optimize = FALSE turns off the optimizations of
+ * opt.c and the IR of ir.c, so that the code
+ * follows the source
+ */
+extern int Optimize;
+
+/* MaxErrors is the number of syntax errors after
+ * which the parser gives up (0: report them all)
+ */
+extern int MaxErrors;
+
 /* Error = TRUE prevents further passes if an error occurs */
 extern int Error; 
 #endif
@@ -0,0 +1,675 @@
+/****************************************************/
+/* File: incr.c                                     */
+/* Incremental compilation for the C- compiler:     */
+/* per-function cache of syntax trees and TM code   */
+/****************************************************/
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "parse.h"
+#include "symtab.h"
+#include "analyze.h"
+#include "cgen.h"
+#include "traverse.h"
+#include "server.h"
+#include "astio.h"
+#include "stats.h"
+#include "opt.h"
+#include "incr.h"
+
+/* CACHE_MAGIC starts every entry; change it when
+ * the entry format or the generated code changes
+ */
+#define CACHE_MAGIC "C-CACHE 7"
+
+/* a token of the program, without white space */
+typedef struct
+   { TokenType type;
+     int lineno;
+     char * text;
+   } Token;
+
+/* Item is one top-level declaration: tokens
+ * first..last of the program
+ */
+typedef struct
+   { int first, last;
+     int isFunc;
+     unsigned long long key; /* functions only */
+     TreeNode * tree;
+     CodeFrag * frag; /* cached code, NULL if none */
+     int reused; /* frag is valid in this program */
+     OutBuf * head; /* entry to store, up to the code */
+   } Item;
+
+/* scanTokens reads all tokens of src; it returns
+ * FALSE on a lexical error, which is left for the
+ * parser to report
+ */
+static int scanTokens(FILE * src, OutBuf * lst, Token ** toks, int * ntoks)
+{ Scanner * scan = newScanner(src,lst);
+  Token * tok = NULL;
+  int n = 0, cap = 0, ok = TRUE;
+  TokenType t;
+  if (scan == NULL) return FALSE;
+  while ((t = getToken(scan)) != ENDFILE)
+  { if (t == NLSP) continue;
+    if ((t == ERROR) || (t == CMTERR) || (t == LEXERR) || (t == TOKENERR))
+    { ok = FALSE;
+      break;
+    }
+    if (n == cap)
+    { Token * bigger;
+      cap = cap ? 2*cap : 1024;
+      bigger = (Token *) realloc(tok,cap * sizeof(Token));
+      if (bigger == NULL)
+      { ok = FALSE;
+        break;
+      }
+      tok = bigger;
+    }
+    tok[n].type = t;
+    tok[n].lineno = scan->lineno;
+    tok[n].text = copyString(scan->tokenString);
+    n++;
+  }
+  freeScanner(scan);
+  *toks = tok;
+  *ntoks = n;
+  return ok;
+}
+
+/* splitItems divides the tokens into top-level
+ * declarations: "type ID ... ;" or "type ID ( ... ) {
+ * ... }". It returns FALSE for anything else, which
+ * is left for the parser to report
+ */
+static int splitItems(Token * tok, int n, Item ** items, int * nitems)
+{ Item * item = NULL;
+  int i = 0, j, depth, count = 0, cap = 0;
+  while (i < n)
+  { if (((tok[i].type != INT) && (tok[i].type != VOID)) ||
+        (i+1 >= n) || (tok[i+1].type != ID))
+      break;
+    if (count == cap)
+    { Item * bigger;
+      cap = cap ? 2*cap : 64;
+      bigger = (Item *) realloc(item,cap * sizeof(Item));
+      if (bigger == NULL) break;
+      item = bigger;
+    }
+    memset(&item[count],0,sizeof(Item));
+    item[count].first = i;
+    if ((i+2 < n) && (tok[i+2].type == LPAREN))
+    { for (j = i+3; (j < n) && (tok[j].type != LBRAC); j++)
+        if ((tok[j].type == SEMI) || (tok[j].type == RBRAC)) break;
+      if ((j == n) || (tok[j].type != LBRAC)) break;
+      for (depth = 0; j < n; j++)
+        if (tok[j].type == LBRAC) depth++;
+        else if ((tok[j].type == RBRAC) && (--depth == 0)) break;
+      if (j == n) break;
+      item[count].isFunc = TRUE;
+    }
+    else
+    { for (j = i+2; (j < n) && (tok[j].type != SEMI); j++)
+        if ((tok[j].type == LBRAC) || (tok[j].type == RBRAC) ||
+            (tok[j].type == INT) || (tok[j].type == VOID)) break;
+      if ((j == n) || (tok[j].type != SEMI)) break;
+    }
+    item[count++].last = j;
+    i = j+1;
+  }
+  *items = item;
+  *nitems = count;
+  return (i == n) && (count > 0);
+}
+
+/* FNV-1a, 64 bits */
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static unsigned long long fnv(unsigned long long h, const void * p, size_t n)
+{ const unsigned char * s = (const unsigned char *) p;
+  while (n-- > 0) h = (h ^ *s++) * FNV_PRIME;
+  return h;
+}
+
+/* hashItem hashes the tokens of an item with their
+ * lines relative to its first token: the line
+ * numbers in the tree depend on them. Code built
+ * with and without -O0 is kept apart
+ */
+static unsigned long long hashItem(Token * tok, Item * it)
+{ unsigned long long h = fnv(FNV_OFFSET,CACHE_MAGIC,strlen(CACHE_MAGIC));
+  int base = tok[it->first].lineno, i;
+  h = fnv(h,&Optimize,sizeof(Optimize));
+  for (i = it->first; i <= it->last; i++)
+  { int head[2];
+    head[0] = tok[i].type;
+    head[1] = tok[i].lineno - base;
+    h = fnv(h,head,sizeof(head));
+    h = fnv(h,tok[i].text,strlen(tok[i].text)+1);
+  }
+  return h;
+}
+
+static void entryPath(char * path, size_t size, char * dir, unsigned long long key)
+{ snprintf(path,size,"%s/%016llx.fn",dir,key);
+}
+
+/**************************************************/
+/*************   Cache entry output   *************/
+/**************************************************/
+
+/* treeHash hashes the tree of function f, which
+ * the code of the functions it is inlined into
+ * depends on
+ */
+static unsigned long long treeHash(TreeNode * f)
+{ TreeNode * sibling = f->sibling;
+  OutBuf * ob = newOutBuf(NULL);
+  unsigned long long h;
+  if (ob == NULL) return 0;
+  f->sibling = NULL;
+  serializeTree(ob,f,f->lineno);
+  f->sibling = sibling;
+  h = fnv(FNV_OFFSET,ob->buf,ob->len);
+  freeOutBuf(ob);
+  return h;
+}
+
+/* signature describes what global symbol s is to
+ * the functions using it: v (variable), a (array),
+ * or f with the return type and a letter per
+ * parameter, b in front for a built-in function.
+ * A function that may be inlined (see opt.h) adds
+ * =<hash of its tree>
+ */
+static char * signature(Symbol * s)
+{ char * sig = (char *) malloc(s->size + 21);
+  char * p = sig;
+  TreeNode * param;
+  if (sig == NULL) return NULL;
+  switch (s->kind)
+  { case VarSym: *p++ = 'v'; break;
+    case ArraySym: *p++ = 'a'; break;
+    default:
+      if (s->decl == NULL) *p++ = 'b';
+      *p++ = 'f';
+      *p++ = s->type == Void ? 'v' : 'i';
+      if (s->decl != NULL)
+      { for (param = s->decl->child[0]; param != NULL; param = param->sibling)
+          if (param->type != Void)
+            *p++ = param->type == IntArray ? 'a' : 'i';
+      }
+      else if (s->size > 0) *p++ = 'i';
+      if ((s->decl != NULL) && mayInline(s->decl))
+        p += sprintf(p,"=%016llx",treeHash(s->decl));
+      break;
+  }
+  *p = '\0';
+  return sig;
+}
+
+/* DepList collects the global symbols used by a
+ * function, each once, with those used by the
+ * functions it may inline
+ */
+typedef struct
+   { Symbol ** sym;
+     int n, cap;
+   } DepList;
+
+static int addDep(TreeNode * t, int depth, void * arg)
+{ DepList * d = (DepList *) arg;
+  Symbol * s = t->sym;
+  int i;
+  if ((s == NULL) || (s->level != 0)) return TRUE;
+  for (i = 0; i < d->n; i++)
+    if (d->sym[i] == s) return TRUE;
+  /* a function inlined calls no other, so this
+     goes one call deep */
+  if ((s->kind == FuncSym) && (s->decl != NULL) && mayInline(s->decl))
+  { TreeVisitor dv = { addDep, NULL, NULL, d };
+    walkTree(s->decl->child[1],&dv);
+  }
+  if (d->n == d->cap)
+  { Symbol ** bigger;
+    int cap = d->cap ? 2*d->cap : 16;
+    bigger = (Symbol **) realloc(d->sym,cap * sizeof(Symbol *));
+    if (bigger == NULL) return TRUE;
+    d->sym = bigger;
+    d->cap = cap;
+  }
+  d->sym[d->n++] = s;
+  return TRUE;
+}
+
+/* entryHead writes the entry of function f up to
+ * its code: the global names it uses and its tree.
+ * It is taken before opt.c changes the tree, so
+ * that a reused function reads as it was parsed
+ */
+static OutBuf * entryHead(TreeNode * f, int base)
+{ TreeNode * sibling = f->sibling;
+  DepList deps = { NULL, 0, 0 };
+  TreeVisitor dv = { addDep, NULL, NULL, &deps };
+  OutBuf * head, * ast;
+  int i;
+  head = newOutBuf(NULL);
+  ast = newOutBuf(NULL);
+  if ((head == NULL) || (ast == NULL))
+  { freeOutBuf(head);
+    freeOutBuf(ast);
+    return NULL;
+  }
+  f->sibling = NULL;
+  walkTree(f,&dv);
+  obPrintf(head,"%s\ndeps %d\n",CACHE_MAGIC,deps.n);
+  for (i = 0; i < deps.n; i++)
+  { char * sig = signature(deps.sym[i]);
+    obPrintf(head,"%s %s\n",deps.sym[i]->name,sig != NULL ? sig : "?");
+    free(sig);
+  }
+  serializeTree(ast,f,base);
+  f->sibling = sibling;
+  obPrintf(head,"ast %lu\n",(unsigned long) ast->len);
+  obWrite(head,ast->buf,ast->len);
+  freeOutBuf(ast);
+  free(deps.sym);
+  return head;
+}
+
+/* storeEntry writes an entry, head and code,
+ * through a temporary file so that readers never
+ * see half an entry
+ */
+static void storeEntry(char * dir, unsigned long long key, OutBuf * head,
+                       CodeFrag * frag)
+{ char path[1024], tmp[1100];
+  FILE * out;
+  int i, ok;
+  if (head == NULL) return;
+  entryPath(path,sizeof(path),dir,key);
+  snprintf(tmp,sizeof(tmp),"%s.%ld",path,(long) getpid());
+  out = fopen(tmp,"wb");
+  if (out == NULL) return;
+  fwrite(head->buf,1,head->len,out);
+  fprintf(out,"code %d\n",frag->size);
+  for (i = 0; i < frag->size; i++)
+  { TMInstr * c = &frag->code[i];
+    fprintf(out,"%s %d %d %d %d %s\n",c->op[0] ? c->op : "-",
+            c->r,c->a,c->b,c->rm,c->sym != NULL ? c->sym : "-");
+  }
+  fputs("end\n",out);
+  ok = ! ferror(out);
+  if ((fclose(out) != 0) || ! ok || (rename(tmp,path) != 0))
+    remove(tmp);
+}
+
+/**************************************************/
+/*************   Cache entry input   **************/
+/**************************************************/
+
+/* Entry is a cache entry read back: the global
+ * names used, with their signatures
+ */
+typedef struct
+   { int ndeps;
+     char ** names;
+     char ** sigs;
+   } Entry;
+
+/* readLine reads one line without its newline */
+static int readLine(FILE * in, char * line, int size)
+{ int n;
+  if (fgets(line,size,in) == NULL) return FALSE;
+  n = strlen(line);
+  if ((n == 0) || (line[n-1] != '\n')) return FALSE;
+  line[n-1] = '\0';
+  return TRUE;
+}
+
+/* readTree reads the tree of an entry, n bytes
+ * in the format of astio.h, placing its first line
+ * at base
+ */
+static TreeNode * readTree(FILE * in, size_t n, int base)
+{ char * buf = (char *) malloc(n + 1);
+  TreeNode * root = NULL;
+  size_t used;
+  int error = TRUE;
+  if (buf == NULL) return NULL;
+  if (fread(buf,1,n,in) == n)
+    root = deserializeTree(buf,n,base,&used,&error);
+  free(buf);
+  /* a damaged entry is a miss; its nodes are not
+     freed, like the trees of the compiler */
+  if (error || (used != n) || (root == NULL) || (root->sibling != NULL))
+    return NULL;
+  return root;
+}
+
+/* readFrag reads the code part of an entry */
+static CodeFrag * readFrag(FILE * in)
+{ char line[256], op[16], sym[200];
+  CodeFrag * frag;
+  int i, n;
+  if (! readLine(in,line,sizeof(line)) ||
+      (sscanf(line,"code %d",&n) != 1) || (n < 0))
+    return NULL;
+  frag = newCodeFrag();
+  if (frag == NULL) return NULL;
+  frag->code = (TMInstr *) calloc(n+1,sizeof(TMInstr));
+  if (frag->code == NULL)
+  { freeCodeFrag(frag);
+    return NULL;
+  }
+  frag->size = frag->cap = n;
+  for (i = 0; i < n; i++)
+  { TMInstr * c = &frag->code[i];
+    if (! readLine(in,line,sizeof(line)) ||
+        (sscanf(line,"%15s %d %d %d %d %199s",op,&c->r,&c->a,&c->b,
+                &c->rm,sym) != 6) ||
+        (strlen(op) >= sizeof(c->op)))
+    { freeCodeFrag(frag);
+      return NULL;
+    }
+    if (strcmp(op,"-") != 0) strcpy(c->op,op);
+    if (strcmp(sym,"-") != 0) c->sym = copyString(sym);
+  }
+  if (! readLine(in,line,sizeof(line)) || (strcmp(line,"end") != 0))
+  { freeCodeFrag(frag);
+    return NULL;
+  }
+  return frag;
+}
+
+static void freeEntry(Entry * e)
+{ int i;
+  for (i = 0; i < e->ndeps; i++)
+  { free(e->names[i]);
+    free(e->sigs[i]);
+  }
+  free(e->names);
+  free(e->sigs);
+  e->ndeps = 0;
+  e->names = e->sigs = NULL;
+}
+
+/* loadEntry reads the entry of item it into it and
+ * e; it returns FALSE if there is none usable
+ */
+static int loadEntry(char * dir, Item * it, int base, Entry * e)
+{ char path[1024], line[256], name[200], sig[200];
+  FILE * in;
+  unsigned long len;
+  int i, n, ok = FALSE;
+  e->ndeps = 0;
+  e->names = e->sigs = NULL;
+  entryPath(path,sizeof(path),dir,it->key);
+  in = fopen(path,"rb");
+  if (in == NULL) return FALSE;
+  if (readLine(in,line,sizeof(line)) && (strcmp(line,CACHE_MAGIC) == 0) &&
+      readLine(in,line,sizeof(line)) && (sscanf(line,"deps %d",&n) == 1) &&
+      (n >= 0))
+  { e->names = (char **) calloc(n+1,sizeof(char *));
+    e->sigs = (char **) calloc(n+1,sizeof(char *));
+    for (i = 0; (e->names != NULL) && (e->sigs != NULL) && (i < n); i++)
+    { if (! readLine(in,line,sizeof(line)) ||
+          (sscanf(line,"%199s %199s",name,sig) != 2))
+        break;
+      e->names[i] = copyString(name);
+      e->sigs[i] = copyString(sig);
+      e->ndeps++;
+    }
+    if ((e->ndeps == n) && readLine(in,line,sizeof(line)) &&
+        (sscanf(line,"ast %lu",&len) == 1))
+    { it->tree = readTree(in,len,base);
+      if (it->tree != NULL) it->frag = readFrag(in);
+      ok = it->frag != NULL;
+    }
+  }
+  fclose(in);
+  if (! ok)
+  { freeEntry(e);
+    it->tree = NULL;
+  }
+  return ok;
+}
+
+/* depsValid checks that the global names used by a
+ * cached function still denote what they did when
+ * it was compiled
+ */
+static int depsValid(Entry * e)
+{ int i, ok = TRUE;
+  for (i = 0; ok && (i < e->ndeps); i++)
+  { Symbol * s = st_lookup(e->names[i]);
+    char * sig = s != NULL ? signature(s) : NULL;
+    ok = (sig != NULL) && (strcmp(sig,e->sigs[i]) == 0);
+    free(sig);
+  }
+  return ok;
+}
+
+/**************************************************/
+/*************   Incremental compile   ************/
+/**************************************************/
+
+/* sourceText rebuilds the program text for the
+ * parser, every token on its original line. A cached
+ * function is replaced by a stub "type ID ;" on its
+ * first line: the line numbers the parser gives a
+ * declaration depend on the token after it
+ */
+static char * sourceText(Token * tok, Item * item, int nitems, size_t * len)
+{ OutBuf * ob = newOutBuf(NULL);
+  char * text;
+  int i, k, line = 1;
+  if (ob == NULL) return NULL;
+  for (i = 0; i < nitems; i++)
+  { int last = item[i].tree != NULL ? item[i].first+1 : item[i].last;
+    for (k = item[i].first; k <= last; k++)
+    { for (; line < tok[k].lineno; line++) obPutc(ob,'\n');
+      obPuts(ob,tok[k].text);
+      obPutc(ob,' ');
+    }
+    if (item[i].tree != NULL) obPutc(ob,';');
+  }
+  obPutc(ob,'\n');
+  text = ob->buf;
+  *len = ob->len;
+  ob->buf = NULL;
+  freeOutBuf(ob);
+  return text;
+}
+
+/* codeFileName returns pgm with its extension
+ * replaced by .tm, as compileSource names it
+ */
+static char * codeFileName(char * pgm)
+{ int fnlen = strcspn(pgm,".");
+  char * codefile = (char *) calloc(fnlen+4, sizeof(char));
+  if (codefile == NULL) return NULL;
+  strncpy(codefile,pgm,fnlen);
+  strcat(codefile,".tm");
+  return codefile;
+}
+
+/* compileItems compiles the program split into
+ * items; it returns -1 if the program must be
+ * compiled without the cache
+ */
+static int compileItems(Token * tok, Item * item, int nitems, char * pgm,
+                        char * dir, int * hits, int * total)
+{ Entry * entry;
+  TreeNode * tree = NULL, * parsed = NULL, ** tail = &tree;
+  CodeFrag ** frags;
+  char * text;
+  size_t len;
+  int i, nfuncs = 0, result = -1;
+  entry = (Entry *) calloc(nitems,sizeof(Entry));
+  frags = (CodeFrag **) calloc(nitems+1,sizeof(CodeFrag *));
+  if ((entry == NULL) || (frags == NULL))
+  { free(entry);
+    free(frags);
+    return -1;
+  }
+  for (i = 0; i < nitems; i++)
+    if (item[i].isFunc)
+    { item[i].key = hashItem(tok,&item[i]);
+      loadEntry(dir,&item[i],tok[item[i].first].lineno,&entry[i]);
+    }
+  /* parse the declarations not found in the cache,
+     into a scratch listing: on a syntax error the
+     program is compiled again without the cache */
+  text = sourceText(tok,item,nitems,&len);
+  if (text != NULL)
+  { OutBuf * scratch = newOutBuf(NULL);
+    FILE * in = fmemopen(text,len,"r");
+    int err = TRUE;
+    if ((scratch != NULL) && (in != NULL))
+      parsed = parseSource(in,scratch,&err);
+    if (in != NULL) fclose(in);
+    freeOutBuf(scratch);
+    free(text);
+    if (err) goto done;
+  }
+  /* merge cached and parsed declarations in order,
+     dropping the stubs of the cached functions */
+  for (i = 0; i < nitems; i++)
+  { if (parsed == NULL) goto done;
+    if (item[i].tree == NULL) item[i].tree = parsed;
+    parsed = parsed->sibling;
+    *tail = item[i].tree;
+    tail = &item[i].tree->sibling;
+  }
+  *tail = NULL;
+  if (parsed != NULL) goto done;
+  result = TRUE;
+  phaseEnd(ParsePhase);
+  if (Stats != NULL) Stats->nodes = countNodes(tree);
+
+  obPuts(listing,"\nTINY COMPILATION: ");
+  obPuts(listing,pgm);
+  obPutc(listing,'\n');
+  if (TraceParse) {
+    obPuts(listing,"\nSyntax tree:\n");
+    printTree(tree);
+  }
+  obFlush(listing);
+
+  /* a cached function is reused if it is declared
+     once and the globals it uses are unchanged.
+     When optimizing, the cached trees are resolved
+     too: the signatures look into the functions
+     that may be inlined, and optimize inlines into
+     the cached trees as it did into their code, so
+     that it leaves out the same functions */
+  phaseStart(SymtabPhase);
+  declareGlobals(tree);
+  if (Optimize)
+    for (i = 0; i < nitems; i++)
+      if (item[i].isFunc) resolveFunction(item[i].tree);
+  for (i = 0; i < nitems; i++)
+  { if (! item[i].isFunc) continue;
+    nfuncs++;
+    item[i].reused = (item[i].frag != NULL) && (item[i].tree->sym != NULL) &&
+                     depsValid(&entry[i]);
+    if (item[i].reused) (*hits)++;
+  }
+  *total = nfuncs;
+  if (! Optimize)
+    for (i = 0; i < nitems; i++)
+      if (item[i].isFunc && ! item[i].reused) resolveFunction(item[i].tree);
+  phaseEnd(SymtabPhase);
+  phaseStart(CheckPhase);
+  for (i = 0; i < nitems; i++)
+    if (item[i].isFunc && ! item[i].reused) checkFunction(item[i].tree);
+  checkMain();
+  obFlush(listing);
+  phaseEnd(CheckPhase);
+  if (Stats != NULL) st_stats(&Stats->symtab);
+
+  if ((! Error) && (code != NULL))
+  { char * codefile = codeFileName(pgm);
+    int f = 0;
+    for (i = 0; i < nitems; i++)
+      if (item[i].isFunc && ! item[i].reused)
+        item[i].head = entryHead(item[i].tree,tok[item[i].first].lineno);
+    /* the trees from the cache are optimized too,
+       for the calls that decide which functions are
+       left out; their code is not generated again.
+       Functions left out are still generated for
+       the cache */
+    optimize(tree);
+    phaseStart(CodePhase);
+    for (i = 0; i < nitems; i++)
+    { if (! item[i].isFunc) continue;
+      if (! item[i].reused)
+      { freeCodeFrag(item[i].frag);
+        item[i].frag = genFunction(item[i].tree);
+      }
+      frags[f++] = item[i].tree->sym->dead ? NULL : item[i].frag;
+    }
+    if ((! Error) && (codefile != NULL))
+    { linkProgram(tree,frags,codefile);
+      for (i = 0; i < nitems; i++)
+        if (item[i].isFunc && ! item[i].reused)
+          storeEntry(dir,item[i].key,item[i].head,item[i].frag);
+    }
+    obFlush(code);
+    obFlush(listing);
+    free(codefile);
+    phaseEnd(CodePhase);
+  }
+done:
+  for (i = 0; i < nitems; i++)
+  { freeCodeFrag(item[i].frag);
+    freeOutBuf(item[i].head);
+    freeEntry(&entry[i]);
+  }
+  free(entry);
+  free(frags);
+  return result;
+}
+
+/* Function compileCached compiles like compileSource
+ * (in main.c), reusing and updating the cache in
+ * directory dir. *hits and *total count the reused
+ * and all functions of the program
+ */
+int compileCached(FILE * src, char * pgm, OutBuf * lst, OutBuf * codefp,
+                  char * dir, int * hits, int * total)
+{ Token * tok = NULL;
+  Item * item = NULL;
+  int ntoks = 0, nitems = 0, i, result = -1;
+  *hits = *total = 0;
+  source = src;
+  listing = lst;
+  code = codefp;
+  Error = FALSE;
+  /* the parse phase takes in scanning, splitting
+     and loading the cache entries */
+  phaseStart(ParsePhase);
+  if (! EchoSource && ! TraceScan && ! TraceAnalyze && ! TraceCode &&
+      scanTokens(src,lst,&tok,&ntoks) &&
+      splitItems(tok,ntoks,&item,&nitems))
+  { mkdir(dir,0777);
+    result = compileItems(tok,item,nitems,pgm,dir,hits,total);
+    /* not the tokens of the stubs parsed */
+    if ((result >= 0) && (Stats != NULL)) Stats->tokens = ntoks;
+  }
+  if (result < 0) phaseEnd(ParsePhase);
+  for (i = 0; i < ntoks; i++) free(tok[i].text);
+  free(tok);
+  free(item);
+  if (result >= 0) return result;
+  *hits = *total = 0;
+  rewind(src);
+  return compileSource(src,pgm,lst,codefp);
+}
@@ -0,0 +1,47 @@
+/****************************************************/
+/* File: incr.h                                     */
+/* Incremental compilation for the C- compiler:     */
+/* per-function cache of syntax trees and TM code   */
+/****************************************************/
+
+#ifndef _INCR_H_
+#define _INCR_H_
+
+/* The cache is a directory with one entry per
+ * function, named by a 64-bit hash of the tokens of
+ * the function (with their line offsets) and holding
+ * its syntax tree, the global names it uses with
+ * their kinds, and its TM code fragment:
+ *
+ *   C-CACHE 7
+ *   deps <n>            n lines: <name> <signature>
+ *   ast <n>             n bytes of tree, see astio.h,
+ *                       as parsed (before opt.c)
+ *   code <n>            n lines: <op> <r> <a> <b> <rm> <sym>
+ *   end
+ *
+ * A function whose tokens hash to an entry is not
+ * parsed, analyzed or generated again, as long as
+ * the global names it uses still have the recorded
+ * kinds; the other functions are compiled as usual,
+ * and all are linked anew. The kind of a function
+ * that may be inlined includes a hash of its tree,
+ * and the names it uses count as used by its
+ * callers, whose code holds copies of it. Such a
+ * function calls no other in its tree as parsed,
+ * which is what opt.c judges inlining by, so the
+ * copies go just one call deep.
+ */
+
+/* Function compileCached compiles like compileSource
+ * (in main.c), reusing and updating the cache in
+ * directory dir. *hits and *total count the reused
+ * and all functions of the program. Tracing other
+ * than TraceParse, and programs the cache cannot
+ * split into declarations, are compiled by
+ * compileSource without the cache
+ */
+int compileCached(FILE * src, char * pgm, OutBuf * lst, OutBuf * codefp,
+                  char * dir, int * hits, int * total);
+
+#endif
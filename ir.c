@@ -0,0 +1,1150 @@
+/****************************************************/
+/* File: ir.c                                       */
+/* Intermediate representation of the C- compiler: */
+/* lowering from the syntax tree, control flow      */
+/* graph, dominators and SSA form                   */
+/****************************************************/
+
+#include "globals.h"
+#include "symtab.h"
+#include "traverse.h"
+#include "stats.h"
+#include "ir.h"
+
+/* Function irGrow makes room in array *p of *cap
+ * elements for element n; it returns FALSE if out
+ * of memory
+ */
+int irGrow(void * p, int * cap, int n, size_t size)
+{ void ** a = (void **) p;
+  void * bigger;
+  int newCap;
+  if (n < *cap) return TRUE;
+  newCap = *cap ? 2 * *cap : 16;
+  while (newCap <= n) newCap *= 2;
+  bigger = realloc(*a,newCap * size);
+  if (bigger == NULL)
+  { obPuts(listing,"Out of memory error in code generator\n");
+    Error = TRUE;
+    return FALSE;
+  }
+  *a = bigger;
+  *cap = newCap;
+  return TRUE;
+}
+
+/* Procedure freeIrFunc releases the IR of a function */
+void freeIrFunc(IrFunc * f)
+{ int b, i;
+  if (f == NULL) return;
+  for (b = 0; b < f->nblocks; b++)
+  { for (i = 0; i < f->block[b].n; i++)
+      free(f->block[b].code[i].args);
+    free(f->block[b].code);
+    free(f->block[b].pred);
+  }
+  free(f->block);
+  free(f->order);
+  free(f->var);
+  free(f);
+}
+
+/* Function irTerminator returns the last
+ * instruction of block b if it ends the block, or
+ * NULL
+ */
+IrInstr * irTerminator(IrBlock * b)
+{ IrInstr * i;
+  if (b->n == 0) return NULL;
+  i = &b->code[b->n-1];
+  if ((i->op == IrJump) || (i->op == IrBranch) || (i->op == IrRet))
+    return i;
+  return NULL;
+}
+
+/* insertInstr inserts i into block b at index at
+ * and returns it in place
+ */
+static IrInstr * insertInstr(IrBlock * b, int at, IrInstr * i)
+{ if (! irGrow(&b->code,&b->cap,b->n,sizeof(IrInstr))) return NULL;
+  memmove(&b->code[at+1],&b->code[at],(b->n - at) * sizeof(IrInstr));
+  b->code[at] = *i;
+  b->n++;
+  return &b->code[at];
+}
+
+/* newInstr fills in an instruction with no
+ * symbol or arguments
+ */
+static void newInstr(IrInstr * i, IrOp op, int d, int a, int b, int val)
+{ i->op = op;
+  i->d = d;
+  i->a = a;
+  i->b = b;
+  i->val = val;
+  i->sym = NULL;
+  i->args = NULL;
+  i->nargs = 0;
+}
+
+/* Procedure irRemoveEdge removes the edge from
+ * block from to its successor number i, with the
+ * phi arguments that came along it
+ */
+void irRemoveEdge(IrFunc * f, int from, int i)
+{ IrBlock * s = &f->block[f->block[from].succ[i]];
+  int j, k;
+  for (j = s->npred - 1; j >= 0; j--)
+    if (s->pred[j] == from) break;
+  if (j >= 0)
+  { memmove(&s->pred[j],&s->pred[j+1],(s->npred - j - 1) * sizeof(int));
+    s->npred--;
+    for (k = 0; (k < s->n) && (s->code[k].op == IrPhi); k++)
+    { IrInstr * phi = &s->code[k];
+      memmove(&phi->args[j],&phi->args[j+1],(phi->nargs - j - 1) * sizeof(int));
+      phi->nargs--;
+    }
+  }
+  if (i == 0) f->block[from].succ[0] = f->block[from].succ[1];
+  f->block[from].nsucc--;
+}
+
+/* Procedure irCompact drops the IrNop instructions */
+void irCompact(IrFunc * f)
+{ int b, i, n;
+  for (b = 0; b < f->nblocks; b++)
+  { IrBlock * bl = &f->block[b];
+    for (i = 0, n = 0; i < bl->n; i++)
+      if (bl->code[i].op == IrNop) free(bl->code[i].args);
+      else bl->code[n++] = bl->code[i];
+    bl->n = n;
+  }
+}
+
+/**************************************************/
+/**********   Lowering   **************************/
+/**************************************************/
+
+/* The lowering is a walk of the syntax tree like
+ * the one of cgen.c. Expressions leave their value
+ * on an operand stack; so do assignments, which
+ * are expressions too. A value nobody takes is
+ * dropped at the end of the enclosing statement. if and while keep their
+ * blocks and the stack height on a second stack.
+ */
+
+/* fn is the function being lowered, cur the block
+ * code goes to and body the block after the entry
+ */
+static IrFunc * fn = NULL;
+static int cur = 0;
+static int body = 0;
+
+static int * operands = NULL;
+static int top = 0;
+static int opCap = 0;
+
+static int * marks = NULL;
+static int markTop = 0;
+static int markCap = 0;
+
+/* params are the variables of the parameters */
+static int * params = NULL;
+static int nparams = 0;
+static int paramCap = 0;
+
+/* tailCall is the call returned by the return
+ * statement being lowered, if it is a self tail call
+ */
+static TreeNode * tailCall = NULL;
+
+static void push(int v)
+{ if (irGrow(&operands,&opCap,top,sizeof(int))) operands[top++] = v;
+}
+
+static int pop(void)
+{ return top > 0 ? operands[--top] : -1;
+}
+
+static void pushMark(int m)
+{ if (irGrow(&marks,&markCap,markTop,sizeof(int))) marks[markTop++] = m;
+}
+
+static int popMark(void)
+{ return markTop > 0 ? marks[--markTop] : 0;
+}
+
+static int newBlock(IrFunc * f)
+{ IrBlock * b;
+  if (! irGrow(&f->block,&f->bcap,f->nblocks,sizeof(IrBlock))) return 0;
+  b = &f->block[f->nblocks];
+  memset(b,0,sizeof(IrBlock));
+  b->rpo = -1;
+  b->idom = -1;
+  return f->nblocks++;
+}
+
+static int newValue(void)
+{ return fn->nvalues++;
+}
+
+/* emit appends an instruction to the current block */
+static IrInstr * emit(IrOp op, int d, int a, int b, int val)
+{ IrBlock * bl = &fn->block[cur];
+  if (! irGrow(&bl->code,&bl->cap,bl->n,sizeof(IrInstr))) return NULL;
+  newInstr(&bl->code[bl->n],op,d,a,b,val);
+  return &bl->code[bl->n++];
+}
+
+/* value emits an instruction defining a new value
+ * and returns the value
+ */
+static int value(IrOp op, int a, int b, int val, Symbol * sym)
+{ int d = newValue();
+  IrInstr * i = emit(op,d,a,b,val);
+  if (i != NULL) i->sym = sym;
+  return d;
+}
+
+static void addEdge(int from, int to)
+{ IrBlock * s = &fn->block[to];
+  if (! irGrow(&s->pred,&s->pcap,s->npred,sizeof(int))) return;
+  s->pred[s->npred++] = from;
+  fn->block[from].succ[fn->block[from].nsucc++] = to;
+}
+
+/* jump ends the current block with a jump to block to */
+static void jump(int to)
+{ emit(IrJump,-1,-1,-1,0);
+  addEdge(cur,to);
+}
+
+static void branch(int c, int then, int other)
+{ emit(IrBranch,-1,c,-1,0);
+  addEdge(cur,then);
+  addEdge(cur,other);
+}
+
+static int isLocal(Symbol * s)
+{ return s->level > 0;
+}
+
+/* varOf returns the variable of local scalar s,
+ * making one on its first use in the function
+ */
+static int varOf(Symbol * s)
+{ if ((s->var >= 0) && (s->var < fn->nvars) && (fn->var[s->var] == s))
+    return s->var;
+  if (! irGrow(&fn->var,&fn->vcap,fn->nvars,sizeof(Symbol *))) return 0;
+  fn->var[fn->nvars] = s;
+  s->var = fn->nvars;
+  return fn->nvars++;
+}
+
+/* collectVar is the preorder visitor that numbers
+ * the variables before any temporary, so that
+ * they are values 0 to nvars-1
+ */
+static int collectVar(TreeNode * t, int depth, void * arg)
+{ Symbol * s = t->sym;
+  if ((s != NULL) && isLocal(s) &&
+      ((s->kind == VarSym) || (s->kind == ArrayParamSym)))
+    varOf(s);
+  return TRUE;
+}
+
+/* element fills in the address of element a of
+ * array s in memory instruction i
+ */
+static void element(IrInstr * i, Symbol * s, int a)
+{ if (s->kind == ArrayParamSym)
+  { i->a = value(IrBin,varOf(s),a,PLUS,NULL);
+    return;
+  }
+  i->a = a;
+  i->sym = s;
+  i->val = isLocal(s) ? s->loc : 0;
+}
+
+/* load returns the value of element a of array s */
+static int load(Symbol * s, int a)
+{ IrInstr i;
+  int d;
+  newInstr(&i,IrLoad,-1,-1,-1,0);
+  element(&i,s,a);
+  d = value(IrLoad,i.a,-1,i.val,i.sym);
+  return d;
+}
+
+/* use returns the value of the name s in an
+ * expression: a variable, a global's load or an
+ * array's address
+ */
+static int use(Symbol * s)
+{ if ((s->kind == VarSym) || (s->kind == ArrayParamSym))
+  { if (isLocal(s)) return varOf(s);
+    return value(IrLoad,-1,-1,0,s);
+  }
+  return value(IrAddr,-1,-1,0,s);
+}
+
+/* assign stores v into scalar s */
+static void assign(Symbol * s, int v)
+{ IrInstr * i;
+  if (isLocal(s))
+  { emit(IrCopy,varOf(s),v,-1,0);
+    return;
+  }
+  i = emit(IrStore,-1,-1,v,0);
+  if (i != NULL) i->sym = s;
+}
+
+/* store stores v into element a of array s */
+static void store(Symbol * s, int a, int v)
+{ IrInstr i;
+  IrInstr * st;
+  newInstr(&i,IrStore,-1,-1,v,0);
+  element(&i,s,a);
+  st = emit(IrStore,-1,i.a,v,i.val);
+  if (st != NULL) st->sym = i.sym;
+}
+
+/* isTailCall tells whether t, returned by the
+ * function being lowered, is a call of it
+ */
+static int isTailCall(TreeNode * t)
+{ return (t != NULL) && (t->nodekind == StmtK) &&
+         (t->kind.stmt == CallK) && (t->sym == fn->sym);
+}
+
+/* lowerTailCall makes the arguments args the
+ * parameters and jumps back to the body; an
+ * argument that is a parameter is copied first,
+ * since the parameters change in turn
+ */
+static void lowerTailCall(int * args, int n)
+{ int i;
+  for (i = 0; (i < n) && (i < nparams); i++)
+    if ((args[i] < fn->nvars) && (args[i] != params[i]))
+    { int t = newValue();
+      emit(IrCopy,t,args[i],-1,0);
+      args[i] = t;
+    }
+  for (i = 0; (i < n) && (i < nparams); i++)
+    if (args[i] != params[i]) emit(IrCopy,params[i],args[i],-1,0);
+  jump(body);
+  cur = newBlock(fn);
+  if (Stats != NULL) Stats->tailCalls++;
+}
+
+/* lowerCall lowers call t, whose n arguments are
+ * on top of the operand stack
+ */
+static void lowerCall(TreeNode * t, int n)
+{ int * args = &operands[top - n];
+  int d = -1;
+  IrInstr * i;
+  if (t->sym->decl == NULL)
+  { if (t->sym->size == 0) d = value(IrIn,-1,-1,0,NULL);
+    else emit(IrOut,-1,args[0],-1,0);
+  }
+  else if (t == tailCall) lowerTailCall(args,n);
+  else
+  { if (t->sym->type != Void) d = newValue();
+    i = emit(IrCall,d,-1,-1,0);
+    if (i != NULL)
+    { i->sym = t->sym;
+      i->args = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+      if (i->args == NULL)
+      { obPuts(listing,"Out of memory error in code generator\n");
+        Error = TRUE;
+      }
+      else
+      { memcpy(i->args,args,n * sizeof(int));
+        i->nargs = n;
+      }
+    }
+  }
+  top -= n;
+  push(d);
+}
+
+static int lowerStmtPre(TreeNode * t)
+{ int header;
+  switch (t->kind.stmt)
+  { case IfK:
+      pushMark(top);
+      return TRUE;
+    case RepeatK:
+      header = newBlock(fn);
+      jump(header);
+      cur = header;
+      pushMark(top);
+      pushMark(header);
+      return TRUE;
+    case ReturnK:
+      if (isTailCall(t->child[0])) tailCall = t->child[0];
+      return TRUE;
+    case CompK:
+      pushMark(top);
+      return TRUE;
+    case AssignK:
+    case AssignKarr:
+    case CallK:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+static void lowerStmtChild(TreeNode * t, int i)
+{ int then, other, join;
+  switch (t->kind.stmt)
+  { case IfK:
+      if (i == 0)
+      { then = newBlock(fn);
+        other = newBlock(fn);
+        branch(pop(),then,other);
+        cur = then;
+        pushMark(other);
+      }
+      else if ((i == 1) && (t->child[2] != NULL))
+      { join = newBlock(fn);
+        jump(join);
+        cur = popMark();
+        pushMark(join);
+      }
+      break;
+    case RepeatK:
+      if (i == 0)
+      { then = newBlock(fn);
+        other = newBlock(fn);
+        branch(pop(),then,other);
+        cur = then;
+        pushMark(other);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static void lowerStmtPost(TreeNode * t)
+{ int v, a, n, exit;
+  TreeNode * arg;
+  switch (t->kind.stmt)
+  { case IfK:
+      v = popMark();
+      jump(v);
+      cur = v;
+      top = popMark();
+      break;
+    case RepeatK:
+      exit = popMark();
+      jump(popMark());
+      cur = exit;
+      top = popMark();
+      break;
+    case AssignK:
+      v = pop();
+      assign(t->sym,v);
+      push(v);
+      break;
+    case AssignKarr:
+      a = pop();
+      v = pop();
+      store(t->sym,a,v);
+      push(v);
+      break;
+    case CallK:
+      for (n = 0, arg = t->child[0]; arg != NULL; arg = arg->sibling) n++;
+      lowerCall(t,n);
+      break;
+    case ReturnK:
+      if ((t->child[0] != NULL) && (t->child[0] == tailCall))
+      { pop();
+        tailCall = NULL;
+        break;
+      }
+      emit(IrRet,-1,t->child[0] != NULL ? pop() : -1,-1,0);
+      cur = newBlock(fn);
+      break;
+    case CompK:
+      top = popMark();
+      break;
+    default:
+      break;
+  }
+}
+
+static int lowerPre(TreeNode * t, int depth, void * arg)
+{ if (t->nodekind == StmtK) return lowerStmtPre(t);
+  switch (t->kind.exp)
+  { case ConstK:
+      push(value(IrConst,-1,-1,t->attr.val,NULL));
+      return FALSE;
+    case IdK:
+      push(use(t->sym));
+      return FALSE;
+    case ParamK:
+      if ((t->type != Void) && (t->sym != NULL) &&
+          irGrow(&params,&paramCap,nparams,sizeof(int)))
+      { params[nparams] = varOf(t->sym);
+        emit(IrParam,params[nparams],-1,-1,nparams);
+        nparams++;
+      }
+      return FALSE;
+    case OpK:
+    case ArrexpK:
+    case FuncK:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+static void lowerChild(TreeNode * t, int i, void * arg)
+{ if (t->nodekind == StmtK) lowerStmtChild(t,i);
+  else if ((t->kind.exp == FuncK) && (i == 0))
+  { body = newBlock(fn);
+    jump(body);
+    cur = body;
+  }
+}
+
+static void lowerPost(TreeNode * t, int depth, void * arg)
+{ int a, b;
+  if (t->nodekind == StmtK)
+  { lowerStmtPost(t);
+    return;
+  }
+  switch (t->kind.exp)
+  { case OpK:
+      b = pop();
+      a = pop();
+      push(value(IrBin,a,b,t->attr.op,NULL));
+      break;
+    case ArrexpK:
+      push(load(t->sym,pop()));
+      break;
+    case FuncK:
+      /* falling off the end returns */
+      emit(IrRet,-1,-1,-1,0);
+      break;
+    default:
+      break;
+  }
+}
+
+/* Function lowerFunction returns the IR of
+ * analyzed function declaration f, not yet in SSA
+ * form, or NULL if out of memory. A self tail call
+ * ("return f(...);" in f) becomes a jump back to
+ * the body with the arguments as the parameters
+ */
+IrFunc * lowerFunction(TreeNode * f)
+{ TreeVisitor v = { lowerPre, lowerChild, lowerPost, NULL };
+  TreeVisitor vars = { collectVar, NULL, NULL, NULL };
+  TreeNode * sibling = f->sibling;
+  fn = (IrFunc *) calloc(1,sizeof(IrFunc));
+  if (fn == NULL)
+  { obPuts(listing,"Out of memory error in code generator\n");
+    Error = TRUE;
+    return NULL;
+  }
+  fn->sym = f->sym;
+  top = 0;
+  markTop = 0;
+  nparams = 0;
+  tailCall = NULL;
+  cur = newBlock(fn);
+  f->sibling = NULL;
+  walkTree(f,&vars);
+  fn->nvalues = fn->nvars;
+  walkTree(f,&v);
+  f->sibling = sibling;
+  if (Error)
+  { freeIrFunc(fn);
+    return NULL;
+  }
+  return fn;
+}
+
+/**************************************************/
+/**********   Control flow   **********************/
+/**************************************************/
+
+/* A list per block or variable is kept as one
+ * array: the items of number k are
+ * item[start[k]] to item[start[k+1]-1]
+ */
+typedef struct
+   { int * start;
+     int * item;
+   } Lists;
+
+static void freeLists(Lists * l)
+{ free(l->start);
+  free(l->item);
+}
+
+/* Function irDominates tells whether block a
+ * dominates block b, by their numbers in the
+ * dominator tree
+ */
+int irDominates(IrFunc * f, int a, int b)
+{ return (f->block[a].pre <= f->block[b].pre) &&
+         (f->block[b].post <= f->block[a].post);
+}
+
+/* domKids returns the children of each block in
+ * the dominator tree
+ */
+static int domKids(IrFunc * f, Lists * kids)
+{ int * next = (int *) malloc((f->nblocks + 1) * sizeof(int));
+  int b;
+  kids->start = (int *) calloc(f->nblocks + 1,sizeof(int));
+  kids->item = (int *) malloc((f->nblocks + 1) * sizeof(int));
+  if ((next == NULL) || (kids->start == NULL) || (kids->item == NULL))
+  { free(next);
+    Error = TRUE;
+    return FALSE;
+  }
+  for (b = 0; b < f->nblocks; b++)
+    if (f->block[b].idom >= 0) kids->start[f->block[b].idom + 1]++;
+  for (b = 0; b < f->nblocks; b++) kids->start[b+1] += kids->start[b];
+  for (b = 0; b < f->nblocks; b++) next[b] = kids->start[b];
+  for (b = 0; b < f->nblocks; b++)
+    if (f->block[b].idom >= 0) kids->item[next[f->block[b].idom]++] = b;
+  free(next);
+  return TRUE;
+}
+
+/* numberTree numbers the blocks in preorder and
+ * postorder of the dominator tree, for irDominates
+ */
+static void numberTree(IrFunc * f)
+{ Lists kids;
+  int * stack = (int *) malloc((2 * f->nblocks + 1) * sizeof(int));
+  int sp = 0, n = 0, b, i;
+  if ((stack == NULL) || ! domKids(f,&kids))
+  { free(stack);
+    Error = TRUE;
+    return;
+  }
+  for (b = 0; b < f->nblocks; b++)
+  { f->block[b].pre = f->nblocks;
+    f->block[b].post = -1;
+  }
+  stack[sp++] = 0;
+  while (sp > 0)
+  { b = stack[--sp];
+    if (b < 0)
+    { f->block[-1 - b].post = n++;
+      continue;
+    }
+    f->block[b].pre = n++;
+    stack[sp++] = -1 - b;
+    for (i = kids.start[b]; i < kids.start[b+1]; i++)
+      stack[sp++] = kids.item[i];
+  }
+  freeLists(&kids);
+  free(stack);
+}
+
+/* intersect returns the nearest common dominator
+ * of a and b, see irFlow
+ */
+static int intersect(IrFunc * f, int a, int b)
+{ while (a != b)
+  { while (f->block[a].rpo > f->block[b].rpo) a = f->block[a].idom;
+    while (f->block[b].rpo > f->block[a].rpo) b = f->block[b].idom;
+  }
+  return a;
+}
+
+/* computeOrder numbers the blocks reachable from
+ * the entry in reverse postorder, by a depth-first
+ * search with an explicit stack. The successors
+ * are searched last first, so that the order, the
+ * layout of the code, puts a then part or a loop
+ * body right after the test
+ */
+static int computeOrder(IrFunc * f)
+{ int * stack = (int *) malloc(2 * f->nblocks * sizeof(int));
+  int * post = (int *) malloc(f->nblocks * sizeof(int));
+  int sp = 0, n = 0, b, i;
+  free(f->order);
+  f->order = (int *) malloc(f->nblocks * sizeof(int));
+  if ((stack == NULL) || (post == NULL) || (f->order == NULL))
+  { free(stack);
+    free(post);
+    Error = TRUE;
+    return FALSE;
+  }
+  for (b = 0; b < f->nblocks; b++) f->block[b].rpo = -1;
+  /* rpo is -2 while a block is on the stack */
+  f->block[0].rpo = -2;
+  stack[sp++] = 0;
+  stack[sp++] = 0;
+  while (sp > 0)
+  { b = stack[sp-2];
+    i = stack[sp-1];
+    if (i < f->block[b].nsucc)
+    { int s = f->block[b].succ[f->block[b].nsucc - 1 - i];
+      stack[sp-1]++;
+      if (f->block[s].rpo == -1)
+      { f->block[s].rpo = -2;
+        stack[sp++] = s;
+        stack[sp++] = 0;
+      }
+    }
+    else
+    { post[n++] = b;
+      sp -= 2;
+    }
+  }
+  for (i = 0; i < n; i++)
+  { f->order[i] = post[n - 1 - i];
+    f->block[f->order[i]].rpo = i;
+  }
+  f->norder = n;
+  free(stack);
+  free(post);
+  return TRUE;
+}
+
+/* markLoop adds one to the depth of the blocks of
+ * the loop with header h, which reach the sources
+ * of its back edges without passing h
+ */
+static void markLoop(IrFunc * f, int h, int * stamp, int * work)
+{ int n = 0, i, b;
+  IrBlock * hb = &f->block[h];
+  for (i = 0; i < hb->npred; i++)
+  { int p = hb->pred[i];
+    if (irDominates(f,h,p) && (stamp[p] != h + 1))
+    { stamp[p] = h + 1;
+      work[n++] = p;
+    }
+  }
+  if (n == 0) return;
+  stamp[h] = h + 1;
+  hb->depth++;
+  while (n > 0)
+  { b = work[--n];
+    if (b == h) continue;
+    f->block[b].depth++;
+    for (i = 0; i < f->block[b].npred; i++)
+    { int p = f->block[b].pred[i];
+      if (stamp[p] != h + 1)
+      { stamp[p] = h + 1;
+        work[n++] = p;
+      }
+    }
+  }
+}
+
+/* Procedure irFlow computes the predecessors, the
+ * reverse postorder, the dominators and the loop
+ * depths of the blocks of f from their successors,
+ * emptying the unreachable blocks. The dominators
+ * are found by the iterative algorithm of Cooper,
+ * Harvey and Kennedy over the reverse postorder
+ */
+void irFlow(IrFunc * f)
+{ int b, i, changed;
+  int * stamp, * work;
+  if (! computeOrder(f)) return;
+  for (b = 0; b < f->nblocks; b++)
+    if (f->block[b].rpo < 0)
+    { IrBlock * bl = &f->block[b];
+      while (bl->nsucc > 0) irRemoveEdge(f,b,bl->nsucc - 1);
+      for (i = 0; i < bl->n; i++) free(bl->code[i].args);
+      bl->n = 0;
+    }
+  for (b = 0; b < f->nblocks; b++)
+  { f->block[b].idom = -1;
+    f->block[b].depth = 0;
+  }
+  f->block[0].idom = 0;
+  do
+  { changed = FALSE;
+    for (i = 1; i < f->norder; i++)
+    { IrBlock * bl = &f->block[f->order[i]];
+      int idom = -1, j;
+      for (j = 0; j < bl->npred; j++)
+      { int p = bl->pred[j];
+        if (f->block[p].idom < 0) continue;
+        idom = idom < 0 ? p : intersect(f,p,idom);
+      }
+      if (idom != bl->idom)
+      { bl->idom = idom;
+        changed = TRUE;
+      }
+    }
+  } while (changed);
+  f->block[0].idom = -1;
+  numberTree(f);
+  stamp = (int *) calloc(f->nblocks,sizeof(int));
+  work = (int *) malloc(f->nblocks * sizeof(int));
+  if ((stamp != NULL) && (work != NULL))
+    for (i = 0; i < f->norder; i++) markLoop(f,f->order[i],stamp,work);
+  free(stamp);
+  free(work);
+}
+
+/**************************************************/
+/**********   SSA form   **************************/
+/**************************************************/
+
+/* frontiers returns the dominance frontiers of the
+ * blocks of f: a join block is in the frontier of
+ * each block from one of its predecessors up to,
+ * not including, its immediate dominator
+ */
+static int frontiers(IrFunc * f, Lists * df)
+{ int * count = (int *) calloc(f->nblocks + 1,sizeof(int));
+  int * last = (int *) malloc(f->nblocks * sizeof(int));
+  int pass, b, j, r, n = 0;
+  df->start = count;
+  df->item = NULL;
+  if ((count == NULL) || (last == NULL))
+  { free(last);
+    return FALSE;
+  }
+  /* the first pass counts, the second fills in */
+  for (pass = 0; pass < 2; pass++)
+  { for (b = 0; b < f->nblocks; b++) last[b] = -1;
+    for (b = 0; b < f->nblocks; b++)
+    { IrBlock * bl = &f->block[b];
+      if ((bl->rpo < 0) || (bl->npred < 2)) continue;
+      for (j = 0; j < bl->npred; j++)
+        for (r = bl->pred[j]; (r >= 0) && (r != bl->idom); r = f->block[r].idom)
+        { if (last[r] == b) continue;
+          last[r] = b;
+          if (pass == 0) count[r+1]++;
+          else df->item[count[r]++] = b;
+        }
+    }
+    if (pass == 0)
+    { for (b = 0; b < f->nblocks; b++) count[b+1] += count[b];
+      n = count[f->nblocks];
+      df->item = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+      if (df->item == NULL)
+      { free(last);
+        return FALSE;
+      }
+    }
+  }
+  /* the fill moved each start to the next one */
+  for (b = f->nblocks; b > 0; b--) count[b] = count[b-1];
+  count[0] = 0;
+  free(last);
+  return TRUE;
+}
+
+/* defSites returns for each variable of f the
+ * blocks assigning it, with repeats
+ */
+static int defSites(IrFunc * f, Lists * defs)
+{ int * count = (int *) calloc(f->nvars + 1,sizeof(int));
+  int pass, b, i, v;
+  defs->start = count;
+  defs->item = NULL;
+  if (count == NULL) return FALSE;
+  for (pass = 0; pass < 2; pass++)
+  { for (b = 0; b < f->nblocks; b++)
+      for (i = 0; i < f->block[b].n; i++)
+      { v = f->block[b].code[i].d;
+        if ((v < 0) || (v >= f->nvars)) continue;
+        if (pass == 0) count[v+1]++;
+        else defs->item[count[v]++] = b;
+      }
+    if (pass == 0)
+    { for (v = 0; v < f->nvars; v++) count[v+1] += count[v];
+      defs->item = (int *) malloc((count[f->nvars] > 0 ? count[f->nvars] : 1) *
+                                  sizeof(int));
+      if (defs->item == NULL) return FALSE;
+    }
+  }
+  for (v = f->nvars; v > 0; v--) count[v] = count[v-1];
+  count[0] = 0;
+  return TRUE;
+}
+
+/* placePhis puts a phi for each variable at the
+ * iterated dominance frontier of its assignments
+ */
+static void placePhis(IrFunc * f, Lists * df, Lists * defs)
+{ int * placed = (int *) malloc(f->nblocks * sizeof(int));
+  int * queued = (int *) malloc(f->nblocks * sizeof(int));
+  int * work = (int *) malloc(f->nblocks * sizeof(int));
+  int v, b, k, n;
+  if ((placed == NULL) || (queued == NULL) || (work == NULL))
+  { Error = TRUE;
+    goto done;
+  }
+  for (b = 0; b < f->nblocks; b++) placed[b] = queued[b] = -1;
+  for (v = 0; v < f->nvars; v++)
+  { n = 0;
+    for (k = defs->start[v]; k < defs->start[v+1]; k++)
+    { b = defs->item[k];
+      if (queued[b] != v)
+      { queued[b] = v;
+        work[n++] = b;
+      }
+    }
+    while (n > 0)
+    { b = work[--n];
+      for (k = df->start[b]; k < df->start[b+1]; k++)
+      { int d = df->item[k];
+        IrBlock * bl = &f->block[d];
+        IrInstr phi;
+        int j;
+        if (placed[d] == v) continue;
+        placed[d] = v;
+        newInstr(&phi,IrPhi,v,-1,-1,v);
+        phi.args = (int *) malloc(bl->npred * sizeof(int));
+        phi.nargs = bl->npred;
+        if ((phi.args == NULL) || (insertInstr(bl,0,&phi) == NULL))
+        { free(phi.args);
+          Error = TRUE;
+          goto done;
+        }
+        for (j = 0; j < bl->npred; j++) phi.args[j] = -1;
+        if (Stats != NULL) Stats->phis++;
+        if (queued[d] != v)
+        { queued[d] = v;
+          work[n++] = d;
+        }
+      }
+    }
+  }
+done:
+  free(placed);
+  free(queued);
+  free(work);
+}
+
+/* renaming state: current[v] is the value variable
+ * v has, undo the variables changed with their
+ * former values
+ */
+static int * current = NULL;
+static int * undo = NULL;
+static int undoTop = 0;
+static int undoCap = 0;
+
+/* renameUse returns the value of operand v */
+static int renameUse(IrFunc * f, int v, int undef)
+{ if ((v < 0) || (v >= f->nvars)) return v;
+  return current[v] >= 0 ? current[v] : undef;
+}
+
+/* define gives variable v a new value */
+static int define(IrFunc * f, int v)
+{ if (! irGrow(&undo,&undoCap,undoTop + 1,sizeof(int))) return v;
+  undo[undoTop++] = v;
+  undo[undoTop++] = current[v];
+  current[v] = f->nvalues++;
+  return current[v];
+}
+
+/* renameBlock renames the variables used and
+ * assigned in block b, and those its successors'
+ * phis take from it
+ */
+static void renameBlock(IrFunc * f, int b, int undef)
+{ IrBlock * bl = &f->block[b];
+  int i, k, s, j;
+  for (i = 0; i < bl->n; i++)
+  { IrInstr * in = &bl->code[i];
+    if (in->op != IrPhi)
+    { in->a = renameUse(f,in->a,undef);
+      in->b = renameUse(f,in->b,undef);
+      for (k = 0; k < in->nargs; k++) in->args[k] = renameUse(f,in->args[k],undef);
+    }
+    if ((in->d >= 0) && (in->d < f->nvars)) in->d = define(f,in->d);
+  }
+  for (s = 0; s < bl->nsucc; s++)
+  { IrBlock * sb = &f->block[bl->succ[s]];
+    for (j = 0; j < sb->npred; j++)
+    { if (sb->pred[j] != b) continue;
+      for (k = 0; (k < sb->n) && (sb->code[k].op == IrPhi); k++)
+        sb->code[k].args[j] = renameUse(f,sb->code[k].val,undef);
+    }
+  }
+}
+
+/* Procedure buildSSA puts f in SSA form, placing
+ * phis at the dominance frontiers of the blocks
+ * that assign each variable; irFlow must be current.
+ * The renaming walks the dominator tree with an
+ * explicit stack; a variable used before any
+ * assignment gets the value 0
+ */
+void buildSSA(IrFunc * f)
+{ Lists df, defs, kids;
+  int * stack = NULL, * mark = NULL;
+  int sp = 0, b, i, undef;
+  IrInstr zero;
+  if (! frontiers(f,&df) || ! defSites(f,&defs))
+  { Error = TRUE;
+    freeLists(&df);
+    freeLists(&defs);
+    return;
+  }
+  placePhis(f,&df,&defs);
+  freeLists(&df);
+  freeLists(&defs);
+  undef = f->nvalues++;
+  newInstr(&zero,IrConst,undef,-1,-1,0);
+  if (insertInstr(&f->block[0],0,&zero) == NULL) return;
+  if (! domKids(f,&kids)) return;
+  stack = (int *) malloc((2 * f->nblocks + 1) * sizeof(int));
+  mark = (int *) malloc((f->nblocks + 1) * sizeof(int));
+  current = (int *) malloc((f->nvars + 1) * sizeof(int));
+  if ((stack == NULL) || (mark == NULL) || (current == NULL))
+  { Error = TRUE;
+    goto done;
+  }
+  for (i = 0; i < f->nvars; i++) current[i] = -1;
+  undoTop = 0;
+  /* a block is pushed as b to enter it and as
+     -1-b to leave it, undoing its definitions */
+  stack[sp++] = 0;
+  while (sp > 0)
+  { b = stack[--sp];
+    if (b < 0)
+    { b = -1 - b;
+      while (undoTop > mark[b])
+      { undoTop -= 2;
+        current[undo[undoTop]] = undo[undoTop+1];
+      }
+      continue;
+    }
+    mark[b] = undoTop;
+    renameBlock(f,b,undef);
+    stack[sp++] = -1 - b;
+    for (i = kids.start[b]; i < kids.start[b+1]; i++)
+      stack[sp++] = kids.item[i];
+  }
+done:
+  freeLists(&kids);
+  free(stack);
+  free(mark);
+  free(current);
+  current = NULL;
+}
+
+/* splitEdges puts a new block on every edge from
+ * a block with two successors to a block with
+ * phis, so that the copies that replace the phis
+ * have a block of their own
+ */
+static void splitEdges(IrFunc * f)
+{ int b, j, k, nblocks = f->nblocks;
+  for (b = 0; b < nblocks; b++)
+  { if ((f->block[b].n == 0) || (f->block[b].code[0].op != IrPhi)) continue;
+    for (j = 0; j < f->block[b].npred; j++)
+    { int p = f->block[b].pred[j], n;
+      IrBlock * nb;
+      if (f->block[p].nsucc < 2) continue;
+      n = newBlock(f);
+      if (Error) return;
+      nb = &f->block[n];
+      if (! irGrow(&nb->pred,&nb->pcap,0,sizeof(int))) return;
+      nb->pred[nb->npred++] = p;
+      nb->succ[nb->nsucc++] = b;
+      if (! irGrow(&nb->code,&nb->cap,0,sizeof(IrInstr))) return;
+      newInstr(&nb->code[nb->n++],IrJump,-1,-1,-1,0);
+      /* the first edge to b not split yet */
+      for (k = 0; f->block[p].succ[k] != b; k++) ;
+      f->block[p].succ[k] = n;
+      f->block[b].pred[j] = n;
+    }
+  }
+}
+
+/* copyTo appends "d = a" to block b, before its
+ * last instruction
+ */
+static void copyTo(IrBlock * b, int d, int a)
+{ IrInstr copy;
+  newInstr(&copy,IrCopy,d,a,-1,0);
+  insertInstr(b,b->n - 1,&copy);
+}
+
+/* parallelCopy appends to block b the copies
+ * d[i] = a[i], i < n, as if they were made at
+ * once: a copy waits while its target is still
+ * the source of another, and a cycle of copies is
+ * broken by saving one target in a new value
+ */
+static void parallelCopy(IrFunc * f, IrBlock * b, int * d, int * a, int n)
+{ int i, j, done;
+  while (n > 0)
+  { done = FALSE;
+    for (i = 0; i < n; i++)
+    { for (j = 0; j < n; j++)
+        if ((j != i) && (a[j] == d[i])) break;
+      if (j < n) continue;
+      copyTo(b,d[i],a[i]);
+      d[i] = d[n-1];
+      a[i] = a[n-1];
+      n--;
+      done = TRUE;
+      break;
+    }
+    if (! done)
+    { int t = f->nvalues++;
+      copyTo(b,t,d[0]);
+      for (j = 0; j < n; j++)
+        if (a[j] == d[0]) a[j] = t;
+    }
+  }
+}
+
+/* Procedure leaveSSA replaces the phis of f by
+ * copies at the ends of the predecessors, made as
+ * one parallel copy per edge. Edges from a block
+ * with two successors are split first, so that
+ * no copy is made on a path it does not belong to
+ */
+void leaveSSA(IrFunc * f)
+{ int b, j, k, nphis, cap = 0;
+  int * d = NULL, * a = NULL;
+  splitEdges(f);
+  for (b = 0; (b < f->nblocks) && ! Error; b++)
+  { for (nphis = 0; nphis < f->block[b].n; nphis++)
+      if (f->block[b].code[nphis].op != IrPhi) break;
+    if (nphis == 0) continue;
+    if (nphis > cap)
+    { cap = nphis;
+      free(d);
+      free(a);
+      d = (int *) malloc(cap * sizeof(int));
+      a = (int *) malloc(cap * sizeof(int));
+      if ((d == NULL) || (a == NULL))
+      { Error = TRUE;
+        break;
+      }
+    }
+    for (j = 0; j < f->block[b].npred; j++)
+    { int n = 0;
+      for (k = 0; k < nphis; k++)
+      { IrInstr * phi = &f->block[b].code[k];
+        if (phi->args[j] == phi->d) continue;
+        d[n] = phi->d;
+        a[n] = phi->args[j];
+        n++;
+      }
+      parallelCopy(f,&f->block[f->block[b].pred[j]],d,a,n);
+    }
+    for (k = 0; k < nphis; k++) f->block[b].code[k].op = IrNop;
+  }
+  free(d);
+  free(a);
+  irCompact(f);
+}
@@ -0,0 +1,156 @@
+/****************************************************/
+/* File: ir.h                                       */
+/* Intermediate representation of the C- compiler: */
+/* three-address code in SSA form over a control    */
+/* flow graph, between the syntax tree and TM code  */
+/****************************************************/
+
+#ifndef _IR_H_
+#define _IR_H_
+
+#include "symtab.h"
+#include "code.h"
+
+/* A function is lowered to basic blocks of
+ * instructions on numbered values. Before SSA
+ * form, values 0 to nvars-1 are the local scalars
+ * and parameters, assigned by IrCopy like any
+ * variable; the other values are temporaries,
+ * defined once. buildSSA renames the variables so
+ * that every value is defined once, joining the
+ * definitions that meet at a block by IrPhi.
+ *
+ * Memory is addressed by IrLoad and IrStore as
+ * value a (if a >= 0) plus offset val, plus the
+ * base of sym if it is not NULL: gp and the
+ * address of sym for a global, mp for a local
+ * array, whose loc is then part of val.
+ */
+
+/* IrOp is the operation of an IR instruction */
+typedef enum
+   {IrConst, /* d = val */
+    IrCopy, /* d = a */
+    IrBin, /* d = a op b, op (a TokenType) in val */
+    IrParam, /* d = parameter number val */
+    IrAddr, /* d = address of element 0 of array sym */
+    IrLoad, /* d = memory[a + val (+ sym)] */
+    IrStore, /* memory[a + val (+ sym)] = b */
+    IrIn, /* d = input() */
+    IrOut, /* output(a) */
+    IrCall, /* d = sym(args), d < 0 for a void call */
+    IrPhi, /* d = args[i] coming from predecessor i */
+    IrJump, /* go to succ[0] */
+    IrBranch, /* go to succ[0] if a != 0, else succ[1] */
+    IrRet, /* return a, or nothing if a < 0 */
+    IrNop /* removed, see irCompact */
+   } IrOp;
+
+typedef struct
+   { IrOp op;
+     int d; /* the value defined, or -1 */
+     int a, b; /* operand values, or -1 */
+     int val; /* see IrOp; IrPhi: the variable, until renamed */
+     Symbol * sym;
+     int * args; /* IrCall, IrPhi */
+     int nargs;
+   } IrInstr;
+
+/* IrBlock is a basic block; its last instruction,
+ * and only that one, is an IrJump, IrBranch or IrRet
+ */
+typedef struct
+   { IrInstr * code;
+     int n, cap;
+     int succ[2];
+     int nsucc;
+     int * pred; /* in the order of the IrPhi args */
+     int npred, pcap;
+     int rpo; /* number in reverse postorder, -1 if unreachable */
+     int idom; /* immediate dominator, -1 for the entry */
+     int pre, post; /* numbers in the dominator tree */
+     int depth; /* loop nesting depth */
+   } IrBlock;
+
+typedef struct
+   { Symbol * sym; /* the function */
+     IrBlock * block; /* block 0 is the entry */
+     int nblocks, bcap;
+     int * order; /* the reachable blocks in reverse postorder */
+     int norder;
+     int nvalues;
+     Symbol ** var; /* the symbols of variables 0 to nvars-1 */
+     int nvars, vcap;
+   } IrFunc;
+
+/* Function irGrow makes room in array *p of *cap
+ * elements for element n; it returns FALSE if out
+ * of memory
+ */
+int irGrow(void * p, int * cap, int n, size_t size);
+
+/* Function lowerFunction returns the IR of
+ * analyzed function declaration f, not yet in SSA
+ * form, or NULL if out of memory. A self tail call
+ * ("return f(...);" in f) becomes a jump back to
+ * the body with the arguments as the parameters
+ */
+IrFunc * lowerFunction(TreeNode * f);
+
+/* Procedure freeIrFunc releases the IR of a function */
+void freeIrFunc(IrFunc * f);
+
+/* Procedure irFlow computes the reverse
+ * postorder, the dominators and the loop depths of
+ * the blocks of f, emptying the unreachable
+ * blocks; the predecessors are kept as edges are
+ * added and removed
+ */
+void irFlow(IrFunc * f);
+
+/* Function irDominates tells whether block a
+ * dominates block b; irFlow must be current
+ */
+int irDominates(IrFunc * f, int a, int b);
+
+/* Procedure buildSSA puts f in SSA form, placing
+ * phis at the dominance frontiers of the blocks
+ * that assign each variable; irFlow must be current
+ */
+void buildSSA(IrFunc * f);
+
+/* Procedure leaveSSA replaces the phis of f by
+ * copies at the ends of the predecessors, made in
+ * parallel; an edge from a block with two
+ * successors is split first. irFlow must be run
+ * again after it
+ */
+void leaveSSA(IrFunc * f);
+
+/* Procedure irCompact drops the IrNop instructions */
+void irCompact(IrFunc * f);
+
+/* Function irTerminator returns the last
+ * instruction of block b if it ends the block, or
+ * NULL
+ */
+IrInstr * irTerminator(IrBlock * b);
+
+/* Procedure irRemoveEdge removes the edge from
+ * block from to its successor number i, with the
+ * phi arguments that came along it
+ */
+void irRemoveEdge(IrFunc * f, int from, int i);
+
+/* Procedure runPasses runs the optimization passes
+ * of irpass.c on f, which is in SSA form
+ */
+void runPasses(IrFunc * f);
+
+/* Function genIrFunction generates the code of
+ * function declaration f through the IR, see
+ * irgen.c, into a new fragment
+ */
+CodeFrag * genIrFunction(TreeNode * f);
+
+#endif
@@ -0,0 +1,965 @@
+/****************************************************/
+/* File: irgen.c                                    */
+/* TM code generation from the intermediate         */
+/* representation of the C- compiler                */
+/****************************************************/
+
+#include <limits.h>
+#include "globals.h"
+#include "symtab.h"
+#include "code.h"
+#include "stats.h"
+#include "ir.h"
+
+/* The IR of a function, out of SSA form, is laid
+ * out in reverse postorder; a block holding just a
+ * jump is left out, the jumps to it going where it
+ * goes. Constants and array addresses are loaded
+ * where they are used. A value whose only use is
+ * the next instruction is passed to it in ac.
+ *
+ * The other values get registers FIRSTREG to
+ * LASTREG by a linear scan over their live
+ * intervals, one interval per value. When the
+ * registers run out, the value of least spill
+ * weight (its uses and definition, ten times
+ * heavier for each loop around them) is left in
+ * memory. Calls keep no registers: a value in a
+ * register live across calls is stored once where
+ * it is defined and loaded again after each call,
+ * which it is worth only if its weight exceeds
+ * that of these loads and store. A copy whose
+ * source ends where its target starts gives the
+ * target the source's register, so it costs
+ * nothing. ac and ac1 load the operands in memory.
+ *
+ * Values in memory get frame slots below the
+ * locals by a second such scan: values whose
+ * intervals do not overlap share slots. The
+ * parameters start in the slots the caller stored
+ * them in. The frame of a call starts below the
+ * slots. A comparison tested by the next branch is
+ * not made a 0 or 1: the branch tests a - b.
+ */
+
+/* NOSLOT marks a value without a slot; 0(mp) is
+ * the control link, never a value
+ */
+#define NOSLOT 0
+
+/* the registers values are allocated to */
+#define FIRSTREG 2
+#define LASTREG 4
+
+static IrFunc * fn = NULL;
+
+/* per value: its definition, number of uses,
+ * slot, and whether it is passed in ac
+ */
+static IrInstr ** def = NULL;
+static int * uses = NULL;
+static int * slot = NULL;
+static char * passed = NULL;
+
+/* FUSED in passed marks a comparison passed to
+ * the branch after it as a - b
+ */
+#define FUSED 2
+
+/* per value: live interval and where it is first
+ * defined
+ */
+static int * start = NULL;
+static int * end = NULL;
+static int * defPos = NULL;
+
+/* per value: its register, 0 if none, whether it
+ * has a slot, its spill weight and the weight of
+ * keeping it in a register across calls
+ */
+static int * reg = NULL;
+static char * home = NULL;
+static long * weight = NULL;
+static long * callCost = NULL;
+
+/* the values live across the call at position p
+ * are across[acrossAt[p]] on, acrossN[p] of them
+ */
+static int * across = NULL;
+static int nacross = 0;
+static int acrossCap = 0;
+static int * acrossAt = NULL;
+static int * acrossN = NULL;
+static int npos = 0;
+
+/* frame is the words of locals, nslots the slots
+ * below them
+ */
+static int frame = 0;
+static int nslots = 0;
+
+/* layout holds the blocks in code order, forward
+ * the block each block's jumps go to, and
+ * blockLoc the location of each block's code
+ */
+static int * layout = NULL;
+static int nlayout = 0;
+static int * forward = NULL;
+static int * blockLoc = NULL;
+
+/* Fixup is a jump to block target, emitted at loc
+ * when the location of the target is known
+ */
+typedef struct
+   { int loc;
+     char * op;
+     int r;
+     int target;
+   } Fixup;
+
+static Fixup * fixups = NULL;
+static int nfixups = 0;
+static int fixupCap = 0;
+
+/* inAc is the value ac holds for the instruction
+ * being generated, next the one for the next
+ * instruction; relop is the comparison whose a - b
+ * ac holds for the branch
+ */
+static int inAc = -1;
+static int next = -1;
+static int relop = -1;
+
+/**************************************************/
+/**********   Values   ****************************/
+/**************************************************/
+
+/* remat tells whether v is loaded where it is used */
+static int remat(int v)
+{ return (def[v] == NULL) || (def[v]->op == IrConst) || (def[v]->op == IrAddr);
+}
+
+/* tracked tells whether v needs a register or a
+ * slot while live
+ */
+static int tracked(int v)
+{ return (v >= 0) && ! remat(v) && ! passed[v];
+}
+
+static int isRelop(int op)
+{ return (op == LT) || (op == RT) || (op == LEQ) || (op == REQ) ||
+         (op == ASSIGN) || (op == NEQ);
+}
+
+/* takesInAc tells whether instruction i can take
+ * its use of v in ac: it reads v first
+ */
+static int takesInAc(IrInstr * i, int v)
+{ switch (i->op)
+  { case IrBin: case IrStore:
+      return (i->a == v) || (i->b == v);
+    case IrCopy: case IrLoad: case IrOut: case IrRet: case IrBranch:
+      return i->a == v;
+    case IrCall:
+      return (i->nargs > 0) && (i->args[0] == v);
+    default:
+      return FALSE;
+  }
+}
+
+static void countUse(int v)
+{ if (v >= 0) uses[v]++;
+}
+
+/* noCode tells whether i is loaded where used
+ * and so emits no code of its own
+ */
+static int noCode(IrInstr * i)
+{ return (i->op == IrConst) || (i->op == IrAddr) || (i->op == IrParam) ||
+         (i->op == IrNop);
+}
+
+/* findValues fills in def, uses and passed */
+static void findValues(void)
+{ int b, i, k, j;
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i < fn->block[b].n; i++)
+    { IrInstr * in = &fn->block[b].code[i];
+      if (in->d >= 0) def[in->d] = in;
+      countUse(in->a);
+      countUse(in->b);
+      for (k = 0; k < in->nargs; k++) countUse(in->args[k]);
+    }
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i + 1 < fn->block[b].n; i++)
+    { IrInstr * in = &fn->block[b].code[i];
+      IrInstr * user;
+      int d = in->d;
+      if ((d < 0) || (uses[d] != 1)) continue;
+      for (j = i + 1; (j < fn->block[b].n - 1) && noCode(&fn->block[b].code[j]); j++)
+        ;
+      user = &fn->block[b].code[j];
+      switch (in->op)
+      { case IrBin:
+          if (isRelop(in->val) && (user->op == IrBranch) && (user->a == d))
+          { passed[d] = FUSED;
+            break;
+          }
+          /* fall through */
+        case IrLoad: case IrIn: case IrCall: case IrCopy:
+          passed[d] = takesInAc(user,d);
+          break;
+        default:
+          break;
+      }
+    }
+}
+
+/**************************************************/
+/**********   Layout   ****************************/
+/**************************************************/
+
+static int jumpOnly(int b)
+{ return (b != 0) && (fn->block[b].n == 1) && (fn->block[b].code[0].op == IrJump);
+}
+
+/* doLayout lays the blocks out and finds where
+ * the jumps go
+ */
+static void doLayout(void)
+{ int b, k, t, steps;
+  for (b = 0; b < fn->nblocks; b++)
+  { for (t = b, steps = 0; jumpOnly(t) && (steps <= fn->nblocks); steps++)
+      t = fn->block[t].succ[0];
+    forward[b] = steps > fn->nblocks ? b : t;
+  }
+  nlayout = 0;
+  for (k = 0; k < fn->norder; k++)
+  { b = fn->order[k];
+    if (forward[b] == b) layout[nlayout++] = b;
+  }
+}
+
+
+/**************************************************/
+/**********   Live intervals   ********************/
+/**************************************************/
+
+/* Sets of values are bit vectors of words words */
+static int words = 0;
+
+#define HAS(s,v) ((s)[(v) >> 5] & (1u << ((v) & 31)))
+#define ADD(s,v) ((s)[(v) >> 5] |= (1u << ((v) & 31)))
+#define DEL(s,v) ((s)[(v) >> 5] &= ~(1u << ((v) & 31)))
+
+/* loopWeight returns the weight of an instruction
+ * in a block depth loops deep
+ */
+static long loopWeight(int depth)
+{ long w = 1;
+  int k;
+  for (k = 0; (k < depth) && (k < 6); k++) w *= 10;
+  return w;
+}
+
+static void extend(int v, int p)
+{ if (p < start[v]) start[v] = p;
+  if (p > end[v]) end[v] = p;
+}
+
+/* genUse notes a use of v in a block that has not
+ * defined it yet
+ */
+static void genUse(unsigned * gen, unsigned * kill, int v)
+{ if (tracked(v) && ! HAS(kill,v)) ADD(gen,v);
+}
+
+static void liveUse(unsigned * live, int v)
+{ if (tracked(v)) ADD(live,v);
+}
+
+/* findAcross walks block b, whose code starts at
+ * position from, backwards from the values live at
+ * its end, listing the values live across each
+ * call, which has to reload them
+ */
+static int findAcross(int b, int from, unsigned * out, unsigned * live)
+{ IrBlock * bl = &fn->block[b];
+  long w = loopWeight(bl->depth);
+  int i, k, v;
+  memcpy(live,out,words * sizeof(unsigned));
+  for (i = bl->n - 1; i >= 0; i--)
+  { IrInstr * c = &bl->code[i];
+    if (tracked(c->d)) DEL(live,c->d);
+    if (c->op == IrCall)
+    { acrossAt[from + i] = nacross;
+      for (k = 0; k < words; k++)
+        for (v = k * 32; live[k] && (v < k * 32 + 32); v++)
+          if (HAS(live,v))
+          { if (! irGrow(&across,&acrossCap,nacross,sizeof(int))) return FALSE;
+            across[nacross++] = v;
+            acrossN[from + i]++;
+            callCost[v] += w;
+          }
+    }
+    liveUse(live,c->a);
+    liveUse(live,c->b);
+    for (k = 0; k < c->nargs; k++) liveUse(live,c->args[k]);
+  }
+  return TRUE;
+}
+
+/* findIntervals computes the values live at the
+ * start and end of each block, by iterating to a
+ * fixed point backwards over the layout, and from
+ * them one interval per value, from the first to
+ * the last position where it is live, its spill
+ * weight and the calls it is live across
+ */
+static int findIntervals(void)
+{ unsigned * sets;
+  unsigned * in, * out, * gen, * kill;
+  int b, i, k, w, v, p, changed;
+  words = (fn->nvalues + 31) / 32;
+  sets = (unsigned *) calloc((size_t) (4 * fn->nblocks + 1) * words + 1,sizeof(unsigned));
+  if (sets == NULL) return FALSE;
+#define SET(n,b) (sets + ((size_t) (n) * fn->nblocks + (b)) * words)
+  for (b = 0; b < fn->nblocks; b++)
+  { gen = SET(2,b);
+    kill = SET(3,b);
+    for (i = 0; i < fn->block[b].n; i++)
+    { IrInstr * in = &fn->block[b].code[i];
+      genUse(gen,kill,in->a);
+      genUse(gen,kill,in->b);
+      for (k = 0; k < in->nargs; k++) genUse(gen,kill,in->args[k]);
+      if (tracked(in->d)) ADD(kill,in->d);
+    }
+  }
+  do
+  { changed = FALSE;
+    for (k = nlayout - 1; k >= 0; k--)
+    { b = layout[k];
+      in = SET(0,b);
+      out = SET(1,b);
+      gen = SET(2,b);
+      kill = SET(3,b);
+      for (i = 0; i < fn->block[b].nsucc; i++)
+      { unsigned * s = SET(0,forward[fn->block[b].succ[i]]);
+        for (w = 0; w < words; w++) out[w] |= s[w];
+      }
+      for (w = 0; w < words; w++)
+      { unsigned n = gen[w] | (out[w] & ~kill[w]);
+        if (n != in[w])
+        { in[w] = n;
+          changed = TRUE;
+        }
+      }
+    }
+  } while (changed);
+  for (v = 0; v < fn->nvalues; v++)
+  { start[v] = INT_MAX;
+    end[v] = -1;
+    defPos[v] = -1;
+  }
+  nacross = 0;
+  for (k = 0, p = 0; k < nlayout; k++)
+  { if (! findAcross(layout[k],p,SET(1,layout[k]),SET(4,0)))
+    { free(sets);
+      return FALSE;
+    }
+    p += fn->block[layout[k]].n;
+  }
+  for (k = 0, p = 0; k < nlayout; k++)
+  { int from = p, to = p + fn->block[layout[k]].n - 1;
+    long lw;
+    b = layout[k];
+    lw = loopWeight(fn->block[b].depth);
+    in = SET(0,b);
+    out = SET(1,b);
+    for (w = 0; w < words; w++)
+      for (i = 0; i < 32; i++)
+      { if (in[w] & (1u << i)) extend(w * 32 + i,from);
+        if (out[w] & (1u << i)) extend(w * 32 + i,to);
+      }
+    for (i = 0; i < fn->block[b].n; i++, p++)
+    { IrInstr * c = &fn->block[b].code[i];
+      if (tracked(c->a))
+      { extend(c->a,p);
+        weight[c->a] += lw;
+      }
+      if (tracked(c->b))
+      { extend(c->b,p);
+        weight[c->b] += lw;
+      }
+      for (w = 0; w < c->nargs; w++)
+        if (tracked(c->args[w]))
+        { extend(c->args[w],p);
+          weight[c->args[w]] += lw;
+        }
+      if (tracked(c->d))
+      { extend(c->d,p);
+        if (defPos[c->d] < 0) defPos[c->d] = p;
+        /* a parameter is in its slot already */
+        if (c->op != IrParam)
+        { weight[c->d] += lw;
+          if (callCost[c->d] > 0) callCost[c->d] += lw;
+        }
+      }
+    }
+  }
+#undef SET
+  free(sets);
+  return TRUE;
+}
+
+/**************************************************/
+/**********   Registers and slots   ***************/
+/**************************************************/
+
+static int byStart(const void * a, const void * b)
+{ int x = start[*(const int *) a], y = start[*(const int *) b];
+  return (x > y) - (x < y);
+}
+
+/* sortByStart returns the values that need a
+ * register or a slot in order of start, *n of
+ * them, or NULL if out of memory
+ */
+static int * sortByStart(int * n)
+{ int * order = (int *) malloc((fn->nvalues + 1) * sizeof(int));
+  int v;
+  *n = 0;
+  if (order == NULL) return NULL;
+  for (v = 0; v < fn->nvalues; v++)
+    if (tracked(v) && (uses[v] > 0) && (end[v] >= 0)) order[(*n)++] = v;
+  qsort(order,*n,sizeof(int),byStart);
+  return order;
+}
+
+/* expired tells whether the interval of w ends
+ * before v needs its place: a value read where v
+ * is written leaves its place to v, as the reads
+ * come first
+ */
+static int expired(int w, int v)
+{ return (end[w] < start[v]) ||
+         ((end[w] == start[v]) && (defPos[v] == start[v]));
+}
+
+/* allocate gives the values their registers */
+static void allocate(int * order, int n)
+{ int active[LASTREG + 1];
+  int nactive = 0, i, j, r, v;
+  for (i = 0; i < n; i++)
+  { int taken = 0, hint = 0;
+    v = order[i];
+    for (j = 0; j < nactive; j++)
+      if (expired(active[j],v)) active[j--] = active[--nactive];
+      else taken |= 1 << reg[active[j]];
+    if ((callCost[v] > 0) && (weight[v] <= callCost[v])) continue;
+    if ((def[v]->op == IrCopy) && tracked(def[v]->a)) hint = reg[def[v]->a];
+    if ((hint != 0) && ! (taken & (1 << hint))) r = hint;
+    else
+      for (r = FIRSTREG; (r <= LASTREG) && (taken & (1 << r)); r++)
+        ;
+    if (r > LASTREG)
+    { /* all taken: the lightest of v and the active
+         values stays in memory */
+      int k = 0;
+      for (j = 1; j < nactive; j++)
+        if (weight[active[j]] < weight[active[k]]) k = j;
+      if (weight[active[k]] >= weight[v]) continue;
+      r = reg[active[k]];
+      reg[active[k]] = 0;
+      active[k] = active[--nactive];
+    }
+    reg[v] = r;
+    active[nactive++] = v;
+  }
+  if (Stats != NULL)
+  { for (i = 0; i < n; i++)
+      if (reg[order[i]] != 0) Stats->allocated++;
+      else Stats->spilled++;
+  }
+}
+
+/* assignSlots gives the values in memory, and
+ * those reloaded after calls, their slots
+ */
+static int assignSlots(int * order, int n)
+{ int * active = (int *) malloc((fn->nvalues + 1) * sizeof(int));
+  int * freeSlots = (int *) malloc((fn->nvalues + 1) * sizeof(int));
+  int nactive = 0, nfree = 0, i, j, v;
+  if ((active == NULL) || (freeSlots == NULL))
+  { free(active);
+    free(freeSlots);
+    return FALSE;
+  }
+  nslots = 0;
+  for (i = 0; i < n; i++)
+  { int s = NOSLOT, from = -1;
+    v = order[i];
+    slot[v] = NOSLOT;
+    home[v] = (reg[v] == 0) || (callCost[v] > 0);
+    if (! home[v]) continue;
+    for (j = 0; j < nactive; j++)
+      if (expired(active[j],v))
+      { freeSlots[nfree++] = slot[active[j]];
+        active[j--] = active[--nactive];
+      }
+    if (def[v]->op == IrParam) s = -2 - def[v]->val;
+    else
+    { if ((def[v]->op == IrCopy) && tracked(def[v]->a) && home[def[v]->a])
+        from = slot[def[v]->a];
+      for (j = nfree - 1; j >= 0; j--)
+        if (freeSlots[j] == from) break;
+      if ((j < 0) && (nfree > 0)) j = nfree - 1;
+      if (j >= 0)
+      { s = freeSlots[j];
+        freeSlots[j] = freeSlots[--nfree];
+      }
+      else s = -frame - nslots++;
+    }
+    slot[v] = s;
+    active[nactive++] = v;
+  }
+  free(active);
+  free(freeSlots);
+  return TRUE;
+}
+
+/**************************************************/
+/**********   Emission   **************************/
+/**************************************************/
+
+/* load loads value v into register r */
+static void load(int r, int v)
+{ IrInstr * d = def[v];
+  if (v == inAc)
+  { if (r != ac) emitRM("LDA",r,0,ac,"copy");
+  }
+  else if ((d == NULL) || (d->op == IrConst))
+    emitRM("LDC",r,d != NULL ? d->val : 0,0,"load const");
+  else if (d->op == IrAddr)
+  { if (d->sym->level == 0)
+      emitRM_Sym("LDA",r,0,gp,d->sym->name,"load array address");
+    else
+      emitRM("LDA",r,d->sym->loc,mp,"load array address");
+  }
+  else if (reg[v] != 0)
+  { if (r != reg[v]) emitRM("LDA",r,0,reg[v],"copy");
+  }
+  else emitRM("LD",r,slot[v],mp,"load value");
+}
+
+/* held returns the register holding v, or -1 */
+static int held(int v)
+{ if (v == inAc) return ac;
+  if (tracked(v) && (reg[v] != 0)) return reg[v];
+  return -1;
+}
+
+/* fetch returns a register holding v, loading v
+ * into r if none does
+ */
+static int fetch(int v, int r)
+{ int h = held(v);
+  if (h >= 0) return h;
+  load(r,v);
+  return r;
+}
+
+/* operands puts a and b in registers *ra and *rb,
+ * loading them into ac and ac1 as needed
+ */
+static void operands(int a, int b, int * ra, int * rb)
+{ int ha = held(a), hb = held(b);
+  if (ha < 0) ha = fetch(a,hb == ac ? ac1 : ac);
+  if (hb < 0) hb = (b == a) ? ha : fetch(b,ha == ac ? ac1 : ac);
+  *ra = ha;
+  *rb = hb;
+}
+
+/* target returns the register v is computed into */
+static int target(int v)
+{ return ((v >= 0) && tracked(v) && (reg[v] != 0)) ? reg[v] : ac;
+}
+
+/* keep keeps value v, computed into register r,
+ * for its uses
+ */
+static void keep(int v, int r)
+{ if ((v < 0) || (uses[v] == 0)) return;
+  if (passed[v])
+  { if (r != ac) emitRM("LDA",ac,0,r,"copy");
+    next = v;
+    return;
+  }
+  if ((reg[v] != 0) && (r != reg[v]))
+  { emitRM("LDA",reg[v],0,r,"copy");
+    r = reg[v];
+  }
+  if (home[v]) emitRM("ST",r,slot[v],mp,"store value");
+}
+
+/* base returns the base register of the memory
+ * operand of i, adding it into scratch register s
+ * to the address in register r if i has one
+ */
+static int base(IrInstr * i, int r, int s)
+{ int b = ((i->sym != NULL) && (i->sym->level == 0)) ? gp : mp;
+  if (i->a < 0) return b;
+  if (i->sym == NULL) return r;
+  emitRO("ADD",s,r,b,"element address");
+  return s;
+}
+
+/* memory emits op on register r and the memory
+ * operand of i, based on register b
+ */
+static void memory(char * op, int r, IrInstr * i, int b, char * c)
+{ if ((i->sym != NULL) && (i->sym->level == 0))
+    emitRM_Sym(op,r,i->val,b,i->sym->name,c);
+  else
+    emitRM(op,r,i->val,b,c);
+}
+
+static void addFixup(char * op, int r, int target)
+{ if (! irGrow(&fixups,&fixupCap,nfixups,sizeof(Fixup))) return;
+  fixups[nfixups].loc = emitSkip(1);
+  fixups[nfixups].op = op;
+  fixups[nfixups].r = r;
+  fixups[nfixups].target = target;
+  nfixups++;
+}
+
+static char * jumpIf(int op)
+{ switch (op)
+  { case LT: return "JLT";
+    case RT: return "JGT";
+    case LEQ: return "JLE";
+    case REQ: return "JGE";
+    case ASSIGN: return "JEQ";
+    default: return "JNE";
+  }
+}
+
+static char * jumpUnless(int op)
+{ switch (op)
+  { case LT: return "JGE";
+    case RT: return "JLE";
+    case LEQ: return "JGT";
+    case REQ: return "JLT";
+    case ASSIGN: return "JNE";
+    default: return "JEQ";
+  }
+}
+
+/* genBin generates i, an IrBin */
+static void genBin(IrInstr * i)
+{ int ra, rb, rd = target(i->d);
+  operands(i->a,i->b,&ra,&rb);
+  switch (i->val)
+  { case PLUS: emitRO("ADD",rd,ra,rb,"op +"); break;
+    case MINUS: emitRO("SUB",rd,ra,rb,"op -"); break;
+    case TIMES: emitRO("MUL",rd,ra,rb,"op *"); break;
+    case OVER: emitRO("DIV",rd,ra,rb,"op /"); break;
+    default:
+      emitRO("SUB",ac,ra,rb,"op relational");
+      if (passed[i->d] == FUSED)
+      { relop = i->val;
+        return;
+      }
+      emitRM(jumpIf(i->val),ac,2,pc,"br if true");
+      emitRM("LDC",rd,0,0,"false case");
+      emitRM("LDA",pc,1,pc,"unconditional jmp");
+      emitRM("LDC",rd,1,0,"true case");
+      break;
+  }
+  keep(i->d,rd);
+}
+
+/* genBranch generates the end of block b, laid
+ * out before block after
+ */
+static void genBranch(IrInstr * i, int b, int after)
+{ int op = relop, r = ac, yes, no;
+  IrBlock * bl = &fn->block[b];
+  if (i->op == IrJump)
+  { if (forward[bl->succ[0]] != after)
+      addFixup("LDA",pc,forward[bl->succ[0]]);
+    return;
+  }
+  if (op < 0)
+  { r = fetch(i->a,ac);
+    op = NEQ;
+  }
+  yes = forward[bl->succ[0]];
+  no = forward[bl->succ[1]];
+  if (yes == after) addFixup(jumpUnless(op),r,no);
+  else
+  { addFixup(jumpIf(op),r,yes);
+    if (no != after) addFixup("LDA",pc,no);
+  }
+}
+
+/* genCall generates call i, at position p: the
+ * arguments go to the frame of the call, below the
+ * slots, and the registers live across the call
+ * are loaded again after it
+ */
+static void genCall(IrInstr * i, int p)
+{ int callBase = -frame - nslots, k;
+  for (k = 0; k < i->nargs; k++)
+  { int r = fetch(i->args[k],ac);
+    inAc = -1;
+    emitRM("ST",r,callBase - 2 - k,mp,"call: store argument");
+  }
+  emitRM("ST",mp,callBase,mp,"call: store control link");
+  emitRM("LDA",mp,callBase,mp,"call: push frame");
+  emitRM("LDA",ac,1,pc,"call: return address");
+  emitRM_Sym("LDC",pc,0,0,i->sym->name,"call");
+  for (k = 0; k < acrossN[p]; k++)
+  { int v = across[acrossAt[p] + k];
+    if (reg[v] != 0) emitRM("LD",reg[v],slot[v],mp,"call: reload register");
+  }
+  keep(i->d,ac);
+}
+
+/* genInstr generates instruction i of block b, at
+ * position p
+ */
+static void genInstr(IrInstr * i, int b, int after, int p)
+{ int r, ra, rb;
+  switch (i->op)
+  { case IrParam:
+      if (tracked(i->d) && (uses[i->d] > 0) && (reg[i->d] != 0))
+        emitRM("LD",reg[i->d],-2 - i->val,mp,"load parameter");
+      break;
+    case IrCopy:
+      if (uses[i->d] == 0) break;
+      if (! passed[i->d] && (i->a != inAc) && tracked(i->a) &&
+          (reg[i->a] == reg[i->d]) &&
+          (! home[i->d] || (home[i->a] && (slot[i->a] == slot[i->d]))))
+        break;
+      r = target(i->d);
+      if (held(i->a) < 0) load(r,i->a);
+      else r = held(i->a);
+      keep(i->d,r);
+      break;
+    case IrBin:
+      genBin(i);
+      break;
+    case IrLoad:
+      r = target(i->d);
+      ra = i->a >= 0 ? fetch(i->a,ac) : ac;
+      memory("LD",r,i,base(i,ra,ac),"load element");
+      keep(i->d,r);
+      break;
+    case IrStore:
+      if (i->a >= 0)
+      { operands(i->b,i->a,&rb,&ra);
+        memory("ST",rb,i,base(i,ra,rb == ac ? ac1 : ac),"store element");
+      }
+      else
+      { rb = fetch(i->b,ac);
+        memory("ST",rb,i,base(i,ac,ac),"store value");
+      }
+      break;
+    case IrIn:
+      r = target(i->d);
+      emitRO("IN",r,0,0,"read integer value");
+      keep(i->d,r);
+      break;
+    case IrOut:
+      r = fetch(i->a,ac);
+      emitRO("OUT",r,0,0,"write value");
+      break;
+    case IrCall:
+      genCall(i,p);
+      break;
+    case IrRet:
+      if (i->a >= 0)
+      { r = fetch(i->a,ac);
+        if (r != ac) emitRM("LDA",ac,0,r,"return value");
+      }
+      emitRM("LD",ac1,-1,mp,"return: load return address");
+      emitRM("LD",mp,0,mp,"return: pop frame");
+      emitRM("LDA",pc,0,ac1,"return");
+      break;
+    case IrJump:
+    case IrBranch:
+      genBranch(i,b,after);
+      break;
+    default:
+      /* constants and addresses */
+      break;
+  }
+}
+
+/* opName returns the source text of operator op */
+static char * opName(int op)
+{ switch (op)
+  { case PLUS: return "+";
+    case MINUS: return "-";
+    case TIMES: return "*";
+    case OVER: return "/";
+    case LT: return "<";
+    case RT: return ">";
+    case LEQ: return "<=";
+    case REQ: return ">=";
+    case ASSIGN: return "==";
+    default: return "!=";
+  }
+}
+
+/* traceInstr records instruction i as a comment */
+static void traceInstr(IrInstr * i)
+{ char buffer[80];
+  char * name = i->sym != NULL ? i->sym->name : "";
+  switch (i->op)
+  { case IrConst: return;
+    case IrCopy: snprintf(buffer,sizeof(buffer),"v%d = v%d",i->d,i->a); break;
+    case IrBin:
+      snprintf(buffer,sizeof(buffer),"v%d = v%d %s v%d",i->d,i->a,opName(i->val),i->b);
+      break;
+    case IrParam: snprintf(buffer,sizeof(buffer),"v%d = param %d",i->d,i->val); break;
+    case IrAddr: snprintf(buffer,sizeof(buffer),"v%d = &%s",i->d,name); break;
+    case IrLoad:
+      if (i->a >= 0)
+        snprintf(buffer,sizeof(buffer),"v%d = %s[v%d + %d]",i->d,name,i->a,i->val);
+      else
+        snprintf(buffer,sizeof(buffer),"v%d = %s[%d]",i->d,name,i->val);
+      break;
+    case IrStore:
+      if (i->a >= 0)
+        snprintf(buffer,sizeof(buffer),"%s[v%d + %d] = v%d",name,i->a,i->val,i->b);
+      else
+        snprintf(buffer,sizeof(buffer),"%s[%d] = v%d",name,i->val,i->b);
+      break;
+    case IrIn: snprintf(buffer,sizeof(buffer),"v%d = input()",i->d); break;
+    case IrOut: snprintf(buffer,sizeof(buffer),"output(v%d)",i->a); break;
+    case IrCall: snprintf(buffer,sizeof(buffer),"v%d = %s(...)",i->d,name); break;
+    case IrRet:
+      if (i->a >= 0) snprintf(buffer,sizeof(buffer),"return v%d",i->a);
+      else snprintf(buffer,sizeof(buffer),"return");
+      break;
+    default: return;
+  }
+  emitComment(buffer);
+}
+
+/* genCode generates the code of fn */
+static void genCode(void)
+{ char buffer[80];
+  int k, i, p = 0;
+  if (TraceCode)
+  { snprintf(buffer,sizeof(buffer),"-> function %s",fn->sym->name);
+    emitComment(buffer);
+  }
+  emitRM("ST",ac,-1,mp,"store return address");
+  nfixups = 0;
+  for (k = 0; k < nlayout; k++)
+  { int b = layout[k];
+    int after = k + 1 < nlayout ? layout[k+1] : -1;
+    IrBlock * bl = &fn->block[b];
+    blockLoc[b] = emitSkip(0);
+    if (TraceCode)
+    { snprintf(buffer,sizeof(buffer),"block %d",b);
+      emitComment(buffer);
+    }
+    inAc = next = relop = -1;
+    for (i = 0; i < bl->n; i++, p++)
+    { if (TraceCode) traceInstr(&bl->code[i]);
+      genInstr(&bl->code[i],b,after,p);
+      /* an instruction without code leaves ac alone */
+      if (noCode(&bl->code[i])) continue;
+      inAc = next;
+      next = -1;
+      if (bl->code[i].op == IrBranch) relop = -1;
+    }
+  }
+  for (k = 0; k < nfixups; k++)
+  { emitBackup(fixups[k].loc);
+    emitRM_Abs(fixups[k].op,fixups[k].r,blockLoc[fixups[k].target],"jump");
+    emitRestore();
+  }
+  if (TraceCode) emitComment("<- function");
+}
+
+/* Function genIrFunction generates the code of
+ * function declaration f through the IR into a
+ * new fragment
+ */
+CodeFrag * genIrFunction(TreeNode * f)
+{ CodeFrag * frag;
+  int * order = NULL;
+  int n, k;
+  fn = lowerFunction(f);
+  if (fn == NULL) return NULL;
+  irFlow(fn);
+  buildSSA(fn);
+  runPasses(fn);
+  leaveSSA(fn);
+  irFlow(fn);
+  frag = newCodeFrag();
+  n = fn->nvalues + 1;
+  for (k = 0, npos = 0; k < fn->nblocks; k++) npos += fn->block[k].n;
+  def = (IrInstr **) calloc(n,sizeof(IrInstr *));
+  uses = (int *) calloc(n,sizeof(int));
+  slot = (int *) calloc(n,sizeof(int));
+  passed = (char *) calloc(n,sizeof(char));
+  start = (int *) malloc(n * sizeof(int));
+  end = (int *) malloc(n * sizeof(int));
+  defPos = (int *) malloc(n * sizeof(int));
+  reg = (int *) calloc(n,sizeof(int));
+  home = (char *) calloc(n,sizeof(char));
+  weight = (long *) calloc(n,sizeof(long));
+  callCost = (long *) calloc(n,sizeof(long));
+  acrossAt = (int *) calloc(npos + 1,sizeof(int));
+  acrossN = (int *) calloc(npos + 1,sizeof(int));
+  layout = (int *) malloc((fn->nblocks + 1) * sizeof(int));
+  forward = (int *) malloc((fn->nblocks + 1) * sizeof(int));
+  blockLoc = (int *) calloc(fn->nblocks + 1,sizeof(int));
+  if ((frag == NULL) || (def == NULL) || (uses == NULL) || (slot == NULL) ||
+      (passed == NULL) || (start == NULL) || (end == NULL) ||
+      (defPos == NULL) || (reg == NULL) || (home == NULL) ||
+      (weight == NULL) || (callCost == NULL) || (acrossAt == NULL) ||
+      (acrossN == NULL) || (layout == NULL) || (forward == NULL) ||
+      (blockLoc == NULL))
+    Error = TRUE;
+  frame = fn->sym->frame;
+  if (! Error)
+  { findValues();
+    doLayout();
+    if (! findIntervals() || ((order = sortByStart(&n)) == NULL)) Error = TRUE;
+  }
+  if (! Error)
+  { allocate(order,n);
+    if (! assignSlots(order,n)) Error = TRUE;
+  }
+  if (! Error)
+  { emitBegin(frag);
+    genCode();
+  }
+  free(order);
+  free(def);
+  free(uses);
+  free(slot);
+  free(passed);
+  free(start);
+  free(end);
+  free(defPos);
+  free(reg);
+  free(home);
+  free(weight);
+  free(callCost);
+  free(acrossAt);
+  free(acrossN);
+  free(layout);
+  free(forward);
+  free(blockLoc);
+  freeIrFunc(fn);
+  fn = NULL;
+  return frag;
+}
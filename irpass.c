@@ -0,0 +1,405 @@
+/****************************************************/
+/* File: irpass.c                                   */
+/* Optimization passes over the SSA form of the     */
+/* C- compiler's intermediate representation        */
+/****************************************************/
+
+#include <limits.h>
+#include "globals.h"
+#include "symtab.h"
+#include "stats.h"
+#include "ir.h"
+
+/* Each pass returns TRUE if it changed the
+ * function; runPasses runs them in turn until none
+ * does. In SSA form a value has one definition, so
+ * a pass that finds value d equal to value a turns
+ * the definition of d into "d = a", and the next
+ * propagation of copies replaces d by a wherever
+ * it is used.
+ */
+
+/* MAXROUNDS bounds the rounds of runPasses */
+#define MAXROUNDS 8
+
+/* def[v] is the instruction defining value v,
+ * found by findDefs; it stays valid while no
+ * instruction is inserted
+ */
+static IrInstr ** def = NULL;
+static int defCap = 0;
+
+static int findDefs(IrFunc * f)
+{ int b, i;
+  if (! irGrow(&def,&defCap,f->nvalues,sizeof(IrInstr *))) return FALSE;
+  memset(def,0,f->nvalues * sizeof(IrInstr *));
+  for (b = 0; b < f->nblocks; b++)
+    for (i = 0; i < f->block[b].n; i++)
+    { IrInstr * in = &f->block[b].code[i];
+      if (in->d >= 0) def[in->d] = in;
+    }
+  return TRUE;
+}
+
+/* isConst tells whether value v is a constant,
+ * and which
+ */
+static int isConst(int v, int * c)
+{ if ((v < 0) || (def[v] == NULL) || (def[v]->op != IrConst)) return FALSE;
+  *c = def[v]->val;
+  return TRUE;
+}
+
+/* makeCopy makes instruction i "d = a" */
+static void makeCopy(IrInstr * i, int a)
+{ i->op = IrCopy;
+  i->a = a;
+  i->b = -1;
+}
+
+/**************************************************/
+/**********   Copies   ****************************/
+/**************************************************/
+
+/* propagateCopies replaces the value of every
+ * copy by its source, and so the value of every
+ * phi whose arguments are all one value (or the
+ * phi itself, around a loop)
+ */
+static int propagateCopies(IrFunc * f)
+{ int * to = (int *) malloc(f->nvalues * sizeof(int));
+  int b, i, k, v, w, changed = FALSE;
+  if (to == NULL) return FALSE;
+  for (v = 0; v < f->nvalues; v++) to[v] = v;
+  for (b = 0; b < f->nblocks; b++)
+    for (i = 0; i < f->block[b].n; i++)
+    { IrInstr * in = &f->block[b].code[i];
+      if (in->op == IrCopy) to[in->d] = in->a;
+      else if (in->op == IrPhi)
+      { int same = -1;
+        for (k = 0; k < in->nargs; k++)
+          if ((in->args[k] != in->d) && (in->args[k] != same))
+          { if (same >= 0) break;
+            same = in->args[k];
+          }
+        if ((k == in->nargs) && (same >= 0)) to[in->d] = same;
+      }
+    }
+  /* follow chains of copies, shortening them */
+  for (v = 0; v < f->nvalues; v++)
+  { int r = v, n;
+    for (k = 0; (to[r] != r) && (k < f->nvalues); k++) r = to[r];
+    w = v;
+    while (to[w] != r)
+    { n = to[w];
+      to[w] = r;
+      w = n;
+    }
+  }
+  for (b = 0; b < f->nblocks; b++)
+    for (i = 0; i < f->block[b].n; i++)
+    { IrInstr * in = &f->block[b].code[i];
+      if (((in->op == IrCopy) || (in->op == IrPhi)) && (to[in->d] != in->d))
+      { in->op = IrNop;
+        changed = TRUE;
+        continue;
+      }
+      if (in->a >= 0) in->a = to[in->a];
+      if (in->b >= 0) in->b = to[in->b];
+      for (k = 0; k < in->nargs; k++)
+        if (in->args[k] >= 0) in->args[k] = to[in->args[k]];
+    }
+  free(to);
+  if (changed) irCompact(f);
+  return changed;
+}
+
+/**************************************************/
+/**********   Constants   *************************/
+/**************************************************/
+
+/* fold computes a op b as TM does, in *r; it
+ * returns FALSE for a division TM would stop at.
+ * A comparison is of a - b with 0, as on TM
+ */
+static int fold(int op, int a, int b, int * r)
+{ unsigned ua = (unsigned) a, ub = (unsigned) b;
+  int diff = (int) (ua - ub);
+  switch (op)
+  { case PLUS: *r = (int) (ua + ub); return TRUE;
+    case MINUS: *r = diff; return TRUE;
+    case TIMES: *r = (int) (ua * ub); return TRUE;
+    case OVER:
+      if ((b == 0) || ((a == INT_MIN) && (b == -1))) return FALSE;
+      *r = a / b;
+      return TRUE;
+    case LT: *r = diff < 0; return TRUE;
+    case RT: *r = diff > 0; return TRUE;
+    case LEQ: *r = diff <= 0; return TRUE;
+    case REQ: *r = diff >= 0; return TRUE;
+    case ASSIGN: *r = diff == 0; return TRUE;
+    case NEQ: *r = diff != 0; return TRUE;
+    default: return FALSE;
+  }
+}
+
+/* simplify folds i, an IrBin with one constant
+ * operand, if that operand is an identity or a zero
+ */
+static int simplify(IrInstr * i)
+{ int c;
+  if (isConst(i->b,&c))
+  { if ((c == 0) && ((i->val == PLUS) || (i->val == MINUS)))
+      makeCopy(i,i->a);
+    else if ((c == 1) && ((i->val == TIMES) || (i->val == OVER)))
+      makeCopy(i,i->a);
+    else if ((c == 0) && (i->val == TIMES))
+      makeCopy(i,i->b);
+    else return FALSE;
+    return TRUE;
+  }
+  if (isConst(i->a,&c))
+  { if ((c == 0) && (i->val == PLUS)) makeCopy(i,i->b);
+    else if ((c == 1) && (i->val == TIMES)) makeCopy(i,i->b);
+    else if ((c == 0) && (i->val == TIMES)) makeCopy(i,i->a);
+    else return FALSE;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/* foldConstants computes the operations on
+ * constants, and takes the branches on constants
+ * once and for all
+ */
+static int foldConstants(IrFunc * f)
+{ int b, i, a, c, r, changed = FALSE, flow = FALSE;
+  if (! findDefs(f)) return FALSE;
+  for (b = 0; b < f->nblocks; b++)
+    for (i = 0; i < f->block[b].n; i++)
+    { IrInstr * in = &f->block[b].code[i];
+      if (in->op == IrBin)
+      { if (isConst(in->a,&a) && isConst(in->b,&c) && fold(in->val,a,c,&r))
+        { in->op = IrConst;
+          in->val = r;
+          in->a = in->b = -1;
+        }
+        else if (! simplify(in)) continue;
+        changed = TRUE;
+        if (Stats != NULL) Stats->folded++;
+      }
+      else if ((in->op == IrBranch) && isConst(in->a,&c))
+      { irRemoveEdge(f,b,c != 0 ? 1 : 0);
+        in->op = IrJump;
+        in->a = -1;
+        changed = flow = TRUE;
+        if (Stats != NULL) Stats->folded++;
+      }
+    }
+  if (flow) irFlow(f);
+  return changed;
+}
+
+/* foldAddresses moves constants added to or
+ * subtracted from an address into the offset of
+ * the load or store
+ */
+static int foldAddresses(IrFunc * f)
+{ int b, i, c, changed = FALSE;
+  if (! findDefs(f)) return FALSE;
+  for (b = 0; b < f->nblocks; b++)
+    for (i = 0; i < f->block[b].n; i++)
+    { IrInstr * in = &f->block[b].code[i];
+      if ((in->op != IrLoad) && (in->op != IrStore)) continue;
+      while (in->a >= 0)
+      { IrInstr * d = def[in->a];
+        if ((in->sym != NULL) && isConst(in->a,&c)) in->a = -1;
+        else if ((d != NULL) && (d->op == IrBin) && (d->val == PLUS) &&
+                 isConst(d->b,&c))
+          in->a = d->a;
+        else if ((d != NULL) && (d->op == IrBin) && (d->val == PLUS) &&
+                 isConst(d->a,&c))
+          in->a = d->b;
+        else if ((d != NULL) && (d->op == IrBin) && (d->val == MINUS) &&
+                 isConst(d->b,&c) && (c != INT_MIN))
+        { in->a = d->a;
+          c = -c;
+        }
+        else break;
+        in->val += c;
+        changed = TRUE;
+      }
+    }
+  return changed;
+}
+
+/**************************************************/
+/**********   Common subexpressions   *************/
+/**************************************************/
+
+/* The operations seen are kept in a hash table of
+ * chains; an operation equal to one seen in a
+ * dominating block gets its value. The blocks are
+ * taken in reverse postorder, so the dominators of
+ * a block come before it
+ */
+
+#define HASHSIZE 1024
+
+typedef struct
+   { IrInstr * in;
+     int block;
+     int next;
+   } Seen;
+
+static int hashTable[HASHSIZE];
+static Seen * seen = NULL;
+static int nseen = 0;
+static int seenCap = 0;
+
+static int commutes(int op)
+{ return (op == PLUS) || (op == TIMES) || (op == ASSIGN) || (op == NEQ);
+}
+
+static int hashOf(IrInstr * in)
+{ unsigned h = (unsigned) in->val * 31u + (unsigned) in->a * 17u + (unsigned) in->b;
+  return (int) (h % HASHSIZE);
+}
+
+static int eliminateCommon(IrFunc * f)
+{ int k, i, j, changed = FALSE;
+  for (k = 0; k < HASHSIZE; k++) hashTable[k] = -1;
+  nseen = 0;
+  for (k = 0; k < f->norder; k++)
+  { int b = f->order[k];
+    for (i = 0; i < f->block[b].n; i++)
+    { IrInstr * in = &f->block[b].code[i];
+      int h;
+      if (in->op != IrBin) continue;
+      if (commutes(in->val) && (in->a > in->b))
+      { int swap = in->a;
+        in->a = in->b;
+        in->b = swap;
+      }
+      h = hashOf(in);
+      for (j = hashTable[h]; j >= 0; j = seen[j].next)
+      { IrInstr * s = seen[j].in;
+        if ((s->val == in->val) && (s->a == in->a) && (s->b == in->b) &&
+            irDominates(f,seen[j].block,b))
+          break;
+      }
+      if (j >= 0)
+      { makeCopy(in,seen[j].in->d);
+        changed = TRUE;
+        if (Stats != NULL) Stats->cse++;
+        continue;
+      }
+      if (! irGrow(&seen,&seenCap,nseen,sizeof(Seen))) return changed;
+      seen[nseen].in = in;
+      seen[nseen].block = b;
+      seen[nseen].next = hashTable[h];
+      hashTable[h] = nseen++;
+    }
+  }
+  return changed;
+}
+
+/**************************************************/
+/**********   Dead code   *************************/
+/**************************************************/
+
+/* hasEffect tells whether i must stay whether or
+ * not its value is used
+ */
+static int hasEffect(IrInstr * i)
+{ switch (i->op)
+  { case IrStore: case IrIn: case IrOut: case IrCall:
+    case IrJump: case IrBranch: case IrRet:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/* live marks the values used, work holds those
+ * whose definitions are still to be marked
+ */
+static char * live = NULL;
+static int * work = NULL;
+static int nwork = 0;
+
+static void markLive(int v)
+{ if ((v >= 0) && ! live[v])
+  { live[v] = TRUE;
+    work[nwork++] = v;
+  }
+}
+
+static void markOperands(IrInstr * i)
+{ int k;
+  markLive(i->a);
+  markLive(i->b);
+  for (k = 0; k < i->nargs; k++) markLive(i->args[k]);
+}
+
+/* removeDead removes the instructions without
+ * effect whose values no instruction that stays
+ * uses
+ */
+static int removeDead(IrFunc * f)
+{ int b, i, changed = FALSE;
+  live = (char *) calloc(f->nvalues + 1,sizeof(char));
+  work = (int *) malloc((f->nvalues + 1) * sizeof(int));
+  nwork = 0;
+  if ((live == NULL) || (work == NULL) || ! findDefs(f)) goto done;
+  for (b = 0; b < f->nblocks; b++)
+    for (i = 0; i < f->block[b].n; i++)
+      if (hasEffect(&f->block[b].code[i])) markOperands(&f->block[b].code[i]);
+  while (nwork > 0)
+  { IrInstr * in = def[work[--nwork]];
+    if (in != NULL) markOperands(in);
+  }
+  for (b = 0; b < f->nblocks; b++)
+    for (i = 0; i < f->block[b].n; i++)
+    { IrInstr * in = &f->block[b].code[i];
+      if (hasEffect(in) || (in->d < 0) || live[in->d]) continue;
+      in->op = IrNop;
+      changed = TRUE;
+      if (Stats != NULL) Stats->deadCode++;
+    }
+  if (changed) irCompact(f);
+done:
+  free(live);
+  free(work);
+  live = NULL;
+  work = NULL;
+  return changed;
+}
+
+/**************************************************/
+/**********   Pass manager   **********************/
+/**************************************************/
+
+/* passes are run in this order in every round */
+static int (* passes[]) (IrFunc * f) =
+   { propagateCopies,
+     foldConstants,
+     foldAddresses,
+     eliminateCommon,
+     removeDead
+   };
+
+#define NPASSES ((int) (sizeof(passes) / sizeof(passes[0])))
+
+/* Procedure runPasses runs the optimization passes
+ * on f, which is in SSA form, until none of them
+ * changes it or MAXROUNDS rounds have run
+ */
+void runPasses(IrFunc * f)
+{ int round, p, changed = TRUE;
+  for (round = 0; changed && (round < MAXROUNDS) && ! Error; round++)
+  { changed = FALSE;
+    for (p = 0; p < NPASSES; p++)
+      if (passes[p](f)) changed = TRUE;
+  }
+}
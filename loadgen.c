@@ -0,0 +1,115 @@
+/****************************************************/
+/* File: loadgen.c                                  */
+/* Load generator for the compile server: times     */
+/* one process per file against one -server         */
+/* process answering batched requests               */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* BATCH is the number of requests sent before RUN */
+#define BATCH 64
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Function runExec compiles n files with one
+ * compiler process each, returning the seconds taken
+ */
+static double runExec(char * compiler, int n, char ** files, int nfiles)
+{ double start = now();
+  int i;
+  for (i=0;i<n;i++)
+  { pid_t pid = fork();
+    if (pid == 0)
+    { execl(compiler,compiler,files[i % nfiles],(char *) NULL);
+      _exit(127);
+    }
+    if (pid < 0)
+    { perror("fork");
+      exit(1);
+    }
+    waitpid(pid,NULL,0);
+  }
+  return now() - start;
+}
+
+/* Function runServer sends n PATH requests to one
+ * compiler -server process, returning the seconds taken
+ */
+static double runServer(char * compiler, int n, char ** files, int nfiles)
+{ int toServer[2], fromServer[2];
+  FILE * out, * in;
+  double start = now();
+  pid_t pid;
+  int sent = 0, got = 0;
+  if ((pipe(toServer) < 0) || (pipe(fromServer) < 0))
+  { perror("pipe");
+    exit(1);
+  }
+  pid = fork();
+  if (pid == 0)
+  { dup2(toServer[0],0);
+    dup2(fromServer[1],1);
+    close(toServer[1]);
+    close(fromServer[0]);
+    execl(compiler,compiler,"-server",(char *) NULL);
+    _exit(127);
+  }
+  close(toServer[0]);
+  close(fromServer[1]);
+  out = fdopen(toServer[1],"w");
+  in = fdopen(fromServer[0],"r");
+  while (got < n)
+  { int batch = 0;
+    while ((sent < n) && (batch < BATCH))
+    { char * f = files[sent % nfiles];
+      fprintf(out,"PATH %lu\n%s",(unsigned long) strlen(f),f);
+      sent++;
+      batch++;
+    }
+    fprintf(out,"RUN\n");
+    fflush(out);
+    while (batch-- > 0)
+    { char header[64], status[8];
+      int id;
+      unsigned long lstLen, cdLen, k;
+      if ((fgets(header,sizeof(header),in) == NULL) ||
+          (sscanf(header,"RESULT %d %7s %lu %lu",&id,status,&lstLen,&cdLen) != 4))
+      { fprintf(stderr,"bad response after %d results\n",got);
+        exit(1);
+      }
+      for (k=0;k<lstLen+cdLen;k++) getc(in);
+      got++;
+    }
+  }
+  fclose(out);
+  fclose(in);
+  waitpid(pid,NULL,0);
+  return now() - start;
+}
+
+int main(int argc, char * argv[])
+{ double tExec, tServer;
+  int n;
+  if (argc < 4)
+  { fprintf(stderr,"usage: %s <compiler> <count> <source>...\n",argv[0]);
+    return 1;
+  }
+  n = atoi(argv[2]);
+  tExec = runExec(argv[1],n,argv+3,argc-3);
+  tServer = runServer(argv[1],n,argv+3,argc-3);
+  printf("%-16s %8s %10s %12s\n","mode","compiles","seconds","compiles/s");
+  printf("%-16s %8d %10.3f %12.1f\n","exec per file",n,tExec,n/tExec);
+  printf("%-16s %8d %10.3f %12.1f\n","server",n,tServer,n/tServer);
+  printf("speedup %.2fx\n",tExec/tServer);
+  return 0;
+}
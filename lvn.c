@@ -0,0 +1,314 @@
+/****************************************************/
+/* File: lvn.c                                      */
+/* Local value numbering over the TM code of the    */
+/* C- compiler                                      */
+/****************************************************/
+
+#include "globals.h"
+#include "code.h"
+#include "stats.h"
+#include "lvn.h"
+
+/* Within a basic block every value the code
+ * handles gets a number: two values with the same
+ * number are equal. A register holds the number
+ * of its value; a memory word read or written in
+ * the block holds the number last loaded from or
+ * stored to it; an operation on numbered operands
+ * gets the number it got before in the block.
+ *
+ * The code generator keeps every value in memory
+ * and loads it into ac and ac1 as needed, so the
+ * same word is often loaded while a register still
+ * holds it ("x = y; output(x);", "u - u / v").
+ * Such a load is dropped, or made a register copy
+ * if another register holds the value; so are a
+ * store of the value a word holds and an
+ * operation whose result is already in its target.
+ *
+ * A memory word is named by the number of its base
+ * register, its offset and its symbol. mp and gp
+ * change only at calls and returns, which end a
+ * block; a word named through them (direct) is
+ * changed only by a store to the same name, or
+ * through a computed address (indirect), which may
+ * point anywhere. Blocks start at location 0, at
+ * every pc-relative target and after every jump;
+ * at its start nothing is known.
+ */
+
+/* TABLESIZE bounds the words and operations known
+ * in a block; a full table is emptied
+ */
+#define TABLESIZE 256
+
+/* NREGS is the number of TM registers */
+#define NREGS 8
+
+typedef struct
+   { int base, off;
+     char * sym;
+     int direct;
+     int value;
+   } Word;
+
+typedef struct
+   { char op[5];
+     int a, b;
+     char * sym;
+     int value;
+   } Operation;
+
+/* the value numbers of the registers */
+static int reg[NREGS];
+
+static Word words[TABLESIZE];
+static int nwords = 0;
+
+static Operation ops[TABLESIZE];
+static int nops = 0;
+
+static int nextValue = 0;
+
+/* startBlock forgets all values */
+static void startBlock(void)
+{ int r;
+  for (r = 0; r < NREGS; r++) reg[r] = nextValue++;
+  nwords = 0;
+  nops = 0;
+}
+
+static int sameSym(char * a, char * b)
+{ if ((a == NULL) || (b == NULL)) return a == b;
+  return strcmp(a,b) == 0;
+}
+
+/* operation returns the number of op applied to
+ * a and b (for LDC and LDA: the offset a from the
+ * value b, plus the address of sym)
+ */
+static int operation(char * op, int a, int b, char * sym)
+{ int i;
+  if (((strcmp(op,"ADD") == 0) || (strcmp(op,"MUL") == 0)) && (a > b))
+  { int swap = a;
+    a = b;
+    b = swap;
+  }
+  for (i = 0; i < nops; i++)
+    if ((ops[i].a == a) && (ops[i].b == b) && (strcmp(ops[i].op,op) == 0) &&
+        sameSym(ops[i].sym,sym))
+      return ops[i].value;
+  if (nops == TABLESIZE) nops = 0;
+  strcpy(ops[nops].op,op);
+  ops[nops].a = a;
+  ops[nops].b = b;
+  ops[nops].sym = sym;
+  ops[nops].value = nextValue++;
+  return ops[nops++].value;
+}
+
+/* findWord returns the index of the word named by
+ * the operand of i, or -1
+ */
+static int findWord(TMInstr * i)
+{ int k;
+  for (k = 0; k < nwords; k++)
+    if ((words[k].base == reg[i->b]) && (words[k].off == i->a) &&
+        sameSym(words[k].sym,i->sym))
+      return k;
+  return -1;
+}
+
+static int isDirect(TMInstr * i)
+{ return (i->b == mp) || (i->b == gp);
+}
+
+/* setWord records that the word named by the
+ * operand of i holds value
+ */
+static void setWord(TMInstr * i, int value)
+{ int k = findWord(i);
+  if (k < 0)
+  { if (nwords == TABLESIZE) nwords = 0;
+    k = nwords++;
+    words[k].base = reg[i->b];
+    words[k].off = i->a;
+    words[k].sym = i->sym;
+    words[k].direct = isDirect(i);
+  }
+  words[k].value = value;
+}
+
+/* store forgets the words a store by i may change */
+static void store(TMInstr * i)
+{ int k, n = 0;
+  if (! isDirect(i))
+  { nwords = 0;
+    return;
+  }
+  for (k = 0; k < nwords; k++)
+    if (words[k].direct) words[n++] = words[k];
+  nwords = n;
+}
+
+/* setReg records the value of register r; a new
+ * mp or gp renames all words
+ */
+static void setReg(int r, int value)
+{ reg[r] = value;
+  if ((r == mp) || (r == gp)) nwords = 0;
+}
+
+static int isOp(TMInstr * i, char * op)
+{ return strcmp(i->op,op) == 0;
+}
+
+/* jumps tells whether i may change pc */
+static int jumps(TMInstr * i)
+{ if (i->op[0] == 'J') return TRUE;
+  if (isOp(i,"HALT")) return TRUE;
+  return (i->r == pc) && ! isOp(i,"ST") && ! isOp(i,"OUT");
+}
+
+/* Action is what becomes of an instruction */
+typedef enum {Keep,Drop,Copy} Action;
+
+/* number gives instruction i its value numbers;
+ * *from is set to the register to copy, for Copy
+ */
+static Action number(TMInstr * i, int * from)
+{ int value, k, r;
+  if (i->op[0] == '\0')
+  { startBlock();
+    return Keep;
+  }
+  if (! i->rm)
+  { if (isOp(i,"IN")) setReg(i->r,nextValue++);
+    else if (isOp(i,"ADD") || isOp(i,"SUB") || isOp(i,"MUL") || isOp(i,"DIV"))
+    { value = operation(i->op,reg[i->a],reg[i->b],NULL);
+      if ((reg[i->r] == value) && (i->r != pc))
+      { if (Stats != NULL) Stats->lvnOps++;
+        return Drop;
+      }
+      setReg(i->r,value);
+    }
+    return Keep;
+  }
+  if (isOp(i,"LDC") || isOp(i,"LDA"))
+  { if (i->b == pc) value = nextValue++; /* an address in the code */
+    else if (isOp(i,"LDC")) value = operation("LDC",i->a,0,i->sym);
+    else value = operation("LDA",i->a,reg[i->b],i->sym);
+    if ((reg[i->r] == value) && (i->r != pc))
+    { if (Stats != NULL) Stats->lvnOps++;
+      return Drop;
+    }
+    setReg(i->r,value);
+    return Keep;
+  }
+  if (isOp(i,"LD"))
+  { if ((i->b == pc) || (i->r == pc))
+    { setReg(i->r,nextValue++);
+      return Keep;
+    }
+    k = findWord(i);
+    if (k < 0)
+    { value = nextValue++;
+      setWord(i,value);
+      setReg(i->r,value);
+      return Keep;
+    }
+    value = words[k].value;
+    if (reg[i->r] == value)
+    { if (Stats != NULL) Stats->lvnLoads++;
+      return Drop;
+    }
+    setReg(i->r,value);
+    for (r = 0; r < NREGS; r++)
+      if ((r != i->r) && (r != pc) && (reg[r] == value))
+      { *from = r;
+        if (Stats != NULL) Stats->lvnCopies++;
+        return Copy;
+      }
+    return Keep;
+  }
+  if (isOp(i,"ST"))
+  { if (i->b == pc) return Keep;
+    k = findWord(i);
+    if ((k >= 0) && (words[k].value == reg[i->r]))
+    { if (Stats != NULL) Stats->lvnStores++;
+      return Drop;
+    }
+    store(i);
+    setWord(i,reg[i->r]);
+  }
+  return Keep;
+}
+
+/* Procedure numberValues removes from fragment f
+ * the instructions that, within a basic block,
+ * load, store or compute a value already where it
+ * goes, and turns a load of a value some other
+ * register holds into a register copy
+ */
+void numberValues(CodeFrag * f)
+{ char * leader = (char *) calloc(f->size+1,sizeof(char));
+  char * drop = (char *) calloc(f->size+1,sizeof(char));
+  int * newLoc = (int *) malloc((f->size+1) * sizeof(int));
+  int loc, n, from;
+  if ((leader == NULL) || (drop == NULL) || (newLoc == NULL))
+  { free(leader);
+    free(drop);
+    free(newLoc);
+    return;
+  }
+  leader[0] = TRUE;
+  for (loc = 0; loc < f->size; loc++)
+  { TMInstr * i = &f->code[loc];
+    if (i->rm && (i->b == pc))
+    { int target = loc + 1 + i->a;
+      if ((target >= 0) && (target <= f->size)) leader[target] = TRUE;
+    }
+    if (jumps(i)) leader[loc+1] = TRUE;
+  }
+  /* newLoc[loc] is where the instruction at loc, or
+     the first one kept after it, goes */
+  n = 0;
+  for (loc = 0; loc < f->size; loc++)
+  { TMInstr * i = &f->code[loc];
+    newLoc[loc] = n;
+    if (leader[loc]) startBlock();
+    switch (number(i,&from))
+    { case Drop:
+        drop[loc] = TRUE;
+        continue;
+      case Copy:
+        strcpy(i->op,"LDA");
+        i->a = 0;
+        i->b = from;
+        i->sym = NULL;
+        i->comment = "copy: value already in a register";
+        break;
+      default:
+        break;
+    }
+    n++;
+  }
+  newLoc[f->size] = n;
+  /* the jumps keep their targets */
+  for (loc = 0, n = 0; loc < f->size; loc++)
+  { TMInstr i = f->code[loc];
+    if (drop[loc]) continue;
+    if ((i.op[0] != '\0') && i.rm && (i.b == pc))
+    { int target = loc + 1 + i.a;
+      if ((target >= 0) && (target <= f->size))
+        i.a = newLoc[target] - (n + 1);
+    }
+    f->code[n++] = i;
+  }
+  f->size = n;
+  for (loc = 0; loc < f->ncomments; loc++)
+    f->comments[loc].loc = newLoc[f->comments[loc].loc];
+  free(leader);
+  free(drop);
+  free(newLoc);
+}
@@ -0,0 +1,22 @@
+/****************************************************/
+/* File: lvn.h                                      */
+/* Local value numbering over the TM code of the    */
+/* C- compiler                                      */
+/****************************************************/
+
+#ifndef _LVN_H_
+#define _LVN_H_
+
+#include "code.h"
+
+/* Procedure numberValues removes from fragment f
+ * the instructions that, within a basic block,
+ * load, store or compute a value already where it
+ * goes, and turns a load of a value some other
+ * register holds into a register copy. The
+ * pc-relative jumps and comments of f are moved
+ * with the code
+ */
+void numberValues(CodeFrag * f);
+
+#endif
@@ -10,14 +10,18 @@
 /* set NO_PARSE to TRUE to get a scanner-only compiler */
 #define NO_PARSE FALSE
 /* set NO_ANALYZE to TRUE to get a parser-only compiler */
-#define NO_ANALYZE TRUE
+#define NO_ANALYZE FALSE
 
 /* set NO_CODE to TRUE to get a compiler that does not
  * generate code
  */
-#define NO_CODE TRUE
+#define NO_CODE FALSE
 
 #include "util.h"
+#include "server.h"
+#include "incr.h"
+#include "astio.h"
+#include "stats.h"
 #if NO_PARSE
 #include "scan.h"
 #else
@@ -26,6 +30,7 @@
 #include "analyze.h"
 #if !NO_CODE
 #include "cgen.h"
+#include "opt.h"
 #endif
 #endif
 #endif
@@ -33,8 +38,8 @@
 /* allocate global variables */
 int lineno = 0;
 FILE * source;
-FILE * listing;
-FILE * code;
+OutBuf * listing;
+OutBuf * code;
 
 /* allocate and set tracing flags */
 int EchoSource = FALSE;
@@ -43,69 +48,288 @@ int TraceParse = TRUE;
 int TraceAnalyze = FALSE;
 int TraceCode = FALSE;
 
+int Optimize = TRUE;
+
+int MaxErrors = 20;
+
 int Error = FALSE;
 
-main( int argc, char * argv[] )
+static void startListing(char * pgm)
+{ Error = FALSE;
+  obPuts(listing,"\nTINY COMPILATION: ");
+  obPuts(listing,pgm);
+  obPutc(listing,'\n');
+}
+
+#if !NO_PARSE
+/* Procedure compileTree is the back end: it runs
+ * analysis and code generation on a parsed program
+ */
+static void compileTree(TreeNode * syntaxTree, char * pgm)
+{ if (Stats != NULL) Stats->nodes = countNodes(syntaxTree);
+  if (TraceParse) {
+    obPuts(listing,"\nSyntax tree:\n");
+    printTree(syntaxTree);
+  }
+  obFlush(listing);
+#if !NO_ANALYZE
+  if (! Error)
+  { if (TraceAnalyze) obPuts(listing,"\nBuilding Symbol Table...\n");
+    phaseStart(SymtabPhase);
+    buildSymtab(syntaxTree);
+    phaseEnd(SymtabPhase);
+    if (TraceAnalyze) obPuts(listing,"\nChecking Types...\n");
+    phaseStart(CheckPhase);
+    typeCheck(syntaxTree);
+    phaseEnd(CheckPhase);
+    if (TraceAnalyze) obPuts(listing,"\nType Checking Finished\n");
+    obFlush(listing);
+    if (Stats != NULL) st_stats(&Stats->symtab);
+  }
+#if !NO_CODE
+  if ((! Error) && (code != NULL))
+  { char * codefile;
+    int fnlen = strcspn(pgm,".");
+    optimize(syntaxTree);
+    phaseStart(CodePhase);
+    codefile = (char *) calloc(fnlen+4, sizeof(char));
+    strncpy(codefile,pgm,fnlen);
+    strcat(codefile,".tm");
+    codeGen(syntaxTree,codefile);
+    obFlush(code);
+    obFlush(listing);
+    free(codefile);
+    phaseEnd(CodePhase);
+  }
+#endif
+#endif
+}
+#endif
+
+/* Function compileSource runs the compiler on src,
+ * sending the listing to lst and, when code generation
+ * is enabled, TM code to codefp; pgm names the program.
+ * Output is flushed at the end of each phase.
+ * It returns FALSE if a syntax error stopped the
+ * compilation (Error is set for any error)
+ */
+int compileSource(FILE * src, char * pgm, OutBuf * lst, OutBuf * codefp)
 { TreeNode * syntaxTree;
-  char pgm[120]; /* source code file name */
+  int syntaxError = FALSE;
+  source = src;
+  listing = lst;
+  code = codefp;
+  startListing(pgm);
+#if NO_PARSE
+  { Scanner * scan = newScanner(source,listing);
+    obPuts(listing,"line number\ttoken\tlexeme\n");
+    obPuts(listing,"----------------------------------\n");
+    while (getToken(scan)!=ENDFILE);
+    freeScanner(scan);
+    obFlush(listing);
+  }
+#else
+  phaseStart(ParsePhase);
+  syntaxTree = parseSource(source,listing,&syntaxError);
+  phaseEnd(ParsePhase);
+  if (syntaxError)
+  { Error = TRUE;
+    obFlush(listing);
+    return FALSE;
+  }
+  compileTree(syntaxTree,pgm);
+#endif
+  return TRUE;
+}
+
+#if !NO_PARSE
+/* Function emitAst is the front end alone: it parses
+ * src and writes the tree to astfile (see astio.h)
+ * instead of compiling it. It returns FALSE on a
+ * syntax error or if the file cannot be written
+ */
+static int emitAst(FILE * src, char * pgm, OutBuf * lst, char * astfile)
+{ TreeNode * syntaxTree;
+  int syntaxError = FALSE;
+  source = src;
+  listing = lst;
+  startListing(pgm);
+  syntaxTree = parseSource(source,listing,&syntaxError);
+  if (TraceParse && ! syntaxError) {
+    obPuts(listing,"\nSyntax tree:\n");
+    printTree(syntaxTree);
+  }
+  obFlush(listing);
+  if (syntaxError)
+  { Error = TRUE;
+    return FALSE;
+  }
+  if (! writeTreeFile(astfile,syntaxTree))
+  { fprintf(stderr,"Unable to write %s\n",astfile);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* Function compileAst is the back end alone: it
+ * compiles the tree stored in the file pgm by
+ * emitAst, like compileSource
+ */
+static int compileAst(char * pgm, OutBuf * lst, OutBuf * codefp)
+{ TreeNode * syntaxTree;
+  int error;
+  listing = lst;
+  code = codefp;
+  startListing(pgm);
+  phaseStart(ParsePhase);
+  syntaxTree = readTreeFile(pgm,&error);
+  phaseEnd(ParsePhase);
+  if (error)
+  { fprintf(stderr,"File %s is not a syntax tree\n",pgm);
+    Error = TRUE;
+    return FALSE;
+  }
+  compileTree(syntaxTree,pgm);
+  return TRUE;
+}
+#endif
+
+/* writeCode writes the TM code in buffer cb to the
+ * file pgm.tm, for a program named pgm.c
+ */
+static void writeCode(char * pgm, OutBuf * cb)
+{ char * codefile;
+  FILE * codefp;
+  int fnlen = strcspn(pgm,".");
+  codefile = (char *) calloc(fnlen+4, sizeof(char));
+  strncpy(codefile,pgm,fnlen);
+  strcat(codefile,".tm");
+  codefp = fopen(codefile,"w");
+  if (codefp == NULL)
+  { printf("Unable to open %s\n",codefile);
+    exit(1);
+  }
+  fwrite(cb->buf,1,cb->len,codefp);
+  fclose(codefp);
+  free(codefile);
+}
+
+/* hasSuffix tells whether name ends in suffix */
+static int hasSuffix(char * name, char * suffix)
+{ size_t n = strlen(name), k = strlen(suffix);
+  return (n >= k) && (strcmp(name+n-k,suffix) == 0);
+}
+
+main( int argc, char * argv[] )
+{ char pgm[120]; /* source code file name */
+  char * prog = argv[0];
   char open_file[120] = "_20181632.txt";
   char *str1 = NULL;
-  if (argc != 2)
-    { fprintf(stderr,"usage: %s <filename>\n",argv[0]);
+  char * cacheDir = NULL; /* -cache: incremental compilation */
+  int emit = FALSE; /* -emit-ast: parse only, write a tree file */
+  int stats = FALSE, json = FALSE; /* -stats[=json] */
+  int isAst; /* the input is a tree file */
+  int hits = 0, total = 0, ok;
+  if ((argc >= 2) && (strcmp(argv[1],"-server") == 0))
+  { if (argc == 2) return serveStream(stdin,stdout);
+    if (argc == 3) return serve(argv[2]);
+  }
+  while (argc > 2)
+  { if ((strcmp(argv[1],"-stats") == 0) || (strcmp(argv[1],"-stats=json") == 0))
+    { stats = TRUE;
+      json = argv[1][6] != '\0';
+      argv++;
+      argc--;
+    }
+    else if ((argc > 3) && (strcmp(argv[1],"-cache") == 0))
+    { cacheDir = argv[2];
+      argv += 2;
+      argc -= 2;
+    }
+    else if (strcmp(argv[1],"-emit-ast") == 0)
+    { emit = TRUE;
+      argv++;
+      argc--;
+    }
+    else if (strcmp(argv[1],"-O0") == 0)
+    { Optimize = FALSE;
+      argv++;
+      argc--;
+    }
+    else if ((argc > 3) && (strcmp(argv[1],"-max-errors") == 0) &&
+             (isdigit((unsigned char) argv[2][0])))
+    { MaxErrors = atoi(argv[2]);
+      argv += 2;
+      argc -= 2;
+    }
+    else break;
+  }
+  if ((argc != 2) || (emit && (cacheDir != NULL)))
+    { fprintf(stderr,"usage: %s [-stats[=json]] [-O0] [-max-errors n] [-cache dir] <filename>\n",prog);
+      fprintf(stderr,"       %s [-stats[=json]] [-max-errors n] -emit-ast <filename>\n",prog);
+      fprintf(stderr,"       %s [-stats[=json]] [-O0] <filename>.ast\n",prog);
+      fprintf(stderr,"       %s -server [socket]\n",prog);
       exit(1);
     }
   strcpy(pgm,argv[1]) ;
   if (strchr (pgm, '.') == NULL)
      strcat(pgm,".tny");
-  source = fopen(pgm,"r");
+  isAst = hasSuffix(pgm,".ast");
+  if (isAst && emit)
+  { fprintf(stderr,"File %s is already a syntax tree\n",pgm);
+    exit(1);
+  }
+  source = fopen(pgm,isAst ? "rb" : "r");
   if (source==NULL)
   { fprintf(stderr,"File %s not found\n",pgm);
     exit(1);
   }
+  if (stats)
+  { statsBegin();
+    if (fseek(source,0,SEEK_END) == 0) Stats->bytes = ftell(source);
+    rewind(source);
+  }
   char temp[120];
   strcpy(temp,pgm);
   str1 = strtok(temp,".");
   //printf("%s",temp);
   strcat(str1, open_file);
-  listing = fopen(str1,"w"); /* send listing to screen */
-  fprintf(listing,"\nTINY COMPILATION: %s\n",pgm);
-#if NO_PARSE
-  fprintf(listing,"line number\ttoken\tlexeme\n");
-  fprintf(listing,"----------------------------------\n");
-  while (getToken()!=ENDFILE);
-#else
-  syntaxTree = parse();
-  if (TraceParse) {
-    fprintf(listing,"\nSyntax tree:\n");
-    printTree(syntaxTree);
-  }
-#if !NO_ANALYZE
-  if (! Error)
-  { if (TraceAnalyze) fprintf(listing,"\nBuilding Symbol Table...\n");
-    buildSymtab(syntaxTree);
-    if (TraceAnalyze) fprintf(listing,"\nChecking Types...\n");
-    typeCheck(syntaxTree);
-    if (TraceAnalyze) fprintf(listing,"\nType Checking Finished\n");
-  }
-#if !NO_CODE
-  if (! Error)
-  { char * codefile;
+  listing = newOutBuf(fopen(str1,"w")); /* send listing to screen */
+  code = NULL;
+#if !NO_PARSE && !NO_ANALYZE && !NO_CODE
+  /* the code stays in memory until the compilation
+   * has succeeded, so an error leaves no .tm file */
+  if (! emit) code = newOutBuf(NULL);
+#endif
+#if !NO_PARSE
+  if (emit)
+  { char * astfile;
     int fnlen = strcspn(pgm,".");
-    codefile = (char *) calloc(fnlen+4, sizeof(char));
-    strncpy(codefile,pgm,fnlen);
-    strcat(codefile,".tm");
-    code = fopen(codefile,"w");
-    if (code == NULL)
-    { printf("Unable to open %s\n",codefile);
-      exit(1);
-    }
-    codeGen(syntaxTree,codefile);
-    fclose(code);
+    astfile = (char *) calloc(fnlen+5, sizeof(char));
+    strncpy(astfile,pgm,fnlen);
+    strcat(astfile,".ast");
+    ok = emitAst(source,pgm,listing,astfile);
+    free(astfile);
   }
+  else if (isAst)
+    ok = compileAst(pgm,listing,code);
+  else
 #endif
-#endif
-#endif
+  if (cacheDir != NULL)
+  { ok = compileCached(source,pgm,listing,code,cacheDir,&hits,&total);
+    printf("cache: %d of %d functions reused (%.1f%%)\n",hits,total,
+           total > 0 ? 100.0 * hits / total : 0.0);
+  }
+  else
+    ok = compileSource(source,pgm,listing,code);
+  if (stats) printStats(stdout,pgm,json);
+  if (! ok)
+    exit(-1);
+  if (code != NULL)
+  { if (! Error) writeCode(pgm,code);
+    freeOutBuf(code);
+  }
+  freeOutBuf(listing);
   fclose(source);
   return 0;
 }
-
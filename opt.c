@@ -0,0 +1,880 @@
+/****************************************************/
+/* File: opt.c                                      */
+/* Syntax tree optimizations of the C- compiler     */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "symtab.h"
+#include "traverse.h"
+#include "stats.h"
+#include "opt.h"
+
+/* isFunction tells whether t declares a function */
+static int isFunction(TreeNode * t)
+{ return (t->nodekind == ExpK) && (t->kind.exp == FuncK);
+}
+
+/**************************************************/
+/**********   Code after return   *****************/
+/**************************************************/
+
+/* returns tells whether statement s always ends in
+ * a return: a return, a compound statement whose
+ * list does (already pruned, so that it is the
+ * last one), or an if whose two branches do
+ */
+static int returns(TreeNode * s)
+{ while (s != NULL)
+  { if (s->nodekind != StmtK) return FALSE;
+    switch (s->kind.stmt)
+    { case ReturnK:
+        return TRUE;
+      case CompK:
+        s = s->child[1];
+        while ((s != NULL) && (s->sibling != NULL)) s = s->sibling;
+        break;
+      case IfK:
+        if ((s->child[2] == NULL) || ! returns(s->child[1])) return FALSE;
+        s = s->child[2];
+        break;
+      default:
+        return FALSE;
+    }
+  }
+  return FALSE;
+}
+
+/* pruneList is the postorder visitor of
+ * pruneFunction: the statements inside a compound
+ * statement have been pruned before its list is
+ */
+static void pruneList(TreeNode * t, int depth, void * arg)
+{ TreeNode * s;
+  if ((t->nodekind != StmtK) || (t->kind.stmt != CompK)) return;
+  for (s = t->child[1]; s != NULL; s = s->sibling)
+    if (returns(s))
+    { if ((s->sibling != NULL) && (Stats != NULL))
+      { TreeNode * d;
+        for (d = s->sibling; d != NULL; d = d->sibling)
+          Stats->deadStmts++;
+      }
+      s->sibling = NULL;
+      break;
+    }
+}
+
+/* Procedure pruneFunction drops the statements of
+ * function declaration f that follow a statement
+ * which always returns
+ */
+void pruneFunction(TreeNode * f)
+{ TreeVisitor v = { NULL, NULL, pruneList, NULL };
+  TreeNode * sibling = f->sibling;
+  f->sibling = NULL;
+  walkTree(f,&v);
+  f->sibling = sibling;
+}
+
+/**************************************************/
+/**********   Unreachable functions   *************/
+/**************************************************/
+
+/* FuncList is the work list of markReachable: the
+ * functions found reachable whose calls are still
+ * to be followed
+ */
+typedef struct
+   { Symbol ** sym;
+     int n, cap;
+   } FuncList;
+
+/* reach marks function s reachable and queues it */
+static void reach(FuncList * l, Symbol * s)
+{ if ((s == NULL) || (s->kind != FuncSym) || (s->decl == NULL) || ! s->dead)
+    return;
+  s->dead = FALSE;
+  if (l->n == l->cap)
+  { Symbol ** bigger;
+    int cap = l->cap ? 2*l->cap : 64;
+    bigger = (Symbol **) realloc(l->sym,cap * sizeof(Symbol *));
+    if (bigger == NULL)
+    { obPuts(listing,"Out of memory error in optimizer\n");
+      Error = TRUE;
+      return;
+    }
+    l->sym = bigger;
+    l->cap = cap;
+  }
+  l->sym[l->n++] = s;
+}
+
+/* callVisit follows the calls of one function.
+ * Only globals are in scope after analysis, so a
+ * call is bound by name: the trees of functions
+ * reused from the cache are not resolved
+ */
+static int callVisit(TreeNode * t, int depth, void * arg)
+{ if ((t->nodekind == StmtK) && (t->kind.stmt == CallK))
+    reach((FuncList *) arg,st_lookup(t->attr.name));
+  return TRUE;
+}
+
+/* Procedure markReachable sets the dead flag of
+ * every function of syntaxTree that main cannot
+ * call, directly or through other functions
+ */
+void markReachable(TreeNode * syntaxTree)
+{ FuncList work = { NULL, 0, 0 };
+  TreeVisitor v = { callVisit, NULL, NULL, &work };
+  TreeNode * t;
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+    if (isFunction(t) && (t->sym != NULL)) t->sym->dead = TRUE;
+  reach(&work,st_lookup("main"));
+  while ((work.n > 0) && ! Error)
+  { TreeNode * f = work.sym[--work.n]->decl;
+    TreeNode * sibling = f->sibling;
+    f->sibling = NULL;
+    walkTree(f,&v);
+    f->sibling = sibling;
+  }
+  if (Stats != NULL)
+    for (t = syntaxTree; t != NULL; t = t->sibling)
+      if (isFunction(t) && (t->sym != NULL) && t->sym->dead)
+        Stats->deadFuncs++;
+  free(work.sym);
+}
+
+/**************************************************/
+/**********   Inlining   **************************/
+/**************************************************/
+
+/* A function is inlined if its body, without local
+ * declarations, is one statement: "return e;" or,
+ * for a void function, an expression "e;". e may
+ * call only input and output, so no function is
+ * ever inlined into itself. This is judged on the
+ * trees before any call is inlined (markInlinable):
+ * a function whose calls were all inlined is not
+ * inlined in turn, so that the code of a function
+ * depends only on the trees of the functions it
+ * calls, not on their order, as the cache (incr.c)
+ * assumes. The parameters of the function are the
+ * only names in e that are not global, and a
+ * scalar one may not be assigned.
+ *
+ * The call is replaced by a copy of e with each
+ * parameter replaced by its argument: a scalar by a
+ * copy of the argument expression, an array
+ * parameter (int a[]) by the array passed. The
+ * arguments are then evaluated where the
+ * parameters are used, as often as that, so an
+ * argument must give the same value anywhere in e
+ * and have no effect: if e reads or writes no
+ * variables but the parameters, any argument
+ * without calls or assignments; else a constant, an
+ * array or a local scalar of the caller, which the
+ * callee cannot change
+ */
+
+/* INLINE_SIZE bounds the nodes of e, with each
+ * parameter counted as the nodes of its argument
+ */
+#define INLINE_SIZE 24
+
+/* isParam tells whether name s, used in the body of
+ * a function without locals, is a parameter; the
+ * slot of parameter i is -2-i, see analyze.c
+ */
+static int isParam(Symbol * s)
+{ return (s != NULL) && (s->level > 0);
+}
+
+/* Shape collects what inlineBody needs to know of
+ * e or of an argument
+ */
+typedef struct
+   { int nodes;
+     int calls; /* of input and output */
+     int unknown; /* calls of other functions, or names
+                     not resolved */
+     int assigns; /* to globals or array elements */
+     int paramAssigns; /* to scalar parameters */
+     int globals; /* global variables read */
+   } Shape;
+
+static int shapeVisit(TreeNode * t, int depth, void * arg)
+{ Shape * sh = (Shape *) arg;
+  if (++sh->nodes > INLINE_SIZE) return FALSE;
+  if (t->nodekind == StmtK)
+    switch (t->kind.stmt)
+    { case CallK:
+        if ((t->sym == NULL) || (t->sym->decl != NULL)) sh->unknown++;
+        sh->calls++;
+        break;
+      case AssignK:
+      case AssignKarr:
+        if (t->sym == NULL) sh->unknown++;
+        else if (isParam(t->sym) && (t->kind.stmt == AssignK))
+          sh->paramAssigns++;
+        sh->assigns++;
+        break;
+      default:
+        sh->unknown++;
+        break;
+    }
+  else
+    switch (t->kind.exp)
+    { case IdK:
+      case ArrexpK:
+        if (t->sym == NULL) sh->unknown++;
+        else if (t->sym->level == 0) sh->globals++;
+        break;
+      case OpK:
+      case ConstK:
+        break;
+      default:
+        sh->unknown++;
+        break;
+    }
+  return TRUE;
+}
+
+/* shapeOf describes the expression t alone */
+static void shapeOf(TreeNode * t, Shape * sh)
+{ TreeVisitor v = { shapeVisit, NULL, NULL, sh };
+  TreeNode * sibling = t->sibling;
+  memset(sh,0,sizeof(Shape));
+  t->sibling = NULL;
+  walkTree(t,&v);
+  t->sibling = sibling;
+}
+
+/* inlineBody returns e if function f can be
+ * inlined, else NULL; *pure is set if e reads
+ * and writes nothing but its parameters
+ */
+static TreeNode * inlineBody(TreeNode * f, int * pure)
+{ TreeNode * body = f->child[1];
+  TreeNode * e;
+  Shape sh;
+  if ((body == NULL) || (body->nodekind != StmtK) ||
+      (body->kind.stmt != CompK) || (body->child[0] != NULL))
+    return NULL;
+  e = body->child[1];
+  if ((e == NULL) || (e->sibling != NULL)) return NULL;
+  if ((e->nodekind == StmtK) && (e->kind.stmt == ReturnK))
+    e = e->child[0];
+  else if (f->type != Void)
+    return NULL;
+  if ((e == NULL) || (strcmp(f->attr.name,"main") == 0)) return NULL;
+  shapeOf(e,&sh);
+  if ((sh.nodes > INLINE_SIZE) || sh.unknown || sh.paramAssigns) return NULL;
+  *pure = (sh.calls == 0) && (sh.assigns == 0) && (sh.globals == 0);
+  return e;
+}
+
+/* Function mayInline tells whether resolved
+ * function declaration f may be inlined by
+ * optimize, judging by its first statement: the
+ * rest may be pruned
+ */
+int mayInline(TreeNode * f)
+{ TreeNode * body = f->child[1], * first = NULL, * rest = NULL;
+  int pure, result;
+  if (! Optimize) return FALSE;
+  if ((body != NULL) && (body->nodekind == StmtK) &&
+      (body->kind.stmt == CompK) && (body->child[1] != NULL))
+  { first = body->child[1];
+    rest = first->sibling;
+    first->sibling = NULL;
+  }
+  result = inlineBody(f,&pure) != NULL;
+  if (first != NULL) first->sibling = rest;
+  return result;
+}
+
+/* INLINE_PARAMS bounds the parameters of a
+ * function inlined
+ */
+#define INLINE_PARAMS 8
+
+/* Inline is the state of one inlining: the
+ * arguments of the call, by parameter, and the
+ * number of uses of each parameter in e
+ */
+typedef struct
+   { TreeNode * args[INLINE_PARAMS];
+     int uses[INLINE_PARAMS];
+     int nargs;
+   } Inline;
+
+/* copyNode returns a copy of node t alone */
+static TreeNode * copyNode(TreeNode * t)
+{ TreeNode * c = (TreeNode *) malloc(sizeof(TreeNode));
+  if (c == NULL)
+  { obPuts(listing,"Out of memory error in optimizer\n");
+    Error = TRUE;
+    return NULL;
+  }
+  *c = *t;
+  c->sibling = NULL;
+  return c;
+}
+
+/* substitute copies the list t, replacing the
+ * parameters of the callee by the arguments of in
+ * (in NULL: a plain copy). Bodies and arguments
+ * are at most INLINE_SIZE nodes, so the recursion
+ * stays shallow
+ */
+static TreeNode * substitute(TreeNode * t, Inline * in)
+{ TreeNode * head = NULL, ** tail = &head;
+  for (; (t != NULL) && ! Error; t = t->sibling)
+  { TreeNode * c;
+    int i, param = -1;
+    if ((in != NULL) && isParam(t->sym) &&
+        (((t->nodekind == ExpK) &&
+          ((t->kind.exp == IdK) || (t->kind.exp == ArrexpK))) ||
+         ((t->nodekind == StmtK) && (t->kind.stmt == AssignKarr))))
+      param = -2 - t->sym->loc;
+    if ((param >= 0) && (param < in->nargs) &&
+        (t->nodekind == ExpK) && (t->kind.exp == IdK))
+    { /* the argument alone, not the ones after it */
+      TreeNode * a = in->args[param], * next = a->sibling;
+      a->sibling = NULL;
+      c = substitute(a,NULL);
+      a->sibling = next;
+    }
+    else
+    { c = copyNode(t);
+      if (c == NULL) break;
+      if ((param >= 0) && (param < in->nargs))
+      { /* an element of an array parameter */
+        c->attr.name = in->args[param]->attr.name;
+        c->sym = in->args[param]->sym;
+      }
+      for (i = 0; i < MAXCHILDREN; i++)
+        c->child[i] = substitute(t->child[i],in);
+    }
+    *tail = c;
+    if (c != NULL) tail = &c->sibling;
+  }
+  return head;
+}
+
+/* stableArg tells whether argument a may be
+ * evaluated in place of its parameter anywhere in
+ * a body that is not pure
+ */
+static int stableArg(TreeNode * a)
+{ if (a->nodekind != ExpK) return FALSE;
+  if (a->kind.exp == ConstK) return TRUE;
+  if ((a->kind.exp != IdK) || (a->sym == NULL)) return FALSE;
+  return (a->sym->kind != VarSym) || (a->sym->level > 0);
+}
+
+/* useVisit counts the uses of each parameter */
+static int useVisit(TreeNode * t, int depth, void * arg)
+{ Inline * in = (Inline *) arg;
+  if (isParam(t->sym))
+  { int i = -2 - t->sym->loc;
+    if ((i >= 0) && (i < in->nargs)) in->uses[i]++;
+  }
+  return TRUE;
+}
+
+/* inlineCall replaces call t, in function caller,
+ * by the body of its function where allowed
+ */
+static void inlineCall(TreeNode * t, Symbol * caller)
+{ Symbol * callee = t->sym;
+  TreeVisitor v;
+  TreeNode * a, * e, * c;
+  Inline in;
+  Shape sh;
+  int pure, size, i;
+  if ((callee == NULL) || (callee->decl == NULL) || (callee == caller) ||
+      ! callee->inlinable)
+    return;
+  e = inlineBody(callee->decl,&pure);
+  if (e == NULL) return;
+  in.nargs = 0;
+  for (a = t->child[0]; a != NULL; a = a->sibling)
+  { if (in.nargs == INLINE_PARAMS) return;
+    in.uses[in.nargs] = 0;
+    in.args[in.nargs++] = a;
+  }
+  v.preProc = useVisit;
+  v.childProc = NULL;
+  v.postProc = NULL;
+  v.arg = &in;
+  a = e->sibling;
+  e->sibling = NULL;
+  walkTree(e,&v);
+  e->sibling = a;
+  shapeOf(e,&sh);
+  size = sh.nodes;
+  for (i = 0; i < in.nargs; i++)
+  { shapeOf(in.args[i],&sh);
+    if (pure)
+    { if (sh.unknown || sh.calls || sh.assigns) return;
+    }
+    else if (! stableArg(in.args[i])) return;
+    size += in.uses[i] * (sh.nodes - 1);
+  }
+  if (size > INLINE_SIZE) return;
+  c = substitute(e,&in);
+  if (c == NULL) return;
+  /* c takes the place of t in its list */
+  c->sibling = t->sibling;
+  *t = *c;
+  free(c);
+  if (Stats != NULL) Stats->inlined++;
+}
+
+/* inlineVisit is the postorder visitor of
+ * inlineFunction: the arguments of a call are
+ * inlined before the call itself
+ */
+static void inlineVisit(TreeNode * t, int depth, void * arg)
+{ if ((t->nodekind == StmtK) && (t->kind.stmt == CallK))
+    inlineCall(t,(Symbol *) arg);
+}
+
+/* Procedure markInlinable marks the functions that
+ * may be inlined, judging by their trees as they
+ * are before any inlining
+ */
+void markInlinable(TreeNode * syntaxTree)
+{ TreeNode * t;
+  int pure;
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+    if (isFunction(t) && (t->sym != NULL))
+      t->sym->inlinable = inlineBody(t,&pure) != NULL;
+}
+
+/* Procedure inlineFunction inlines the calls of
+ * small functions in function declaration f
+ */
+void inlineFunction(TreeNode * f)
+{ TreeVisitor v = { NULL, NULL, inlineVisit, NULL };
+  TreeNode * sibling = f->sibling;
+  if (f->sym == NULL) return;
+  v.arg = f->sym;
+  f->sibling = NULL;
+  walkTree(f,&v);
+  f->sibling = sibling;
+}
+
+/**************************************************/
+/**********   While loops   ***********************/
+/**************************************************/
+
+/* In each while loop, outermost first, the
+ * expressions whose value cannot change while the
+ * loop runs are computed once before it, into a
+ * new local (a "temp", named $t). Such an
+ * expression has an operator and only constants
+ * and scalar variables not assigned in the loop;
+ * globals only if the loop calls no declared
+ * function, since that may assign them. Array
+ * elements and divisions by anything but a nonzero
+ * constant stay in place, as the loop may not run
+ * and then must not fault.
+ *
+ * Then, in a loop whose body increments a local i
+ * by a constant c in one statement of its own list,
+ * the only assignment of i in the loop, the
+ * products i * k for a constant k become a temp t
+ * set to i * k before the loop and increased by
+ * c * k after the increment. A product and an add
+ * cost the same on TM, so this pays only where the
+ * same product is used REDUCE_USES times or more
+ */
+#define REDUCE_USES 2
+
+/* Loop describes the while loop being optimized */
+typedef struct
+   { TreeNode * loop;
+     Symbol ** sym; /* scalars assigned in the loop */
+     int * count; /* assignments of each */
+     int n, cap;
+     int calls; /* calls of declared functions */
+     Symbol * func; /* function holding the loop */
+     TreeNode ** pre; /* link where hoisted code goes */
+     TreeNode ** temps; /* assignments hoisted so far */
+     int ntemps, tcap;
+     TreeNode ** products; /* local * constant, see reduce */
+     int nproducts, pcap;
+   } Loop;
+
+/* grow makes room in array *p of *cap elements
+ * for element n; it returns FALSE if out of memory
+ */
+static int grow(void * p, int * cap, int n, size_t size)
+{ void ** a = (void **) p;
+  void * bigger;
+  int newCap;
+  if (n < *cap) return TRUE;
+  newCap = *cap ? 2 * *cap : 16;
+  bigger = realloc(*a,newCap * size);
+  if (bigger == NULL)
+  { obPuts(listing,"Out of memory error in optimizer\n");
+    Error = TRUE;
+    return FALSE;
+  }
+  *a = bigger;
+  *cap = newCap;
+  return TRUE;
+}
+
+/* assigned returns the assignments of s in the loop */
+static int assigned(Loop * lp, Symbol * s)
+{ int i;
+  for (i = 0; i < lp->n; i++)
+    if (lp->sym[i] == s) return lp->count[i];
+  return 0;
+}
+
+static int isKind(TreeNode * t, ExpKind kind)
+{ return (t != NULL) && (t->nodekind == ExpK) && (t->kind.exp == kind);
+}
+
+/* productOf returns the variable of t if it is a
+ * product of a local and a constant, and sets *k
+ * to the constant
+ */
+static Symbol * productOf(TreeNode * t, int * k)
+{ TreeNode * l, * r;
+  if (! isKind(t,OpK) || (t->attr.op != TIMES)) return NULL;
+  l = t->child[0];
+  r = t->child[1];
+  if (isKind(r,IdK) && isKind(l,ConstK))
+  { l = r;
+    r = t->child[0];
+  }
+  if (! isKind(l,IdK) || ! isKind(r,ConstK) || (l->sym == NULL) ||
+      (l->sym->kind != VarSym) || (l->sym->level == 0))
+    return NULL;
+  *k = r->attr.val;
+  return l->sym;
+}
+
+/* noteAssign counts an assignment of s */
+static void noteAssign(Loop * lp, Symbol * s)
+{ int i, cap;
+  for (i = 0; i < lp->n; i++)
+    if (lp->sym[i] == s)
+    { lp->count[i]++;
+      return;
+    }
+  cap = lp->cap;
+  if (! grow(&lp->sym,&cap,lp->n,sizeof(Symbol *)) ||
+      ! grow(&lp->count,&lp->cap,lp->n,sizeof(int)))
+    return;
+  lp->sym[lp->n] = s;
+  lp->count[lp->n++] = 1;
+}
+
+/* loopVisit collects what the loop assigns and
+ * calls, and its products. A variable declared in
+ * the loop counts as assigned: blocks share frame
+ * slots, so it may start with another value each
+ * time
+ */
+static int loopVisit(TreeNode * t, int depth, void * arg)
+{ Loop * lp = (Loop *) arg;
+  int k;
+  if (productOf(t,&k) != NULL)
+  { if (grow(&lp->products,&lp->pcap,lp->nproducts,sizeof(TreeNode *)))
+      lp->products[lp->nproducts++] = t;
+    return FALSE;
+  }
+  if (t->sym == NULL) return TRUE;
+  if (t->nodekind == ExpK)
+  { if (t->kind.exp == VarK) noteAssign(lp,t->sym);
+  }
+  else if (t->kind.stmt == CallK)
+  { if (t->sym->decl != NULL) lp->calls++;
+  }
+  else if (t->kind.stmt == AssignK)
+    noteAssign(lp,t->sym);
+  return ! Error;
+}
+
+/* sameTree tells whether expressions a and b,
+ * without calls, compute the same
+ */
+static int sameTree(TreeNode * a, TreeNode * b)
+{ if ((a == NULL) || (b == NULL)) return a == b;
+  if ((a->nodekind != ExpK) || (b->nodekind != ExpK) ||
+      (a->kind.exp != b->kind.exp))
+    return FALSE;
+  switch (a->kind.exp)
+  { case ConstK:
+      return a->attr.val == b->attr.val;
+    case IdK:
+      return a->sym == b->sym;
+    case OpK:
+      return (a->attr.op == b->attr.op) &&
+             sameTree(a->child[0],b->child[0]) &&
+             sameTree(a->child[1],b->child[1]);
+    default:
+      return FALSE;
+  }
+}
+
+/* newTemp declares a new local of the function
+ * holding the loop, in a frame slot of its own
+ */
+static Symbol * newTemp(Loop * lp)
+{ Symbol * s;
+  st_enterScope();
+  s = st_insert("$t",lp->loop->lineno,VarSym,-lp->func->frame);
+  st_exitScope();
+  if (s != NULL) lp->func->frame++;
+  return s;
+}
+
+/* tempNode makes node t (keeping its sibling) a
+ * use of temp s
+ */
+static void tempNode(TreeNode * t, Symbol * s)
+{ int i;
+  for (i = 0; i < MAXCHILDREN; i++) t->child[i] = NULL;
+  t->nodekind = ExpK;
+  t->kind.exp = IdK;
+  t->attr.name = s->name;
+  t->sym = s;
+}
+
+/* newAssign returns "s = e;" */
+static TreeNode * newAssign(Symbol * s, TreeNode * e)
+{ TreeNode * a = newStmtNode(AssignK);
+  if (a == NULL)
+  { Error = TRUE;
+    return NULL;
+  }
+  a->lineno = e->lineno;
+  a->attr.name = s->name;
+  a->sym = s;
+  a->child[0] = e;
+  return a;
+}
+
+/* hoist moves the invariant expression at *link
+ * before the loop, leaving a use of its temp
+ */
+static void hoist(TreeNode ** link, Loop * lp)
+{ TreeNode * e = *link, * use, * a;
+  Symbol * s = NULL;
+  int i;
+  if (! isKind(e,OpK) || Error) return;
+  for (i = 0; i < lp->ntemps; i++)
+    if (sameTree(lp->temps[i]->child[0],e)) s = lp->temps[i]->sym;
+  if (s == NULL)
+  { use = copyNode(e);
+    if ((use == NULL) || ((s = newTemp(lp)) == NULL) ||
+        ((a = newAssign(s,e)) == NULL) ||
+        ! grow(&lp->temps,&lp->tcap,lp->ntemps,sizeof(TreeNode *)))
+      return;
+    lp->temps[lp->ntemps++] = a;
+    a->sibling = *lp->pre;
+    *lp->pre = a;
+    lp->pre = &a->sibling;
+    /* e moves whole, the use takes its place */
+    use->sibling = e->sibling;
+    e->sibling = NULL;
+    *link = use;
+  }
+  else use = e;
+  tempNode(use,s);
+  if (Stats != NULL) Stats->hoisted++;
+}
+
+/* hoistNode hoists the invariant expressions
+ * under *link and tells whether *link is one
+ */
+static int hoistNode(TreeNode ** link, Loop * lp)
+{ TreeNode * t = *link, ** c;
+  Symbol * s = t->sym;
+  int i;
+  if (isKind(t,ConstK)) return TRUE;
+  if (isKind(t,IdK))
+    return (s != NULL) && (s->kind == VarSym) && ! assigned(lp,s) &&
+           ((s->level > 0) || (lp->calls == 0));
+  if (isKind(t,OpK))
+  { int left = hoistNode(&t->child[0],lp);
+    int right = hoistNode(&t->child[1],lp);
+    if (left && right &&
+        ((t->attr.op != OVER) ||
+         (isKind(t->child[1],ConstK) && (t->child[1]->attr.val != 0))))
+      return TRUE;
+    if (left) hoist(&t->child[0],lp);
+    if (right) hoist(&t->child[1],lp);
+    return FALSE;
+  }
+  for (i = 0; i < MAXCHILDREN; i++)
+    for (c = &t->child[i]; *c != NULL; c = &(*c)->sibling)
+      if (hoistNode(c,lp)) hoist(c,lp);
+  return FALSE;
+}
+
+/* stepOf returns TRUE and sets *step if s is an
+ * increment of a local by a constant
+ */
+static int stepOf(TreeNode * s, int * step)
+{ TreeNode * e = s->child[0], * l, * r;
+  if ((s->nodekind != StmtK) || (s->kind.stmt != AssignK) ||
+      (s->sym == NULL) || (s->sym->kind != VarSym) ||
+      (s->sym->level == 0) || ! isKind(e,OpK))
+    return FALSE;
+  l = e->child[0];
+  r = e->child[1];
+  if ((e->attr.op == PLUS) && isKind(l,ConstK) && isKind(r,IdK) &&
+      (r->sym == s->sym))
+  { *step = l->attr.val;
+    return TRUE;
+  }
+  if (((e->attr.op == PLUS) || (e->attr.op == MINUS)) &&
+      isKind(l,IdK) && (l->sym == s->sym) && isKind(r,ConstK))
+  { *step = e->attr.op == PLUS ? r->attr.val : -r->attr.val;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/* reduce strength-reduces the products i * k of
+ * the induction variable i incremented by
+ * statement inc, for the k of its first product
+ */
+static void reduce(TreeNode * inc, int step, Loop * lp)
+{ TreeNode * init, * sum, * use, * c, * a, * update;
+  Symbol * s;
+  int i, k = 0, ki, first = -1, nuses = 0;
+  for (i = 0; i < lp->nproducts; i++)
+    if ((productOf(lp->products[i],&ki) == inc->sym) &&
+        ((first < 0) || (ki == k)))
+    { if (first < 0)
+      { first = i;
+        k = ki;
+      }
+      nuses++;
+    }
+  if ((nuses < REDUCE_USES) || Error) return;
+  /* before the loop t = i * k, after the
+     increment t = t + c * k */
+  init = copyNode(lp->products[first]);
+  sum = newExpNode(OpK);
+  use = newExpNode(IdK);
+  c = newExpNode(ConstK);
+  if ((init != NULL) && (sum != NULL) && (use != NULL) && (c != NULL) &&
+      ((s = newTemp(lp)) != NULL))
+  { sum->lineno = use->lineno = c->lineno = inc->lineno;
+    sum->attr.op = PLUS;
+    sum->child[0] = use;
+    sum->child[1] = c;
+    tempNode(use,s);
+    c->attr.val = step * k;
+    a = newAssign(s,init);
+    update = newAssign(s,sum);
+    if ((a != NULL) && (update != NULL))
+    { a->sibling = *lp->pre;
+      *lp->pre = a;
+      lp->pre = &a->sibling;
+      update->sibling = inc->sibling;
+      inc->sibling = update;
+      for (i = first; i < lp->nproducts; i++)
+        if ((productOf(lp->products[i],&ki) == inc->sym) && (ki == k))
+          tempNode(lp->products[i],s);
+      if (Stats != NULL) Stats->reduced += nuses;
+    }
+  }
+}
+
+/* optimizeLoop optimizes the while loop at *link;
+ * it returns the link of the loop, after the code
+ * hoisted
+ */
+static TreeNode ** optimizeLoop(TreeNode ** link, Symbol * func)
+{ Loop lp;
+  TreeVisitor v = { loopVisit, NULL, NULL, &lp };
+  TreeNode * loop = *link, * sibling = loop->sibling, * s;
+  int step;
+  memset(&lp,0,sizeof(lp));
+  lp.loop = loop;
+  lp.func = func;
+  lp.pre = link;
+  loop->sibling = NULL;
+  walkTree(loop,&v);
+  loop->sibling = sibling;
+  /* the loop itself is never invariant */
+  if (! Error) hoistNode(&loop,&lp);
+  /* the statements of the body, run in turn */
+  s = loop->child[1];
+  if ((s != NULL) && (s->nodekind == StmtK) && (s->kind.stmt == CompK))
+    s = s->child[1];
+  for (; (s != NULL) && ! Error; s = s->sibling)
+    if (stepOf(s,&step) && (assigned(&lp,s->sym) == 1))
+      reduce(s,step,&lp);
+  free(lp.sym);
+  free(lp.count);
+  free(lp.temps);
+  free(lp.products);
+  return lp.pre;
+}
+
+/* loopList optimizes the loops in statement list
+ * *link and in the statements under it
+ */
+static void loopList(TreeNode ** link, Symbol * func)
+{ for (; (*link != NULL) && ! Error; link = &(*link)->sibling)
+  { TreeNode * t = *link;
+    if (t->nodekind != StmtK) continue;
+    switch (t->kind.stmt)
+    { case RepeatK:
+        link = optimizeLoop(link,func);
+        loopList(&t->child[1],func);
+        break;
+      case IfK:
+        loopList(&t->child[1],func);
+        loopList(&t->child[2],func);
+        break;
+      case CompK:
+        loopList(&t->child[1],func);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+/* Procedure optimizeLoops hoists loop invariants
+ * and reduces the strength of products of
+ * induction variables in the while loops of
+ * resolved function declaration f
+ */
+void optimizeLoops(TreeNode * f)
+{ if ((f->sym != NULL) && (f->child[1] != NULL))
+    loopList(&f->child[1],f->sym);
+}
+
+/* Procedure optimize runs the optimizations on an
+ * analyzed program, unless Optimize is FALSE
+ */
+void optimize(TreeNode * syntaxTree)
+{ TreeNode * t;
+  if (! Optimize) return;
+  phaseStart(OptPhase);
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+    if (isFunction(t)) pruneFunction(t);
+  markInlinable(syntaxTree);
+  for (t = syntaxTree; t != NULL; t = t->sibling)
+    if (isFunction(t))
+    { inlineFunction(t);
+      optimizeLoops(t);
+    }
+  markReachable(syntaxTree);
+  phaseEnd(OptPhase);
+}
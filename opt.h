@@ -0,0 +1,61 @@
+/****************************************************/
+/* File: opt.h                                      */
+/* Syntax tree optimizations of the C- compiler,    */
+/* run between analysis and code generation         */
+/****************************************************/
+
+#ifndef _OPT_H_
+#define _OPT_H_
+
+/* Procedure pruneFunction drops the statements of
+ * function declaration f that follow a statement
+ * which always returns
+ */
+void pruneFunction(TreeNode * f);
+
+/* Procedure inlineFunction replaces the calls of
+ * small functions in function declaration f by
+ * their bodies, see opt.c; the functions of the
+ * program must be resolved and marked by
+ * markInlinable
+ */
+void inlineFunction(TreeNode * f);
+
+/* Procedure markInlinable sets the inlinable flag
+ * of every function of syntaxTree that
+ * inlineFunction may inline. It must be called
+ * after pruning and before any inlining
+ */
+void markInlinable(TreeNode * syntaxTree);
+
+/* Procedure optimizeLoops moves the invariant
+ * expressions of the while loops of resolved
+ * function declaration f before the loops, into
+ * new locals, and reduces the strength of the
+ * products of their induction variables
+ */
+void optimizeLoops(TreeNode * f);
+
+/* Function mayInline tells whether resolved
+ * function declaration f may be inlined by
+ * optimize, before its body is pruned. The
+ * cache (incr.c) uses it to tell which callees
+ * the code of a function depends on
+ */
+int mayInline(TreeNode * f);
+
+/* Procedure markReachable sets the dead flag of
+ * every function of syntaxTree that main cannot
+ * call, directly or through other functions; code
+ * generation leaves those out. The globals must be
+ * declared (see declareGlobals), and the functions
+ * pruned, so that calls after a return do not count
+ */
+void markReachable(TreeNode * syntaxTree);
+
+/* Procedure optimize runs the optimizations on an
+ * analyzed program, unless Optimize is FALSE
+ */
+void optimize(TreeNode * syntaxTree);
+
+#endif
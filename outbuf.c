@@ -0,0 +1,177 @@
+/****************************************************/
+/* File: outbuf.c                                   */
+/* Buffered output implementation                   */
+/****************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "outbuf.h"
+
+/* OB_INITSIZE is the initial size of a buffer */
+#define OB_INITSIZE 65536
+
+/* INTLEN is enough room for any int in decimal */
+#define INTLEN 12
+
+/* Function newOutBuf creates a buffer writing to fp;
+ * with fp NULL the text stays in buf until freed
+ */
+OutBuf * newOutBuf(FILE * fp)
+{ OutBuf * ob = (OutBuf *) malloc(sizeof(OutBuf));
+  if (ob==NULL) return NULL;
+  ob->buf = (char *) malloc(OB_INITSIZE);
+  if (ob->buf==NULL)
+  { free(ob);
+    return NULL;
+  }
+  ob->len = 0;
+  ob->cap = OB_INITSIZE;
+  ob->fp = fp;
+  return ob;
+}
+
+/* Procedure freeOutBuf flushes and releases a buffer
+ * (the file is not closed)
+ */
+void freeOutBuf(OutBuf * ob)
+{ if (ob==NULL) return;
+  obFlush(ob);
+  free(ob->buf);
+  free(ob);
+}
+
+/* Procedure obFlush writes the buffered text to the
+ * attached file; it is called at the end of each phase
+ */
+void obFlush(OutBuf * ob)
+{ if (ob->fp==NULL) return;
+  if (ob->len > 0) fwrite(ob->buf,1,ob->len,ob->fp);
+  ob->len = 0;
+  fflush(ob->fp);
+}
+
+/* reserve makes room for n more bytes, writing the
+ * text out early once a file buffer is very large
+ */
+static void reserve(OutBuf * ob, size_t n)
+{ size_t cap;
+  char * p;
+  if (ob->len + n <= ob->cap) return;
+  if ((ob->fp != NULL) && (ob->len + n > OB_HIGHWATER))
+  { fwrite(ob->buf,1,ob->len,ob->fp);
+    ob->len = 0;
+    if (n <= ob->cap) return;
+  }
+  cap = ob->cap;
+  while (cap < ob->len + n) cap *= 2;
+  p = (char *) realloc(ob->buf,cap);
+  if (p==NULL)
+  { /* keep going unbuffered rather than lose output */
+    if (ob->fp != NULL)
+    { fwrite(ob->buf,1,ob->len,ob->fp);
+      ob->len = 0;
+    }
+    return;
+  }
+  ob->buf = p;
+  ob->cap = cap;
+}
+
+/* Procedure obWrite appends n bytes of s */
+void obWrite(OutBuf * ob, const char * s, size_t n)
+{ reserve(ob,n);
+  if (ob->len + n > ob->cap)
+  { if (ob->fp != NULL) fwrite(s,1,n,ob->fp);
+    return;
+  }
+  memcpy(ob->buf+ob->len,s,n);
+  ob->len += n;
+}
+
+/* Procedure obPuts appends string s */
+void obPuts(OutBuf * ob, const char * s)
+{ obWrite(ob,s,strlen(s)); }
+
+/* Procedure obPutc appends character c */
+void obPutc(OutBuf * ob, int c)
+{ char ch = (char) c;
+  if (ob->len < ob->cap) ob->buf[ob->len++] = ch;
+  else obWrite(ob,&ch,1);
+}
+
+/* Procedure obSpaces appends n blanks */
+void obSpaces(OutBuf * ob, int n)
+{ if (n <= 0) return;
+  reserve(ob,n);
+  if (ob->len + n > ob->cap)
+  { if (ob->fp != NULL) fprintf(ob->fp,"%*s",n,"");
+    return;
+  }
+  memset(ob->buf+ob->len,' ',n);
+  ob->len += n;
+}
+
+/* formatInt writes v in decimal ending just before
+ * end and returns the start of the digits
+ */
+static char * formatInt(char * end, int v)
+{ unsigned int u = (v < 0) ? 0u - (unsigned int) v : (unsigned int) v;
+  do
+  { *--end = (char) ('0' + u % 10);
+    u /= 10;
+  } while (u != 0);
+  if (v < 0) *--end = '-';
+  return end;
+}
+
+/* Procedure obPutInt appends v in decimal */
+void obPutInt(OutBuf * ob, int v)
+{ char digits[INTLEN];
+  char * p = formatInt(digits+INTLEN,v);
+  obWrite(ob,p,digits+INTLEN-p);
+}
+
+/* Procedure obPutIntW appends v padded to width
+ * like printf's %<width>d; a negative width pads
+ * on the right like %-<width>d
+ */
+void obPutIntW(OutBuf * ob, int v, int width)
+{ char digits[INTLEN];
+  char * p = formatInt(digits+INTLEN,v);
+  int n = digits+INTLEN-p;
+  if (width > n) obSpaces(ob,width-n);
+  obWrite(ob,p,n);
+  if (-width > n) obSpaces(ob,-width-n);
+}
+
+/* Procedure obPutsW appends s padded like %<width>s */
+void obPutsW(OutBuf * ob, const char * s, int width)
+{ int n = strlen(s);
+  if (width > n) obSpaces(ob,width-n);
+  obWrite(ob,s,n);
+  if (-width > n) obSpaces(ob,-width-n);
+}
+
+/* Procedure obPrintf appends printf-formatted text;
+ * it is the slow path for uncommon formats
+ */
+void obPrintf(OutBuf * ob, const char * fmt, ...)
+{ va_list ap;
+  int n;
+  va_start(ap,fmt);
+  n = vsnprintf(ob->buf+ob->len,ob->cap-ob->len,fmt,ap);
+  va_end(ap);
+  if (n < 0) return;
+  if ((size_t) n >= ob->cap - ob->len)
+  { reserve(ob,n+1);
+    va_start(ap,fmt);
+    if ((size_t) n < ob->cap - ob->len)
+      vsnprintf(ob->buf+ob->len,ob->cap-ob->len,fmt,ap);
+    else if (ob->fp != NULL)
+      vfprintf(ob->fp,fmt,ap);
+    va_end(ap);
+    if ((size_t) n >= ob->cap - ob->len) return;
+  }
+  ob->len += n;
+}
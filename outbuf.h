@@ -0,0 +1,69 @@
+/****************************************************/
+/* File: outbuf.h                                   */
+/* Buffered output for listings, TM code and the    */
+/* TM trace: text is collected in a large growable  */
+/* buffer and written out once per phase            */
+/****************************************************/
+
+#ifndef _OUTBUF_H_
+#define _OUTBUF_H_
+
+#include <stdio.h>
+
+/* OB_HIGHWATER is the size at which a buffer with
+ * a file attached is written out early
+ */
+#define OB_HIGHWATER (4 << 20)
+
+typedef struct
+   { char * buf; /* text not yet written */
+     size_t len; /* bytes used in buf */
+     size_t cap; /* bytes allocated for buf */
+     FILE * fp; /* destination, or NULL to keep text in memory */
+   } OutBuf;
+
+/* Function newOutBuf creates a buffer writing to fp;
+ * with fp NULL the text stays in buf until freed
+ */
+OutBuf * newOutBuf(FILE * fp);
+
+/* Procedure freeOutBuf flushes and releases a buffer
+ * (the file is not closed)
+ */
+void freeOutBuf(OutBuf * ob);
+
+/* Procedure obFlush writes the buffered text to the
+ * attached file; it is called at the end of each phase
+ */
+void obFlush(OutBuf * ob);
+
+/* Procedure obWrite appends n bytes of s */
+void obWrite(OutBuf * ob, const char * s, size_t n);
+
+/* Procedure obPuts appends string s */
+void obPuts(OutBuf * ob, const char * s);
+
+/* Procedure obPutc appends character c */
+void obPutc(OutBuf * ob, int c);
+
+/* Procedure obSpaces appends n blanks */
+void obSpaces(OutBuf * ob, int n);
+
+/* Procedure obPutInt appends v in decimal */
+void obPutInt(OutBuf * ob, int v);
+
+/* Procedure obPutIntW appends v padded to width
+ * like printf's %<width>d; a negative width pads
+ * on the right like %-<width>d
+ */
+void obPutIntW(OutBuf * ob, int v, int width);
+
+/* Procedure obPutsW appends s padded like %<width>s */
+void obPutsW(OutBuf * ob, const char * s, int width);
+
+/* Procedure obPrintf appends printf-formatted text;
+ * it is the slow path for uncommon formats
+ */
+void obPrintf(OutBuf * ob, const char * fmt, ...);
+
+#endif
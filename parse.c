@@ -5,109 +5,216 @@
 /* Kenneth C. Louden                                */
 /****************************************************/
 
+#include <setjmp.h>
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
 #include "parse.h"
+#include "stats.h"
 
-static TokenType token; /* holds current token */
+/* ParseState holds everything one parse needs; it is
+ * passed through the recursive-descent functions so
+ * that several parses may run in the same process
+ */
+typedef struct
+   { Scanner * scan; /* scanner for the source file */
+     OutBuf * listing; /* listing output for errors */
+     TokenType token; /* holds current token */
+     int errors; /* syntax errors reported so far */
+     int maxErrors; /* stop after this many (0: no limit) */
+     int quiet; /* recovering: no token matched since */
+     jmp_buf fail; /* syntaxError unwinds to the innermost
+                      recoverable production */
+     jmp_buf stop; /* ... or to parseSource at maxErrors */
+   } ParseState;
+
+#ifdef __GNUC__
+#define NORETURN __attribute__ ((noreturn))
+#else
+#define NORETURN
+#endif
+
+static void syntaxError(ParseState *ps, char *message) NORETURN;
+
+/* ParseProc is a production that recoverable can run */
+typedef TreeNode *(*ParseProc)(ParseState *ps);
 
 /* function prototypes for recursive calls */
-static TreeNode *stmt_sequence(void);
-static TreeNode *statement(void);
-static TreeNode *if_stmt(void);
-static TreeNode *repeat_stmt(void);
-static TreeNode *assign_stmt(void);
-static TreeNode *read_stmt(void);
-static TreeNode *write_stmt(void);
-static TreeNode *exp(void);
-static TreeNode *add_exp(TreeNode *g);
-static TreeNode *term(TreeNode *g);
-static TreeNode *factor(TreeNode *g);
-static TreeNode *param(void);
-static ExpType get_type(void);
-static TreeNode *compound(void);
-static TreeNode *local_declare(void);
-static TreeNode *stmt_declare(void);
-static TreeNode *call(void);
-static TreeNode *args(void);
-static TreeNode *simple_exp(void);
-static TreeNode *ret_stmt(void);
-static TreeNode *exp_list(void);
-static TreeNode *stmt_list(void);
-static TreeNode *var_declare(void);
-static TreeNode *tempa(void);
-static TreeNode *add_oper(void);
-static TreeNode *add_op(void);
-static TreeNode *mul_op(void);
-static TreeNode *sim_op(void);
-static TreeNode *callparam(void);
-TreeNode *arr_op(void);
-int flag = 0;
-int add_mul_flag = 0;
-
-static void syntaxError(char *message)
+static TreeNode *stmt_sequence(ParseState *ps);
+static TreeNode *statement(ParseState *ps);
+static TreeNode *if_stmt(ParseState *ps);
+static TreeNode *repeat_stmt(ParseState *ps);
+static TreeNode *param(ParseState *ps);
+static ExpType get_type(ParseState *ps);
+static TreeNode *compound(ParseState *ps);
+static TreeNode *local_declare(ParseState *ps);
+static TreeNode *stmt_declare(ParseState *ps);
+static TreeNode *ret_stmt(ParseState *ps);
+static TreeNode *stmt_list(ParseState *ps);
+static TreeNode *var_declare(ParseState *ps);
+static TreeNode *expression(ParseState *ps);
+static TreeNode *binary(ParseState *ps, int minPrec);
+static TreeNode *factor(ParseState *ps);
+static TreeNode *args(ParseState *ps);
+
+/* stmtNode and expNode stamp new nodes with the
+ * line number of this parse's scanner rather than
+ * the global lineno
+ */
+static TreeNode *stmtNode(ParseState *ps, StmtKind kind)
+{
+  TreeNode *t = newStmtNode(kind);
+  if (t != NULL)
+    t->lineno = ps->scan->lineno;
+  return t;
+}
+
+static TreeNode *expNode(ParseState *ps, ExpKind kind)
+{
+  TreeNode *t = newExpNode(kind);
+  if (t != NULL)
+    t->lineno = ps->scan->lineno;
+  return t;
+}
+
+/* syntaxError reports an error, with the current
+ * token, and abandons the production being parsed:
+ * it does not return. Errors found while still
+ * recovering from the previous one are not reported
+ */
+static void syntaxError(ParseState *ps, char *message)
 { // fprintf(listing,"\n>>> ");
-  fprintf(listing, "Syntax error at line %d: %s", lineno, message);
-  fprintf(listing, "Current token: \t");
-  printToken(token, tokenString);
-  fprintf(listing, "\nSyntax tree:\n");
-  exit(-1);
-  Error = TRUE;
+  if (!ps->quiet)
+  {
+    obPrintf(ps->listing, "Syntax error at line %d: %s", ps->scan->lineno, message);
+    obPuts(ps->listing, "Current token: \t");
+    printToken(ps->listing, ps->token, ps->scan->tokenString);
+    ps->errors++;
+  }
+  if ((ps->maxErrors > 0) && (ps->errors >= ps->maxErrors))
+    longjmp(ps->stop, 1);
+  longjmp(ps->fail, 1);
 }
 
-static void match(TokenType expected)
+/* advance moves to the next token, skipping
+ * white space and newlines
+ */
+static void advance(ParseState *ps)
 {
-  if (token == expected)
+  ps->token = getToken(ps->scan);
+  while (ps->token == NLSP)
   {
-    token = getToken();
-    while (token == NLSP)
+    ps->token = getToken(ps->scan);
+  }
+}
+
+/* synchronize skips tokens after a syntax error up
+ * to a point where parsing can resume: past a SEMI
+ * or a whole {...} block, or before a declaration
+ * (INT, VOID) or a closing RBRAC. At the top level a
+ * stray RBRAC is skipped as well
+ */
+static void synchronize(ParseState *ps, int topLevel)
+{
+  int depth = 0; /* braces opened while skipping */
+  ps->quiet = TRUE;
+  for (;;)
+  {
+    switch (ps->token)
     {
-      token = getToken();
+    case ENDFILE:
+      return;
+    case SEMI:
+      if (depth == 0)
+      {
+        advance(ps);
+        return;
+      }
+      break;
+    case INT:
+    case VOID:
+      if (depth == 0)
+        return;
+      break;
+    case LBRAC:
+      depth++;
+      break;
+    case RBRAC:
+      if (depth == 0)
+      {
+        if (topLevel)
+          advance(ps);
+        return;
+      }
+      if (--depth == 0)
+      {
+        advance(ps);
+        return;
+      }
+      break;
+    default:
+      break;
     }
+    advance(ps);
   }
+}
+
+/* recoverable runs proc; if it hits a syntax error
+ * the input is resynchronized and NULL is returned,
+ * so that the caller can go on with the next item
+ */
+static TreeNode *recoverable(ParseState *ps, ParseProc proc, int topLevel)
+{
+  jmp_buf outer;
+  TreeNode *t = NULL;
+  memcpy(outer, ps->fail, sizeof(jmp_buf));
+  if (setjmp(ps->fail) == 0)
+    t = proc(ps);
   else
-  {
-    syntaxError("!!unexpected token -> ");
-    printToken(token, tokenString);
+    synchronize(ps, topLevel);
+  memcpy(ps->fail, outer, sizeof(jmp_buf));
+  return t;
+}
 
-    fprintf(listing, "      ");
+static void match(ParseState *ps, TokenType expected)
+{
+  if (ps->token == expected)
+  {
+    advance(ps);
+    ps->quiet = FALSE;
   }
+  else
+    syntaxError(ps, "!!unexpected token -> ");
 }
 
 // type 반환
-ExpType get_type(void)
+ExpType get_type(ParseState *ps)
 {
 
-  if (token == INT)
+  if (ps->token == INT)
   {
-    match(INT);
+    match(ps, INT);
     return Integer;
   }
-  else if (token == VOID)
+  else if (ps->token == VOID)
   {
-    match(VOID);
+    match(ps, VOID);
     return Void;
   }
   else
-  {
-    syntaxError("syntax error\n");
-    fprintf(listing, "get -Current token: \t");
-    printToken(TOKENERR, tokenString);
-    token = getToken();
-  }
+    syntaxError(ps, "syntax error\n");
 }
-TreeNode *stmt_sequence(void)
+TreeNode *stmt_sequence(ParseState *ps)
 {
-  TreeNode *t = statement();
+  TreeNode *t = recoverable(ps, statement, TRUE);
 
   TreeNode *p = t;
-  while ((token != ENDFILE) && (token != END) &&
-         (token != ELSE) && (token != UNTIL))
+  while ((ps->token != ENDFILE) && (ps->token != END) &&
+         (ps->token != ELSE) && (ps->token != UNTIL))
   {
     TreeNode *q;
     // match(SEMI);
-    q = statement();
+    q = recoverable(ps, statement, TRUE);
     // if(ERROR) return;
     if (q != NULL)
     {
@@ -123,599 +230,326 @@ TreeNode *stmt_sequence(void)
   return t;
 }
 
-TreeNode *statement(void)
+TreeNode *statement(ParseState *ps)
 {
   TreeNode *t = NULL;
-  ExpType type = get_type();
-  char *name = copyString(tokenString);
-  match(ID);
+  ExpType type = get_type(ps);
+  char *name = copyString(ps->scan->tokenString);
+  int line = ps->scan->lineno; /* of the name */
+  match(ps, ID);
   // if(ERROR) return;
   /* 프로그램 젤 앞의 d선언문 scan완료*/
 
-  if (token == SEMI)
+  if (ps->token == SEMI)
   {
 
     /* 변수 선언*/
-    match(SEMI);
-    t = newExpNode(VarK);
+    match(ps, SEMI);
+    t = expNode(ps, VarK);
+    t->lineno = line;
     t->attr.name = name;
     t->type = type;
     //
   }
-  else if (token == LPAREN)
+  else if (ps->token == LPAREN)
   {
 
     /*함수 선언*/
-    t = newExpNode(FuncK);
+    t = expNode(ps, FuncK);
     t->attr.name = name;
     t->type = type;
-    match(LPAREN);
-    t->child[0] = param();
-    match(RPAREN);
-    t->child[1] = compound();
+    match(ps, LPAREN);
+    t->child[0] = param(ps);
+    match(ps, RPAREN);
+    t->child[1] = compound(ps);
   }
-  else if (token == LSQBRAC)
+  else if (ps->token == LSQBRAC)
   {
 
     /*배열 선언*/
-    t = newExpNode(ArrK);
+    t = expNode(ps, ArrK);
     t->attr.name = name;
     t->type = type;
-    match(LSQBRAC);
-    t->arr_size = atoi(tokenString);
-    match(NUM);
-    match(RSQBRAC);
-    match(SEMI);
+    match(ps, LSQBRAC);
+    t->arr_size = atoi(ps->scan->tokenString);
+    match(ps, NUM);
+    match(ps, RSQBRAC);
+    match(ps, SEMI);
   }
   else
-  {
-    syntaxError("syntax error\n");
-    fprintf(listing, "stmt - Current token: \t");
-    printToken(TOKENERR, tokenString);
-    token = getToken();
-  }
+    syntaxError(ps, "syntax error\n");
   return t;
 }
 
-TreeNode *param(void)
+TreeNode *param(ParseState *ps)
 {
-  TreeNode *t = newExpNode(ParamK);
+  TreeNode *t = expNode(ps, ParamK);
   TreeNode *q;
-  switch (token)
+  switch (ps->token)
   {
   case INT:
-    match(INT);
+    match(ps, INT);
     t->type = Integer;
-    t->attr.name = copyString(tokenString);
-    match(ID);
-    if (token == LSQBRAC)
+    t->attr.name = copyString(ps->scan->tokenString);
+    match(ps, ID);
+    if (ps->token == LSQBRAC)
     {
-      match(LSQBRAC);
-      match(RSQBRAC);
+      match(ps, LSQBRAC);
+      match(ps, RSQBRAC);
+      t->type = IntArray;
     }
-    if (token == COMMA)
+    if (ps->token == COMMA)
     {
-      match(COMMA);
-      q = param();
+      match(ps, COMMA);
+      q = param(ps);
       t->sibling = q;
     }
     break;
   case VOID:
-    match(VOID);
+    match(ps, VOID);
     t->type = Void;
-    t->attr.name = copyString(tokenString);
+    t->attr.name = copyString(ps->scan->tokenString);
 
     break;
   }
 
   return t;
 }
-TreeNode *callparam(void)
-{
-  TreeNode *t = NULL;
-  TreeNode *q;
-  // match(token);
-  switch (token)
-  {
-  case ID:
-    t = newExpNode(IdK);
-    t->attr.name = copyString(tokenString);
-    match(ID);
-    if (token == COMMA)
-    {
-      match(COMMA);
-      q = callparam();
-      t->sibling = q;
-    }
-    break;
-  case NUM:
-    t = newExpNode(ConstK);
-    t->attr.val = atoi(tokenString);
-    match(NUM);
-    if (token == COMMA)
-    {
-      match(COMMA);
-      q = callparam();
-      t->sibling = q;
-    }
-    break;
-  default:
-    syntaxError("syntax error\n");
-    fprintf(listing, "Current token: \t");
-    printToken(TOKENERR, tokenString);
-  }
-  return t;
-}
-TreeNode *compound(void)
+TreeNode *compound(ParseState *ps)
 {
-  TreeNode *t = newStmtNode(CompK);
-  match(LBRAC);
-  t->child[0] = local_declare();
-  t->child[1] = stmt_list();
+  TreeNode *t = stmtNode(ps, CompK);
+  match(ps, LBRAC);
+  t->child[0] = local_declare(ps);
+  t->child[1] = stmt_list(ps);
   // match(SEMI);
-  match(RBRAC);
+  match(ps, RBRAC);
   return t;
 }
-TreeNode *tempa(void)
+/****************************************/
+/* expressions: precedence climbing     */
+/****************************************/
+/* binaryPrec is the binding power of each binary
+ * operator; any other token has 0 and ends the
+ * expression. All operators are left associative,
+ * except the relational ones, which do not chain
+ */
+#define RELPREC 1
+#define MAXPREC 3
+
+static const unsigned char binaryPrec[NLSP + 1] =
+    {[LT] = RELPREC, [RT] = RELPREC, [LEQ] = RELPREC,
+     [REQ] = RELPREC, [ASSIGN] = RELPREC, [NEQ] = RELPREC,
+     [PLUS] = 2, [MINUS] = 2, [TIMES] = MAXPREC, [OVER] = MAXPREC};
+
+/* expression parses
+ *   expression -> var = expression | binary(RELPREC)
+ * An assignment is recognized after its left side
+ * has been parsed: if a lone variable is followed
+ * by EQ, its node becomes an AssignK (or AssignKarr
+ * with the subscript in child[1]) whose child[0] is
+ * the value assigned. A variable in parentheses is
+ * not a var: (x) = e is a syntax error at the EQ
+ */
+TreeNode *expression(ParseState *ps)
 {
-
-  TreeNode *t = NULL;
-  char *name = copyString(tokenString);
-
-  if (token == ID)
-  {
-    match(ID);
-    // printToken(token, tokenString);
-    if (token == EQ)
-    {
-      t = newStmtNode(AssignK);
-      t->attr.name = name;
-      match(EQ);
-      t->child[0] = add_oper();
-    }
-    else if ((token == LT) || (token == ASSIGN) || (token == RT) || (token == REQ) || (token == LEQ) || (token == NEQ))
-    {
-      t = newExpNode(SimpIK);
-      t->simp_name = name;
-      t->attr.op = token;
-      match(token);
-      t->child[0] = add_oper();
-    }
-    else if ((token == PLUS) || (token == MINUS))
-    {
-      add_mul_flag = 0;
-      t = newExpNode(AddSI);
-      t->simp_name = name;
-      t->attr.op = token;
-      match(token);
-      t->child[0] = add_oper();
-    }
-    else if ((token == TIMES) || (token == OVER))
-    {
-      add_mul_flag = 1;
-      t = newExpNode(MulSI);
-      t->simp_name = name;
-      t->attr.op = token;
-      match(token);
-      t->child[0] = add_oper();
-    }
-    else if (token == LPAREN)
-    {
-
-      match(LPAREN);
-      t = newStmtNode(CallK);
-      t->child[0] = callparam();
-      match(RPAREN);
-    }
-    else if (token == LSQBRAC)
-    {
-      t = newStmtNode(AssignKarr);
-      t->attr.name = name;
-      match(LSQBRAC);
-      t->arr_size = atoi(tokenString);
-      match(NUM);
-      match(RSQBRAC);
-      match(EQ);
-      t->child[0] = add_oper();
-    }
-  }
-  return t;
+  int paren = ps->token == LPAREN;
+  TreeNode *t = binary(ps, RELPREC);
+  TreeNode *a;
+  if ((ps->token != EQ) || paren || (t->nodekind != ExpK) ||
+      ((t->kind.exp != IdK) && (t->kind.exp != ArrexpK)))
+    return t;
+  a = stmtNode(ps, t->kind.exp == IdK ? AssignK : AssignKarr);
+  a->attr.name = t->attr.name;
+  a->lineno = t->lineno;
+  a->child[1] = t->child[0];
+  free(t);
+  match(ps, EQ);
+  a->child[0] = expression(ps);
+  return a;
 }
-TreeNode *add_oper(void)
-{
-  TreeNode *t;
-  TreeNode *q;
-  if (token == LPAREN)
-    match(LPAREN);
-  char *name = copyString(tokenString);
 
-  if (token == ID)
-  {
-    match(ID);
-    if (token == LPAREN)
-      match(LPAREN);
-    if (token == RPAREN)
-      match(RPAREN);
-    if (token == SEMI)
-    {
-      t = newExpNode(IdK);
-      t->attr.name = name;
-    }
-    else if ((token == PLUS) || (token == MINUS))
-    {
-      add_mul_flag = 0;
-      t = newExpNode(AddIK);
-      t->attr.name = name;
-      q = add_op();
-      t->sibling = q;
-    }
-    else if ((token == TIMES) || (token == OVER))
-    {
-      add_mul_flag = 1;
-      t = newExpNode(MulIK);
-      t->attr.name = name;
-      q = mul_op();
-      t->sibling = q;
-    }
-    else if ((token == LT) || (token == ASSIGN) || (token == RT) || (token == REQ) || (token == LEQ) || (token == NEQ))
-    {
-      t = newExpNode(SimpIK);
-      t->simp_name = name;
-      t->attr.op = token;
-      q = sim_op();
-      t->sibling = q;
-    }
-    else if (token == LSQBRAC)
-    {
-      t = newExpNode(ArrexpK);
-      t->attr.name = name;
-      match(LSQBRAC);
-      q = add_oper();
-      t->child[0] = q;
-      match(RSQBRAC);
-      if ((token == PLUS) || (token == MINUS))
-      {
-        q = add_op();
-        t->sibling = q;
-      }
-      if ((token == TIMES) || (token == OVER))
-      {
-
-        q = mul_op();
-        t->sibling = q;
-      }
-    }
-  }
-  else if (token == NUM)
-  {
-    int temp = atoi(tokenString);
-    match(NUM);
-    if (token == LPAREN)
-      match(LPAREN);
-    if (token == RPAREN)
-      match(RPAREN);
-    if (token == SEMI)
-    {
-      t = newExpNode(ConstK);
-      t->attr.val = temp;
-    }
-    else if ((token == PLUS) || (token == MINUS))
-    {
-      // match(token);
-      t = newExpNode(AddCK);
-      t->attr.val = temp;
-      q = add_op();
-
-      t->sibling = q;
-    }
-    else if ((token == TIMES) || (token == OVER))
-    {
-      // match(token);
-      t = newExpNode(MulCK);
-      t->attr.val = temp;
-      q = mul_op();
-      t->sibling = q;
-    }
-    else if ((token == LT) || (token == ASSIGN) || (token == RT) || (token == REQ) || (token == LEQ) || (token == NEQ))
-    {
-      t = newExpNode(SimpNK);
-      t->simp_val = temp;
-      t->attr.op = token;
-      q = sim_op();
-      t->sibling = q;
-    }
-  }
-  else
-  {
-    syntaxError("syntax error\n");
-    fprintf(listing, "add- Current token: \t");
-    printToken(TOKENERR, tokenString);
-  }
-  return t;
-}
-TreeNode *sim_op(void)
+/* binary parses a chain of operators binding at
+ * least as tightly as minPrec into a tree of OpK
+ * nodes. Operators of one level are folded in the
+ * loop, so a chain such as y*y*y costs one factor
+ * call per operand and no recursion
+ */
+TreeNode *binary(ParseState *ps, int minPrec)
 {
-  TreeNode *t = NULL;
-  match(token);
-  if (token == NUM)
-  {
-    t = newExpNode(ConstK);
-    t->attr.val = atoi(tokenString);
-    match(token);
-    if (token != SEMI)
-    {
-      add_mul_flag = 2;
-      if ((token == TIMES) || (token == OVER))
-        t->sibling = mul_op();
-      else
-        t->sibling = add_op();
-    }
+  TreeNode *t = factor(ps);
+  int prec;
+  while ((prec = binaryPrec[ps->token]) >= minPrec)
+  {
+    TreeNode *p = expNode(ps, OpK);
+    p->attr.op = ps->token;
+    p->child[0] = t;
+    match(ps, ps->token);
+    p->child[1] = prec == MAXPREC ? factor(ps) : binary(ps, prec + 1);
+    t = p;
+    if ((prec == RELPREC) && (binaryPrec[ps->token] == RELPREC))
+      syntaxError(ps, "relational operators do not chain\n");
   }
-  else if (token == ID)
-  {
-    t = newExpNode(IdK);
-    t->attr.name = copyString(tokenString);
-    match(token);
-    if (token != SEMI)
-    {
-      add_mul_flag = 2;
-      if ((token == TIMES) || (token == OVER))
-        t->sibling = mul_op();
-      else if (token == LSQBRAC)
-        t->sibling = arr_op();
-      else
-        t->sibling = add_op();
-    }
-  }
-
   return t;
 }
-TreeNode *add_op(void)
+
+/* factor parses
+ *   factor -> ( expression ) | NUM | ID | ID [ expression ]
+ *           | ID ( args )
+ */
+TreeNode *factor(ParseState *ps)
 {
   TreeNode *t = NULL;
-  TreeNode *q;
-  if (token == LPAREN)
-    match(LPAREN);
-  if (token == RPAREN)
-    match(RPAREN);
-  if ((flag == 0) && ((token == PLUS) || (token == MINUS)))
+  char *name;
+  int line;
+  switch (ps->token)
   {
-
-    t = newExpNode(OpK);
-    t->attr.op = token;
-    if (add_mul_flag == 2 || add_mul_flag)
-      t->type = MtA;
-    add_mul_flag = 0;
-    match(token);
-    flag = 1;
-    if (token != SEMI)
+  case NUM:
+    t = expNode(ps, ConstK);
+    t->attr.val = atoi(ps->scan->tokenString);
+    match(ps, NUM);
+    break;
+  case ID:
+    name = copyString(ps->scan->tokenString);
+    line = ps->scan->lineno;
+    match(ps, ID);
+    if (ps->token == LSQBRAC)
     {
-      flag = 1;
-      if ((token == TIMES) || (token == OVER))
-        t->sibling = mul_op();
-      else
-        t->sibling = add_op();
+      t = expNode(ps, ArrexpK);
+      t->attr.name = name;
+      match(ps, LSQBRAC);
+      t->child[0] = expression(ps);
+      match(ps, RSQBRAC);
     }
-  }
-  else if (token == ID && flag == 1)
-  {
-    t = newExpNode(IdK);
-    t->attr.name = copyString(tokenString);
-    match(token);
-    if (token == RPAREN)
-      match(RPAREN);
-    flag = 0;
-    if (token != SEMI)
+    else if (ps->token == LPAREN)
     {
-
-      flag = 0;
-      if ((token == TIMES) || (token == OVER))
-        t->sibling = mul_op();
-      else if (token == LSQBRAC)
-      {
-        t->sibling = arr_op();
-      }
-      else
-        t->sibling = add_op();
+      t = stmtNode(ps, CallK);
+      t->attr.name = name;
+      match(ps, LPAREN);
+      t->child[0] = args(ps);
+      match(ps, RPAREN);
     }
-  }
-  else if (token == NUM && flag == 1)
-  {
-    t = newExpNode(ConstK);
-    t->attr.val = atoi(tokenString);
-    match(token);
-    if (token == RPAREN)
-      match(RPAREN);
-    flag = 0;
-    if (token != SEMI)
+    else
     {
-      flag = 0;
-      if ((token == TIMES) || (token == OVER))
-        t->sibling = mul_op();
-      else
-        t->sibling = add_op();
+      t = expNode(ps, IdK);
+      t->lineno = line;
+      t->attr.name = name;
     }
+    break;
+  case LPAREN:
+    match(ps, LPAREN);
+    t = expression(ps);
+    match(ps, RPAREN);
+    break;
+  default:
+    syntaxError(ps, "unexpected token -> ");
   }
   return t;
 }
 
-TreeNode *arr_op(void)
+/* args parses the argument list of a call,
+ * returning the arguments as a sibling list
+ */
+TreeNode *args(ParseState *ps)
 {
   TreeNode *t = NULL;
-  TreeNode *q;
-
-  if (token == LSQBRAC)
-  {
-    match(LSQBRAC);
-    t = newExpNode(ArrexpK);
-    t->attr.name = copyString(tokenString);
-
-    q = add_oper();
-    t->child[0] = q;
-    match(RSQBRAC);
-    if ((token == PLUS) || (token == MINUS))
-    {
-      q = add_op();
-      t->sibling = q;
-    }
-    if ((token == TIMES) || (token == OVER))
-    {
-
-      q = mul_op();
-      t->sibling = q;
-    }
-  }
-  return t;
-}
-TreeNode *mul_op(void)
-{
-  TreeNode *t;
-  TreeNode *q;
-  if (token == LPAREN)
-    match(LPAREN);
-  if (token == RPAREN)
-    match(RPAREN);
-  if ((flag == 0) && ((token == TIMES) || (token == OVER)))
-  {
-
-    t = newExpNode(OpK);
-    t->attr.op = token;
-    if (add_mul_flag == 2 || !add_mul_flag)
-      t->type = AtM;
-    add_mul_flag = 1;
-    match(token);
-    if (token != SEMI)
-    {
-      flag = 1;
-      t->sibling = add_op();
-    }
-  }
-  else if (token == ID && flag == 1)
-  {
-    t = newExpNode(IdK);
-    t->attr.name = copyString(tokenString);
-    match(token);
-    if (token == RPAREN)
-      match(RPAREN);
-    if (token != SEMI)
-    {
-      flag = 0;
-      if ((token == TIMES) || (token == OVER))
-        t->sibling = mul_op();
-      else if (token == LSQBRAC)
-        t->sibling = arr_op();
-      else
-        t->sibling = add_op();
-    }
-  }
-  else if (token == NUM && flag == 1)
+  TreeNode *p = NULL;
+  if (ps->token == RPAREN)
+    return NULL;
+  for (;;)
   {
-    t = newExpNode(ConstK);
-    t->attr.val = atoi(tokenString);
-    match(token);
-    if (token == RPAREN)
-      match(RPAREN);
-    if (token != SEMI)
+    TreeNode *q = expression(ps);
+    if (t == NULL)
+      t = p = q;
+    else
     {
-      flag = 0;
-      if ((token == TIMES) || (token == OVER))
-        t->sibling = mul_op();
-      else
-        t->sibling = add_op();
+      p->sibling = q;
+      p = q;
     }
-  }
-  else
-  {
-    syntaxError("syntax error\n");
-    fprintf(listing, "mul- Current token: \t");
-    printToken(TOKENERR, tokenString);
+    if (ps->token != COMMA)
+      break;
+    match(ps, COMMA);
   }
   return t;
 }
-TreeNode *var_declare(void)
+TreeNode *var_declare(ParseState *ps)
 {
   TreeNode *t;
-  ExpType type = get_type();
-  char *name = copyString(tokenString);
-  match(ID);
+  ExpType type = get_type(ps);
+  char *name = copyString(ps->scan->tokenString);
+  int line = ps->scan->lineno; /* of the name */
+  match(ps, ID);
 
-  if (token == SEMI)
+  if (ps->token == SEMI)
   {
 
     /* 변수 선언*/
-    match(SEMI);
+    match(ps, SEMI);
     // return NULL;
-    t = newExpNode(VarK);
+    t = expNode(ps, VarK);
+    t->lineno = line;
     t->attr.name = name;
     t->type = type;
     //
   }
-  else if (token == LSQBRAC)
+  else if (ps->token == LSQBRAC)
   {
 
     /*배열 선언*/
-    t = newExpNode(ArrK);
+    t = expNode(ps, ArrK);
     t->attr.name = name;
     t->type = type;
-    match(LSQBRAC);
-    t->arr_size = atoi(tokenString);
-    match(NUM);
-    match(RSQBRAC);
-    match(SEMI);
+    match(ps, LSQBRAC);
+    t->arr_size = atoi(ps->scan->tokenString);
+    match(ps, NUM);
+    match(ps, RSQBRAC);
+    match(ps, SEMI);
   }
   else
   {
-    syntaxError("syntax error\n");
-    fprintf(listing, "var -Current token: \t");
-    printToken(TOKENERR, tokenString);
-    token = getToken();
+    syntaxError(ps, "syntax error\n");
   }
   return t;
 }
-TreeNode *local_declare(void)
+TreeNode *local_declare(ParseState *ps)
 {
   TreeNode *t = NULL;
-  if (token == INT || token == VOID)
-  {
-    t = var_declare();
-  }
   TreeNode *p = t;
-  if (t != NULL)
+  while ((ps->token == INT || ps->token == VOID))
   {
-    while ((token == INT || token == VOID))
+    TreeNode *q;
+    // match(SEMI);
+    q = recoverable(ps, var_declare, FALSE);
+    // if(ERROR) return;
+    if (q != NULL)
     {
-      TreeNode *q;
-      // match(SEMI);
-      q = var_declare();
-      // if(ERROR) return;
-      if (q != NULL)
+      if (t == NULL)
+        t = p = q;
+      else /* now p cannot be NULL either */
       {
-        if (t == NULL)
-          t = p = q;
-        else /* now p cannot be NULL either */
-        {
-          p->sibling = q;
-          p = q;
-        }
+        p->sibling = q;
+        p = q;
       }
     }
   }
   return t;
 }
-TreeNode *stmt_list(void)
+TreeNode *stmt_list(ParseState *ps)
 {
   TreeNode *t = NULL;
 
-  if (token == RBRAC)
+  if (ps->token == RBRAC)
     return NULL;
 
-  t = stmt_declare();
+  t = recoverable(ps, stmt_declare, FALSE);
   TreeNode *p = t;
-  while (token != RBRAC)
+  while ((ps->token != RBRAC) && (ps->token != ENDFILE))
   {
     TreeNode *q;
+    /* after an error a declaration ends the list */
+    if (ps->quiet && ((ps->token == INT) || (ps->token == VOID)))
+      break;
     // match(SEMI);
-    q = stmt_declare();
+    q = recoverable(ps, stmt_declare, FALSE);
     // if(ERROR) return;
     if (q != NULL)
     {
@@ -730,198 +564,151 @@ TreeNode *stmt_list(void)
   }
   return t;
 }
-TreeNode *stmt_declare(void)
+TreeNode *stmt_declare(ParseState *ps)
 {
   TreeNode *t = NULL;
-  switch (token)
+  switch (ps->token)
   {
   case WHILE:
-    t = repeat_stmt();
+    t = repeat_stmt(ps);
     break;
   case IF:
-    t = if_stmt();
+    t = if_stmt(ps);
     break;
   case RETURN:
-    t = ret_stmt();
+    t = ret_stmt(ps);
     break;
   case LBRAC:
-    t = compound();
+    t = compound(ps);
 
     break;
   case ID:
-    t = tempa();
-    match(SEMI);
+  case NUM:
+  case LPAREN:
+    t = expression(ps);
+    match(ps, SEMI);
     break;
-  default:
-    syntaxError("syntax error\n");
-    fprintf(listing, "stCurrent token: \t");
-    printToken(TOKENERR, tokenString);
-    token = getToken();
+  case SEMI:
+    match(ps, SEMI);
     break;
+  default:
+    syntaxError(ps, "syntax error\n");
   }
 
   return t;
 }
-TreeNode *ret_stmt(void)
+TreeNode *ret_stmt(ParseState *ps)
 {
-  TreeNode *t = newStmtNode(ReturnK);
+  TreeNode *t = stmtNode(ps, ReturnK);
 
-  match(RETURN);
-  if (token != SEMI)
+  match(ps, RETURN);
+  if (ps->token != SEMI)
   {
-    t->child[0] = add_oper();
+    t->child[0] = expression(ps);
   }
-  match(SEMI);
+  match(ps, SEMI);
   return t;
 }
-TreeNode *if_stmt(void)
+TreeNode *if_stmt(ParseState *ps)
 {
-  TreeNode *t = newStmtNode(IfK);
-  match(IF);
-  match(LPAREN);
+  TreeNode *t = stmtNode(ps, IfK);
+  match(ps, IF);
+  match(ps, LPAREN);
   if (t != NULL)
-    t->child[0] = add_oper();
+    t->child[0] = expression(ps);
+  match(ps, RPAREN);
 
   if (t != NULL)
-    t->child[1] = stmt_declare();
+    t->child[1] = stmt_declare(ps);
 
-  if (token == ELSE)
+  if (ps->token == ELSE)
   {
-    match(ELSE);
+    match(ps, ELSE);
     if (t != NULL)
-      t->child[2] = stmt_declare();
+      t->child[2] = stmt_declare(ps);
   }
   return t;
 }
 
-TreeNode *repeat_stmt(void)
-{
-  TreeNode *t = newStmtNode(RepeatK);
-  match(WHILE);
-  match(LPAREN);
-  if (t != NULL)
-    t->child[0] = add_oper();
-
-  if (t != NULL)
-    t->child[1] = stmt_declare();
-  return t;
-}
-
-TreeNode *assign_stmt(void)
+TreeNode *repeat_stmt(ParseState *ps)
 {
-  TreeNode *t = newStmtNode(AssignK);
-  if ((t != NULL) && (token == ID))
-    t->attr.name = copyString(tokenString);
-  match(ID);
-  match(ASSIGN);
+  TreeNode *t = stmtNode(ps, RepeatK);
+  match(ps, WHILE);
+  match(ps, LPAREN);
   if (t != NULL)
-    t->child[0] = tempa();
-  return t;
-}
-
-TreeNode *read_stmt(void)
-{
-  TreeNode *t = newStmtNode(ReadK);
-  match(READ);
-  if ((t != NULL) && (token == ID))
-    t->attr.name = copyString(tokenString);
-  match(ID);
-  return t;
-}
+    t->child[0] = expression(ps);
+  match(ps, RPAREN);
 
-TreeNode *write_stmt(void)
-{
-  TreeNode *t = newStmtNode(WriteK);
-  match(WRITE);
   if (t != NULL)
-    t->child[0] = tempa();
+    t->child[1] = stmt_declare(ps);
   return t;
 }
 
-TreeNode *add_exp(TreeNode *g)
+/****************************************/
+/* the primary function of the parser   */
+/****************************************/
+/* Function parseSource returns the newly
+ * constructed syntax tree of src; errors and
+ * traces are written to lst. After a syntax error
+ * the parser resynchronizes and goes on, so that
+ * all errors are reported in one pass; *error is
+ * then set and the tree holds the parts that did
+ * parse. Parsing stops after MaxErrors errors, in
+ * which case NULL is returned
+ */
+TreeNode *parseSource(FILE *src, OutBuf *lst, int *error)
 {
-  TreeNode *t = term(g);
-  while ((token == PLUS) || (token == MINUS))
+  ParseState state;
+  ParseState *ps = &state;
+  TreeNode *t = NULL;
+  *error = FALSE;
+  ps->scan = newScanner(src, lst);
+  if (ps->scan == NULL)
   {
-    TreeNode *p = newExpNode(OpK);
-    if (p != NULL)
-    {
-      p->child[0] = t;
-      p->attr.op = token;
-      t = p;
-      match(token);
-      t->child[1] = term(NULL);
-    }
+    obPuts(lst, "Out of memory error creating scanner\n");
+    *error = TRUE;
+    return NULL;
   }
-  return t;
-}
-
-TreeNode *term(TreeNode *g)
-{
-  TreeNode *t = factor(g);
-  while ((token == TIMES) || (token == OVER))
+  ps->listing = lst;
+  ps->errors = 0;
+  ps->maxErrors = MaxErrors;
+  ps->quiet = FALSE;
+  if (setjmp(ps->stop) == 0)
   {
-    TreeNode *p = newExpNode(OpK);
-    if (p != NULL)
-    {
-      p->child[0] = t;
-      p->attr.op = token;
-      t = p;
-      match(token);
-      p->child[1] = factor(NULL);
-    }
+    memcpy(ps->fail, ps->stop, sizeof(jmp_buf));
+    advance(ps);
+    t = stmt_sequence(ps);
+    // if(ERROR) return NULL;
+    if (ps->token != ENDFILE)
+      syntaxError(ps, "Code ends before file\n");
   }
-  return t;
-}
-
-TreeNode *factor(TreeNode *g)
-{
-  TreeNode *t = NULL;
-  if (g != NULL)
-    return g;
-  switch (token)
+  else
   {
-  case NUM:
-    t = newExpNode(ConstK);
-    if ((t != NULL) && (token == NUM))
-    {
-      t->attr.val = atoi(tokenString);
-      t->type = Integer;
-    }
-    match(NUM);
-    break;
-  case ID:
-    t = newExpNode(IdK);
-    if ((t != NULL) && (token == ID))
-      match(ID);
-    break;
-  case LPAREN:
-    match(LPAREN);
-    t = tempa();
-    match(RPAREN);
-    break;
-  default:
-    syntaxError("unexpected token -> ");
-    printToken(token, tokenString);
-    token = getToken();
-    break;
+    t = NULL;
+    if ((ps->maxErrors > 1) && (ps->errors >= ps->maxErrors))
+      obPrintf(lst, "Too many syntax errors (%d), parsing stopped\n", ps->errors);
   }
+  *error = ps->errors > 0;
+  if (Stats != NULL)
+    Stats->tokens = ps->scan->tokens;
+  freeScanner(ps->scan);
   return t;
 }
 
-/****************************************/
-/* the primary function of the parser   */
-/****************************************/
 /* Function parse returns the newly
- * constructed syntax tree
+ * constructed syntax tree of the global
+ * source file; the compilation stops after
+ * the syntax errors have been reported
  */
 TreeNode *parse(void)
 {
-  TreeNode *t;
-  token = getToken();
-  t = stmt_sequence();
-  // if(ERROR) return NULL;
-  if (token != ENDFILE)
-    syntaxError("Code ends before file\n");
+  int error;
+  TreeNode *t = parseSource(source, listing, &error);
+  if (error)
+  {
+    Error = TRUE;
+    obFlush(listing);
+    exit(-1);
+  }
   return t;
 }
@@ -13,4 +13,15 @@
  */
 TreeNode * parse(void);
 
+/* Function parseSource returns the newly
+ * constructed syntax tree of src, writing
+ * errors and traces to lst; *error is set
+ * if a syntax error was found. The parser
+ * recovers from errors, reporting up to
+ * MaxErrors of them in one pass. It keeps no
+ * global state, so it may be called once per
+ * source or from several threads at once
+ */
+TreeNode * parseSource(FILE * src, OutBuf * lst, int * error);
+
 #endif
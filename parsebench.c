@@ -0,0 +1,155 @@
+/****************************************************/
+/* File: parsebench.c                               */
+/* Measures parse throughput of the front end it    */
+/* is linked with: parse.o or tiny.tab.o, and the   */
+/* cost of handing the tree on in binary form       */
+/****************************************************/
+
+#include <time.h>
+#include "globals.h"
+#include "util.h"
+#include "parse.h"
+#include "traverse.h"
+#include "astio.h"
+
+/* allocate global variables */
+int lineno = 0;
+FILE * source;
+OutBuf * listing;
+OutBuf * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MaxErrors = 20;
+
+int Error = FALSE;
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* the node count and shape checksum let runs with
+ * the two front ends be checked against each other
+ */
+typedef struct
+   { unsigned long sum;
+     unsigned long nodes;
+   } TreeSum;
+
+static int sumVisit(TreeNode * t, int depth, void * arg)
+{ TreeSum * s = (TreeSum *) arg;
+  int kind = t->nodekind == StmtK ? (int) t->kind.stmt : (int) t->kind.exp;
+  s->sum = s->sum * 31 + (t->nodekind << 5 | kind) + depth;
+  s->nodes++;
+  return TRUE;
+}
+
+/* fullVisit also sums what the shape leaves out,
+ * so that a tree read back can be checked against
+ * the tree written
+ */
+static int fullVisit(TreeNode * t, int depth, void * arg)
+{ TreeSum * s = (TreeSum *) arg;
+  const char * p;
+  sumVisit(t,depth,arg);
+  s->sum = s->sum * 31 + t->lineno;
+  s->sum = s->sum * 31 + t->type;
+  s->sum = s->sum * 31 + (unsigned) t->arr_size;
+  if ((t->nodekind == ExpK) && (t->kind.exp == OpK))
+    s->sum = s->sum * 31 + t->attr.op;
+  else if ((t->nodekind == ExpK) && (t->kind.exp == ConstK))
+    s->sum = s->sum * 31 + (unsigned) t->attr.val;
+  else if ((t->nodekind == ExpK) ||
+           (t->kind.stmt == AssignK) || (t->kind.stmt == AssignKarr) ||
+           (t->kind.stmt == ReadK) || (t->kind.stmt == CallK))
+    for (p = t->attr.name; (p != NULL) && (*p != '\0'); p++)
+      s->sum = s->sum * 31 + (unsigned char) *p;
+  return TRUE;
+}
+
+static unsigned long fullSum(TreeNode * tree)
+{ TreeSum s = { 0, 0 };
+  TreeVisitor v = { fullVisit, NULL, NULL, &s };
+  walkTree(tree,&v);
+  return s.sum;
+}
+
+int main(int argc, char * argv[])
+{ TreeNode * tree = NULL, * copy = NULL;
+  OutBuf * ast;
+  TreeSum ts;
+  TreeVisitor tv = { sumVisit, NULL, NULL, &ts };
+  double elapsed, start;
+  long bytes;
+  size_t used;
+  int reps, i, err;
+  FILE * f;
+  if (argc != 4)
+  { fprintf(stderr,"usage: %s <label> <source> <parses>\n",argv[0]);
+    return 1;
+  }
+  reps = atoi(argv[3]);
+  listing = newOutBuf(stdout);
+  f = fopen(argv[2],"r");
+  if (f == NULL)
+  { fprintf(stderr,"File %s not found\n",argv[2]);
+    return 1;
+  }
+  fseek(f,0,SEEK_END);
+  bytes = ftell(f);
+
+  /* trees are not freed anywhere in the compiler,
+   * so every parse keeps its tree */
+  start = now();
+  for (i=0;i<reps;i++)
+  { rewind(f);
+    tree = parseSource(f,listing,&err);
+    if (err) { freeOutBuf(listing); return 1; }
+  }
+  elapsed = now() - start;
+  fclose(f);
+  ts.sum = ts.nodes = 0;
+  walkTree(tree,&tv);
+
+  printf("%-10s %10lu nodes %016lx %8.3f s %8.2f MB/s %8.2f Mnodes/s\n",
+         argv[1],ts.nodes,ts.sum,elapsed,
+         bytes * (double) reps / elapsed / 1e6,
+         ts.nodes * (double) reps / elapsed / 1e6);
+
+  /* the same tree through the binary format of
+   * astio.h: written, then read back */
+  ast = newOutBuf(NULL);
+  start = now();
+  for (i=0;i<reps;i++)
+  { ast->len = 0;
+    serializeTree(ast,tree,0);
+  }
+  elapsed = now() - start;
+  printf("%-10s %10lu bytes %16s %8.3f s %8.2f MB/s %8.2f Mnodes/s\n",
+         "  write",(unsigned long) ast->len,"",elapsed,
+         ast->len * (double) reps / elapsed / 1e6,
+         ts.nodes * (double) reps / elapsed / 1e6);
+  start = now();
+  for (i=0;i<reps;i++)
+  { copy = deserializeTree(ast->buf,ast->len,0,&used,&err);
+    if (err) { fprintf(stderr,"bad tree\n"); return 1; }
+  }
+  elapsed = now() - start;
+  printf("%-10s %10lu bytes %016lx %8.3f s %8.2f MB/s %8.2f Mnodes/s\n",
+         "  read",(unsigned long) ast->len,fullSum(copy),elapsed,
+         ast->len * (double) reps / elapsed / 1e6,
+         ts.nodes * (double) reps / elapsed / 1e6);
+  if (fullSum(copy) != fullSum(tree))
+  { fprintf(stderr,"tree read back differs from the tree written\n");
+    return 1;
+  }
+  freeOutBuf(ast);
+  freeOutBuf(listing);
+  return 0;
+}
@@ -11,45 +11,76 @@
 
 /* states in scanner DFA */
 typedef enum
-   { START,INASSIGN,INCOMMENT,INNUM,INID,DONE }
+   { START,INOP,INOVER,INCOMMENT,INSTAR,INNUM,INID,INLEXERR,
+     INSPACE,DONE }
    StateType;
 
-/* lexeme of identifier or reserved word */
-char tokenString[MAXTOKENLEN+1];
-
 /* BUFLEN = length of the input buffer for
-   source code lines */
-#define BUFLEN 256
+   source code text */
+#define BUFLEN 4096
 
-static char lineBuf[BUFLEN]; /* holds the current line */
-static int linepos = 0; /* current position in LineBuf */
-static int bufsize = 0; /* current size of buffer string */
-static int EOF_flag = FALSE; /* corrects ungetNextChar behavior on EOF */
+/* ScanState is the private part of a Scanner */
+typedef struct
+   { unsigned char buf[BUFLEN]; /* holds the current block */
+     int bufpos; /* current position in buf */
+     int bufsize; /* current size of buffer */
+     int EOF_flag; /* corrects ungetNextChar behavior on EOF */
+   } ScanState;
 
-/* getNextChar fetches the next non-blank character
-   from lineBuf, reading in a new line if lineBuf is
-   exhausted */
-static int getNextChar(void)
-{ if (!(linepos < bufsize))
-  { lineno++;
-    if (fgets(lineBuf,BUFLEN-1,source))
-    { if (EchoSource) fprintf(listing,"%4d: %s",lineno,lineBuf);
-      bufsize = strlen(lineBuf);
-      linepos = 0;
-      return lineBuf[linepos++];
-    }
-    else
-    { EOF_flag = TRUE;
+/* Function newScanner creates a scanner reading
+ * from source; trace output goes to listing
+ */
+Scanner * newScanner(FILE * source, OutBuf * listing)
+{ Scanner * s = (Scanner *) malloc(sizeof(Scanner));
+  ScanState * st = (ScanState *) malloc(sizeof(ScanState));
+  if ((s==NULL) || (st==NULL))
+  { free(s);
+    free(st);
+    return NULL;
+  }
+  st->bufpos = 0;
+  st->bufsize = 0;
+  st->EOF_flag = FALSE;
+  s->source = source;
+  s->listing = listing;
+  s->lineno = 1;
+  s->tokenString[0] = '\0';
+  s->tokens = 0;
+  s->state = st;
+  return s;
+}
+
+/* Procedure freeScanner releases a scanner
+ * (the source file is not closed)
+ */
+void freeScanner(Scanner * s)
+{ if (s==NULL) return;
+  free(s->state);
+  free(s);
+}
+
+/* getNextChar fetches the next character from buf,
+   reading in a new block if buf is exhausted. Lines
+   are counted by the DFA, so a line may span blocks */
+static int getNextChar(Scanner * s)
+{ ScanState * st = (ScanState *) s->state;
+  if (!(st->bufpos < st->bufsize))
+  { st->bufsize = fread(st->buf,1,BUFLEN,s->source);
+    st->bufpos = 0;
+    if (st->bufsize == 0)
+    { st->EOF_flag = TRUE;
       return EOF;
     }
   }
-  else return lineBuf[linepos++];
+  st->EOF_flag = FALSE;
+  return st->buf[st->bufpos++];
 }
 
 /* ungetNextChar backtracks one character
-   in lineBuf */
-static void ungetNextChar(void)
-{ if (!EOF_flag) linepos-- ;}
+   in buf */
+static void ungetNextChar(Scanner * s)
+{ ScanState * st = (ScanState *) s->state;
+  if (!st->EOF_flag) st->bufpos-- ;}
 
 /* lookup table of reserved words */
 static struct
@@ -58,7 +89,8 @@ static struct
     } reservedWords[MAXRESERVED]
    = {{"if",IF},{"then",THEN},{"else",ELSE},{"end",END},
       {"repeat",REPEAT},{"until",UNTIL},{"read",READ},
-      {"write",WRITE}};
+      {"write",WRITE},{"void",VOID},{"while",WHILE},
+      {"int",INT},{"return",RETURN}};
 
 /* lookup an identifier to see if it is a reserved word */
 /* uses linear search */
@@ -74,9 +106,12 @@ static TokenType reservedLookup (char * s)
 /* the primary function of the scanner  */
 /****************************************/
 /* function getToken returns the 
- * next token in source file
+ * next token in source file. It scans
+ * the same tokens as lex/tiny.l, longest
+ * match first, so the two scanners can be
+ * linked in place of each other
  */
-TokenType getToken(void)
+TokenType getToken(Scanner * s)
 {  /* index for storing into tokenString */
    int tokenStringIndex = 0;
    /* holds current token to be returned */
@@ -85,8 +120,10 @@ TokenType getToken(void)
    StateType state = START;
    /* flag to indicate save to tokenString */
    int save;
+   /* first character of a two-character operator */
+   int first = 0;
    while (state != DONE)
-   { int c = getNextChar();
+   { int c = getNextChar(s);
      save = TRUE;
      switch (state)
      { case START:
@@ -94,14 +131,14 @@ TokenType getToken(void)
            state = INNUM;
          else if (isalpha(c))
            state = INID;
-         else if (c == ':')
-           state = INASSIGN;
-         else if ((c == ' ') || (c == '\t') || (c == '\n'))
-           save = FALSE;
-         else if (c == '{')
-         { save = FALSE;
-           state = INCOMMENT;
+         else if ((c == '=') || (c == '!') || (c == '<') || (c == '>'))
+         { first = c;
+           state = INOP;
          }
+         else if (c == '/')
+           state = INOVER;
+         else if ((c == ' ') || (c == '\t'))
+           state = INSPACE;
          else
          { state = DONE;
            switch (c)
@@ -109,11 +146,9 @@ TokenType getToken(void)
                save = FALSE;
                currentToken = ENDFILE;
                break;
-             case '=':
-               currentToken = EQ;
-               break;
-             case '<':
-               currentToken = LT;
+             case '\n':
+               s->lineno++;
+               currentToken = NLSP;
                break;
              case '+':
                currentToken = PLUS;
@@ -124,9 +159,6 @@ TokenType getToken(void)
              case '*':
                currentToken = TIMES;
                break;
-             case '/':
-               currentToken = OVER;
-               break;
              case '(':
                currentToken = LPAREN;
                break;
@@ -136,68 +168,123 @@ TokenType getToken(void)
              case ';':
                currentToken = SEMI;
                break;
+             case '[':
+               currentToken = LSQBRAC;
+               break;
+             case ']':
+               currentToken = RSQBRAC;
+               break;
+             case '{':
+               currentToken = LBRAC;
+               break;
+             case '}':
+               currentToken = RBRAC;
+               break;
+             case ',':
+               currentToken = COMMA;
+               break;
              default:
                currentToken = ERROR;
                break;
            }
          }
          break;
+       case INOP:
+         state = DONE;
+         if (c == '=')
+           switch (first)
+           { case '=': currentToken = ASSIGN; break;
+             case '!': currentToken = NEQ; break;
+             case '<': currentToken = LEQ; break;
+             default: currentToken = REQ; break;
+           }
+         else
+         { /* backup in the input */
+           ungetNextChar(s);
+           save = FALSE;
+           switch (first)
+           { case '=': currentToken = EQ; break;
+             case '!': currentToken = ERROR; break;
+             case '<': currentToken = LT; break;
+             default: currentToken = RT; break;
+           }
+         }
+         break;
+       case INOVER:
+         if (c == '*')
+         { /* the comment is not part of any token */
+           save = FALSE;
+           tokenStringIndex = 0;
+           state = INCOMMENT;
+         }
+         else
+         { /* backup in the input */
+           ungetNextChar(s);
+           save = FALSE;
+           state = DONE;
+           currentToken = OVER;
+         }
+         break;
        case INCOMMENT:
+       case INSTAR:
          save = FALSE;
          if (c == EOF)
          { state = DONE;
-           currentToken = ENDFILE;
+           currentToken = CMTERR;
          }
-         else if (c == '}') state = START;
-         break;
-       case INASSIGN:
-         state = DONE;
-         if (c == '=')
-           currentToken = ASSIGN;
+         else if ((c == '/') && (state == INSTAR))
+           state = START;
          else
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           currentToken = ERROR;
+         { if (c == '\n') s->lineno++;
+           state = (c == '*') ? INSTAR : INCOMMENT;
          }
          break;
        case INNUM:
-         if (!isdigit(c))
+       case INID:
+       case INLEXERR:
+         if (isalnum(c))
+         { if (isdigit(c) ? (state == INID) : (state == INNUM))
+             state = INLEXERR;
+         }
+         else
          { /* backup in the input */
-           ungetNextChar();
+           ungetNextChar(s);
            save = FALSE;
+           currentToken = (state == INNUM) ? NUM :
+                          (state == INID) ? ID : LEXERR;
            state = DONE;
-           currentToken = NUM;
          }
          break;
-       case INID:
-         if (!isalpha(c))
+       case INSPACE:
+         if ((c != ' ') && (c != '\t'))
          { /* backup in the input */
-           ungetNextChar();
+           ungetNextChar(s);
            save = FALSE;
            state = DONE;
-           currentToken = ID;
+           currentToken = NLSP;
          }
          break;
        case DONE:
        default: /* should never happen */
-         fprintf(listing,"Scanner Bug: state= %d\n",state);
+         obPrintf(s->listing,"Scanner Bug: state= %d\n",state);
          state = DONE;
          currentToken = ERROR;
          break;
      }
-     if ((save) && (tokenStringIndex <= MAXTOKENLEN))
-       tokenString[tokenStringIndex++] = (char) c;
+     if ((save) && (tokenStringIndex < MAXTOKENLEN))
+       s->tokenString[tokenStringIndex++] = (char) c;
      if (state == DONE)
-     { tokenString[tokenStringIndex] = '\0';
+     { s->tokenString[tokenStringIndex] = '\0';
        if (currentToken == ID)
-         currentToken = reservedLookup(tokenString);
+         currentToken = reservedLookup(s->tokenString);
      }
    }
-   if (TraceScan) {
-     fprintf(listing,"\t%d: ",lineno);
-     printToken(currentToken,tokenString);
+   if (TraceScan && (currentToken != NLSP)) {
+     obPuts(s->listing,"    ");
+     obPutInt(s->listing,s->lineno);
+     obPuts(s->listing,"\t ");
+     printToken(s->listing,currentToken,s->tokenString);
    }
+   if ((currentToken != NLSP) && (currentToken != ENDFILE)) s->tokens++;
    return currentToken;
 } /* end getToken */
-
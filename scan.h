@@ -11,12 +11,33 @@
 /* MAXTOKENLEN is the maximum size of a token */
 #define MAXTOKENLEN 40
 
-/* tokenString array stores the lexeme of each token */
-extern char tokenString[MAXTOKENLEN+1];
+/* Scanner holds all state of one scanner instance,
+ * so that several sources can be scanned in the
+ * same process, one after another or at once
+ */
+typedef struct
+   { FILE * source; /* source code text file */
+     OutBuf * listing; /* trace output for TraceScan */
+     int lineno; /* source line number of current token */
+     /* tokenString array stores the lexeme of each token */
+     char tokenString[MAXTOKENLEN+1];
+     long tokens; /* tokens returned, but NLSP and ENDFILE */
+     void * state; /* private to the scanner implementation */
+   } Scanner;
+
+/* Function newScanner creates a scanner reading
+ * from source; trace output goes to listing
+ */
+Scanner * newScanner(FILE * source, OutBuf * listing);
+
+/* Procedure freeScanner releases a scanner
+ * (the source file is not closed)
+ */
+void freeScanner(Scanner *);
 
-/* function getToken returns the 
+/* function getToken returns the
  * next token in source file
  */
-TokenType getToken(void);
+TokenType getToken(Scanner *);
 
 #endif
@@ -0,0 +1,81 @@
+/****************************************************/
+/* File: scanbench.c                                */
+/* Measures the throughput of the scanner it is     */
+/* linked with, in tokens per second                */
+/****************************************************/
+
+#include <time.h>
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+
+/* allocate global variables */
+int lineno = 0;
+FILE * source;
+OutBuf * listing;
+OutBuf * code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int MaxErrors = 20;
+
+int Error = FALSE;
+
+static double now(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char * argv[])
+{ char * text;
+  long bytes, tokens = 0;
+  double elapsed, start;
+  int reps, i;
+  FILE * f;
+  if (argc != 4)
+  { fprintf(stderr,"usage: %s <label> <source> <scans>\n",argv[0]);
+    return 1;
+  }
+  reps = atoi(argv[3]);
+  f = fopen(argv[2],"r");
+  if (f == NULL)
+  { fprintf(stderr,"File %s not found\n",argv[2]);
+    return 1;
+  }
+  /* the source is scanned from memory, so that only
+   * the scanner is timed and not the file system */
+  fseek(f,0,SEEK_END);
+  bytes = ftell(f);
+  rewind(f);
+  text = (char *) malloc(bytes+1);
+  if ((text == NULL) || (fread(text,1,bytes,f) != (size_t) bytes))
+  { fprintf(stderr,"cannot read %s\n",argv[2]);
+    return 1;
+  }
+  fclose(f);
+
+  start = now();
+  for (i=0;i<reps;i++)
+  { FILE * src = fmemopen(text,bytes,"r");
+    Scanner * s = newScanner(src,NULL);
+    TokenType t;
+    do t = getToken(s);
+    while ((t != ENDFILE) && (t != CMTERR));
+    tokens = s->tokens;
+    freeScanner(s);
+    fclose(src);
+  }
+  elapsed = now() - start;
+
+  printf("%-10s %10ld tokens %8.3f s %8.2f MB/s %8.2f Mtokens/s\n",
+         argv[1],tokens,elapsed,
+         bytes * (double) reps / elapsed / 1e6,
+         tokens * (double) reps / elapsed / 1e6);
+  free(text);
+  return 0;
+}
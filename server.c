@@ -0,0 +1,171 @@
+/****************************************************/
+/* File: server.c                                   */
+/* Compile-server mode for the TINY compiler:       */
+/* one long-lived process compiles batches of       */
+/* framed requests read from a stream or socket     */
+/****************************************************/
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "globals.h"
+#include "server.h"
+
+/* MAXHEADER is the longest request header line */
+#define MAXHEADER 64
+
+typedef enum {PathReq,TextReq} RequestKind;
+
+/* a request waiting in the current batch */
+typedef struct
+   { int id;
+     RequestKind kind;
+     char * data; /* file path or program text */
+     size_t len;
+   } Request;
+
+/* Function readRequest reads one framed request into r.
+ * It returns 1 for a request, 0 at end of input,
+ * 2 for RUN and -1 for a malformed frame
+ */
+static int readRequest(FILE * in, Request * r)
+{ char header[MAXHEADER];
+  char word[8];
+  unsigned long len;
+  if (fgets(header,MAXHEADER,in) == NULL) return 0;
+  if (strcmp(header,"RUN\n") == 0) return 2;
+  if (sscanf(header,"%7s %lu",word,&len) != 2) return -1;
+  if (strcmp(word,"PATH") == 0) r->kind = PathReq;
+  else if (strcmp(word,"TEXT") == 0) r->kind = TextReq;
+  else return -1;
+  r->data = (char *) malloc(len+1);
+  if (r->data == NULL) return -1;
+  if (fread(r->data,1,len,in) != len)
+  { free(r->data);
+    return -1;
+  }
+  r->data[len] = '\0';
+  r->len = len;
+  return 1;
+}
+
+/* Procedure answer writes the RESULT frame of one request */
+static void answer(FILE * out, int id, int ok, OutBuf * lst, OutBuf * cd)
+{ fprintf(out,"RESULT %d %s %lu %lu\n",id,ok ? "OK" : "ERROR",
+          (unsigned long) lst->len,(unsigned long) cd->len);
+  fwrite(lst->buf,1,lst->len,out);
+  fwrite(cd->buf,1,cd->len,out);
+}
+
+/* Procedure runRequest compiles one request in-process,
+ * collecting listing and code in memory
+ */
+static void runRequest(FILE * out, Request * r)
+{ char name[32];
+  char * pgm;
+  OutBuf * lst = newOutBuf(NULL);
+  OutBuf * cd = newOutBuf(NULL);
+  FILE * src;
+  int ok;
+  if ((lst == NULL) || (cd == NULL))
+  { fprintf(out,"RESULT %d ERROR 0 0\n",r->id);
+    freeOutBuf(lst);
+    freeOutBuf(cd);
+    return;
+  }
+  if (r->kind == PathReq)
+  { pgm = r->data;
+    src = fopen(pgm,"r");
+  }
+  else
+  { sprintf(name,"<request %d>",r->id);
+    pgm = name;
+    src = fmemopen(r->data,r->len,"r");
+  }
+  if (src == NULL)
+  { obPrintf(lst,"File %s not found\n",pgm);
+    ok = FALSE;
+  }
+  else
+  { ok = compileSource(src,pgm,lst,cd) && ! Error;
+    fclose(src);
+  }
+  answer(out,r->id,ok,lst,cd);
+  freeOutBuf(lst);
+  freeOutBuf(cd);
+}
+
+/* Procedure runBatch compiles the pending requests
+ * and flushes their answers with one write
+ */
+static void runBatch(FILE * out, Request * batch, int n)
+{ int i;
+  for (i=0;i<n;i++)
+  { runRequest(out,&batch[i]);
+    free(batch[i].data);
+  }
+  fflush(out);
+}
+
+/* Function serveStream answers the requests read
+ * from in on out until end of input
+ */
+int serveStream(FILE * in, FILE * out)
+{ Request batch[BATCH_MAX];
+  int n = 0, id = 0;
+  int status;
+  while ((status = readRequest(in,&batch[n])) > 0)
+  { if (status == 1)
+    { batch[n++].id = ++id;
+      if (n < BATCH_MAX) continue;
+    }
+    runBatch(out,batch,n);
+    n = 0;
+  }
+  runBatch(out,batch,n);
+  if (status < 0)
+  { /* a bad frame leaves the stream out of sync */
+    fprintf(out,"RESULT %d ERROR 0 0\n",id+1);
+    fflush(out);
+    return 1;
+  }
+  return 0;
+}
+
+/* Function serve listens on the Unix socket at path
+ * and serves its connections one after another
+ */
+int serve(const char * path)
+{ struct sockaddr_un addr;
+  int sock, conn;
+  if (strlen(path) >= sizeof(addr.sun_path))
+  { fprintf(stderr,"Socket path %s too long\n",path);
+    return 1;
+  }
+  sock = socket(AF_UNIX,SOCK_STREAM,0);
+  if (sock < 0)
+  { perror("socket");
+    return 1;
+  }
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path,path);
+  unlink(path);
+  if ((bind(sock,(struct sockaddr *) &addr,sizeof(addr)) < 0) ||
+      (listen(sock,8) < 0))
+  { perror(path);
+    close(sock);
+    return 1;
+  }
+  while ((conn = accept(sock,NULL,NULL)) >= 0)
+  { FILE * in = fdopen(conn,"r");
+    FILE * out = fdopen(dup(conn),"w");
+    if ((in != NULL) && (out != NULL))
+      serveStream(in,out);
+    if (in != NULL) fclose(in); else close(conn);
+    if (out != NULL) fclose(out);
+  }
+  close(sock);
+  unlink(path);
+  return 0;
+}
@@ -0,0 +1,50 @@
+/****************************************************/
+/* File: server.h                                   */
+/* Compile-server interface for the TINY compiler   */
+/****************************************************/
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+/* The compile server keeps one process alive and
+ * compiles every request in-process. Requests are
+ * framed as a header line followed by a payload:
+ *
+ *   PATH <len>\n<len bytes: source file path>
+ *   TEXT <len>\n<len bytes: source program text>
+ *   RUN\n        compile the requests read so far
+ *
+ * Requests are batched: they are compiled when RUN
+ * arrives, when BATCH_MAX requests are pending, or
+ * at end of input. Each request is answered, in
+ * order, with
+ *
+ *   RESULT <id> <OK|ERROR> <listing len> <code len>\n
+ *   <listing bytes><TM code bytes>
+ *
+ * where id counts requests from 1 on each stream.
+ */
+
+/* BATCH_MAX is the largest number of requests
+ * compiled (and answered) as one batch
+ */
+#define BATCH_MAX 64
+
+/* Function compileSource (in main.c) runs the
+ * compiler on src, sending the listing to lst and
+ * TM code to codefp; it returns FALSE if a syntax
+ * error stopped the compilation
+ */
+int compileSource(FILE * src, char * pgm, OutBuf * lst, OutBuf * codefp);
+
+/* Function serveStream answers the requests read
+ * from in on out until end of input
+ */
+int serveStream(FILE * in, FILE * out);
+
+/* Function serve listens on the Unix socket at path
+ * and serves its connections one after another
+ */
+int serve(const char * path);
+
+#endif
@@ -0,0 +1,160 @@
+/****************************************************/
+/* File: stats.c                                    */
+/* Phase timing and counters of the C- compiler    */
+/****************************************************/
+
+#include <time.h>
+#include <sys/resource.h>
+#include "globals.h"
+#include "traverse.h"
+#include "stats.h"
+
+CompileStats * Stats = NULL;
+
+static CompileStats stats;
+
+static const char * phaseName[NPHASES] =
+   { "parse", "symtab", "typecheck", "optimize", "codegen" };
+
+static double clockTime(clockid_t id)
+{ struct timespec ts;
+  clock_gettime(id,&ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Procedure statsBegin turns statistics on and
+ * starts the clock of the whole run
+ */
+void statsBegin(void)
+{ memset(&stats,0,sizeof(stats));
+  stats.wallStart = clockTime(CLOCK_MONOTONIC);
+  stats.cpuStart = clockTime(CLOCK_PROCESS_CPUTIME_ID);
+  Stats = &stats;
+}
+
+/* Procedures phaseStart and phaseEnd bracket one
+ * interval of phase p; the intervals add up
+ */
+void phaseStart(Phase p)
+{ if (Stats == NULL) return;
+  Stats->phase[p].wallStart = clockTime(CLOCK_MONOTONIC);
+  Stats->phase[p].cpuStart = clockTime(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+void phaseEnd(Phase p)
+{ if (Stats == NULL) return;
+  Stats->phase[p].wall += clockTime(CLOCK_MONOTONIC) - Stats->phase[p].wallStart;
+  Stats->phase[p].cpu += clockTime(CLOCK_PROCESS_CPUTIME_ID) - Stats->phase[p].cpuStart;
+}
+
+static int countVisit(TreeNode * t, int depth, void * arg)
+{ (* (long *) arg)++;
+  return TRUE;
+}
+
+/* Function countNodes returns the number of nodes
+ * of the list t and its subtrees
+ */
+long countNodes(TreeNode * t)
+{ long n = 0;
+  TreeVisitor v = { countVisit, NULL, NULL, &n };
+  walkTree(t,&v);
+  return n;
+}
+
+/* rate returns n per second of t, 0 if t is 0 */
+static double rate(double n, double t)
+{ return t > 0 ? n / t : 0.0;
+}
+
+/* Procedure printStats reports the statistics of
+ * program pgm to out, as a table or, if json is
+ * TRUE, as one JSON object
+ */
+void printStats(FILE * out, char * pgm, int json)
+{ CompileStats * s = &stats;
+  SymtabStats * st = &s->symtab;
+  double wall = clockTime(CLOCK_MONOTONIC) - s->wallStart;
+  double cpu = clockTime(CLOCK_PROCESS_CPUTIME_ID) - s->cpuStart;
+  double parse = s->phase[ParsePhase].wall;
+  double load = (double) st->peak / st->buckets;
+  double probes = st->lookups > 0 ? (double) st->probes / st->lookups : 0.0;
+  struct rusage ru;
+  long maxrss = 0;
+  int i;
+  if (getrusage(RUSAGE_SELF,&ru) == 0) maxrss = ru.ru_maxrss;
+  if (json)
+  { fprintf(out,"{\"program\": \"");
+    for (i = 0; pgm[i] != '\0'; i++)
+    { if ((pgm[i] == '"') || (pgm[i] == '\\')) fputc('\\',out);
+      fputc(pgm[i],out);
+    }
+    fprintf(out,"\",\n \"phases\": {");
+    for (i = 0; i < NPHASES; i++)
+      fprintf(out,"%s\n  \"%s\": {\"wall_s\": %.6f, \"cpu_s\": %.6f}",
+              i > 0 ? "," : "",phaseName[i],s->phase[i].wall,s->phase[i].cpu);
+    fprintf(out,",\n  \"total\": {\"wall_s\": %.6f, \"cpu_s\": %.6f}},\n",wall,cpu);
+    fprintf(out," \"source_bytes\": %ld,\n",s->bytes);
+    fprintf(out," \"tokens\": %ld,\n \"tokens_per_s\": %.0f,\n",
+            s->tokens,rate(s->tokens,parse));
+    fprintf(out," \"nodes\": %ld,\n \"node_bytes\": %lu,\n",
+            s->nodes,(unsigned long) (s->nodes * sizeof(TreeNode)));
+    fprintf(out," \"symtab\": {\"buckets\": %d, \"symbols\": %d, \"peak_live\": %d, "
+            "\"load_factor\": %.3f, \"longest_chain\": %d, \"lookups\": %ld, "
+            "\"probes_per_lookup\": %.3f},\n",
+            st->buckets,st->symbols,st->peak,load,st->longest,st->lookups,probes);
+    fprintf(out," \"instructions\": %ld,\n",s->instructions);
+    fprintf(out," \"dead_functions\": %d,\n \"dead_statements\": %ld,\n",
+            s->deadFuncs,s->deadStmts);
+    fprintf(out," \"inlined_calls\": %ld,\n \"tail_calls\": %ld,\n",
+            s->inlined,s->tailCalls);
+    fprintf(out," \"hoisted\": %ld,\n \"strength_reduced\": %ld,\n",
+            s->hoisted,s->reduced);
+    fprintf(out," \"lvn_loads_removed\": %ld,\n \"lvn_loads_copied\": %ld,\n",
+            s->lvnLoads,s->lvnCopies);
+    fprintf(out," \"lvn_stores_removed\": %ld,\n \"lvn_ops_removed\": %ld,\n",
+            s->lvnStores,s->lvnOps);
+    fprintf(out," \"ssa_phis\": %ld,\n \"ssa_folded\": %ld,\n",
+            s->phis,s->folded);
+    fprintf(out," \"ssa_cse\": %ld,\n \"ssa_dead\": %ld,\n",
+            s->cse,s->deadCode);
+    fprintf(out," \"regs_allocated\": %ld,\n \"regs_spilled\": %ld,\n",
+            s->allocated,s->spilled);
+    fprintf(out," \"spills_avoided\": %ld,\n \"spills\": %ld,\n",
+            s->spillsAvoided,s->spills);
+    fprintf(out," \"max_rss_kb\": %ld}\n",maxrss);
+    return;
+  }
+  fprintf(out,"stats: %s\n",pgm);
+  fprintf(out,"  %-12s %10s %10s\n","phase","wall ms","cpu ms");
+  for (i = 0; i < NPHASES; i++)
+    fprintf(out,"  %-12s %10.3f %10.3f\n",phaseName[i],
+            s->phase[i].wall * 1e3,s->phase[i].cpu * 1e3);
+  fprintf(out,"  %-12s %10.3f %10.3f\n","total",wall * 1e3,cpu * 1e3);
+  fprintf(out,"  source       %ld bytes\n",s->bytes);
+  fprintf(out,"  tokens       %ld (%.0f per s)\n",s->tokens,rate(s->tokens,parse));
+  fprintf(out,"  nodes        %ld (%lu bytes)\n",s->nodes,
+          (unsigned long) (s->nodes * sizeof(TreeNode)));
+  fprintf(out,"  symbols      %d, at most %d live in %d buckets (load %.3f)\n",
+          st->symbols,st->peak,st->buckets,load);
+  fprintf(out,"  chains       longest %d, %.3f names compared per lookup (%ld lookups)\n",
+          st->longest,probes,st->lookups);
+  fprintf(out,"  instructions %ld\n",s->instructions);
+  fprintf(out,"  dead code    %d functions, %ld statements left out\n",
+          s->deadFuncs,s->deadStmts);
+  fprintf(out,"  inlined      %ld calls\n",s->inlined);
+  fprintf(out,"  tail calls   %ld made jumps\n",s->tailCalls);
+  fprintf(out,"  loops        %ld invariants hoisted, %ld products reduced\n",
+          s->hoisted,s->reduced);
+  fprintf(out,"  redundant    %ld loads, %ld stores, %ld operations removed;"
+          " %ld loads made copies\n",
+          s->lvnLoads,s->lvnStores,s->lvnOps,s->lvnCopies);
+  fprintf(out,"  ssa          %ld phis, %ld constants folded, %ld common"
+          " subexpressions, %ld dead instructions\n",
+          s->phis,s->folded,s->cse,s->deadCode);
+  fprintf(out,"  registers    %ld values in registers, %ld in memory\n",
+          s->allocated,s->spilled);
+  fprintf(out,"  operands     %ld kept off the stack, %ld pushed\n",
+          s->spillsAvoided,s->spills);
+  fprintf(out,"  max rss      %ld KB\n",maxrss);
+}
@@ -0,0 +1,82 @@
+/****************************************************/
+/* File: stats.h                                    */
+/* Phase timing and counters of the C- compiler,   */
+/* reported by the -stats option                    */
+/****************************************************/
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include "symtab.h"
+
+/* Phase names the timed parts of a compilation */
+typedef enum
+   {ParsePhase, /* scanning and parsing, or reading a tree file */
+    SymtabPhase, /* building the symbol table */
+    CheckPhase, /* type checking */
+    OptPhase, /* optimizations of the syntax tree */
+    CodePhase, /* code generation and output */
+    NPHASES} Phase;
+
+typedef struct
+   { double wall, cpu; /* seconds spent in the phase */
+     double wallStart, cpuStart; /* of the open interval */
+   } PhaseTime;
+
+/* CompileStats collects the figures of one run */
+typedef struct
+   { PhaseTime phase[NPHASES];
+     double wallStart, cpuStart; /* of the whole run */
+     long bytes; /* source text read */
+     long tokens; /* tokens of the program */
+     long nodes; /* syntax tree nodes */
+     long instructions; /* TM instructions written */
+     int deadFuncs; /* functions left out, see opt.c */
+     long deadStmts; /* statements after a return dropped */
+     long inlined; /* calls replaced by the function body */
+     long tailCalls; /* self tail calls made jumps, see ir.c */
+     long hoisted; /* loop invariants computed before the loop */
+     long reduced; /* products of induction variables made adds */
+     long lvnLoads; /* redundant loads removed, see lvn.c */
+     long lvnCopies; /* loads made register copies */
+     long lvnStores; /* stores of the value already stored */
+     long lvnOps; /* operations whose result was in place */
+     long phis; /* phis placed by the SSA construction, see ir.c */
+     long folded; /* IR operations on constants folded, see irpass.c */
+     long cse; /* IR operations found computed before */
+     long deadCode; /* IR instructions whose value is not used */
+     long allocated; /* IR values given registers, see irgen.c */
+     long spilled; /* IR values left in memory */
+     long spillsAvoided; /* operands kept off the stack, see cgen.c */
+     long spills; /* operands pushed on the stack */
+     SymtabStats symtab;
+   } CompileStats;
+
+/* Stats is NULL unless statistics are wanted; the
+ * counting sites test it, so they cost nothing else
+ */
+extern CompileStats * Stats;
+
+/* Procedure statsBegin turns statistics on and
+ * starts the clock of the whole run
+ */
+void statsBegin(void);
+
+/* Procedures phaseStart and phaseEnd bracket one
+ * interval of phase p; the intervals add up
+ */
+void phaseStart(Phase p);
+void phaseEnd(Phase p);
+
+/* Function countNodes returns the number of nodes
+ * of the list t and its subtrees
+ */
+long countNodes(TreeNode * t);
+
+/* Procedure printStats reports the statistics of
+ * program pgm to out, as a table or, if json is
+ * TRUE, as one JSON object
+ */
+void printStats(FILE * out, char * pgm, int json);
+
+#endif
@@ -1,16 +1,14 @@
 /****************************************************/
 /* File: symtab.c                                   */
-/* Symbol table implementation for the TINY compiler*/
-/* (allows only one symbol table)                   */
+/* Symbol table implementation for the C- compiler  */
+/* (one table of nested scopes)                     */
 /* Symbol table is implemented as a chained         */
 /* hash table                                       */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
+#include "globals.h"
 #include "symtab.h"
 
 /* SIZE is the size of the hash table */
@@ -31,92 +29,186 @@ static int hash ( char * key )
   return temp;
 }
 
-/* the list of line numbers of the source 
- * code in which a variable is referenced
+/* the hash table; a name declared in an inner
+ * scope comes before the outer declarations of
+ * the same bucket, so lookups find it first
  */
-typedef struct LineListRec
-   { int lineno;
-     struct LineListRec * next;
-   } * LineList;
-
-/* The record in the bucket lists for
- * each variable, including name, 
- * assigned memory location, and
- * the list of line numbers in which
- * it appears in the source code
+static Symbol * hashTable[SIZE];
+
+/* scopes[i] lists the symbols of scope depth i,
+ * last declared first
+ */
+static Symbol ** scopes = NULL;
+static int scopeTop = -1; /* innermost scope */
+static int scopeSize = 0;
+
+/* every symbol ever inserted, for st_reset */
+static Symbol * allSymbols = NULL;
+
+/* chain[h] is the length of bucket h; the rest
+ * of the counters of st_stats are kept in stats
  */
-typedef struct BucketListRec
-   { char * name;
-     LineList lines;
-     int memloc ; /* memory location for variable */
-     struct BucketListRec * next;
-   } * BucketList;
-
-/* the hash table */
-static BucketList hashTable[SIZE];
-
-/* Procedure st_insert inserts line numbers and
- * memory locations into the symbol table
- * loc = memory location is inserted only the
- * first time, otherwise ignored
+static int chain[SIZE];
+static SymtabStats stats = { SIZE };
+
+/* Procedure st_enterScope opens a new innermost
+ * scope; st_exitScope closes it again
  */
-void st_insert( char * name, int lineno, int loc )
+void st_enterScope(void)
+{ if (scopeTop+1 == scopeSize)
+  { int size = scopeSize ? 2*scopeSize : 16;
+    Symbol ** bigger = (Symbol **) realloc(scopes,size * sizeof(Symbol *));
+    if (bigger == NULL)
+    { obPuts(listing,"Out of memory error in symbol table\n");
+      Error = TRUE;
+      return;
+    }
+    scopes = bigger;
+    scopeSize = size;
+  }
+  scopes[++scopeTop] = NULL;
+}
+
+void st_exitScope(void)
+{ Symbol * s;
+  if (scopeTop < 0) return;
+  /* the symbols of the innermost scope head their
+     buckets, latest first */
+  for (s = scopes[scopeTop]; s != NULL; s = s->scopeNext)
+  { int h = hash(s->name);
+    hashTable[h] = s->next;
+    chain[h]--;
+    stats.live--;
+  }
+  scopeTop--;
+}
+
+/* Function st_insert declares name in the innermost
+ * scope and returns its symbol, or NULL if the
+ * name is already declared in that scope
+ */
+Symbol * st_insert( char * name, int lineno, SymKind kind, int loc )
 { int h = hash(name);
-  BucketList l =  hashTable[h];
-  while ((l != NULL) && (strcmp(name,l->name) != 0))
+  Symbol * l = hashTable[h];
+  while ((l != NULL) && (l->level == scopeTop))
+  { if (strcmp(name,l->name) == 0) return NULL;
     l = l->next;
-  if (l == NULL) /* variable not yet in table */
-  { l = (BucketList) malloc(sizeof(struct BucketListRec));
-    l->name = name;
-    l->lines = (LineList) malloc(sizeof(struct LineListRec));
-    l->lines->lineno = lineno;
-    l->memloc = loc;
-    l->lines->next = NULL;
-    l->next = hashTable[h];
-    hashTable[h] = l; }
-  else /* found in table, so just add line number */
-  { LineList t = l->lines;
-    while (t->next != NULL) t = t->next;
-    t->next = (LineList) malloc(sizeof(struct LineListRec));
-    t->next->lineno = lineno;
-    t->next->next = NULL;
   }
+  l = (Symbol *) malloc(sizeof(Symbol));
+  if (l == NULL)
+  { obPuts(listing,"Out of memory error in symbol table\n");
+    Error = TRUE;
+    return NULL;
+  }
+  l->name = name;
+  l->kind = kind;
+  l->level = scopeTop;
+  l->loc = loc;
+  l->size = 0;
+  l->frame = 0;
+  l->dead = FALSE;
+  l->inlinable = FALSE;
+  l->var = -1;
+  l->type = Integer;
+  l->decl = NULL;
+  l->lines = NULL;
+  st_addLine(l,lineno);
+  l->next = hashTable[h];
+  hashTable[h] = l;
+  l->scopeNext = scopes[scopeTop];
+  scopes[scopeTop] = l;
+  l->allNext = allSymbols;
+  allSymbols = l;
+  stats.symbols++;
+  if (++stats.live > stats.peak) stats.peak = stats.live;
+  if (++chain[h] > stats.longest) stats.longest = chain[h];
+  return l;
 } /* st_insert */
 
-/* Function st_lookup returns the memory 
- * location of a variable or -1 if not found
+/* Function st_lookup returns the innermost
+ * symbol for name, or NULL if not found
  */
-int st_lookup ( char * name )
+Symbol * st_lookup ( char * name )
 { int h = hash(name);
-  BucketList l =  hashTable[h];
+  Symbol * l =  hashTable[h];
+  stats.lookups++;
   while ((l != NULL) && (strcmp(name,l->name) != 0))
+  { stats.probes++;
     l = l->next;
-  if (l == NULL) return -1;
-  else return l->memloc;
+  }
+  if (l != NULL) stats.probes++;
+  return l;
 }
 
-/* Procedure printSymTab prints a formatted 
- * listing of the symbol table contents 
- * to the listing file
+/* Procedure st_addLine records a reference to
+ * symbol s at lineno
  */
-void printSymTab(FILE * listing)
+void st_addLine( Symbol * s, int lineno )
+{ LineList t = (LineList) malloc(sizeof(struct LineListRec));
+  if (t == NULL) return;
+  t->lineno = lineno;
+  t->next = NULL;
+  if (s->lines == NULL) s->lines = t;
+  else s->lastLine->next = t;
+  s->lastLine = t;
+}
+
+/* Procedure st_reset empties the symbol table
+ * so that another program can be analyzed;
+ * it leaves one (global) scope open
+ */
+void st_reset(void)
 { int i;
-  fprintf(listing,"Variable Name  Location   Line Numbers\n");
-  fprintf(listing,"-------------  --------   ------------\n");
+  while (allSymbols != NULL)
+  { Symbol * next = allSymbols->allNext;
+    LineList t = allSymbols->lines;
+    while (t != NULL)
+    { LineList tnext = t->next;
+      free(t);
+      t = tnext;
+    }
+    free(allSymbols);
+    allSymbols = next;
+  }
   for (i=0;i<SIZE;++i)
-  { if (hashTable[i] != NULL)
-    { BucketList l = hashTable[i];
-      while (l != NULL)
-      { LineList t = l->lines;
-        fprintf(listing,"%-14s ",l->name);
-        fprintf(listing,"%-8d  ",l->memloc);
-        while (t != NULL)
-        { fprintf(listing,"%4d ",t->lineno);
-          t = t->next;
-        }
-        fprintf(listing,"\n");
-        l = l->next;
-      }
+  { hashTable[i] = NULL;
+    chain[i] = 0;
+  }
+  memset(&stats,0,sizeof(stats));
+  stats.buckets = SIZE;
+  scopeTop = -1;
+  st_enterScope();
+} /* st_reset */
+
+/* Procedure st_stats fills in *s */
+void st_stats(SymtabStats * s)
+{ *s = stats;
+}
+
+static const char * kindName[] =
+   { "var", "array", "array param", "function" };
+
+/* Procedure printSymTab prints a formatted
+ * listing of the symbols of the innermost
+ * scope to the listing file
+ */
+void printSymTab(OutBuf * listing)
+{ Symbol * l;
+  obPuts(listing,"Name           Kind         Location   Line Numbers\n");
+  obPuts(listing,"-------------  -----------  --------   ------------\n");
+  for (l = scopes[scopeTop]; l != NULL; l = l->scopeNext)
+  { LineList t = l->lines;
+    obPutsW(listing,l->name,-14);
+    obPutc(listing,' ');
+    obPutsW(listing,kindName[l->kind],-12);
+    obPutc(listing,' ');
+    obPutIntW(listing,l->loc,-8);
+    obPuts(listing,"  ");
+    while (t != NULL)
+    { obPutIntW(listing,t->lineno,4);
+      obPutc(listing,' ');
+      t = t->next;
     }
+    obPutc(listing,'\n');
   }
 } /* printSymTab */
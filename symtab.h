@@ -1,7 +1,7 @@
 /****************************************************/
 /* File: symtab.h                                   */
-/* Symbol table interface for the TINY compiler     */
-/* (allows only one symbol table)                   */
+/* Symbol table interface for the C- compiler       */
+/* (one table of nested scopes)                     */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -9,22 +9,90 @@
 #ifndef _SYMTAB_H_
 #define _SYMTAB_H_
 
-/* Procedure st_insert inserts line numbers and
- * memory locations into the symbol table
- * loc = memory location is inserted only the
- * first time, otherwise ignored
+/* SymKind tells what a declared name denotes */
+typedef enum {VarSym,ArraySym,ArrayParamSym,FuncSym} SymKind;
+
+/* the list of line numbers of the source
+ * code in which a name is referenced
+ */
+typedef struct LineListRec
+   { int lineno;
+     struct LineListRec * next;
+   } * LineList;
+
+/* Symbol describes one declared name. Symbols
+ * outlive their scope, since the syntax tree
+ * points to them until the next st_reset
+ */
+typedef struct symbol
+   { char * name;
+     SymKind kind;
+     int level; /* scope depth; 0 is the global scope */
+     int loc; /* variables: address (global, from gp) or
+                 offset (local, from fp); arrays: of
+                 element 0; array params: of the address */
+     int size; /* ArraySym: elements; FuncSym: params */
+     int frame; /* FuncSym: frame slots, see analyze.c */
+     int dead; /* FuncSym: not called from main, see opt.c */
+     int inlinable; /* FuncSym: see opt.c */
+     int var; /* local scalars: IR variable, see ir.c */
+     ExpType type; /* FuncSym: return type */
+     TreeNode * decl; /* declaring node, NULL if built in */
+     LineList lines;
+     LineList lastLine; /* end of lines, for st_addLine */
+     struct symbol * next; /* in the hash bucket */
+     struct symbol * scopeNext; /* in the same scope */
+     struct symbol * allNext; /* in the whole table */
+   } Symbol;
+
+/* Procedure st_enterScope opens a new innermost
+ * scope; st_exitScope closes it again
+ */
+void st_enterScope(void);
+void st_exitScope(void);
+
+/* Function st_insert declares name in the innermost
+ * scope and returns its symbol, or NULL if the
+ * name is already declared in that scope
  */
-void st_insert( char * name, int lineno, int loc );
+Symbol * st_insert( char * name, int lineno, SymKind kind, int loc );
 
-/* Function st_lookup returns the memory 
- * location of a variable or -1 if not found
+/* Function st_lookup returns the innermost
+ * symbol for name, or NULL if not found
  */
-int st_lookup ( char * name );
+Symbol * st_lookup ( char * name );
+
+/* Procedure st_addLine records a reference to
+ * symbol s at lineno
+ */
+void st_addLine( Symbol * s, int lineno );
+
+/* Procedure st_reset empties the symbol table
+ * so that another program can be analyzed;
+ * it leaves one (global) scope open
+ */
+void st_reset(void);
+
+/* SymtabStats describes the use of the table since
+ * the last st_reset, for the -stats report
+ */
+typedef struct
+   { int buckets; /* hash table size */
+     int symbols; /* symbols inserted */
+     int live; /* symbols in open scopes now */
+     int peak; /* most symbols in open scopes at once */
+     int longest; /* longest bucket chain seen */
+     long lookups; /* calls of st_lookup */
+     long probes; /* names compared by st_lookup */
+   } SymtabStats;
+
+/* Procedure st_stats fills in *s */
+void st_stats(SymtabStats * s);
 
-/* Procedure printSymTab prints a formatted 
- * listing of the symbol table contents 
- * to the listing file
+/* Procedure printSymTab prints a formatted
+ * listing of the symbols of the innermost
+ * scope to the listing file
  */
-void printSymTab(FILE * listing);
+void printSymTab(OutBuf * listing);
 
 #endif
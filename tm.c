@@ -9,6 +9,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "outbuf.h"
 
 #ifndef TRUE
 #define TRUE 1
@@ -18,8 +21,14 @@
 #endif
 
 /******* const *******/
-#define   IADDR_SIZE  1024 /* increase for large programs */
-#define   DADDR_SIZE  1024 /* increase for large programs */
+/* increase for large programs, e.g. with
+   -DIADDR_SIZE=1048576 -DDADDR_SIZE=1048576 */
+#ifndef IADDR_SIZE
+#define   IADDR_SIZE  1024
+#endif
+#ifndef DADDR_SIZE
+#define   DADDR_SIZE  1024
+#endif
 #define   NO_REGS 8
 #define   PC_REG  7
 
@@ -67,7 +76,8 @@ typedef enum {
    srHALT,
    srIMEM_ERR,
    srDMEM_ERR,
-   srZERODIVIDE
+   srZERODIVIDE,
+   srIN_EOF      /* IN found no more input */
    } STEPRESULT;
 
 typedef struct {
@@ -77,15 +87,84 @@ typedef struct {
       int iarg3  ;
    } INSTRUCTION;
 
+/* The verifier of verifyProgram divides iMem into
+   basic blocks; go runs a block without the checks
+   of stepTM when its guards hold on entry */
+typedef struct {
+      int size ;    /* instructions, 0 if the location
+                       does not start a block */
+      int guard ;   /* first guard in guardTab */
+      int nguards ;
+      int exitsOk ; /* the block can only go on to a
+                       location in iMem */
+   } BLOCK;
+
+/* a guard: the block is safe if lo <= reg[r] <= hi */
+typedef struct {
+      int r ;
+      int lo, hi ;
+   } GUARD;
+
+/* PROGRAM is a loaded and verified program; it is
+   only read while it runs, so any number of
+   machines can share it */
+typedef struct {
+      INSTRUCTION * iMem ; /* IADDR_SIZE locations */
+      int iSize ;          /* locations up to the last one loaded */
+      BLOCK * blockTab ;   /* by location */
+      char * checkTab ;    /* the LD or ST at a location
+                              must check its address */
+      GUARD * guardTab ;
+      int guardCount, guardSize ;
+      char written[NO_REGS] ; /* some instruction sets the
+                                 register; the others must
+                                 stay 0, see verifyProgram */
+   } PROGRAM;
+
+/* SCANNER holds a line being read: the program
+   text, a command or the value of an IN */
+typedef struct {
+      char line[LINESIZE] ;
+      int len ;
+      int col ;
+      int num ;
+      char word[WORDSIZE] ;
+      char ch ;
+   } SCANNER;
+
+/* MACHINE is the state of one TM running a
+   program; machines share nothing else, so each
+   can run in its own thread */
+typedef struct {
+      PROGRAM * prog ;
+      int reg [NO_REGS] ;
+      int * dMem ;        /* DADDR_SIZE words */
+      long memcnt ;       /* LD and ST executed by the last go */
+      long stepTotal ;    /* instructions executed since the
+                             last clear, kept by checkpoints */
+      /* go stops before location stopLoc is executed
+         for the stopHits'th time (f command); -1: no
+         stop */
+      int stopLoc, stopHits ;
+      /* with -checkpoint, go writes a checkpoint to
+         savePath every saveEvery instructions */
+      char * savePath ;
+      long saveEvery, nextSave ;
+      OutBuf * out ;      /* trace and OUT output */
+      FILE * in ;         /* IN values, one per line */
+      int prompt ;        /* ask for IN values on stdout */
+      SCANNER inLine ;    /* the last IN value read */
+   } MACHINE;
+
 /******** vars ********/
+/* the state of the interactive commands */
 int iloc = 0 ;
 int dloc = 0 ;
 int traceflag = FALSE;
 int icountflag = FALSE;
-
-INSTRUCTION iMem [IADDR_SIZE];
-int dMem [DADDR_SIZE];
-int reg [NO_REGS];
+int done  ;
+SCANNER cmdLine ;
+char fileName[LINESIZE] ;
 
 char * opCodeTab[]
         = {"HALT","IN","OUT","ADD","SUB","MUL","DIV","????",
@@ -97,20 +176,9 @@ char * opCodeTab[]
 
 char * stepResultTab[]
         = {"OK","Halted","Instruction Memory Fault",
-           "Data Memory Fault","Division by 0"
+           "Data Memory Fault","Division by 0","End of input"
           };
 
-char pgmName[20];
-FILE *pgm  ;
-
-char in_Line[LINESIZE] ;
-int lineLen ;
-int inCol  ;
-int num  ;
-char word[WORDSIZE] ;
-char ch  ;
-int done  ;
-
 /********************************************/
 int opClass( int c )
 { if      ( c <= opRRLim) return ( opclRR );
@@ -119,94 +187,135 @@ int opClass( int c )
 } /* opClass */
 
 /********************************************/
-void writeInstruction ( int loc )
-{ printf( "%5d: ", loc) ;
+void writeInstruction ( MACHINE * tm, int loc )
+{ INSTRUCTION * iMem = tm->prog->iMem ;
+  OutBuf * out = tm->out ;
+  obPutIntW(out, loc, 5) ;
+  obPuts(out, ": ") ;
   if ( (loc >= 0) && (loc < IADDR_SIZE) )
-  { printf("%6s%3d,", opCodeTab[iMem[loc].iop], iMem[loc].iarg1);
+  { obPutsW(out, opCodeTab[iMem[loc].iop], 6);
+    obPutIntW(out, iMem[loc].iarg1, 3);
+    obPutc(out, ',');
     switch ( opClass(iMem[loc].iop) )
-    { case opclRR: printf("%1d,%1d", iMem[loc].iarg2, iMem[loc].iarg3);
+    { case opclRR: obPutInt(out, iMem[loc].iarg2);
+                   obPutc(out, ',');
+                   obPutInt(out, iMem[loc].iarg3);
                    break;
       case opclRM:
-      case opclRA: printf("%3d(%1d)", iMem[loc].iarg2, iMem[loc].iarg3);
+      case opclRA: obPutIntW(out, iMem[loc].iarg2, 3);
+                   obPutc(out, '(');
+                   obPutInt(out, iMem[loc].iarg3);
+                   obPutc(out, ')');
                    break;
     }
-    printf ("\n") ;
   }
+  obPutc(out, '\n') ;
 } /* writeInstruction */
 
 /********************************************/
-void getCh (void)
-{ if (++inCol < lineLen)
-  ch = in_Line[inCol] ;
-  else ch = ' ' ;
+/* readLine reads the next line of f into sc; it
+   returns FALSE at the end of f */
+int readLine ( SCANNER * sc, FILE * f )
+{ if (fgets(sc->line, LINESIZE-2, f) == NULL)
+  { sc->line[0] = '\0' ;
+    sc->len = sc->col = 0 ;
+    return FALSE ;
+  }
+  sc->len = strlen(sc->line) ;
+  if ((sc->len > 0) && (sc->line[sc->len-1] == '\n'))
+    sc->line[--sc->len] = '\0' ;
+  sc->col = 0 ;
+  return TRUE ;
+} /* readLine */
+
+/********************************************/
+void getCh (SCANNER * sc)
+{ if (++sc->col < sc->len)
+  sc->ch = sc->line[sc->col] ;
+  else sc->ch = ' ' ;
 } /* getCh */
 
 /********************************************/
-int nonBlank (void)
-{ while ((inCol < lineLen)
-         && (in_Line[inCol] == ' ') )
-    inCol++ ;
-  if (inCol < lineLen)
-  { ch = in_Line[inCol] ;
+int nonBlank (SCANNER * sc)
+{ while ((sc->col < sc->len)
+         && (sc->line[sc->col] == ' ') )
+    sc->col++ ;
+  if (sc->col < sc->len)
+  { sc->ch = sc->line[sc->col] ;
     return TRUE ; }
   else
-  { ch = ' ' ;
+  { sc->ch = ' ' ;
     return FALSE ; }
 } /* nonBlank */
 
 /********************************************/
-int getNum (void)
+int getNum (SCANNER * sc)
 { int sign;
   int term;
   int temp = FALSE;
-  num = 0 ;
+  sc->num = 0 ;
   do
   { sign = 1;
-    while ( nonBlank() && ((ch == '+') || (ch == '-')) )
+    while ( nonBlank(sc) && ((sc->ch == '+') || (sc->ch == '-')) )
     { temp = FALSE ;
-      if (ch == '-')  sign = - sign ;
-      getCh();
+      if (sc->ch == '-')  sign = - sign ;
+      getCh(sc);
     }
     term = 0 ;
-    nonBlank();
-    while (isdigit(ch))
+    nonBlank(sc);
+    while (isdigit(sc->ch))
     { temp = TRUE ;
-      term = term * 10 + ( ch - '0' ) ;
-      getCh();
+      term = term * 10 + ( sc->ch - '0' ) ;
+      getCh(sc);
     }
-    num = num + (term * sign) ;
-  } while ( (nonBlank()) && ((ch == '+') || (ch == '-')) ) ;
+    sc->num = sc->num + (term * sign) ;
+  } while ( (nonBlank(sc)) && ((sc->ch == '+') || (sc->ch == '-')) ) ;
   return temp;
 } /* getNum */
 
 /********************************************/
-int getWord (void)
+int getWord (SCANNER * sc)
 { int temp = FALSE;
   int length = 0;
-  if (nonBlank ())
-  { while (isalnum(ch))
-    { if (length < WORDSIZE-1) word [length++] =  ch ;
-      getCh() ;
+  if (nonBlank (sc))
+  { while (isalnum(sc->ch))
+    { if (length < WORDSIZE-1) sc->word [length++] =  sc->ch ;
+      getCh(sc) ;
     }
-    word[length] = '\0';
+    sc->word[length] = '\0';
     temp = (length != 0);
   }
   return temp;
 } /* getWord */
 
 /********************************************/
-int skipCh ( char c  )
+/* getName reads the next word of the line, up to
+   a blank, into name; it returns FALSE if there
+   is none */
+int getName ( SCANNER * sc, char * name, int size )
+{ int length = 0;
+  if (! nonBlank (sc)) return FALSE;
+  while ((sc->col < sc->len) && (sc->line[sc->col] != ' '))
+  { if (length < size-1) name[length++] = sc->line[sc->col];
+    sc->col++;
+  }
+  name[length] = '\0';
+  return TRUE;
+} /* getName */
+
+/********************************************/
+int skipCh ( SCANNER * sc, char c  )
 { int temp = FALSE;
-  if ( nonBlank() && (ch == c) )
-  { getCh();
+  if ( nonBlank(sc) && (sc->ch == c) )
+  { getCh(sc);
     temp = TRUE;
   }
   return temp;
 } /* skipCh */
 
 /********************************************/
-int atEOL(void)
-{ return ( ! nonBlank ());
+int atEOL(SCANNER * sc)
+{ return ( ! nonBlank (sc));
 } /* atEOL */
 
 /********************************************/
@@ -218,103 +327,99 @@ int error( char * msg, int lineNo, int instNo)
 } /* error */
 
 /********************************************/
-int readInstructions (void)
+/* freeProgram releases a program */
+void freeProgram ( PROGRAM * p )
+{ if (p == NULL) return ;
+  free(p->iMem) ;
+  free(p->blockTab) ;
+  free(p->checkTab) ;
+  free(p->guardTab) ;
+  free(p) ;
+} /* freeProgram */
+
+/********************************************/
+/* readInstructions reads program file pgm into p */
+int readInstructions ( PROGRAM * p, FILE * pgm )
 { OPCODE op;
   int arg1, arg2, arg3;
-  int loc, regNo, lineNo;
-  for (regNo = 0 ; regNo < NO_REGS ; regNo++)
-      reg[regNo] = 0 ;
-  dMem[0] = DADDR_SIZE - 1 ;
-  for (loc = 1 ; loc < DADDR_SIZE ; loc++)
-      dMem[loc] = 0 ;
-  for (loc = 0 ; loc < IADDR_SIZE ; loc++)
-  { iMem[loc].iop = opHALT ;
-    iMem[loc].iarg1 = 0 ;
-    iMem[loc].iarg2 = 0 ;
-    iMem[loc].iarg3 = 0 ;
-  }
+  int loc, lineNo;
+  SCANNER sc;
   lineNo = 0 ;
-  while (! feof(pgm))
-  { fgets( in_Line, LINESIZE-2, pgm  ) ;
-    inCol = 0 ; 
-    lineNo++;
-    lineLen = strlen(in_Line)-1 ;
-    if (in_Line[lineLen]=='\n') in_Line[lineLen] = '\0' ;
-    else in_Line[++lineLen] = '\0';
-    if ( (nonBlank()) && (in_Line[inCol] != '*') )
-    { if (! getNum())
+  while (readLine(&sc, pgm))
+  { lineNo++;
+    if ( (nonBlank(&sc)) && (sc.line[sc.col] != '*') )
+    { if (! getNum(&sc))
         return error("Bad location", lineNo,-1);
-      loc = num;
-      if (loc > IADDR_SIZE)
+      loc = sc.num;
+      if ((loc < 0) || (loc >= IADDR_SIZE))
         return error("Location too large",lineNo,loc);
-      if (! skipCh(':'))
+      if (loc >= p->iSize) p->iSize = loc + 1;
+      if (! skipCh(&sc,':'))
         return error("Missing colon", lineNo,loc);
-      if (! getWord ())
+      if (! getWord (&sc))
         return error("Missing opcode", lineNo,loc);
       op = opHALT ;
       while ((op < opRALim)
-             && (strncmp(opCodeTab[op], word, 4) != 0) )
+             && (strncmp(opCodeTab[op], sc.word, 4) != 0) )
           op++ ;
-      if (strncmp(opCodeTab[op], word, 4) != 0)
+      if (strncmp(opCodeTab[op], sc.word, 4) != 0)
           return error("Illegal opcode", lineNo,loc);
       switch ( opClass(op) )
       { case opclRR :
         /***********************************/
-        if ( (! getNum ()) || (num < 0) || (num >= NO_REGS) )
+        if ( (! getNum (&sc)) || (sc.num < 0) || (sc.num >= NO_REGS) )
             return error("Bad first register", lineNo,loc);
-        arg1 = num;
-        if ( ! skipCh(','))
+        arg1 = sc.num;
+        if ( ! skipCh(&sc,','))
             return error("Missing comma", lineNo, loc);
-        if ( (! getNum ()) || (num < 0) || (num >= NO_REGS) )
+        if ( (! getNum (&sc)) || (sc.num < 0) || (sc.num >= NO_REGS) )
             return error("Bad second register", lineNo, loc);
-        arg2 = num;
-        if ( ! skipCh(',')) 
+        arg2 = sc.num;
+        if ( ! skipCh(&sc,','))
             return error("Missing comma", lineNo,loc);
-        if ( (! getNum ()) || (num < 0) || (num >= NO_REGS) )
+        if ( (! getNum (&sc)) || (sc.num < 0) || (sc.num >= NO_REGS) )
             return error("Bad third register", lineNo,loc);
-        arg3 = num;
+        arg3 = sc.num;
         break;
 
         case opclRM :
         case opclRA :
         /***********************************/
-        if ( (! getNum ()) || (num < 0) || (num >= NO_REGS) )
+        if ( (! getNum (&sc)) || (sc.num < 0) || (sc.num >= NO_REGS) )
             return error("Bad first register", lineNo,loc);
-        arg1 = num;
-        if ( ! skipCh(','))
+        arg1 = sc.num;
+        if ( ! skipCh(&sc,','))
             return error("Missing comma", lineNo,loc);
-        if (! getNum ())
+        if (! getNum (&sc))
             return error("Bad displacement", lineNo,loc);
-        arg2 = num;
-        if ( ! skipCh('(') && ! skipCh(',') )
+        arg2 = sc.num;
+        if ( ! skipCh(&sc,'(') && ! skipCh(&sc,',') )
             return error("Missing LParen", lineNo,loc);
-        if ( (! getNum ()) || (num < 0) || (num >= NO_REGS))
+        if ( (! getNum (&sc)) || (sc.num < 0) || (sc.num >= NO_REGS))
             return error("Bad second register", lineNo,loc);
-        arg3 = num;
+        arg3 = sc.num;
         break;
         }
-      iMem[loc].iop = op;
-      iMem[loc].iarg1 = arg1;
-      iMem[loc].iarg2 = arg2;
-      iMem[loc].iarg3 = arg3;
+      p->iMem[loc].iop = op;
+      p->iMem[loc].iarg1 = arg1;
+      p->iMem[loc].iarg2 = arg2;
+      p->iMem[loc].iarg3 = arg3;
     }
   }
   return TRUE;
 } /* readInstructions */
 
-
 /********************************************/
-STEPRESULT stepTM (void)
+/* execute runs one instruction whose location is
+   in iMem and, for LD and ST, whose address is in
+   dMem; reg[PC_REG] is already the next location */
+STEPRESULT execute ( MACHINE * tm, INSTRUCTION * ip )
 { INSTRUCTION currentinstruction  ;
-  int pc  ;
+  int * reg = tm->reg ;
   int r,s,t,m  ;
   int ok ;
 
-  pc = reg[PC_REG] ;
-  if ( (pc < 0) || (pc > IADDR_SIZE)  )
-      return srIMEM_ERR ;
-  reg[PC_REG] = pc + 1 ;
-  currentinstruction = iMem[ pc ] ;
+  currentinstruction = *ip ;
   switch (opClass(currentinstruction.iop) )
   { case opclRR :
     /***********************************/
@@ -328,8 +433,6 @@ STEPRESULT stepTM (void)
       r = currentinstruction.iarg1 ;
       s = currentinstruction.iarg3 ;
       m = currentinstruction.iarg2 + reg[s] ;
-      if ( (m < 0) || (m > DADDR_SIZE))
-         return srDMEM_ERR ;
       break;
 
     case opclRA :
@@ -344,28 +447,33 @@ STEPRESULT stepTM (void)
   { /* RR instructions */
     case opHALT :
     /***********************************/
-      printf("HALT: %1d,%1d,%1d\n",r,s,t);
+      obPrintf(tm->out,"HALT: %1d,%1d,%1d\n",r,s,t);
       return srHALT ;
       /* break; */
 
     case opIN :
     /***********************************/
+      if (tm->prompt) obFlush(tm->out);
       do
-      { printf("Enter value for IN instruction: ") ;
-        fflush (stdin);
-        fflush (stdout);
-        gets(in_Line);
-        lineLen = strlen(in_Line) ;
-        inCol = 0;
-        ok = getNum();
-        if ( ! ok ) printf ("Illegal value\n");
-        else reg[r] = num;
+      { if (tm->prompt)
+        { printf("Enter value for IN instruction: ") ;
+          fflush (stdout);
+        }
+        if (! readLine(&tm->inLine, tm->in)) return srIN_EOF ;
+        ok = getNum(&tm->inLine);
+        if ( ! ok )
+        { if (tm->prompt) printf ("Illegal value\n");
+          else obPuts(tm->out, "Illegal value\n");
+        }
+        else reg[r] = tm->inLine.num;
       }
       while (! ok);
       break;
 
-    case opOUT :  
-      printf ("OUT instruction prints: %d\n", reg[r] ) ;
+    case opOUT :
+      obPuts(tm->out, "OUT instruction prints: ") ;
+      obPutInt(tm->out, reg[r]) ;
+      obPutc(tm->out, '\n') ;
       break;
     case opADD :  reg[r] = reg[s] + reg[t] ;  break;
     case opSUB :  reg[r] = reg[s] - reg[t] ;  break;
@@ -378,8 +486,8 @@ STEPRESULT stepTM (void)
       break;
 
     /*************** RM instructions ********************/
-    case opLD :    reg[r] = dMem[m] ;  break;
-    case opST :    dMem[m] = reg[r] ;  break;
+    case opLD :    reg[r] = tm->dMem[m] ; tm->memcnt++ ; break;
+    case opST :    tm->dMem[m] = reg[r] ; tm->memcnt++ ; break;
 
     /*************** RA instructions ********************/
     case opLDA :    reg[r] = m ; break;
@@ -394,26 +502,478 @@ STEPRESULT stepTM (void)
     /* end of legal instructions */
   } /* case */
   return srOKAY ;
+} /* execute */
+
+/********************************************/
+STEPRESULT stepTM (MACHINE * tm)
+{ INSTRUCTION * iMem = tm->prog->iMem ;
+  int pc  ;
+  int m  ;
+
+  pc = tm->reg[PC_REG] ;
+  if ( (pc < 0) || (pc >= IADDR_SIZE)  )
+      return srIMEM_ERR ;
+  tm->reg[PC_REG] = pc + 1 ;
+  if ( opClass(iMem[pc].iop) == opclRM )
+  { m = iMem[pc].iarg2 + tm->reg[iMem[pc].iarg3] ;
+    if ( (m < 0) || (m >= DADDR_SIZE))
+       return srDMEM_ERR ;
+  }
+  return execute( tm, &iMem[pc] ) ;
 } /* stepTM */
 
 /********************************************/
-int doCommand (void)
+/* writesReg tells whether instruction ip sets
+   register r */
+int writesReg ( INSTRUCTION * ip, int r )
+{ switch (ip->iop)
+  { case opIN : case opADD : case opSUB : case opMUL : case opDIV :
+    case opLD : case opLDA : case opLDC :
+      return ip->iarg1 == r ;
+    case opJLT : case opJLE : case opJGT :
+    case opJGE : case opJEQ : case opJNE :
+      return r == PC_REG ;
+    default :
+      return FALSE ;
+  }
+} /* writesReg */
+
+/********************************************/
+/* endsBlock tells whether instruction ip may not
+   go on to the next location */
+int endsBlock ( INSTRUCTION * ip )
+{ return (ip->iop == opHALT) || writesReg(ip, PC_REG) ;
+} /* endsBlock */
+
+/********************************************/
+/* addGuard narrows the guard of register r in
+   the guards of the current block, from first */
+int addGuard ( PROGRAM * p, int first, int r, int lo, int hi )
+{ int i ;
+  GUARD * bigger ;
+  for (i = first ; i < p->guardCount ; i++)
+    if (p->guardTab[i].r == r)
+    { if (lo > p->guardTab[i].lo) p->guardTab[i].lo = lo ;
+      if (hi < p->guardTab[i].hi) p->guardTab[i].hi = hi ;
+      return TRUE ;
+    }
+  if (p->guardCount == p->guardSize)
+  { int size = p->guardSize ? 2 * p->guardSize : 256 ;
+    bigger = (GUARD *) realloc(p->guardTab, size * sizeof(GUARD)) ;
+    if (bigger == NULL) return FALSE ;
+    p->guardTab = bigger ;
+    p->guardSize = size ;
+  }
+  p->guardTab[p->guardCount].r = r ;
+  p->guardTab[p->guardCount].lo = lo ;
+  p->guardTab[p->guardCount].hi = hi ;
+  p->guardCount++ ;
+  return TRUE ;
+} /* addGuard */
+
+/********************************************/
+/* verifyProgram proves what it can of the code
+   loaded in iMem. Blocks start at 0, at the static
+   targets of jumps (d(pc), or LDC into pc) and
+   after the instructions that end a block. Within
+   a block each register is followed as a constant
+   (a register no instruction sets stays 0, like
+   gp) or as its value on entry plus a constant.
+   An LD or ST at a constant address in dMem needs
+   no check; at entry value plus constant it needs
+   a guard on that register; otherwise it keeps
+   its check. exitsOk is set when the jump and the
+   next location of the block are in iMem.
+   The proofs hold for a machine started as
+   clearMachine leaves it, where the registers the
+   program never sets (p->written) are 0: any other
+   way of setting the state, such as readCheckpoint,
+   must keep them 0 */
+void verifyProgram (PROGRAM * p)
+{ INSTRUCTION * iMem = p->iMem ;
+  BLOCK * blockTab = p->blockTab ;
+  int iSize = p->iSize ;
+  char * written = p->written ;
+  int known[NO_REGS] ;  /* register is a constant */
+  int base[NO_REGS] ;   /* else entry value of base, or -1 */
+  int val[NO_REGS] ;    /* plus val */
+  int loc, start, r, s, d, a, target, targetOk ;
+  INSTRUCTION * ip ;
+  for (r = 0 ; r < NO_REGS ; r++) written[r] = (r == PC_REG) ;
+  for (loc = 0 ; loc < iSize ; loc++)
+  { blockTab[loc].size = 0 ;
+    p->checkTab[loc] = TRUE ;
+    for (r = 0 ; r < PC_REG ; r++)
+      if (writesReg(&iMem[loc], r)) written[r] = TRUE ;
+  }
+  p->guardCount = 0 ;
+  /* mark the starts of the blocks */
+  if (iSize > 0) blockTab[0].size = 1 ;
+  for (loc = 0 ; loc < iSize ; loc++)
+  { ip = &iMem[loc] ;
+    if (! endsBlock(ip)) continue ;
+    if (loc + 1 < iSize) blockTab[loc+1].size = 1 ;
+    target = -1 ;
+    if ((ip->iop == opLDC) && (ip->iarg1 == PC_REG))
+      target = ip->iarg2 ;
+    else if ((opClass(ip->iop) == opclRA) && (ip->iarg3 == PC_REG))
+      target = loc + 1 + ip->iarg2 ;
+    if ((target >= 0) && (target < iSize)) blockTab[target].size = 1 ;
+  }
+  /* follow the registers through each block */
+  for (start = 0 ; start < iSize ; start = loc + 1)
+  { blockTab[start].guard = p->guardCount ;
+    for (r = 0 ; r < NO_REGS ; r++)
+    { known[r] = ! written[r] ;
+      base[r] = r ;
+      val[r] = 0 ;
+    }
+    for (loc = start ; ; loc++)
+    { ip = &iMem[loc] ;
+      known[PC_REG] = TRUE ;
+      val[PC_REG] = loc + 1 ;
+      r = ip->iarg1 ;
+      s = ip->iarg3 ;
+      d = ip->iarg2 ;
+      if (opClass(ip->iop) == opclRM)
+      { a = val[s] + d ;
+        if (known[s])
+          p->checkTab[loc] = (a < 0) || (a >= DADDR_SIZE) ;
+        else if (base[s] >= 0)
+          p->checkTab[loc] = ! addGuard(p, blockTab[start].guard, base[s],
+                                        -a, DADDR_SIZE - 1 - a) ;
+      }
+      if (endsBlock(ip)) break ;
+      if ((ip->iop == opLDA) && (known[s] || (base[s] >= 0)))
+      { known[r] = known[s] ;
+        base[r] = base[s] ;
+        val[r] = val[s] + d ;
+      }
+      else if (ip->iop == opLDC)
+      { known[r] = TRUE ;
+        val[r] = d ;
+      }
+      else if (writesReg(ip, r))
+      { known[r] = FALSE ;
+        base[r] = -1 ;
+      }
+      if ((loc + 1 == iSize) || (blockTab[loc+1].size > 0))
+        break ;
+    }
+    blockTab[start].size = loc + 1 - start ;
+    blockTab[start].nguards = p->guardCount - blockTab[start].guard ;
+    /* where can the block go on to */
+    target = -1 ;
+    if (ip->iop == opLDC)
+      target = d ;
+    else if ((opClass(ip->iop) == opclRA) && known[s])
+      target = val[s] + d ;
+    targetOk = (target >= 0) && (target < IADDR_SIZE) ;
+    if (ip->iop == opHALT)
+      blockTab[start].exitsOk = TRUE ;
+    else if (! writesReg(ip, PC_REG))
+      blockTab[start].exitsOk = loc + 1 < IADDR_SIZE ;
+    else if (ip->iop >= opJLT)
+      blockTab[start].exitsOk = (loc + 1 < IADDR_SIZE) && targetOk ;
+    else
+      blockTab[start].exitsOk = targetOk ;
+  }
+} /* verifyProgram */
+
+/********************************************/
+/* loadProgram reads and verifies program file
+   name; it returns NULL if it cannot */
+PROGRAM * loadProgram ( char * name )
+{ PROGRAM * p ;
+  FILE * pgm = fopen(name,"r");
+  if (pgm == NULL)
+  { printf("file '%s' not found\n",name);
+    return NULL ;
+  }
+  p = (PROGRAM *) calloc(1, sizeof(PROGRAM)) ;
+  if (p != NULL)
+  { /* zeroed locations are HALT 0,0,0 */
+    p->iMem = (INSTRUCTION *) calloc(IADDR_SIZE, sizeof(INSTRUCTION)) ;
+    p->blockTab = (BLOCK *) calloc(IADDR_SIZE, sizeof(BLOCK)) ;
+    p->checkTab = (char *) calloc(IADDR_SIZE, 1) ;
+  }
+  if ( (p == NULL) || (p->iMem == NULL) || (p->blockTab == NULL)
+       || (p->checkTab == NULL) )
+  { printf("out of memory for '%s'\n",name);
+    freeProgram(p) ;
+    p = NULL ;
+  }
+  else if (! readInstructions(p, pgm))
+  { freeProgram(p) ;
+    p = NULL ;
+  }
+  else verifyProgram(p) ;
+  fclose(pgm) ;
+  return p ;
+} /* loadProgram */
+
+/********************************************/
+/* clearMachine resets the registers, dMem and
+   counts of tm for a new execution */
+void clearMachine ( MACHINE * tm )
+{ int regNo ;
+  for (regNo = 0;  regNo < NO_REGS ; regNo++)
+        tm->reg[regNo] = 0 ;
+  memset(tm->dMem, 0, DADDR_SIZE * sizeof(int)) ;
+  tm->dMem[0] = DADDR_SIZE - 1 ;
+  tm->memcnt = 0 ;
+  tm->stepTotal = 0 ;
+  tm->nextSave = tm->saveEvery ;
+} /* clearMachine */
+
+/********************************************/
+/* newMachine returns a cleared machine running
+   program p, reading IN values from in and writing
+   to out; NULL if out of memory */
+MACHINE * newMachine ( PROGRAM * p, FILE * in, OutBuf * out )
+{ MACHINE * tm = (MACHINE *) calloc(1, sizeof(MACHINE)) ;
+  if (tm == NULL) return NULL ;
+  tm->dMem = (int *) malloc(DADDR_SIZE * sizeof(int)) ;
+  if (tm->dMem == NULL)
+  { free(tm) ;
+    return NULL ;
+  }
+  tm->prog = p ;
+  tm->in = in ;
+  tm->out = out ;
+  tm->stopLoc = -1 ;
+  clearMachine(tm) ;
+  return tm ;
+} /* newMachine */
+
+/********************************************/
+/* freeMachine releases a machine, but not its
+   program or files */
+void freeMachine ( MACHINE * tm )
+{ free(tm->dMem) ;
+  free(tm) ;
+} /* freeMachine */
+
+/********************************************/
+/* programHash returns a hash (FNV-1a) of the code
+   loaded, which a checkpoint must match */
+unsigned long programHash ( PROGRAM * p )
+{ unsigned long h = 2166136261UL ;
+  int loc ;
+  for (loc = 0 ; loc < p->iSize ; loc++)
+  { h = ((h ^ (unsigned) p->iMem[loc].iop) * 16777619UL) & 0xffffffffUL ;
+    h = ((h ^ (unsigned) p->iMem[loc].iarg1) * 16777619UL) & 0xffffffffUL ;
+    h = ((h ^ (unsigned) p->iMem[loc].iarg2) * 16777619UL) & 0xffffffffUL ;
+    h = ((h ^ (unsigned) p->iMem[loc].iarg3) * 16777619UL) & 0xffffffffUL ;
+  }
+  return h ;
+} /* programHash */
+
+/********************************************/
+/* writeCheckpoint saves the state of machine tm
+   after steps instructions to file name, as text:
+
+     TM checkpoint 1
+     program <locations> <hash>
+     steps <instructions executed>
+     regs <reg[0]> ... <reg[7]>
+     @<address> <value> ...   (a run of nonzero dMem)
+     end
+
+   It is written to name.tmp first and renamed, so
+   a crash leaves the last checkpoint whole. The
+   output so far is flushed first */
+int writeCheckpoint ( MACHINE * tm, char * name, long steps )
+{ char * tmp = (char *) malloc(strlen(name) + 5) ;
+  FILE * f ;
+  int i, loc ;
+  if (tmp == NULL) return FALSE ;
+  strcpy(tmp, name) ;
+  strcat(tmp, ".tmp") ;
+  obFlush(tm->out) ;
+  f = fopen(tmp, "w") ;
+  if (f == NULL)
+  { printf("cannot write checkpoint '%s'\n", tmp) ;
+    free(tmp) ;
+    return FALSE ;
+  }
+  fprintf(f, "TM checkpoint 1\nprogram %d %lx\nsteps %ld\nregs",
+          tm->prog->iSize, programHash(tm->prog), steps) ;
+  for (i = 0 ; i < NO_REGS ; i++) fprintf(f, " %d", tm->reg[i]) ;
+  for (loc = 0 ; loc < DADDR_SIZE ; loc++)
+    if (tm->dMem[loc] != 0)
+    { if ((loc == 0) || (tm->dMem[loc-1] == 0)) fprintf(f, "\n@%d", loc) ;
+      fprintf(f, " %d", tm->dMem[loc]) ;
+    }
+  fprintf(f, "\nend\n") ;
+  if ((fclose(f) != 0) || (rename(tmp, name) != 0))
+  { printf("cannot write checkpoint '%s'\n", name) ;
+    remove(tmp) ;
+    free(tmp) ;
+    return FALSE ;
+  }
+  free(tmp) ;
+  return TRUE ;
+} /* writeCheckpoint */
+
+/********************************************/
+/* readCheckpoint restores into tm the state saved
+   by writeCheckpoint in file name, for the same
+   program. A checkpoint setting a register the
+   program never sets, which verifyProgram takes to
+   be 0, or a pc outside the program is refused */
+int readCheckpoint ( MACHINE * tm, char * name )
+{ FILE * f = fopen(name, "r") ;
+  unsigned long hash ;
+  int size, version, i, loc, v, bad = FALSE ;
+  long steps ;
+  char c ;
+  if (f == NULL)
+  { printf("checkpoint '%s' not found\n", name) ;
+    return FALSE ;
+  }
+  if ( (fscanf(f, "TM checkpoint %d program %d %lx steps %ld regs",
+               &version, &size, &hash, &steps) != 4) || (version != 1) )
+  { printf("'%s' is not a TM checkpoint\n", name) ;
+    fclose(f) ;
+    return FALSE ;
+  }
+  if ( (size != tm->prog->iSize) || (hash != programHash(tm->prog)) )
+  { printf("checkpoint '%s' is of another program\n", name) ;
+    fclose(f) ;
+    return FALSE ;
+  }
+  for (i = 0 ; i < NO_REGS ; i++)
+    if ( (fscanf(f, "%d", &tm->reg[i]) != 1)
+         || ((tm->reg[i] != 0) && ! tm->prog->written[i]) )
+    { printf("bad registers in checkpoint '%s'\n", name) ;
+      fclose(f) ;
+      return FALSE ;
+    }
+  if ( (tm->reg[PC_REG] < 0) || (tm->reg[PC_REG] >= tm->prog->iSize) )
+  { printf("bad pc in checkpoint '%s'\n", name) ;
+    fclose(f) ;
+    return FALSE ;
+  }
+  for (loc = 0 ; loc < DADDR_SIZE ; loc++) tm->dMem[loc] = 0 ;
+  c = ' ' ;
+  while ( ! bad && (fscanf(f, " %c", &c) == 1) && (c == '@') )
+  { if (fscanf(f, "%d", &loc) != 1) bad = TRUE ;
+    else while (fscanf(f, "%d", &v) == 1)
+    { if ((loc < 0) || (loc >= DADDR_SIZE))
+      { bad = TRUE ;
+        break ;
+      }
+      tm->dMem[loc++] = v ;
+    }
+  }
+  fclose(f) ;
+  if (bad || (c != 'e'))
+  { printf("bad memory in checkpoint '%s'\n", name) ;
+    return FALSE ;
+  }
+  tm->stepTotal = steps ;
+  tm->nextSave = steps + tm->saveEvery ;
+  return TRUE ;
+} /* readCheckpoint */
+
+/********************************************/
+/* goTM runs the program until it stops, adding
+   the instructions executed to *count; it returns
+   srOKAY if it stops at stopLoc. A block whose
+   guards hold runs without the checks of stepTM,
+   except for the LD and ST it could not prove, and
+   the common instructions are done in place;
+   anything else runs through stepTM. Checkpoints
+   are written between blocks. The state of tm must
+   be one the program reached from clearMachine,
+   or at least keep the registers it never sets at
+   0 (see verifyProgram), or the unchecked blocks
+   may access outside dMem */
+STEPRESULT goTM ( MACHINE * tm, long * count )
+{ STEPRESULT result = srOKAY ;
+  PROGRAM * p = tm->prog ;
+  int * reg = tm->reg ;
+  int * dMem = tm->dMem ;
+  int pc, m, i, inMem = FALSE ;
+  INSTRUCTION * ip, * last ;
+  BLOCK * b ;
+  GUARD * g ;
+  while (result == srOKAY)
+  { pc = reg[PC_REG] ;
+    if ( (pc == tm->stopLoc) && (--tm->stopHits <= 0) )
+    { tm->stopLoc = -1 ;
+      return srOKAY ;
+    }
+    if ( (tm->saveEvery > 0) && (tm->stepTotal + *count >= tm->nextSave) )
+    { writeCheckpoint(tm, tm->savePath, tm->stepTotal + *count) ;
+      tm->nextSave = tm->stepTotal + *count + tm->saveEvery ;
+    }
+    if ( (inMem || ((pc >= 0) && (pc < IADDR_SIZE)))
+         && (p->blockTab[pc].size > 0)
+         && ((tm->stopLoc <= pc) || (tm->stopLoc >= pc + p->blockTab[pc].size)) )
+    { b = &p->blockTab[pc] ;
+      g = p->guardTab + b->guard ;
+      for (i = 0 ; i < b->nguards ; i++, g++)
+        if ( (reg[g->r] < g->lo) || (reg[g->r] > g->hi) ) break ;
+      if (i == b->nguards)
+      { *count += b->size ;
+        last = &p->iMem[pc + b->size] ;
+        for (ip = &p->iMem[pc] ; ip < last ; ip++)
+        { reg[PC_REG] = ++pc ;
+          switch (ip->iop)
+          { case opLD :
+            case opST :
+              m = ip->iarg2 + reg[ip->iarg3] ;
+              if ( p->checkTab[pc-1] && ((m < 0) || (m >= DADDR_SIZE)) )
+              { *count -= last - ip - 1 ;
+                return srDMEM_ERR ;
+              }
+              if (ip->iop == opLD) reg[ip->iarg1] = dMem[m] ;
+              else dMem[m] = reg[ip->iarg1] ;
+              tm->memcnt++ ;
+              break ;
+            case opLDA : reg[ip->iarg1] = ip->iarg2 + reg[ip->iarg3] ; break ;
+            case opLDC : reg[ip->iarg1] = ip->iarg2 ; break ;
+            case opADD : reg[ip->iarg1] = reg[ip->iarg2] + reg[ip->iarg3] ; break ;
+            case opSUB : reg[ip->iarg1] = reg[ip->iarg2] - reg[ip->iarg3] ; break ;
+            case opMUL : reg[ip->iarg1] = reg[ip->iarg2] * reg[ip->iarg3] ; break ;
+            default :
+              result = execute(tm, ip) ;
+              if (result != srOKAY)
+              { *count -= last - ip - 1 ;
+                return result ;
+              }
+          }
+        }
+        inMem = b->exitsOk ;
+        continue ;
+      }
+    }
+    result = stepTM (tm) ;
+    ++*count ;
+    inMem = FALSE ;
+  }
+  return result ;
+} /* goTM */
+
+/********************************************/
+int doCommand (MACHINE * tm)
 { char cmd;
-  int stepcnt=0, i;
+  long stepcnt=0;
+  int i;
   int printcnt;
   int stepResult;
-  int regNo, loc;
+  SCANNER * sc = &cmdLine;
+  obFlush(tm->out);
   do
   { printf ("Enter command: ");
-    fflush (stdin);
     fflush (stdout);
-    gets(in_Line);
-    lineLen = strlen(in_Line);
-    inCol = 0;
+    if (! readLine(sc, stdin)) return FALSE;
   }
-  while (! getWord ());
+  while (! getWord (sc));
 
-  cmd = word[0] ;
+  cmd = sc->word[0] ;
   switch ( cmd )
   { case 't' :
     /***********************************/
@@ -438,8 +998,12 @@ int doCommand (void)
       printf("   t(race         "\
              "Toggle instruction trace\n");
       printf("   p(rint         "\
-             "Toggle print of total instructions executed"\
-             " ('go' only)\n");
+             "Toggle print of total instructions and"\
+             " memory operations executed ('go' only)\n");
+      printf("   f(orward <b <n>> "\
+             "Execute until location b is reached the n'th time\n");
+      printf("   w(rite <file>  "\
+             "Write a checkpoint of registers, dMem and step count\n");
       printf("   c(lear         "\
              "Reset simulator for new execution of program\n");
       printf("   h(elp          "\
@@ -457,17 +1021,37 @@ int doCommand (void)
 
     case 's' :
     /***********************************/
-      if ( atEOL ())  stepcnt = 1;
-      else if ( getNum ())  stepcnt = abs(num);
+      if ( atEOL (sc))  stepcnt = 1;
+      else if ( getNum (sc))  stepcnt = abs(sc->num);
       else   printf("Step count?\n");
       break;
 
     case 'g' :   stepcnt = 1 ;     break;
 
+    case 'f' :
+    /***********************************/
+      tm->stopHits = 1 ;
+      if ( ! getNum (sc))
+        printf("Location?\n");
+      else
+      { tm->stopLoc = sc->num ;
+        if ( getNum (sc)) tm->stopHits = sc->num ;
+        stepcnt = 1 ;
+      }
+      break;
+
+    case 'w' :
+    /***********************************/
+      if ( ! getName(sc, fileName, sizeof(fileName)) )
+        printf("File name?\n");
+      else if ( writeCheckpoint(tm, fileName, tm->stepTotal) )
+        printf("Checkpoint written after %ld instructions.\n", tm->stepTotal);
+      break;
+
     case 'r' :
     /***********************************/
       for (i = 0; i < NO_REGS; i++)
-      { printf("%1d: %4d    ", i,reg[i]);
+      { printf("%1d: %4d    ", i,tm->reg[i]);
         if ( (i % 4) == 3 ) printf ("\n");
       }
       break;
@@ -475,16 +1059,16 @@ int doCommand (void)
     case 'i' :
     /***********************************/
       printcnt = 1 ;
-      if ( getNum ())
-      { iloc = num ;
-        if ( getNum ()) printcnt = num ;
+      if ( getNum (sc))
+      { iloc = sc->num ;
+        if ( getNum (sc)) printcnt = sc->num ;
       }
-      if ( ! atEOL ())
+      if ( ! atEOL (sc))
         printf ("Instruction locations?\n");
       else
       { while ((iloc >= 0) && (iloc < IADDR_SIZE)
                 && (printcnt > 0) )
-        { writeInstruction(iloc);
+        { writeInstruction(tm,iloc);
           iloc++ ;
           printcnt-- ;
         }
@@ -494,16 +1078,16 @@ int doCommand (void)
     case 'd' :
     /***********************************/
       printcnt = 1 ;
-      if ( getNum  ())
-      { dloc = num ;
-        if ( getNum ()) printcnt = num ;
+      if ( getNum  (sc))
+      { dloc = sc->num ;
+        if ( getNum (sc)) printcnt = sc->num ;
       }
-      if ( ! atEOL ())
+      if ( ! atEOL (sc))
         printf("Data locations?\n");
       else
       { while ((dloc >= 0) && (dloc < DADDR_SIZE)
                   && (printcnt > 0))
-        { printf("%5d: %5d\n",dloc,dMem[dloc]);
+        { printf("%5d: %5d\n",dloc,tm->dMem[dloc]);
           dloc++;
           printcnt--;
         }
@@ -515,11 +1099,7 @@ int doCommand (void)
       iloc = 0;
       dloc = 0;
       stepcnt = 0;
-      for (regNo = 0;  regNo < NO_REGS ; regNo++)
-            reg[regNo] = 0 ;
-      dMem[0] = DADDR_SIZE - 1 ;
-      for (loc = 1 ; loc < DADDR_SIZE ; loc++)
-            dMem[loc] = 0 ;
+      clearMachine(tm);
       break;
 
     case 'q' : return FALSE;  /* break; */
@@ -528,59 +1108,272 @@ int doCommand (void)
   }  /* case */
   stepResult = srOKAY;
   if ( stepcnt > 0 )
-  { if ( cmd == 'g' )
+  { if ( (cmd == 'g') || (cmd == 'f') )
     { stepcnt = 0;
-      while (stepResult == srOKAY)
-      { iloc = reg[PC_REG] ;
-        if ( traceflag ) writeInstruction( iloc ) ;
-        stepResult = stepTM ();
+      tm->memcnt = 0;
+      if ( ! traceflag || (cmd == 'f') )
+        stepResult = goTM (tm, &stepcnt);
+      else while (stepResult == srOKAY)
+      { iloc = tm->reg[PC_REG] ;
+        writeInstruction( tm, iloc ) ;
+        stepResult = stepTM (tm);
         stepcnt++;
       }
+      tm->stepTotal += stepcnt;
+      tm->stopLoc = -1;
+      obFlush(tm->out);
       if ( icountflag )
-        printf("Number of instructions executed = %d\n",stepcnt);
+      { printf("Number of instructions executed = %ld\n",stepcnt);
+        printf("Number of memory operations executed = %ld\n",tm->memcnt);
+      }
     }
     else
     { while ((stepcnt > 0) && (stepResult == srOKAY))
-      { iloc = reg[PC_REG] ;
-        if ( traceflag ) writeInstruction( iloc ) ;
-        stepResult = stepTM ();
+      { iloc = tm->reg[PC_REG] ;
+        if ( traceflag ) writeInstruction( tm, iloc ) ;
+        stepResult = stepTM (tm);
+        tm->stepTotal++;
         stepcnt-- ;
       }
     }
+    obFlush(tm->out);
     printf( "%s\n",stepResultTab[stepResult] );
   }
   return TRUE;
 } /* doCommand */
 
 
+/********************************************/
+/* B A T C H   R U N S                      */
+/********************************************/
+
+/* JOB is one run of a batch: program prog with
+   the IN values of file input (one per line; NULL:
+   none), written to file output like a p and g
+   command would print it */
+typedef struct {
+      char * progName, * input, * output ;
+      PROGRAM * prog ;    /* NULL if it did not load */
+      int result ;        /* STEPRESULT, -1 if it did not run */
+      long steps ;
+   } JOB;
+
+/* BATCH is the work of the threads of runBatch:
+   they take the jobs in order, next being the
+   first not yet taken */
+typedef struct {
+      JOB * jobs ;
+      int njobs ;
+      int next ;
+      pthread_mutex_t lock ;
+   } BATCH;
+
+/********************************************/
+/* runJob runs job j on a machine of its own */
+void runJob ( JOB * j )
+{ FILE * in, * out ;
+  OutBuf * ob ;
+  MACHINE * tm ;
+  if (j->prog == NULL) return ;
+  /* without input, IN finds the end of input */
+  in = fopen(j->input != NULL ? j->input : "/dev/null", "r") ;
+  if (in == NULL) return ;
+  out = fopen(j->output, "w") ;
+  if (out == NULL)
+  { fclose(in) ;
+    return ;
+  }
+  ob = newOutBuf(out) ;
+  tm = (ob == NULL) ? NULL : newMachine(j->prog, in, ob) ;
+  if (tm != NULL)
+  { j->result = goTM(tm, &j->steps) ;
+    obPrintf(ob, "Number of instructions executed = %ld\n", j->steps) ;
+    obPrintf(ob, "Number of memory operations executed = %ld\n", tm->memcnt) ;
+    obPrintf(ob, "%s\n", stepResultTab[j->result]) ;
+    freeMachine(tm) ;
+  }
+  if (ob != NULL) freeOutBuf(ob) ;
+  fclose(out) ;
+  fclose(in) ;
+} /* runJob */
+
+/********************************************/
+/* worker is a thread of runBatch */
+void * worker ( void * arg )
+{ BATCH * b = (BATCH *) arg ;
+  int i ;
+  for (;;)
+  { pthread_mutex_lock(&b->lock) ;
+    i = b->next++ ;
+    pthread_mutex_unlock(&b->lock) ;
+    if (i >= b->njobs) return NULL ;
+    runJob(&b->jobs[i]) ;
+  }
+} /* worker */
+
+/********************************************/
+/* runBatch runs the jobs of file jobFile, one per
+   line as
+
+     <program> <input file, or -> <output file>
+
+   on threads threads. Each program is loaded and
+   verified once and shared by its jobs. A line per
+   job is printed at the end, in the order of the
+   file */
+int runBatch ( char * jobFile, int threads )
+{ FILE * f = fopen(jobFile, "r") ;
+  char line[3*LINESIZE], prog[LINESIZE], input[LINESIZE], output[LINESIZE] ;
+  BATCH b ;
+  pthread_t * tids ;
+  int i, k, cap = 0, started = 0, failed = 0 ;
+  if (f == NULL)
+  { printf("file '%s' not found\n", jobFile) ;
+    return FALSE ;
+  }
+  b.jobs = NULL ;
+  b.njobs = 0 ;
+  b.next = 0 ;
+  while (fgets(line, sizeof(line), f) != NULL)
+  { if (sscanf(line, "%120s %120s %120s", prog, input, output) != 3)
+      continue ;
+    if (b.njobs == cap)
+    { JOB * bigger ;
+      cap = cap ? 2 * cap : 64 ;
+      bigger = (JOB *) realloc(b.jobs, cap * sizeof(JOB)) ;
+      if (bigger == NULL)
+      { printf("out of memory\n") ;
+        fclose(f) ;
+        return FALSE ;
+      }
+      b.jobs = bigger ;
+    }
+    b.jobs[b.njobs].progName = strdup(prog) ;
+    b.jobs[b.njobs].input = strcmp(input, "-") ? strdup(input) : NULL ;
+    b.jobs[b.njobs].output = strdup(output) ;
+    b.jobs[b.njobs].prog = NULL ;
+    b.jobs[b.njobs].result = -1 ;
+    b.jobs[b.njobs].steps = 0 ;
+    /* share the program of an earlier job */
+    for (k = 0 ; k < b.njobs ; k++)
+      if (strcmp(b.jobs[k].progName, prog) == 0) break ;
+    b.jobs[b.njobs].prog = (k < b.njobs) ? b.jobs[k].prog : loadProgram(prog) ;
+    b.njobs++ ;
+  }
+  fclose(f) ;
+  if (threads > b.njobs) threads = b.njobs ;
+  if (threads < 1) threads = 1 ;
+  pthread_mutex_init(&b.lock, NULL) ;
+  tids = (pthread_t *) malloc(threads * sizeof(pthread_t)) ;
+  if (tids != NULL)
+    for ( ; started < threads ; started++)
+      if (pthread_create(&tids[started], NULL, worker, &b) != 0) break ;
+  if (started == 0) worker(&b) ;
+  for (i = 0 ; i < started ; i++) pthread_join(tids[i], NULL) ;
+  pthread_mutex_destroy(&b.lock) ;
+  free(tids) ;
+  for (i = 0 ; i < b.njobs ; i++)
+  { if (b.jobs[i].result < 0)
+    { printf("%s: not run\n", b.jobs[i].output) ;
+      failed++ ;
+    }
+    else
+      printf("%s: %s, %ld instructions\n", b.jobs[i].output,
+             stepResultTab[b.jobs[i].result], b.jobs[i].steps) ;
+  }
+  printf("%d runs on %d threads, %d not run\n", b.njobs,
+         started ? started : 1, failed) ;
+  for (i = 0 ; i < b.njobs ; i++)
+  { for (k = 0 ; k < i ; k++)
+      if (b.jobs[k].prog == b.jobs[i].prog) break ;
+    if (k == i) freeProgram(b.jobs[i].prog) ;
+    free(b.jobs[i].progName) ;
+    free(b.jobs[i].input) ;
+    free(b.jobs[i].output) ;
+  }
+  free(b.jobs) ;
+  return failed == 0 ;
+} /* runBatch */
+
+
 /********************************************/
 /* E X E C U T I O N   B E G I N S   H E R E */
 /********************************************/
 
-main( int argc, char * argv[] )
-{ if (argc != 2)
-  { printf("usage: %s <filename>\n",argv[0]);
+int main( int argc, char * argv[] )
+{ char * restore = NULL;
+  char * batch = NULL;
+  char * pgmName;
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  long saveEvery = 0;
+  char * savePath = NULL;
+  int arg = 1;
+  PROGRAM * prog;
+  MACHINE * tm;
+  while ((arg < argc) && (argv[arg][0] == '-'))
+  { if ((strcmp(argv[arg],"-restore") == 0) && (arg + 2 < argc))
+    { restore = argv[arg+1];
+      arg += 2;
+    }
+    else if ((strcmp(argv[arg],"-checkpoint") == 0) && (arg + 3 < argc)
+             && (atol(argv[arg+2]) > 0))
+    { savePath = argv[arg+1];
+      saveEvery = atol(argv[arg+2]);
+      arg += 3;
+    }
+    else if ((strcmp(argv[arg],"-threads") == 0) && (arg + 1 < argc)
+             && (atol(argv[arg+1]) > 0))
+    { threads = atol(argv[arg+1]);
+      arg += 2;
+    }
+    else if ((strcmp(argv[arg],"-batch") == 0) && (arg + 1 < argc))
+    { batch = argv[arg+1];
+      arg += 2;
+    }
+    else break;
+  }
+  if (batch != NULL)
+  { if (arg != argc)
+    { printf("usage: %s [-threads <n>] -batch <jobs>\n", argv[0]);
+      exit(1);
+    }
+    return runBatch(batch, threads > 0 ? (int) threads : 1) ? 0 : 1;
+  }
+  if (arg != argc - 1)
+  { printf("usage: %s [-restore <checkpoint>] [-checkpoint <file> <n>] <filename>\n"
+           "       %s [-threads <n>] -batch <jobs>\n", argv[0], argv[0]);
     exit(1);
   }
-  strcpy(pgmName,argv[1]) ;
+  pgmName = (char *) malloc(strlen(argv[arg]) + 4);
+  if (pgmName == NULL) exit(1);
+  strcpy(pgmName,argv[arg]) ;
   if (strchr (pgmName, '.') == NULL)
      strcat(pgmName,".tm");
-  pgm = fopen(pgmName,"r");
-  if (pgm == NULL)
-  { printf("file '%s' not found\n",pgmName);
-    exit(1);
-  }
 
   /* read the program */
-  if ( ! readInstructions ())
+  prog = loadProgram(pgmName);
+  if (prog == NULL)
+         exit(1) ;
+  tm = newMachine(prog, stdin, newOutBuf(stdout));
+  if ((tm == NULL) || (tm->out == NULL))
          exit(1) ;
-  /* switch input file to terminal */
-  /* reset( input ); */
+  tm->prompt = TRUE;
+  tm->savePath = savePath;
+  tm->saveEvery = tm->nextSave = saveEvery;
+  if (restore != NULL)
+  { if (! readCheckpoint(tm, restore))
+         exit(1) ;
+    printf("Restored %s after %ld instructions.\n", restore, tm->stepTotal) ;
+  }
   /* read-eval-print */
   printf("TM  simulation (enter h for help)...\n");
   do
-     done = ! doCommand ();
+     done = ! doCommand (tm);
   while (! done );
+  freeOutBuf(tm->out);
+  freeMachine(tm);
+  freeProgram(prog);
+  free(pgmName);
   printf("Simulation done.\n");
   return 0;
 }
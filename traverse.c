@@ -0,0 +1,77 @@
+/****************************************************/
+/* File: traverse.c                                 */
+/* Non-recursive syntax tree traversal              */
+/****************************************************/
+
+#include "globals.h"
+#include "traverse.h"
+
+/* STACKINIT is the initial depth of the walk stack */
+#define STACKINIT 64
+
+/* a node on the path from the root whose children
+ * are being visited: next is the next child slot to
+ * enter, done the number of slots already finished
+ */
+typedef struct
+   { TreeNode * node;
+     int next;
+     int done;
+   } WalkFrame;
+
+/* Procedure walkTree visits every node of the sibling
+ * list t and of its subtrees, keeping the path from
+ * the root on an explicit stack
+ */
+void walkTree(TreeNode * t, TreeVisitor * v)
+{ WalkFrame * stack;
+  int size = STACKINIT;
+  int top = -1; /* index of the innermost frame */
+  stack = (WalkFrame *) malloc(size * sizeof(WalkFrame));
+  if (stack == NULL)
+  { obPuts(listing,"Out of memory error in walkTree\n");
+    Error = TRUE;
+    return;
+  }
+  for (;;)
+  { if (t != NULL)
+    { /* enter t: preorder visit, then push it */
+      int descend = TRUE;
+      if (v->preProc != NULL) descend = v->preProc(t,top+1,v->arg);
+      if (top+1 == size)
+      { WalkFrame * bigger;
+        bigger = (WalkFrame *) realloc(stack,2 * size * sizeof(WalkFrame));
+        if (bigger == NULL)
+        { obPuts(listing,"Out of memory error in walkTree\n");
+          Error = TRUE;
+          break;
+        }
+        stack = bigger;
+        size *= 2;
+      }
+      ++top;
+      stack[top].node = t;
+      stack[top].next = stack[top].done = descend ? 0 : MAXCHILDREN;
+      t = NULL;
+    }
+    else if (top < 0) break;
+    else
+    { WalkFrame * f = &stack[top];
+      if (f->done < f->next)
+      { /* the list in child slot done is finished */
+        if (v->childProc != NULL) v->childProc(f->node,f->done,v->arg);
+        f->done++;
+      }
+      else if (f->next < MAXCHILDREN)
+        t = f->node->child[f->next++];
+      else
+      { /* postorder visit, then on to the sibling */
+        TreeNode * node = f->node;
+        --top;
+        if (v->postProc != NULL) v->postProc(node,top+1,v->arg);
+        t = node->sibling;
+      }
+    }
+  }
+  free(stack);
+}
@@ -0,0 +1,34 @@
+/****************************************************/
+/* File: traverse.h                                 */
+/* Non-recursive syntax tree traversal shared by    */
+/* the passes of the TINY compiler                  */
+/****************************************************/
+
+#ifndef _TRAVERSE_H_
+#define _TRAVERSE_H_
+
+/* TreeVisitor holds the callbacks of one traversal;
+ * any of them may be NULL. depth counts the child
+ * links between a node and the top-level list.
+ */
+typedef struct
+   { /* preorder visit; returning FALSE skips the
+      * children of t (postProc is still applied) */
+     int (* preProc) (TreeNode * t, int depth, void * arg);
+     /* called after child slot i of t, whether or
+      * not that child is NULL */
+     void (* childProc) (TreeNode * t, int i, void * arg);
+     /* postorder visit, after all children */
+     void (* postProc) (TreeNode * t, int depth, void * arg);
+     void * arg; /* passed to every callback */
+   } TreeVisitor;
+
+/* Procedure walkTree visits every node of the sibling
+ * list t and of its subtrees, keeping the path from
+ * the root on an explicit stack: siblings are followed
+ * in a loop and children are pushed, so neither long
+ * statement lists nor deep expressions use C stack
+ */
+void walkTree(TreeNode * t, TreeVisitor * v);
+
+#endif
@@ -8,79 +8,87 @@
 
 #include "globals.h"
 #include "util.h"
+#include "traverse.h"
+
+/* printWord prints a token name and its lexeme
+ * as one line of the token listing
+ */
+static void printWord( OutBuf * listing, const char * name, const char * lexeme )
+{ obPutc(listing,'\t');
+  obPuts(listing,name);
+  obPutc(listing,'\t');
+  obPuts(listing,lexeme);
+  obPutc(listing,'\n');
+}
 
 /* Procedure printToken prints a token 
- * and its lexeme to the listing file
+ * and its lexeme to the given listing file
  */
-void printToken( TokenType token, const char* tokenString )
+void printToken( OutBuf * listing, TokenType token, const char* tokenString )
 {switch (token)
   { 
     /*reserved words*/
-    case IF: fprintf(listing,"\t%s\t%s\n","IF",tokenString); break;
-    case THEN: fprintf(listing,"\t%s\t%s\n","THEN",tokenString); break;
-    case ELSE: fprintf(listing,"\t%s\t%s\n","ELSE",tokenString); break;
-    case END: fprintf(listing,"\t%s\t%s\n","END",tokenString); break;
-    case REPEAT: fprintf(listing,"\t%s\t%s\n","REPEAT",tokenString); break;
-    case UNTIL: fprintf(listing,"\t%s\t%s\n","UNTIL",tokenString); break;
-    case READ: fprintf(listing,"\t%s\t%s\n","READ",tokenString); break;
-    case WRITE: fprintf(listing,"\t%s\t%s\n","WRITE",tokenString); break;
-    case VOID: fprintf(listing,"\t%s\t%s\n","VOID",tokenString); break;
-    case WHILE: fprintf(listing,"\t%s\t%s\n","WHILE",tokenString); break;
-    case INT: fprintf(listing,"\t%s\t%s\n","INT",tokenString); break;
-    case RETURN: fprintf(listing,"\t%s\t%s\n","RETURN",tokenString); break;
+    case IF: printWord(listing,"IF",tokenString); break;
+    case THEN: printWord(listing,"THEN",tokenString); break;
+    case ELSE: printWord(listing,"ELSE",tokenString); break;
+    case END: printWord(listing,"END",tokenString); break;
+    case REPEAT: printWord(listing,"REPEAT",tokenString); break;
+    case UNTIL: printWord(listing,"UNTIL",tokenString); break;
+    case READ: printWord(listing,"READ",tokenString); break;
+    case WRITE: printWord(listing,"WRITE",tokenString); break;
+    case VOID: printWord(listing,"VOID",tokenString); break;
+    case WHILE: printWord(listing,"WHILE",tokenString); break;
+    case INT: printWord(listing,"INT",tokenString); break;
+    case RETURN: printWord(listing,"RETURN",tokenString); break;
     
     /*special symbols*/
-    case ASSIGN: fprintf(listing,"\t==\t==\n"); break;
-    case LT: fprintf(listing,"\t<\t<\n"); break;
-    case RT: fprintf(listing,"\t>\t>\n"); break;
-    case LEQ: fprintf(listing,"\t<=\t<=\n"); break;
-    case REQ: fprintf(listing,"\t>=\t>=\n"); break;
-    case EQ: fprintf(listing,"\t=\t=\n"); break;
-    case NEQ: fprintf(listing,"\t!=\t!=\n"); break;
-    case LPAREN: fprintf(listing,"\t(\t(\n"); break;
-    case RPAREN: fprintf(listing,"\t)\t)\n"); break;
-    case LSQBRAC: fprintf(listing,"\t[\t[\n"); break;
-    case RSQBRAC: fprintf(listing,"\t]\t]\n"); break;
-    case LBRAC: fprintf(listing,"\t{\t{\n"); break;
-    case RBRAC: fprintf(listing,"\t}\t}\n"); break;
-    case COMMA: fprintf(listing,"\t,\t,\n"); break;
-    case SEMI: fprintf(listing,"\t;\t;\n"); break;
-    case PLUS: fprintf(listing,"\t+\t+\n"); break;
-    case MINUS: fprintf(listing,"\t-\t-\n"); break;
-    case TIMES: fprintf(listing,"\t*\t*\n"); break;
-    case OVER: fprintf(listing,"\t/\t/\n"); break;
-    case ENDFILE: fprintf(listing,"\tEOF\n"); break;
+    case ASSIGN: obPuts(listing,"\t==\t==\n"); break;
+    case LT: obPuts(listing,"\t<\t<\n"); break;
+    case RT: obPuts(listing,"\t>\t>\n"); break;
+    case LEQ: obPuts(listing,"\t<=\t<=\n"); break;
+    case REQ: obPuts(listing,"\t>=\t>=\n"); break;
+    case EQ: obPuts(listing,"\t=\t=\n"); break;
+    case NEQ: obPuts(listing,"\t!=\t!=\n"); break;
+    case LPAREN: obPuts(listing,"\t(\t(\n"); break;
+    case RPAREN: obPuts(listing,"\t)\t)\n"); break;
+    case LSQBRAC: obPuts(listing,"\t[\t[\n"); break;
+    case RSQBRAC: obPuts(listing,"\t]\t]\n"); break;
+    case LBRAC: obPuts(listing,"\t{\t{\n"); break;
+    case RBRAC: obPuts(listing,"\t}\t}\n"); break;
+    case COMMA: obPuts(listing,"\t,\t,\n"); break;
+    case SEMI: obPuts(listing,"\t;\t;\n"); break;
+    case PLUS: obPuts(listing,"\t+\t+\n"); break;
+    case MINUS: obPuts(listing,"\t-\t-\n"); break;
+    case TIMES: obPuts(listing,"\t*\t*\n"); break;
+    case OVER: obPuts(listing,"\t/\t/\n"); break;
+    case ENDFILE: obPuts(listing,"\tEOF\n"); break;
 
     /*pre-declared regex*/
     case CMTERR: 
-      fprintf(listing, 
+      obPuts(listing,
           "\tERROR\tCOMMENT ERROR\n"); break;
 
     /*lexical error 
       ex. variable mix of number and identifier*/
     case LEXERR: 
-      fprintf(listing, 
+      obPrintf(listing,
           "\tERROR\tLEXICAL ERROR(%s)\n", tokenString); break;
     case NUM:
-      fprintf(listing,
-          "\tNUM\t%s\n",tokenString);
+      printWord(listing,"NUM",tokenString);
       break;
     case ID:
-      fprintf(listing,
-          "\tID\t%s\n",tokenString);
+      printWord(listing,"ID",tokenString);
       break;
       
     /*other undefined tokens*/
     case ERROR:
-      fprintf(listing,
-          "\tERROR\t%s\n",tokenString);
+      printWord(listing,"ERROR",tokenString);
       break;
     case TOKENERR:
-      fprintf(listing,
-          "\t%s\t%s\n",tokenString,tokenString);
+      printWord(listing,tokenString,tokenString);
       break;
     default: /* should never happen */
-      fprintf(listing,"Unknown token: %d\n",token);
+      obPrintf(listing,"Unknown token: %d\n",token);
   }
 }
 
@@ -91,13 +99,18 @@ TreeNode * newStmtNode(StmtKind kind)
 { TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
   int i;
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    obPrintf(listing,"Out of memory error at line %d\n",lineno);
   else {
     for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = StmtK;
     t->kind.stmt = kind;
     t->lineno = lineno;
+    t->attr.name = NULL;
+    t->type = Void;
+    t->arr_size = 0;
+    t->sym = NULL;
+    t->need = t->effects = 0;
   }
   return t;
 }
@@ -109,14 +122,18 @@ TreeNode * newExpNode(ExpKind kind)
 { TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
   int i;
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    obPrintf(listing,"Out of memory error at line %d\n",lineno);
   else {
     for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
     t->sibling = NULL;
     t->nodekind = ExpK;
     t->kind.exp = kind;
     t->lineno = lineno;
+    t->attr.name = NULL;
     t->type = Void;
+    t->arr_size = 0;
+    t->sym = NULL;
+    t->need = t->effects = 0;
   }
   return t;
 }
@@ -131,7 +148,7 @@ char * copyString(char * s)
   n = strlen(s)+1;
   t = malloc(n);
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    obPrintf(listing,"Out of memory error at line %d\n",lineno);
   else strcpy(t,s);
   return t;
 }
@@ -147,314 +164,181 @@ static indentno = 0;
 
 /* printSpaces indents by printing spaces */
 static void printSpaces(void)
-{ int i;
-  for (i=0;i<indentno;i++)
-    fprintf(listing," ");
+{ obSpaces(listing,indentno);
 }
 
-/* procedure printTree prints a syntax tree to the 
- * listing file using indentation to indicate subtrees
+/* printName, printNum and printArray print one
+ * labelled line of the syntax tree listing
  */
-void printTree( TreeNode * tree )
-{ int i;
-  INDENT;
-  while (tree != NULL) {
-    printSpaces();
-    if (tree->nodekind==StmtK)
-    { switch (tree->kind.stmt) {
-        case IfK:
-          fprintf(listing,"If\n");
-          break;
-        case RepeatK:
-          fprintf(listing,"Repeat\n");
-          break;
-        case AssignK:
-          //UNINDENT;
-          //printSpaces();
-          fprintf(listing,"Assign : =\n");
-          INDENT;
-          printSpaces();
-          fprintf(listing, "Variable : %s\n", tree->attr.name);
-          
-          UNINDENT;
-          break;
-        case AssignKarr:
-          //UNINDENT;
-          //printSpaces();
-          fprintf(listing,"Assign : =\n");
-          INDENT;
-          printSpaces();
-          fprintf(listing, "Variable : %s[%d]\n", tree->attr.name, tree->arr_size);
-          
-          UNINDENT;
-          break;
-        case ReadK:
-          fprintf(listing,"Read: %s\n",tree->attr.name);
-          break;
-        case WriteK:
-          fprintf(listing,"Write\n");
-          break;
-        case CompK:
-          fprintf(listing, "Compound statment\n");
-          break;
-        case ReturnK:
-          //printSpaces();
-          fprintf(listing,"Return Statement :\n");
-          break;
-        case CallK:
-          fprintf(listing, "Call parameters: \n");
-          break;
-        default:
-          fprintf(listing,"Unknown ExpNode kind\n");
-          break;
-      }
-    }
-    else if (tree->nodekind==ExpK)
-    { switch (tree->kind.exp) {
-        case OpK:
-          //printSpaces();
-          switch(tree->type){
-            case MtA:
-              
-              fprintf(listing,"Addictive Expression\n");
-              //INDENT;
-              printSpaces();
-              //UNINDENT;
-              break;
-            case AtM:
-              
-              fprintf(listing,"Multiple Expression\n");
-              //INDENT;
-              printSpaces();
-              //UNINDENT;
-              break;
-            default:
-              
-              //printSpaces();
-              //UNINDENT;
-              break;
-          }
-       
-          fprintf(listing,"Operator: ");
-          if(tree->attr.op == PLUS){
-            fprintf(listing,"+\n");
-          }
-          else if(tree->attr.op == MINUS){
-            fprintf(listing,"-\n");
-          }
-          else if(tree->attr.op == TIMES){
-            fprintf(listing,"*\n");
-          }
-          else if(tree->attr.op == OVER){
-            fprintf(listing,"/\n");
-          }
-          //printToken(tree->attr.op,"\0");
-          break;
-        case ConstK:
-          //INDENT;
-          //printSpaces();
-          fprintf(listing,"Constant: %d\n",tree->attr.val);
-          //UNINDENT;
-          break;
-        case IdK:
-          //printSpaces();
-          fprintf(listing,"Variable: %s\n",tree->attr.name);
-          break;
+static void printName(const char * label, const char * name)
+{ obPuts(listing,label);
+  obPuts(listing,name);
+  obPutc(listing,'\n');
+}
+
+static void printNum(const char * label, int val)
+{ obPuts(listing,label);
+  obPutInt(listing,val);
+  obPutc(listing,'\n');
+}
+
+static void printArray(const char * label, const char * name, int size)
+{ obPuts(listing,label);
+  obPuts(listing,name);
+  obPutc(listing,'[');
+  obPutInt(listing,size);
+  obPuts(listing,"]\n");
+}
+
+/* opName returns the spelling of a binary operator */
+static const char * opName(TokenType op)
+{ switch (op)
+  { case PLUS: return "+";
+    case MINUS: return "-";
+    case TIMES: return "*";
+    case OVER: return "/";
+    case LT: return "<";
+    case RT: return ">";
+    case LEQ: return "<=";
+    case REQ: return ">=";
+    case ASSIGN: return "==";
+    case NEQ: return "!=";
+    default: return "?";
+  }
+}
+
+/* printNode is the preorder visitor of printTree:
+ * it prints one node, indented by its depth
+ */
+static int printNode( TreeNode * tree, int depth, void * arg )
+{ indentno = 4*(depth+1);
+  printSpaces();
+  if (tree->nodekind==StmtK)
+  { switch (tree->kind.stmt) {
+      case IfK:
+        obPuts(listing,"If\n");
+        break;
+      case RepeatK:
+        obPuts(listing,"Repeat\n");
+        break;
+      case AssignK:
+        //UNINDENT;
+        //printSpaces();
+        obPuts(listing,"Assign : =\n");
+        INDENT;
+        printSpaces();
+        printName("Variable : ",tree->attr.name);
         
-        case VarK:
-          fprintf(listing, "Variable Declaration: %s\n", tree->attr.name);
+        UNINDENT;
+        break;
+      case AssignKarr:
+        obPuts(listing,"Assign : =\n");
+        INDENT;
+        printSpaces();
+        printName("Array Variable : ",tree->attr.name);
+        UNINDENT;
+        break;
+      case ReadK:
+        printName("Read: ",tree->attr.name);
+        break;
+      case WriteK:
+        obPuts(listing,"Write\n");
+        break;
+      case CompK:
+        obPuts(listing,"Compound statment\n");
+        break;
+      case ReturnK:
+        //printSpaces();
+        obPuts(listing,"Return Statement :\n");
+        break;
+      case CallK:
+        printName("Call: ",tree->attr.name);
+        break;
+      default:
+        obPuts(listing,"Unknown ExpNode kind\n");
+        break;
+    }
+  }
+  else if (tree->nodekind==ExpK)
+  { switch (tree->kind.exp) {
+      case OpK:
+        printName("Operator: ",opName(tree->attr.op));
+        break;
+      case ConstK:
+        //INDENT;
+        //printSpaces();
+        printNum("Constant: ",tree->attr.val);
+        //UNINDENT;
+        break;
+      case IdK:
+        //printSpaces();
+        printName("Variable: ",tree->attr.name);
+        break;
+      
+      case VarK:
+        printName("Variable Declaration: ",tree->attr.name);
+        INDENT;
+        printSpaces();
+        switch(tree->type){
+          case Integer: obPuts(listing,"Type: int\n");break;
+          case Void: obPuts(listing,"Type: void\n");break;
+        }
+        UNINDENT;
+        break;
+      case FuncK:
+        printName("Function Declaration: ",tree->attr.name);
+        INDENT;
+        printSpaces();
+        switch(tree->type){
+          case Integer: obPuts(listing,"Type: int\n");break;
+          case Void: obPuts(listing,"Type: void\n");break;
+        }
+        UNINDENT;
+        break;
+      case ArrK:
+        printArray("Variable Declaration: ",tree->attr.name,tree->arr_size);
           INDENT;
           printSpaces();
           switch(tree->type){
-            case Integer: fprintf(listing, "Type: int\n");break;
-            case Void: fprintf(listing, "Type: void\n");break;
+            case Integer: obPuts(listing,"Type: int\n");break;
+            case Void: obPuts(listing,"Type: void\n");break;
           }
           UNINDENT;
           break;
-        case FuncK:
-          fprintf(listing, "Function Declaration: %s\n", tree->attr.name);
-          INDENT;
-          printSpaces();
-          switch(tree->type){
-            case Integer: fprintf(listing, "Type: int\n");break;
-            case Void: fprintf(listing, "Type: void\n");break;
-          }
-          UNINDENT;
+      case ArrexpK:
+        printName("Array Variable: ",tree->attr.name);
+          
           break;
-        case ArrK:
-          fprintf(listing, "Variable Declaration: %s[%d]\n", tree->attr.name, tree->arr_size);
-            INDENT;
+      case ParamK:
+        INDENT;
+        switch(tree->type){
+          case Integer: 
+            printName("Parameter: ",tree->attr.name);
             printSpaces();
-            switch(tree->type){
-              case Integer: fprintf(listing, "Type: int\n");break;
-              case Void: fprintf(listing, "Type: void\n");break;
-            }
-            UNINDENT;
+            obPuts(listing,"Type: int\n");
             break;
-        case ArrexpK:
-          fprintf(listing, "Array Declaration: %s\n", tree->attr.name);
-            
-            break;
-        case ParamK:
-          INDENT;
-          switch(tree->type){
-            case Integer: 
-              fprintf(listing, "Parameter: %s\n", tree->attr.name);
-              printSpaces();
-              fprintf(listing, "Type: int\n");
-              break;
-            }
-            UNINDENT;
+          case IntArray:
+            printName("Parameter: ",tree->attr.name);
+            printSpaces();
+            obPuts(listing,"Type: int[]\n");
             break;
-        case AddIK:
-          //printSpaces();
-          fprintf(listing, "Addictive Expression\n");
-          //INDENT;
-          printSpaces();
-          fprintf(listing, "Variable: %s\n", tree->attr.name);
-          //UNINDENT;
-          break;
-        case AddCK:
-          //printSpaces();
-          fprintf(listing, "Addictive Expression\n");
-          //INDENT;
-          printSpaces();
-          fprintf(listing, "Constant: %d\n", tree->attr.val);
-          //UNINDENT;
-          break;
-        case MulIK:
-          //printSpaces();
-          fprintf(listing, "Multiple Expression\n");
-          //INDENT;
-          printSpaces();
-          fprintf(listing, "Variable: %s\n", tree->attr.name);
-          //UNINDENT;
-          break;
-        case MulCK:
-          //printSpaces();
-          fprintf(listing, "Mulpiple Expression\n");
-          //INDENT;
-          printSpaces();
-          fprintf(listing, "Constant: %d\n", tree->attr.val);
-          //UNINDENT;
-          break;
-        case SimpIK:
-          //printSpaces();
-          fprintf(listing, "Simple Expression\n");
-          //INDENT;
-          printSpaces();
-          fprintf(listing, "Variable: %s\n", tree->simp_name);
-          printSpaces();
-          fprintf(listing, "Operator: ");
-          switch(tree->attr.op){
-              case LT : 
-                fprintf(listing,">\n");
-                break;
-              case RT : 
-                fprintf(listing,"<\n");
-                break;
-              case LEQ : 
-                fprintf(listing,"<=\n");
-                break;
-              case REQ : 
-                fprintf(listing,">=\n");
-                break;
-              case ASSIGN : 
-                fprintf(listing,"==\n");
-                break;
-              case NEQ : 
-                fprintf(listing,"!=\n");
-                break;
           }
-          
-          //UNINDENT;
-          break;
-        case SimpNK:
-          //printSpaces();
-          fprintf(listing, "Simple Expression\n");
-          //INDENT;
-          printSpaces();
-          fprintf(listing, "Constant: %d\n", tree->simp_val);
-          printSpaces();
-          fprintf(listing, "Operator: ");
-          switch(tree->attr.op){
-              case LT : 
-                fprintf(listing,">\n");
-                break;
-              case RT : 
-                fprintf(listing,"<\n");
-                break;
-              case LEQ : 
-                fprintf(listing,"<=\n");
-                break;
-              case REQ : 
-                fprintf(listing,">=\n");
-                break;
-              case ASSIGN : 
-                fprintf(listing,"==\n");
-                break;
-              case NEQ : 
-                fprintf(listing,"!=\n");
-                break;
-          }
-          
-          //UNINDENT;
-          break;
-        case AddSI:
-          //printSpaces();
-          fprintf(listing, "Addictive operation\n");
-          //INDENT;
-          printSpaces();
-          fprintf(listing, "variable: %s\n", tree->simp_name);
-          printSpaces();
-          fprintf(listing, "Operator: ");
-           if(tree->attr.op == PLUS){
-              fprintf(listing,"+\n");
-            }
-            else if(tree->attr.op == MINUS){
-              fprintf(listing,"-\n");
-            }
-            else if(tree->attr.op == TIMES){
-              fprintf(listing,"*\n");
-            }
-            else if(tree->attr.op == OVER){
-              fprintf(listing,"/\n");
-            }
-          
-          //UNINDENT;
-          break;
-        case MulSI:
-          //printSpaces();
-          fprintf(listing, "Multiple operation\n");
-          //INDENT;
-          printSpaces();
-          fprintf(listing, "variable: %s\n", tree->simp_name);
-          printSpaces();
-          fprintf(listing, "Operator: ");
-          if(tree->attr.op == PLUS){
-              fprintf(listing,"+\n");
-            }
-            else if(tree->attr.op == MINUS){
-              fprintf(listing,"-\n");
-            }
-            else if(tree->attr.op == TIMES){
-              fprintf(listing,"*\n");
-            }
-            else if(tree->attr.op == OVER){
-              fprintf(listing,"/\n");
-            }
-          
-          //UNINDENT;
-          break;
-        default:
-          fprintf(listing,"Unknown ExpNode kind\n");
+          UNINDENT;
           break;
-      }
+      default:
+        obPuts(listing,"Unknown ExpNode kind\n");
+        break;
     }
-    else fprintf(listing,"Unknown node kind\n");
-    for (i=0;i<MAXCHILDREN;i++)
-         printTree(tree->child[i]);
-    tree = tree->sibling;
   }
-  UNINDENT;
+  else obPuts(listing,"Unknown node kind\n");
+  return TRUE;
+}
+
+/* procedure printTree prints a syntax tree to the 
+ * listing file using indentation to indicate subtrees
+ */
+void printTree( TreeNode * tree )
+{ TreeVisitor v = { printNode, NULL, NULL, NULL };
+  walkTree(tree,&v);
+  indentno = 0;
 }
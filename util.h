@@ -9,9 +9,9 @@
 #define _UTIL_H_
 
 /* Procedure printToken prints a token 
- * and its lexeme to the listing file
+ * and its lexeme to the given listing file
  */
-void printToken( TokenType, const char* );
+void printToken( OutBuf *, TokenType, const char* );
 
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
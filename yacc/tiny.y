@@ -1,6 +1,8 @@
 /****************************************************/
 /* File: tiny.y                                     */
-/* The TINY Yacc/Bison specification file           */
+/* The C- Yacc/Bison specification file             */
+/* An LALR alternative to the recursive-descent     */
+/* parser in parse.c; it builds the same trees      */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -11,153 +13,410 @@
 #include "util.h"
 #include "scan.h"
 #include "parse.h"
+#include "stats.h"
 
-#define YYSTYPE TreeNode *
-static char * savedName; /* for use in assignments */
-static int savedLineNo;  /* ditto */
-static TreeNode * savedTree; /* stores syntax tree for later return */
+/* Chain is a sibling list under construction; tail
+ * makes appending O(1) for long lists
+ */
+typedef struct
+   { TreeNode * head;
+     TreeNode * tail;
+   } Chain;
+
+/* ParseState holds everything one parse needs */
+typedef struct
+   { Scanner * scan; /* scanner for the source file */
+     OutBuf * listing; /* listing output for errors */
+     TokenType token; /* last token read, for messages */
+     int errors; /* syntax errors reported so far */
+     int maxErrors; /* stop after this many (0: no limit) */
+     TreeNode * tree; /* the tree built by the parse */
+   } ParseState;
+%}
+
+%define api.pure full
+%define api.token.prefix {TOK_}
+%locations
+%parse-param {ParseState * ps}
+%lex-param {ParseState * ps}
 
+%union { TreeNode * node;
+         Chain chain;
+         char * name;
+         int val;
+         TokenType op;
+         ExpType type;
+       }
+
+%{
+static int yylex(YYSTYPE * lvalp, YYLTYPE * llocp, ParseState * ps);
+static void yyerror(YYLTYPE * llocp, ParseState * ps, const char * message);
+static TreeNode * stmtNode(StmtKind kind, YYLTYPE at);
+static TreeNode * expNode(ExpKind kind, YYLTYPE at);
+static Chain chainOf(TreeNode * t);
+static Chain chainAppend(Chain c, TreeNode * t);
+static TreeNode * opNode(TreeNode * l, TokenType op, YYLTYPE at, TreeNode * r);
+static TreeNode * assignNode(TreeNode * var, TreeNode * value);
 %}
 
-%token IF THEN ELSE END REPEAT UNTIL READ WRITE
-%token ID NUM 
-%token ASSIGN EQ LT PLUS MINUS TIMES OVER LPAREN RPAREN SEMI
-%token ERROR 
+%token IF ELSE WHILE RETURN INT VOID
+%token <name> ID
+%token <val> NUM
+%token <op> PLUS MINUS TIMES OVER LT LEQ RT REQ ASSIGN NEQ
+%token EQ LPAREN RPAREN LSQBRAC RSQBRAC LBRAC RBRAC SEMI COMMA
+%token BAD /* scanner errors: never part of a program */
+
+%nonassoc LOWER_THAN_ELSE
+%nonassoc ELSE
+
+%type <chain> decl_list param_list local_decls stmt_list arg_list
+%type <node> declaration var_decl fun_decl params param compound_stmt
+%type <node> statement expression_stmt selection_stmt iteration_stmt
+%type <node> return_stmt expression simple_exp add_exp term factor
+%type <node> var call args
+%type <type> type_spec
+%type <op> relop addop mulop
 
-%% /* Grammar for TINY */
+%% /* Grammar for C- */
 
-program     : stmt_seq
-                 { savedTree = $1;} 
+program     : decl_list
+                 { ps->tree = $1.head; }
             ;
-stmt_seq    : stmt_seq SEMI stmt
-                 { YYSTYPE t = $1;
-                   if (t != NULL)
-                   { while (t->sibling != NULL)
-                        t = t->sibling;
-                     t->sibling = $3;
-                     $$ = $1; }
-                     else $$ = $3;
+decl_list   : decl_list declaration
+                 { $$ = chainAppend($1,$2); }
+            | declaration
+                 { $$ = chainOf($1); }
+            ;
+declaration : var_decl { $$ = $1; }
+            | fun_decl { $$ = $1; }
+            | error SEMI { $$ = NULL; }
+            | error compound_stmt { $$ = NULL; }
+            ;
+var_decl    : type_spec ID SEMI
+                 { $$ = expNode(VarK,@2);
+                   $$->attr.name = $2;
+                   $$->type = $1;
+                 }
+            | type_spec ID LSQBRAC NUM RSQBRAC SEMI
+                 { $$ = expNode(ArrK,@3);
+                   $$->attr.name = $2;
+                   $$->type = $1;
+                   $$->arr_size = $4;
                  }
-            | stmt  { $$ = $1; }
             ;
-stmt        : if_stmt { $$ = $1; }
-            | repeat_stmt { $$ = $1; }
-            | assign_stmt { $$ = $1; }
-            | read_stmt { $$ = $1; }
-            | write_stmt { $$ = $1; }
-            | error  { $$ = NULL; }
+type_spec   : INT { $$ = Integer; }
+            | VOID { $$ = Void; }
             ;
-if_stmt     : IF exp THEN stmt_seq END
-                 { $$ = newStmtNode(IfK);
-                   $$->child[0] = $2;
-                   $$->child[1] = $4;
+fun_decl    : type_spec ID LPAREN params RPAREN compound_stmt
+                 { $$ = expNode(FuncK,@3);
+                   $$->attr.name = $2;
+                   $$->type = $1;
+                   $$->child[0] = $4;
+                   $$->child[1] = $6;
                  }
-            | IF exp THEN stmt_seq ELSE stmt_seq END
-                 { $$ = newStmtNode(IfK);
-                   $$->child[0] = $2;
-                   $$->child[1] = $4;
-                   $$->child[2] = $6;
+            ;
+params      : param_list { $$ = $1.head; }
+            | VOID
+                 { $$ = expNode(ParamK,@1);
+                   $$->attr.name = NULL;
+                 }
+            | /* empty */
+                 { /* yylloc is the lookahead, the RPAREN */
+                   $$ = expNode(ParamK,yylloc);
+                   $$->attr.name = NULL;
                  }
             ;
-repeat_stmt : REPEAT stmt_seq UNTIL exp
-                 { $$ = newStmtNode(RepeatK);
-                   $$->child[0] = $2;
-                   $$->child[1] = $4;
+param_list  : param_list COMMA param
+                 { $$ = chainAppend($1,$3); }
+            | param { $$ = chainOf($1); }
+            ;
+param       : type_spec ID
+                 { $$ = expNode(ParamK,@1);
+                   $$->attr.name = $2;
+                   $$->type = $1;
+                 }
+            | type_spec ID LSQBRAC RSQBRAC
+                 { $$ = expNode(ParamK,@1);
+                   $$->attr.name = $2;
+                   $$->type = IntArray;
                  }
             ;
-assign_stmt : ID { savedName = copyString(tokenString);
-                   savedLineNo = lineno; }
-              ASSIGN exp
-                 { $$ = newStmtNode(AssignK);
-                   $$->child[0] = $4;
-                   $$->attr.name = savedName;
-                   $$->lineno = savedLineNo;
+compound_stmt : LBRAC local_decls stmt_list RBRAC
+                 { $$ = stmtNode(CompK,@1);
+                   $$->child[0] = $2.head;
+                   $$->child[1] = $3.head;
                  }
             ;
-read_stmt   : READ ID
-                 { $$ = newStmtNode(ReadK);
-                   $$->attr.name =
-                     copyString(tokenString);
+local_decls : local_decls var_decl
+                 { $$ = chainAppend($1,$2); }
+            | /* empty */ { $$ = chainOf(NULL); }
+            ;
+stmt_list   : stmt_list statement
+                 { $$ = chainAppend($1,$2); }
+            | /* empty */ { $$ = chainOf(NULL); }
+            ;
+statement   : expression_stmt { $$ = $1; }
+            | compound_stmt { $$ = $1; }
+            | selection_stmt { $$ = $1; }
+            | iteration_stmt { $$ = $1; }
+            | return_stmt { $$ = $1; }
+            | error SEMI { $$ = NULL; }
+            ;
+expression_stmt : expression SEMI { $$ = $1; }
+            | SEMI { $$ = NULL; }
+            ;
+selection_stmt : IF LPAREN expression RPAREN statement %prec LOWER_THAN_ELSE
+                 { $$ = stmtNode(IfK,@1);
+                   $$->child[0] = $3;
+                   $$->child[1] = $5;
+                 }
+            | IF LPAREN expression RPAREN statement ELSE statement
+                 { $$ = stmtNode(IfK,@1);
+                   $$->child[0] = $3;
+                   $$->child[1] = $5;
+                   $$->child[2] = $7;
+                 }
+            ;
+iteration_stmt : WHILE LPAREN expression RPAREN statement
+                 { $$ = stmtNode(RepeatK,@1);
+                   $$->child[0] = $3;
+                   $$->child[1] = $5;
                  }
             ;
-write_stmt  : WRITE exp
-                 { $$ = newStmtNode(WriteK);
+return_stmt : RETURN SEMI
+                 { $$ = stmtNode(ReturnK,@1); }
+            | RETURN expression SEMI
+                 { $$ = stmtNode(ReturnK,@1);
                    $$->child[0] = $2;
                  }
             ;
-exp         : simple_exp LT simple_exp 
-                 { $$ = newExpNode(OpK);
-                   $$->child[0] = $1;
-                   $$->child[1] = $3;
-                   $$->attr.op = LT;
+expression  : var EQ expression
+                 { $$ = assignNode($1,$3); }
+            | simple_exp { $$ = $1; }
+            ;
+var         : ID
+                 { $$ = expNode(IdK,@1);
+                   $$->attr.name = $1;
                  }
-            | simple_exp EQ simple_exp
-                 { $$ = newExpNode(OpK);
-                   $$->child[0] = $1;
-                   $$->child[1] = $3;
-                   $$->attr.op = EQ;
+            | ID LSQBRAC expression RSQBRAC
+                 { $$ = expNode(ArrexpK,@2);
+                   $$->attr.name = $1;
+                   $$->child[0] = $3;
                  }
-            | simple_exp { $$ = $1; }
             ;
-simple_exp  : simple_exp PLUS term 
-                 { $$ = newExpNode(OpK);
-                   $$->child[0] = $1;
-                   $$->child[1] = $3;
-                   $$->attr.op = PLUS;
-                 }
-            | simple_exp MINUS term
-                 { $$ = newExpNode(OpK);
-                   $$->child[0] = $1;
-                   $$->child[1] = $3;
-                   $$->attr.op = MINUS;
-                 } 
+simple_exp  : add_exp relop add_exp
+                 { $$ = opNode($1,$2,@2,$3); }
+            | add_exp { $$ = $1; }
+            ;
+relop       : LT { $$ = LT; }
+            | LEQ { $$ = LEQ; }
+            | RT { $$ = RT; }
+            | REQ { $$ = REQ; }
+            | ASSIGN { $$ = ASSIGN; }
+            | NEQ { $$ = NEQ; }
+            ;
+add_exp     : add_exp addop term
+                 { $$ = opNode($1,$2,@2,$3); }
             | term { $$ = $1; }
             ;
-term        : term TIMES factor 
-                 { $$ = newExpNode(OpK);
-                   $$->child[0] = $1;
-                   $$->child[1] = $3;
-                   $$->attr.op = TIMES;
-                 }
-            | term OVER factor
-                 { $$ = newExpNode(OpK);
-                   $$->child[0] = $1;
-                   $$->child[1] = $3;
-                   $$->attr.op = OVER;
-                 }
+addop       : PLUS { $$ = PLUS; }
+            | MINUS { $$ = MINUS; }
+            ;
+term        : term mulop factor
+                 { $$ = opNode($1,$2,@2,$3); }
             | factor { $$ = $1; }
             ;
-factor      : LPAREN exp RPAREN
-                 { $$ = $2; }
+mulop       : TIMES { $$ = TIMES; }
+            | OVER { $$ = OVER; }
+            ;
+factor      : LPAREN expression RPAREN { $$ = $2; }
+            | var { $$ = $1; }
+            | call { $$ = $1; }
             | NUM
-                 { $$ = newExpNode(ConstK);
-                   $$->attr.val = atoi(tokenString);
+                 { $$ = expNode(ConstK,@1);
+                   $$->attr.val = $1;
                  }
-            | ID { $$ = newExpNode(IdK);
-                   $$->attr.name =
-                         copyString(tokenString);
+            ;
+call        : ID LPAREN args RPAREN
+                 { $$ = stmtNode(CallK,@2);
+                   $$->attr.name = $1;
+                   $$->child[0] = $3;
                  }
-            | error { $$ = NULL; }
+            ;
+args        : arg_list { $$ = $1.head; }
+            | /* empty */ { $$ = NULL; }
+            ;
+arg_list    : arg_list COMMA expression
+                 { $$ = chainAppend($1,$3); }
+            | expression { $$ = chainOf($1); }
             ;
 
 %%
 
-int yyerror(char * message)
-{ fprintf(listing,"Syntax error at line %d: %s\n",lineno,message);
-  fprintf(listing,"Current token: ");
-  printToken(yychar,tokenString);
-  Error = TRUE;
-  return 0;
+/* tokenKind maps the scanner's tokens to Bison's */
+static const int tokenKind[] =
+   { [ENDFILE] = TOK_YYEOF, [ERROR] = TOK_BAD, [CMTERR] = TOK_BAD,
+     [LEXERR] = TOK_BAD, [TOKENERR] = TOK_BAD,
+     [IF] = TOK_IF, [THEN] = TOK_BAD, [ELSE] = TOK_ELSE, [END] = TOK_BAD,
+     [REPEAT] = TOK_BAD, [UNTIL] = TOK_BAD, [READ] = TOK_BAD,
+     [WRITE] = TOK_BAD, [VOID] = TOK_VOID, [WHILE] = TOK_WHILE,
+     [INT] = TOK_INT, [RETURN] = TOK_RETURN,
+     [ID] = TOK_ID, [NUM] = TOK_NUM,
+     [ASSIGN] = TOK_ASSIGN, [EQ] = TOK_EQ, [NEQ] = TOK_NEQ, [LT] = TOK_LT,
+     [RT] = TOK_RT, [LEQ] = TOK_LEQ, [REQ] = TOK_REQ, [PLUS] = TOK_PLUS,
+     [MINUS] = TOK_MINUS, [TIMES] = TOK_TIMES, [OVER] = TOK_OVER,
+     [LPAREN] = TOK_LPAREN, [RPAREN] = TOK_RPAREN, [SEMI] = TOK_SEMI,
+     [LSQBRAC] = TOK_LSQBRAC, [RSQBRAC] = TOK_RSQBRAC, [LBRAC] = TOK_LBRAC,
+     [RBRAC] = TOK_RBRAC, [COMMA] = TOK_COMMA, [NLSP] = TOK_BAD
+   };
+
+/* yylex hands the next token to the parser, skipping
+ * white space. Once MaxErrors errors have been
+ * reported it returns end of file, which makes the
+ * parser give up
+ */
+static int yylex(YYSTYPE * lvalp, YYLTYPE * llocp, ParseState * ps)
+{ TokenType token;
+  if ((ps->maxErrors > 0) && (ps->errors >= ps->maxErrors))
+    return TOK_YYEOF;
+  do token = getToken(ps->scan);
+  while (token == NLSP);
+  ps->token = token;
+  llocp->first_line = llocp->last_line = ps->scan->lineno;
+  llocp->first_column = llocp->last_column = 0;
+  switch (token)
+  { case ID:
+      lvalp->name = copyString(ps->scan->tokenString);
+      break;
+    case NUM:
+      lvalp->val = atoi(ps->scan->tokenString);
+      break;
+    default:
+      lvalp->op = token;
+      break;
+  }
+  return tokenKind[token];
+}
+
+static void yyerror(YYLTYPE * llocp, ParseState * ps, const char * message)
+{ obPrintf(ps->listing,"Syntax error at line %d: %s\n",ps->scan->lineno,message);
+  obPuts(ps->listing,"Current token: \t");
+  printToken(ps->listing,ps->token,ps->scan->tokenString);
+  ps->errors++;
 }
 
-/* yylex calls getToken to make Yacc/Bison output
- * compatible with ealier versions of the TINY scanner
+/* stmtNode and expNode stamp new nodes with the
+ * line of the token at, the one parse.c is at when
+ * it builds the same node: the keyword of a
+ * statement, the name of a variable, the bracket
+ * or parenthesis after the name of an array or
+ * function, the operator of an operation
  */
-static int yylex(void)
-{ return getToken(); }
+static TreeNode * stmtNode(StmtKind kind, YYLTYPE at)
+{ TreeNode * t = newStmtNode(kind);
+  if (t != NULL) t->lineno = at.first_line;
+  return t;
+}
 
-TreeNode * parse(void)
-{ yyparse();
-  return savedTree;
+static TreeNode * expNode(ExpKind kind, YYLTYPE at)
+{ TreeNode * t = newExpNode(kind);
+  if (t != NULL) t->lineno = at.first_line;
+  return t;
+}
+
+static Chain chainOf(TreeNode * t)
+{ Chain c;
+  c.head = c.tail = t;
+  return c;
+}
+
+/* chainAppend appends the list t (possibly NULL) */
+static Chain chainAppend(Chain c, TreeNode * t)
+{ if (t == NULL) return c;
+  if (c.head == NULL) c.head = t;
+  else c.tail->sibling = t;
+  c.tail = t;
+  while (c.tail->sibling != NULL) c.tail = c.tail->sibling;
+  return c;
+}
+
+/* opNode builds the OpK node of l op r, op being
+ * at location at
+ */
+static TreeNode * opNode(TreeNode * l, TokenType op, YYLTYPE at, TreeNode * r)
+{ TreeNode * t = expNode(OpK,at);
+  t->attr.op = op;
+  t->child[0] = l;
+  t->child[1] = r;
+  return t;
 }
 
+/* assignNode builds the AssignK or AssignKarr node
+ * of var = value, taking over the name and subscript
+ * of the variable node
+ */
+static TreeNode * assignNode(TreeNode * var, TreeNode * value)
+{ TreeNode * t = newStmtNode(var->kind.exp == IdK ? AssignK : AssignKarr);
+  t->attr.name = var->attr.name;
+  t->lineno = var->lineno;
+  t->child[0] = value;
+  t->child[1] = var->child[0];
+  free(var);
+  return t;
+}
+
+/****************************************/
+/* the primary function of the parser   */
+/****************************************/
+/* Function parseSource returns the newly
+ * constructed syntax tree of src; errors and
+ * traces are written to lst. Bison's error
+ * recovery resumes after the next SEMI or
+ * compound statement, so that all errors are
+ * reported in one pass; *error is then set
+ */
+TreeNode * parseSource(FILE * src, OutBuf * lst, int * error)
+{ ParseState state;
+  ParseState * ps = &state;
+  *error = FALSE;
+  ps->scan = newScanner(src,lst);
+  if (ps->scan == NULL)
+  { obPuts(lst,"Out of memory error creating scanner\n");
+    *error = TRUE;
+    return NULL;
+  }
+  ps->listing = lst;
+  ps->token = ENDFILE;
+  ps->errors = 0;
+  ps->maxErrors = MaxErrors;
+  ps->tree = NULL;
+  if ((yyparse(ps) != 0) && (ps->errors == 0))
+  { obPuts(lst,"Out of memory error in parser\n");
+    ps->errors++;
+  }
+  if ((ps->maxErrors > 0) && (ps->errors >= ps->maxErrors))
+  { ps->tree = NULL;
+    if (ps->maxErrors > 1)
+      obPrintf(lst,"Too many syntax errors (%d), parsing stopped\n",ps->errors);
+  }
+  *error = ps->errors > 0;
+  if (Stats != NULL) Stats->tokens = ps->scan->tokens;
+  freeScanner(ps->scan);
+  return ps->tree;
+}
+
+/* Function parse returns the newly
+ * constructed syntax tree of the global
+ * source file; the compilation stops after
+ * the syntax errors have been reported
+ */
+TreeNode * parse(void)
+{ int error;
+  TreeNode * t = parseSource(source,listing,&error);
+  if (error)
+  { Error = TRUE;
+    obFlush(listing);
+    exit(-1);
+  }
+  return t;
+}